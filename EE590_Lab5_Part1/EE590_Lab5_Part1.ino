@@ -1,16 +1,23 @@
 /**
  * @file EE590_Lab5_Part1.ino
- * @brief FreeRTOS-based SRTF Task Scheduling System on ESP32
+ * @brief FreeRTOS-based SRTF, EDF and RM Task Scheduling System on ESP32
  *
  * @mainpage EE590 Lab5 - Part 1
  *
  * @section overview Overview
- * This sketch demonstrates Shortest Remaining Time First (SRTF) scheduling using FreeRTOS tasks on an ESP32.
+ * This sketch schedules FreeRTOS tasks on an ESP32 under Shortest Remaining Time First (SRTF), Earliest
+ * Deadline First (EDF) or Rate Monotonic (RM), chosen by SCHED_POLICY.
  * The program performs three tasks:
  * - Blinks an LED for a total of 500 ms.
  * - Displays an incrementing counter on an LCD. in 2 seconds
  * - Prints alphabet characters to the serial monitor in 13 seconds.
- * Tasks are managed by a scheduler that resumes them based on the shortest remaining execution time.
+ * Tasks are declared as (period, WCET, deadline) in taskSpecs and admitted by the RTScheduler core,
+ * which picks the next task under SRTF, EDF or RM. The scheduler task sleeps until a task ends a slice
+ * or a release is due, instead of polling every 1 ms.
+ * The counter task does no I2C itself: it queues its LCD requests (LcdQueue.h) and a service task below
+ * every task of the set sends them while the set is blocked.
+ * Every slice, every scheduler wake-up and every LCD drain is timed into a TaskProfile (TaskProfile.h), and
+ * loop() prints them with each task's stack high-water mark when PROFILE_DUMP_KEY arrives over serial.
  *
  * @section author Author
  * Created by Sai Jayanth Kalisi, 2025
@@ -21,6 +28,9 @@
 #include <freertos/task.h>
 #include <Wire.h>
 #include <LiquidCrystal_I2C.h>
+#include <LcdQueue.h>
+#include <TaskProfile.h>
+#include "RTScheduler.h"
 
 //========= PIN DEFINITIONS =========
 #define LED 1              ///< Output LED pin
@@ -30,156 +40,296 @@
 #define LCD_TIME 100       ///< LCD update interval in milliseconds
 #define PRINT_TIME 500     ///< Serial print interval in milliseconds
 
+//========= SCHEDULER SETTINGS =========
+#define ROUND_PERIOD_MS 16000         ///< Every task is released once per round
+#define SCHED_POLICY RT_POLICY_SRTF   ///< Policy the scheduler starts with
+#define NEW_JOB_FLAG (1u << 31)       ///< Set in a slice grant when it is the first slice of a new job
+
+//========= LCD SERVICE SETTINGS =========
+#define LCD_QUEUE_LEN 16              ///< LCD commands that can wait to be sent
+#define LCD_SERVICE_PRIORITY 0        ///< Below the task set, so the LCD is sent while the tasks are blocked
+#define LCD_SERVICE_STACK 2048        ///< LCD service task stack in bytes
+#define SCHEDULER_STACK 2048          ///< Scheduler task stack in bytes
+
+//========= PROFILING SETTINGS =========
+#define SLICE_SLACK_US 2000           ///< A slice may run this much past its planned length before it counts as an overrun
+#define SCHEDULER_DEADLINE_US 1000    ///< One scheduler wake-up should fit in a tick
+#define PROFILE_SCHEDULER N_TASKS     ///< Profile index of the scheduler task; the task set's come first
+#define PROFILE_LCD_SERVICE (N_TASKS + 1) ///< Profile index of the LCD service task
+#define N_PROFILES (N_TASKS + 2)      ///< Profiles kept
+#define PROFILE_DUMP_KEY 'p'          ///< Serial command that prints the profiles
+
 
 //========= LCD SETUP =========
 /**
  * @brief 16x2 I2C LCD at address 0x27
  */
 LiquidCrystal_I2C lcd(0x27, 16, 2);
+LcdQueue<LCD_QUEUE_LEN, 16, 2> lcdQueue;  ///< Requests from counterTask, sent by lcdServiceTask
 
 //========= TASK EXECUTION TIMES =========
 const TickType_t ledTaskExecutionTime = pdMS_TO_TICKS(500);         ///< LED total execution time 500 ms
 const TickType_t counterTaskExecutionTime = pdMS_TO_TICKS(2000);    ///< LCD count total time 2 s
 const TickType_t alphabetTaskExecutionTime = pdMS_TO_TICKS(13000);  ///< Alphabet print total time 13 s
 
-//========= REMAINING TIMES =========
-volatile TickType_t remainingLedTime = ledTaskExecutionTime;
-volatile TickType_t remainingCounterTime = counterTaskExecutionTime;
-volatile TickType_t remainingAlphabetTime = alphabetTaskExecutionTime;
-
-//========= STATE FLAGS =========
-volatile bool LEDdone = false;     ///< Flag to track completion of LED task
-volatile bool COUNTdone = false;   ///< Flag to track completion of counter task
-volatile bool ALPHAdone = false;   ///< Flag to track completion of alphabet task
-
 //========= Global VALUES =========
 volatile int count = 0;            ///< Current LCD count value
 volatile char glyph = 'A' - 1;     ///< Current alphabet character
 
 //========= TASK HANDLES =========
-TaskHandle_t TaskLED_Handle = NULL;
-TaskHandle_t TaskCOUNT_Handle = NULL;
-TaskHandle_t TaskALPHA_Handle = NULL;
 TaskHandle_t TaskSchedule_Handle = NULL;
+TaskHandle_t TaskLCD_Handle = NULL;
+
+//========= SCHEDULER STATE =========
+volatile TickType_t sliceTicks[RT_MAX_TASKS];  ///< Budget used by each task's last slice, set before it notifies the scheduler
+uint32_t grantedJob[RT_MAX_TASKS];             ///< Job number of each task's last grant, to flag the first slice of a job
+
+//========= PROTOTYPES =========
+void ledTask(void *arg);
+void counterTask(void *arg);
+void alphabetTask(void *arg);
+
+/**
+ * @brief One task of the set: what FreeRTOS needs to create it and what the scheduler needs to admit it
+ */
+typedef struct {
+  const char *name;      ///< FreeRTOS task name
+  TaskFunction_t fn;     ///< Task body, passed its scheduler id
+  uint32_t stack;        ///< Stack size in bytes
+  TickType_t period;     ///< Ticks between releases
+  TickType_t wcet;       ///< Budget per release
+  TickType_t deadline;   ///< Ticks after the release the job is due
+  uint32_t sliceUs;      ///< Planned length of one slice; longer ones count as profile overruns
+} TaskSpec;
+
+/**
+ * @brief The task set. Adding a task is one more row here.
+ */
+const TaskSpec taskSpecs[] = {
+  { "BlinkingLED", ledTask, 2048, pdMS_TO_TICKS(ROUND_PERIOD_MS), ledTaskExecutionTime, pdMS_TO_TICKS(ROUND_PERIOD_MS), LED_TIME * 2 * 1000 },
+  { "CountingLCD", counterTask, 2048, pdMS_TO_TICKS(ROUND_PERIOD_MS), counterTaskExecutionTime, pdMS_TO_TICKS(ROUND_PERIOD_MS), LCD_TIME * 1000 },
+  { "AlphabetPrintSerial", alphabetTask, 4096, pdMS_TO_TICKS(ROUND_PERIOD_MS), alphabetTaskExecutionTime, pdMS_TO_TICKS(ROUND_PERIOD_MS), PRINT_TIME * 1000 },
+};
+#define N_TASKS (sizeof(taskSpecs) / sizeof(taskSpecs[0]))
+
+//========= PROFILES =========
+TaskProfile profiles[N_PROFILES];  ///< Task set by scheduler id, then the scheduler and the LCD service
+TaskHandle_t profiledTasks[N_PROFILES];  ///< FreeRTOS handle behind each profile, for its stack high-water mark
+
+
+//========= SLICE PROTOCOL =========
+
+/**
+ * @brief Blocks the calling task until the scheduler grants it a slice, and starts timing the slice
+ * @param id scheduler id of the calling task
+ * @param newJob set to true if this is the first slice of a new release
+ * @return the task's remaining budget in ticks
+ */
+TickType_t waitForSlice(int id, bool *newJob) {
+  uint32_t grant = 0;
+  xTaskNotifyWait(0, ULONG_MAX, &grant, portMAX_DELAY);
+  profiles[id].begin(micros());
+  *newJob = (grant & NEW_JOB_FLAG) != 0;
+  return grant & ~NEW_JOB_FLAG;
+}
+
+/**
+ * @brief Records the slice in the task's profile and reports its end to the scheduler, waking it
+ * @param id scheduler id of the calling task
+ * @param used budget the slice consumed, in ticks
+ * @param done true if the task has finished its job
+ */
+void endSlice(int id, TickType_t used, bool done) {
+  profiles[id].end(micros());
+  sliceTicks[id] = used;
+  uint32_t bits = (1u << id) | (done ? 1u << (id + RT_MAX_TASKS) : 0);
+  xTaskNotify(TaskSchedule_Handle, bits, eSetBits);
+}
+
+/**
+ * @brief Gives a task its next slice, passing its remaining budget
+ * @param id scheduler id of the task
+ */
+void grantSlice(int id) {
+  RtTask *t = rtGet(id);
+  uint32_t grant = t->remaining;
+  if (t->jobs != grantedJob[id]) {
+    grantedJob[id] = t->jobs;
+    grant |= NEW_JOB_FLAG;
+  }
+  xTaskNotify((TaskHandle_t)t->user, grant, eSetValueWithOverwrite);
+}
 
 
 //========= TASK DEFINITIONS =========
 
 /**
  * @brief Blinks an LED until the allotted execution time expires
- * @param arg Unused task parameter
+ * @param arg scheduler id of the task
  */
 void ledTask(void *arg) {
+  int id = (int)(intptr_t)arg;
   pinMode(LED, OUTPUT);
   while (1) {
+    bool newJob;
+    TickType_t budget = waitForSlice(id, &newJob);
     // check if task needs any further changes in this time slice
-    if (!LEDdone && remainingLedTime >= pdMS_TO_TICKS(LED_TIME * 2)) {
+    if (budget >= pdMS_TO_TICKS(LED_TIME * 2)) {
       // if so, do task in current time slice by toggling LED on and off
       digitalWrite(LED, HIGH);
       vTaskDelay(pdMS_TO_TICKS(LED_TIME));
       digitalWrite(LED, LOW);
       vTaskDelay(pdMS_TO_TICKS(LED_TIME));
-      remainingLedTime -= pdMS_TO_TICKS(LED_TIME * 2);
+      endSlice(id, pdMS_TO_TICKS(LED_TIME * 2), false);
     } else {
       // if not, consider task as complete
       Serial.println("LED Complete");
-      LEDdone = true;
+      endSlice(id, 0, true);
     }
-    vTaskSuspend(NULL);
   }
 }
 
 /**
  * @brief Displays a counter on the LCD every 100 ms until it reaches 20 or time expires
- * @param arg Unused task parameter
+ * @details The count is queued on lcdQueue, which returns at once, so the slice is not spent on I2C.
+ *          Before reporting completion the task waits for its last count to be on the display.
+ * @param arg scheduler id of the task
  */
 void counterTask(void *arg) {
+  int id = (int)(intptr_t)arg;
+  uint32_t shown = LCD_QUEUE_FULL;  // ticket of the last count queued
   while (1) {
+    bool newJob;
+    TickType_t budget = waitForSlice(id, &newJob);
+    if (newJob) count = 0;
     // check if task needs any further changes in this time slice
-    if (!COUNTdone && count < 20 && remainingCounterTime >= pdMS_TO_TICKS(LCD_TIME)) {
+    if (count < 20 && budget >= pdMS_TO_TICKS(LCD_TIME)) {
       //if so, do task during time slice by incrementing count and printing to LCD
       count++;
-      lcd.clear();
-      lcd.setCursor(0, 0);
-      lcd.print("Count: ");
-      lcd.print(count);
+      lcdQueue.beginUpdate();  // the whole screen or, if the queue is full, none of it
+      lcdQueue.clear();
+      lcdQueue.print("Count: ");
+      lcdQueue.print(count);
+      uint32_t ticket = lcdQueue.endUpdate();
+      if (ticket != LCD_QUEUE_FULL) shown = ticket;
       
       // Serial.print("Time: " + String(millis()) + " for ");
       // Serial.println(count);
       vTaskDelay(pdMS_TO_TICKS(LCD_TIME));
-      remainingCounterTime -= pdMS_TO_TICKS(LCD_TIME);
+      endSlice(id, pdMS_TO_TICKS(LCD_TIME), false);
     } else {
-      // if not consider task complete
+      // if not consider task complete, once the last count is on the display
+      lcdQueue.wait(shown, [] { vTaskDelay(1); });
       Serial.println("Count Complete");
-      COUNTdone = true;
+      endSlice(id, 0, true);
     }
-    vTaskSuspend(NULL);
   }
 }
 
 /**
  * @brief Prints the alphabet to the serial monitor every 500 ms until Z or time expires
- * @param arg Unused task parameter
+ * @param arg scheduler id of the task
  */
 void alphabetTask(void *arg) {
+  int id = (int)(intptr_t)arg;
   while (1) {
+    bool newJob;
+    TickType_t budget = waitForSlice(id, &newJob);
+    if (newJob) glyph = 'A' - 1;
     //check if task needs any further changes in this time slice. 
-    if (!ALPHAdone && glyph < 'Z' && remainingAlphabetTime >= pdMS_TO_TICKS(PRINT_TIME)) {
+    if (glyph < 'Z' && budget >= pdMS_TO_TICKS(PRINT_TIME)) {
       //if so, do next time slice by printing next char
       glyph++;
       // Serial.print("Time: " + String(millis()) + " for ");
       Serial.print(glyph);
       vTaskDelay(pdMS_TO_TICKS(PRINT_TIME));
-      remainingAlphabetTime -= pdMS_TO_TICKS(PRINT_TIME);
+      endSlice(id, pdMS_TO_TICKS(PRINT_TIME), false);
     } else {
       // if not, consider task as done
       Serial.println();
       Serial.println("Alphabet Done");
-      ALPHAdone = true;
+      endSlice(id, 0, true);
     }
-    vTaskSuspend(NULL);
   }
 }
 
 /**
- * @brief Implements Shortest Remaining Time First (SRTF) scheduling
- *        and resets all tasks when all are finished
+ * @brief Sends queued LCD requests to the display
+ * @details Sleeps until a request is posted, then drains the queue. It runs below the task set, so it
+ *          only gets the CPU while every task is blocked. Each drain is timed into its profile.
+ * @param arg Unused task parameter
+ */
+void lcdServiceTask(void *arg) {
+  while (1) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    TaskProfile &profile = profiles[PROFILE_LCD_SERVICE];
+    profile.begin(micros());
+    if (lcdQueue.drain(lcd) > 0) profile.end(micros());
+  }
+}
+
+/**
+ * @brief Wakes lcdServiceTask; run by lcdQueue after every post
+ * @param arg the service task's handle
+ */
+void wakeLcdService(void *arg) {
+  xTaskNotifyGive((TaskHandle_t)arg);
+}
+
+/**
+ * @brief Runs the task set under the RTScheduler policy, one slice at a time
+ * @details Sleeps until a task reports the end of its slice or the next release is due, so it costs
+ *          nothing between events. On waking it charges the finished slice, completes finished jobs,
+ *          releases due tasks and, if no slice is in progress, grants one to the task the policy picks.
+ *          The time from waking to sleeping again is recorded in its profile.
  * @param arg Unused task parameter
  */
 void scheduleTasks(void *arg) {
+  int running = RT_NONE;
+  uint32_t allTasks = (1u << rtTaskCount()) - 1;
+  rtStart(xTaskGetTickCount());
+  TaskProfile &profile = profiles[PROFILE_SCHEDULER];
+  profile.begin(micros());
+
   while (1) {
-    // Reset if all are done
-    if (LEDdone && COUNTdone && ALPHAdone) {
+    TickType_t now = xTaskGetTickCount();
+    uint32_t released = rtRelease(now);
+    if (released == allTasks) {
       Serial.println("Resetting tasks...");
-      count = 0;
-      glyph = 'A' - 1;
-      remainingLedTime = ledTaskExecutionTime;
-      remainingCounterTime = counterTaskExecutionTime;
-      remainingAlphabetTime = alphabetTaskExecutionTime;
-      LEDdone = COUNTdone = ALPHAdone = false;
-      
-      vTaskSuspend(TaskLED_Handle);
-      vTaskSuspend(TaskCOUNT_Handle);
-      vTaskSuspend(TaskALPHA_Handle);
     }
 
-    // SRTF Scheduling
-    if (!LEDdone && (remainingLedTime <= remainingCounterTime || COUNTdone) && (remainingLedTime <= remainingAlphabetTime || ALPHAdone) && eTaskGetState(TaskLED_Handle) == eSuspended) {
-      vTaskResume(TaskLED_Handle);
-    } else if (!COUNTdone && (remainingCounterTime <= remainingLedTime || LEDdone) && (remainingCounterTime <= remainingAlphabetTime || ALPHAdone) && eTaskGetState(TaskCOUNT_Handle) == eSuspended) {
-      vTaskResume(TaskCOUNT_Handle);
-    } else if (!ALPHAdone && (remainingAlphabetTime <= remainingLedTime || LEDdone) && (remainingAlphabetTime <= remainingCounterTime || COUNTdone) && eTaskGetState(TaskALPHA_Handle) == eSuspended) {
-      vTaskResume(TaskALPHA_Handle);
+    if (running == RT_NONE) {
+      running = rtPick(now);
+      if (running != RT_NONE) grantSlice(running);
     }
 
-    vTaskDelay(pdMS_TO_TICKS(1));  //frequency with which to check
+    // sleep until a slice ends or the next release
+    uint32_t events = 0;
+    profile.end(micros());
+    xTaskNotifyWait(0, ULONG_MAX, &events, rtNextRelease(now) - now);
+    profile.begin(micros());
+    now = xTaskGetTickCount();
+
+    for (int id = 0; id < rtTaskCount(); id++) {
+      if (events & (1u << id)) {
+        rtCharge(id, sliceTicks[id]);
+        if (id == running) running = RT_NONE;
+      }
+      if ((events & (1u << (id + RT_MAX_TASKS))) && !rtComplete(id, now)) {
+        Serial.print(rtGet(id)->name);
+        Serial.println(" missed its deadline");
+      }
+    }
   }
 }
 
 //========= SETUP =========
 /**
  * @brief Arduino setup function
- * @details Initializes peripherals and creates tasks pinned to Core 0
+ * @details Initializes peripherals, admits the task set under SCHED_POLICY and creates the tasks pinned to Core 0.
+ *          A task the admission test rejects is reported and not created.
+ *          The LCD service task is created first, so the queue can wake it from the first post.
+ *          Each task's profile gets its stack size and, for the task set, its slice length plus SLICE_SLACK_US as deadline.
  */
 void setup() {
   Serial.begin(115200);
@@ -188,18 +338,52 @@ void setup() {
   lcd.clear();
   lcd.backlight();
 
-  // Create tasks pinned to core 0
-  xTaskCreatePinnedToCore(ledTask, "BlinkingLED", 2048, NULL, 1, &TaskLED_Handle, 0);
-  xTaskCreatePinnedToCore(counterTask, "CountingLCD", 2048, NULL, 1, &TaskCOUNT_Handle, 0);
-  xTaskCreatePinnedToCore(alphabetTask, "AlphabetPrintSerial", 4096, NULL, 1, &TaskALPHA_Handle, 0);
-  xTaskCreatePinnedToCore(scheduleTasks, "SchedulerSRTF", 2048, NULL, 2, &TaskSchedule_Handle, 0); // Higher priority
+  for (size_t i = 0; i < N_TASKS; i++) profiles[i].setup("(not admitted)");
+  profiles[PROFILE_LCD_SERVICE].setup("LCDService", LCD_TIME * 1000, LCD_SERVICE_STACK);
+  xTaskCreatePinnedToCore(lcdServiceTask, "LCDService", LCD_SERVICE_STACK, NULL, LCD_SERVICE_PRIORITY, &TaskLCD_Handle, 0);
+  profiledTasks[PROFILE_LCD_SERVICE] = TaskLCD_Handle;
+  lcdQueue.setWake(wakeLcdService, TaskLCD_Handle);
+
+  rtClear();
+  if (!rtSetPolicy(SCHED_POLICY)) {
+    Serial.println("Policy rejected");
+  }
+  for (size_t i = 0; i < N_TASKS; i++) {
+    const TaskSpec *spec = &taskSpecs[i];
+    int id = rtAddTask(spec->name, spec->period, spec->wcet, spec->deadline, NULL);
+    if (id == RT_NONE) {
+      Serial.print(spec->name);
+      Serial.println(" rejected by admission test");
+      continue;
+    }
+    profiles[id].setup(spec->name, spec->sliceUs + SLICE_SLACK_US, spec->stack);
+    TaskHandle_t handle = NULL;
+    xTaskCreatePinnedToCore(spec->fn, spec->name, spec->stack, (void *)(intptr_t)id, 1, &handle, 0);
+    rtGet(id)->user = handle;
+    profiledTasks[id] = handle;
+  }
+  Serial.print(rtPolicyName(rtPolicy()));
+  Serial.print(" utilization (ppm): ");
+  Serial.println((int)rtUtilizationPpm());
+
+  profiles[PROFILE_SCHEDULER].setup("Scheduler", SCHEDULER_DEADLINE_US, SCHEDULER_STACK);
+  xTaskCreatePinnedToCore(scheduleTasks, "Scheduler", SCHEDULER_STACK, NULL, 2, &TaskSchedule_Handle, 0); // Higher priority
+  profiledTasks[PROFILE_SCHEDULER] = TaskSchedule_Handle;
 }
 
 
 //========= LOOP =========
 /**
- * @brief Empty main loop as tasks handle all operations
+ * @brief Tasks handle all operations; the main loop only answers profile dump requests
+ * @details On PROFILE_DUMP_KEY, reads every profiled task's stack high-water mark (bytes left at the
+ *          deepest point so far) and prints the profiles.
  */
 void loop() {
-  // not used
+  if (Serial.available() > 0 && Serial.read() == PROFILE_DUMP_KEY) {
+    for (size_t i = 0; i < N_PROFILES; i++) {
+      if (profiledTasks[i] != NULL) profiles[i].stackHighWater(uxTaskGetStackHighWaterMark(profiledTasks[i]));
+    }
+    profileDump(Serial, profiles, N_PROFILES);
+  }
+  vTaskDelay(pdMS_TO_TICKS(50));
 }
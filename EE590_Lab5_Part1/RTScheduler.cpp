@@ -0,0 +1,334 @@
+/**
+ * @file RTScheduler.cpp
+ * @brief Implementation of the Lab 5 Part 1 policy and admission core. See RTScheduler.h.
+ */
+#include "RTScheduler.h"
+
+#include <string.h>
+
+#define RT_PPM 1000000ULL ///< Utilization fixed point: parts per million
+
+/// n(2^(1/n) - 1) in ppm, rounded down, for n = 1 to RT_MAX_TASKS
+static const uint32_t rmBoundPpm[RT_MAX_TASKS] = {
+  1000000, 828427, 779763, 756828, 743491, 734772, 728626, 724061,
+  720537, 717734, 715451, 713557, 711958, 710592, 709411, 708380,
+};
+
+static RtTask rtTasks[RT_MAX_TASKS];
+static int rtCount = 0;
+static RtPolicy currentPolicy = RT_POLICY_SRTF;
+
+// =============== INTERNALS =============== //
+
+/**
+ * Name: ticksBefore
+ * @brief Wrap-safe a < b for tick counts less than 2^31 apart.
+ */
+static inline bool ticksBefore(uint32_t a, uint32_t b) {
+  return (int32_t)(a - b) < 0;
+}
+
+/**
+ * Name: harmonic
+ * @brief True when every period divides the next larger one.
+ */
+static bool harmonic() {
+  uint32_t periods[RT_MAX_TASKS];
+  for (int i = 0; i < rtCount; i++) {
+    uint32_t p = rtTasks[i].period;
+    int j = i;
+    while (j > 0 && periods[j - 1] > p) {
+      periods[j] = periods[j - 1];
+      j--;
+    }
+    periods[j] = p;
+  }
+  for (int i = 1; i < rtCount; i++) {
+    if (periods[i] % periods[i - 1] != 0) return false;
+  }
+  return true;
+}
+
+/**
+ * Name: busyPeriodWithin
+ * @brief True when the longest busy period, which starts with every task released at
+ *      once, ends within limit ticks. Any policy that never idles with a job pending
+ *      finishes each job by then.
+ * @details Iterates L = sum of ceil(L / period) * WCET from the sum of the WCETs. L only
+ *      grows, so the loop stops at the fixed point or once L passes limit.
+ */
+static bool busyPeriodWithin(uint32_t limit) {
+  uint64_t length = 0;
+  for (int i = 0; i < rtCount; i++) length += rtTasks[i].wcet;
+  while (length <= limit) {
+    uint64_t demand = 0;
+    for (int i = 0; i < rtCount; i++) {
+      const RtTask *t = &rtTasks[i];
+      demand += (length + t->period - 1) / t->period * t->wcet;
+    }
+    if (demand == length) return true;
+    length = demand;
+  }
+  return false;
+}
+
+/**
+ * Name: ppmUp
+ * @brief wcet / divisor in ppm, rounded up, so the sum of the terms never understates the load.
+ */
+static inline uint64_t ppmUp(uint32_t wcet, uint32_t divisor) {
+  return (wcet * RT_PPM + divisor - 1) / divisor;
+}
+
+/**
+ * Name: rtKey
+ * @brief Ordering key of an active task under the current policy; smaller runs first.
+ */
+static int64_t rtKey(const RtTask *t, uint32_t now) {
+  switch (currentPolicy) {
+    case RT_POLICY_EDF:
+      return (int32_t)(t->release + t->deadline - now);  // negative once overdue
+    case RT_POLICY_RM:
+      return t->period;
+    case RT_POLICY_SRTF:
+    default:
+      return t->remaining;
+  }
+}
+
+// =============== TASK SET =============== //
+
+/**
+ * Name: rtClear
+ * @brief Removes every task. The policy is kept.
+ */
+void rtClear() {
+  memset(rtTasks, 0, sizeof(rtTasks));
+  rtCount = 0;
+}
+
+/**
+ * Name: rtAddTask
+ * @brief Adds a task if the task set still passes the admission test of the current policy.
+ * @param name label for reports.
+ * @param period ticks between releases.
+ * @param wcet worst-case execution time per release, in ticks.
+ * @param deadline ticks after each release the job is due, 1 to period.
+ * @param user caller data kept with the task.
+ * @retval the task id (0 up, in order of addition), or RT_NONE if the arguments are
+ *      invalid, the table is full or the task set would not be admissible.
+ */
+int rtAddTask(const char *name, uint32_t period, uint32_t wcet, uint32_t deadline, void *user) {
+  if (rtCount == RT_MAX_TASKS || period == 0 || wcet == 0 || deadline < wcet || deadline > period) {
+    return RT_NONE;
+  }
+
+  RtTask *t = &rtTasks[rtCount];
+  memset(t, 0, sizeof(RtTask));
+  t->name = name;
+  t->period = period;
+  t->wcet = wcet;
+  t->deadline = deadline;
+  t->user = user;
+  rtCount++;
+
+  if (!rtAdmissible(currentPolicy)) {
+    rtCount--;
+    return RT_NONE;
+  }
+  return rtCount - 1;
+}
+
+/**
+ * Name: rtSetPolicy
+ * @brief Switches policy if the current task set passes its admission test.
+ * @retval false if it does not; the old policy stays in force.
+ */
+bool rtSetPolicy(RtPolicy policy) {
+  if (!rtAdmissible(policy)) return false;
+  currentPolicy = policy;
+  return true;
+}
+
+/**
+ * Name: rtPolicy
+ * @brief The policy in force.
+ */
+RtPolicy rtPolicy() {
+  return currentPolicy;
+}
+
+/**
+ * Name: rtAdmissible
+ * @brief Admission test of the current task set under a policy. See RTScheduler.h.
+ */
+bool rtAdmissible(RtPolicy policy) {
+  if (rtCount == 0) return true;
+
+  uint64_t utilization = 0;  // WCET / period, each term rounded up
+  uint64_t density = 0;      // WCET / min(deadline, period), each term rounded up
+  uint32_t shortestDeadline = rtTasks[0].deadline;
+  bool implicitDeadlines = true;
+  for (int i = 0; i < rtCount; i++) {
+    const RtTask *t = &rtTasks[i];
+    utilization += ppmUp(t->wcet, t->period);
+    density += ppmUp(t->wcet, t->deadline);
+    if (t->deadline < shortestDeadline) shortestDeadline = t->deadline;
+    if (t->deadline != t->period) implicitDeadlines = false;
+  }
+
+  switch (policy) {
+    case RT_POLICY_EDF:
+      return density <= RT_PPM;
+    case RT_POLICY_RM:
+      if (!implicitDeadlines) return false;
+      return utilization <= (harmonic() ? RT_PPM : rmBoundPpm[rtCount - 1]);
+    case RT_POLICY_SRTF:
+    default:
+      // A job with little budget left can hold off a longer one past its deadline even
+      // at 100% density, so only a busy period no task can miss in is admitted.
+      return density <= RT_PPM && busyPeriodWithin(shortestDeadline);
+  }
+}
+
+/**
+ * Name: rtUtilizationPpm
+ * @brief Sum of WCET / period over the task set, in parts per million.
+ */
+uint32_t rtUtilizationPpm() {
+  uint64_t utilization = 0;
+  for (int i = 0; i < rtCount; i++) {
+    utilization += rtTasks[i].wcet * RT_PPM / rtTasks[i].period;
+  }
+  return (uint32_t)utilization;
+}
+
+/**
+ * Name: rtGet
+ * @brief Task by id, or NULL.
+ */
+RtTask *rtGet(int id) {
+  return (id < 0 || id >= rtCount) ? NULL : &rtTasks[id];
+}
+
+/**
+ * Name: rtTaskCount
+ * @brief Number of tasks added.
+ */
+int rtTaskCount() {
+  return rtCount;
+}
+
+/**
+ * Name: rtPolicyName
+ * @brief Short name of a policy for reports.
+ */
+const char *rtPolicyName(RtPolicy policy) {
+  switch (policy) {
+    case RT_POLICY_EDF: return "EDF";
+    case RT_POLICY_RM: return "RM";
+    case RT_POLICY_SRTF:
+    default: return "SRTF";
+  }
+}
+
+// =============== SCHEDULING =============== //
+
+/**
+ * Name: rtStart
+ * @brief Resets every task so that the next rtRelease(now) releases all of them at now.
+ */
+void rtStart(uint32_t now) {
+  for (int i = 0; i < rtCount; i++) {
+    RtTask *t = &rtTasks[i];
+    t->release = now - t->period;
+    t->remaining = 0;
+    t->active = false;
+    t->jobs = 0;
+    t->misses = 0;
+  }
+}
+
+/**
+ * Name: rtRelease
+ * @brief Starts a new job for every task whose next release is due.
+ * @details A task still active at its release has overrun: the old job counts as a miss
+ *      and is replaced. If the scheduler ran late by whole periods, each skipped release
+ *      is counted the same way.
+ * @retval bit i set for each task i released.
+ */
+uint32_t rtRelease(uint32_t now) {
+  uint32_t released = 0;
+  for (int i = 0; i < rtCount; i++) {
+    RtTask *t = &rtTasks[i];
+    while (!ticksBefore(now, t->release + t->period)) {
+      if (t->active) t->misses++;
+      t->release += t->period;
+      t->remaining = t->wcet;
+      t->active = true;
+      t->jobs++;
+      released |= 1u << i;
+    }
+  }
+  return released;
+}
+
+/**
+ * Name: rtNextRelease
+ * @brief Tick of the earliest upcoming release, so the caller can sleep until then.
+ */
+uint32_t rtNextRelease(uint32_t now) {
+  uint32_t next = now + UINT32_MAX / 2;
+  for (int i = 0; i < rtCount; i++) {
+    uint32_t release = rtTasks[i].release + rtTasks[i].period;
+    if (ticksBefore(release, next)) next = release;
+  }
+  return next;
+}
+
+/**
+ * Name: rtPick
+ * @brief Active task to run next under the current policy.
+ * @retval its id, or RT_NONE if no task is active.
+ */
+int rtPick(uint32_t now) {
+  int best = RT_NONE;
+  int64_t bestKey = 0;
+  for (int i = 0; i < rtCount; i++) {
+    const RtTask *t = &rtTasks[i];
+    if (!t->active) continue;
+    int64_t key = rtKey(t, now);
+    if (best == RT_NONE || key < bestKey) {
+      best = i;
+      bestKey = key;
+    }
+  }
+  return best;
+}
+
+/**
+ * Name: rtCharge
+ * @brief Takes ticks of execution off a task's remaining budget.
+ */
+void rtCharge(int id, uint32_t ticks) {
+  RtTask *t = rtGet(id);
+  if (t == NULL) return;
+  t->remaining = (ticks < t->remaining) ? t->remaining - ticks : 0;
+}
+
+/**
+ * Name: rtComplete
+ * @brief Ends a task's current job.
+ * @retval false if it finished after its deadline; the miss is counted.
+ */
+bool rtComplete(int id, uint32_t now) {
+  RtTask *t = rtGet(id);
+  if (t == NULL || !t->active) return true;
+  t->active = false;
+  t->remaining = 0;
+  if (ticksBefore(t->release + t->deadline, now)) {
+    t->misses++;
+    return false;
+  }
+  return true;
+}
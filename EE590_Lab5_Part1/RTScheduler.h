@@ -0,0 +1,97 @@
+/**
+ * @file RTScheduler.h
+ * @brief Policy and admission core for the Lab 5 Part 1 FreeRTOS scheduler.
+ *
+ * @section description Description
+ * Tasks are declared as (period, WCET, deadline) in ticks. Each release gives a task a
+ * job with WCET ticks of budget, due deadline ticks after the release. rtPick chooses
+ * among the released tasks with the selected policy:
+ * - RT_POLICY_SRTF: least remaining budget first.
+ * - RT_POLICY_EDF: earliest absolute deadline first.
+ * - RT_POLICY_RM: shortest period first (rate monotonic).
+ * Ties go to the task added first. Adding a policy means adding its key to rtKey in
+ * RTScheduler.cpp, not another chain of comparisons per task.
+ *
+ * rtAddTask and rtSetPolicy run an admission test first and refuse a task set the
+ * policy cannot be shown to meet:
+ * - EDF: sum of WCET / min(deadline, period) <= 1 (exact when deadline = period).
+ * - RM: sum of WCET / period <= n(2^(1/n) - 1), or <= 1 when every period divides the
+ *   next larger one (harmonic periods), and deadlines equal to periods.
+ * - SRTF: density <= 1 as for EDF, and the busy period that starts with every task
+ *   released at once must end within the shortest deadline. Least remaining budget first
+ *   can miss deadlines at any utilization, so this bound, which holds for any policy that
+ *   never idles with work pending, is sufficient but refuses some sets SRTF would meet.
+ * Each term is counted in ppm rounded up, so a set just over a bound is never admitted
+ * because of rounding; one that meets it exactly may be refused.
+ *
+ * The core does no waiting of its own. The sketch sleeps until rtNextRelease or until
+ * a task reports the end of a slice, then calls rtRelease, rtCharge/rtComplete and
+ * rtPick, so the scheduler only runs on events.
+ *
+ * @section notes Notes
+ * - Times are FreeRTOS ticks compared with wrap-safe differences.
+ * - Not thread safe: call everything from the scheduler task only.
+ */
+#ifndef RT_SCHEDULER_H
+#define RT_SCHEDULER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define RT_MAX_TASKS 16    ///< Tasks one scheduler can hold; also the width of the release mask
+#define RT_NONE      (-1)  ///< No task / task rejected
+
+// =============== ENUMS =============== //
+
+typedef enum {
+  RT_POLICY_SRTF,  ///< Shortest remaining time first
+  RT_POLICY_EDF,   ///< Earliest deadline first
+  RT_POLICY_RM,    ///< Rate monotonic
+} RtPolicy;
+
+// =============== STRUCTS =============== //
+
+typedef struct {
+  const char *name;    ///< For reports
+  uint32_t period;     ///< Ticks between releases
+  uint32_t wcet;       ///< Budget per release, in ticks
+  uint32_t deadline;   ///< Ticks after the release the job is due
+  uint32_t release;    ///< Tick of the current release
+  uint32_t remaining;  ///< Budget left in the current job
+  bool active;         ///< Released and not complete
+  uint32_t jobs;       ///< Releases so far
+  uint32_t misses;     ///< Jobs that completed late or were still running at the next release
+  void *user;          ///< Caller data, e.g. the FreeRTOS task handle
+} RtTask;
+
+// =============== FUNCTIONS =============== //
+
+/**
+ * @name Task Set
+ * @{
+ */
+void rtClear();
+int rtAddTask(const char *name, uint32_t period, uint32_t wcet, uint32_t deadline, void *user);
+bool rtSetPolicy(RtPolicy policy);
+RtPolicy rtPolicy();
+bool rtAdmissible(RtPolicy policy);
+uint32_t rtUtilizationPpm();
+RtTask *rtGet(int id);
+int rtTaskCount();
+const char *rtPolicyName(RtPolicy policy);
+/** @} */
+
+/**
+ * @name Scheduling
+ * @{
+ */
+void rtStart(uint32_t now);
+uint32_t rtRelease(uint32_t now);
+uint32_t rtNextRelease(uint32_t now);
+int rtPick(uint32_t now);
+void rtCharge(int id, uint32_t ticks);
+bool rtComplete(int id, uint32_t now);
+/** @} */
+
+#endif
@@ -9,6 +9,22 @@
  * sliding window average, detects anomalies, displays real-time values on an I2C LCD,
  * and concurrently calculates prime numbers using FreeRTOS tasks pinned to ESP32 cores.
  *
+ * The primes come from a segmented sieve (PrimeSieve.h). The range is split between one
+ * prime task per core, and each task yields once per segment rather than once per number.
+ *
+ * The light detector publishes every sample through FreeRTOS queues. The LCD and alarm
+ * tasks block on their queue and run as soon as a sample arrives, instead of polling a
+ * shared flag under a semaphore. The alarm blinks the LED without blocking (BlinkAlarm.h), so
+ * it checks every sample as it arrives, even while an earlier alarm is still blinking.
+ *
+ * The LCD task draws into a shadow framebuffer (LcdFrame.h) and only the characters that
+ * changed go over I2C, so a new reading no longer clears and repaints the whole display.
+ *
+ * Each task times one unit of its work into a TaskProfile (TaskProfile.h): a read, an LCD
+ * update, an alarm check or a sieve segment. loop() prints the profiles with every task's
+ * stack high-water mark when PROFILE_DUMP_KEY arrives over serial, so the stack sizes
+ * below can be set from measurements.
+ *
  * @section author Author
  * Created by Sai Jayanth Kalisi, 2025
  *
@@ -17,8 +33,14 @@
 //========= LIBRARIES =========
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/queue.h>
 #include <Wire.h>
 #include <LiquidCrystal_I2C.h>
+#include <WindowedStats.h>
+#include <PrimeSieve.h>
+#include <LcdFrame.h>
+#include <TaskProfile.h>
+#include <BlinkAlarm.h>
 
 //========= PIN DEFINITIONS =========
 #define LED 1       ///< Output LED pin for anomaly alert
@@ -26,41 +48,89 @@
 #define SDA_PIN 20  ///< I2C Data Pin
 #define SCL_PIN 21  ///< I2C Clock Pin
 
+#define ALARM_QUEUE_LEN 8        ///< Samples the alarm task can fall behind by before samples are dropped
+#define ALARM_BLINKS 4           ///< LED blinks after the last anomalous sample
+#define ALARM_HALF_PERIOD_MS 200 ///< LED on, then off, time of each blink
+#define LATENCY_REPORT_EVERY 20  ///< Alarm task prints its sample-to-alarm latency every this many samples
+
+#define PRIME_LIMIT 5000         ///< Primes below this are found
+#define PRIME_TASKS 2            ///< Prime tasks, one per core, each sieving its share of the range
+#define PRIME_YIELD_MS 10        ///< Pause between sieve segments so the other tasks on the core run
+
+#define SAMPLE_PERIOD_MS 500     ///< Light read period; a read, LCD update or alarm check should finish within it
+#define TASK_STACK 4096          ///< Stack of every task, in bytes
+#define PROFILE_DUMP_KEY 'p'     ///< Serial command that prints the profiles
+
+//========= PROFILES =========
+/**
+ * @brief Profile index of each task
+ */
+enum {
+  PROFILE_LEDR,
+  PROFILE_LCD,
+  PROFILE_ANOMALY,
+  PROFILE_PRIME,                          ///< First of PRIME_TASKS
+  N_PROFILES = PROFILE_PRIME + PRIME_TASKS,
+};
+
 //========= LCD SETUP =========
 /**
  * @brief 16x2 I2C LCD at address 0x27
  */
 LiquidCrystal_I2C lcd(0x27, 16, 2);
+LcdFrame<16, 2> lcdFrame;  ///< What the LCD should show; only LCDTask draws on it
 
 //========= TASK HANDLES =========
 TaskHandle_t TaskLEDR_Handle = NULL;
 TaskHandle_t TaskLCD_Handle = NULL;
 TaskHandle_t TaskANOMALY_Handle = NULL;
-TaskHandle_t TaskPRIME_Handle = NULL;
+TaskHandle_t TaskPRIME_Handle[PRIME_TASKS] = {NULL};
+
+//========= STRUCTS =========
+/**
+ * @brief One light reading as published by the light detector
+ */
+typedef struct {
+  int lightLevel;        ///< Raw LEDR reading
+  int sma;               ///< Sliding window average including this reading
+  uint32_t timestampUs;  ///< micros() when the reading was taken
+} LightSample;
+
+/**
+ * @brief Share of the prime range handed to one prime task
+ */
+typedef struct {
+  uint32_t low;   ///< First number checked
+  uint32_t high;  ///< One past the last number checked
+  TaskProfile *profile;  ///< Where the task times its segments
+} PrimeRange;
 
 //========= GLOBAL VARIABLES =========
-static SemaphoreHandle_t semaphore;  ///< Semaphore for data synchronization
+static QueueHandle_t lcdMailbox;   ///< Holds only the newest sample; older unread samples are overwritten
+static QueueHandle_t alarmQueue;   ///< Every sample, in order, for the anomaly alarm
+volatile uint32_t droppedAlarmSamples = 0;  ///< Samples lost because the alarm queue was full
+BlinkAlarm alarmBlink(ALARM_BLINKS, ALARM_HALF_PERIOD_MS * 1000);  ///< LED pattern; only AnomalyAlarmTask touches it
 
-int newLightLevel = 0;       ///< Most recent light level that was read by LEDR
-int sma = 0;                 ///< current rolling SMA value
 const int WINDOW_SIZE = 5;   ///< Window size over which to calculate sliding mean
-int window[WINDOW_SIZE];     ///< Window of Window Size over which to calculate sliding mean
-int currIndex = 0;           ///< Current Index of Window to replace older value
-int currSum = 0;             ///< Current rolling sum
-bool updatedNewVal = false;  ///< whether or not a new value has been added to the window
+WindowedMoments<WINDOW_SIZE> lightWindow;  ///< Sliding window of light readings, updated in O(1) per read
+PrimeRange primeRanges[PRIME_TASKS];       ///< Range of each prime task, set in setup()
+TaskProfile profiles[N_PROFILES];          ///< Written by each task, printed by loop()
+TaskHandle_t profiledTasks[N_PROFILES];    ///< Task behind each profile, for its stack high-water mark
 
 //========= SETUP =========
 /**
  * @brief Arduino setup function
  * @details 1. Initialize pins, serial, LCD, etc
- *          2. Create binary semaphore for synchronizing light level data.
+ *          2. Create the LCD mailbox (length 1, overwritten) and the alarm queue.
  *          3. Create Tasks
  *          - Create the `Light Detector Task` and assign it to Core 0.
  *          - Create `LCD Task` and assign it to Core 0.
- *          - Create `Anomaly Alarm Task` and assign it to Core 1.
- *          - Create `Prime Calculation Task` and assign it to Core 1.
- *          4. Scheduler attempted before realizing that FreeRTOS automatically establishes a round robin system
- * Initializes peripherals, LCD, semaphore, and starts FreeRTOS tasks
+ *          - Create `Anomaly Alarm Task` and assign it to Core 1, one priority above the prime
+ *            task so a new sample preempts it immediately.
+ *          - Create one `Prime Calculation Task` per core, each with its share of 0 to PRIME_LIMIT.
+ *          4. Set up every task's profile with its deadline and stack size.
+ *          5. Scheduler attempted before realizing that FreeRTOS automatically establishes a round robin system
+ * Initializes peripherals, LCD, queues, and starts FreeRTOS tasks
  */
 void setup() {
   Serial.begin(115200);
@@ -73,22 +143,46 @@ void setup() {
   lcd.backlight();
   lcd.setCursor(0, 0);
 
-  semaphore = xSemaphoreCreateBinary();
-  xSemaphoreGive(semaphore);
+  lcdMailbox = xQueueCreate(1, sizeof(LightSample));
+  alarmQueue = xQueueCreate(ALARM_QUEUE_LEN, sizeof(LightSample));
+
+  profiles[PROFILE_LEDR].setup("LEDRread", SAMPLE_PERIOD_MS * 1000, TASK_STACK);
+  profiles[PROFILE_LCD].setup("UpdateLCD", SAMPLE_PERIOD_MS * 1000, TASK_STACK);
+  profiles[PROFILE_ANOMALY].setup("DetectAnomaly", SAMPLE_PERIOD_MS * 1000, TASK_STACK);
+  for (int i = 0; i < PRIME_TASKS; i++) profiles[PROFILE_PRIME + i].setup("FindPrime", PROFILE_UNSET, TASK_STACK);
 
-  xTaskCreatePinnedToCore(LightDetectorTask, "LEDRread", 4096, NULL, 1, &TaskLEDR_Handle, 0);
-  xTaskCreatePinnedToCore(LCDTask, "UpdateLCD", 4096, NULL, 1, &TaskLCD_Handle, 0);
-  xTaskCreatePinnedToCore(AnomalyAlarmTask, "DetectAnomaly", 4096, NULL, 1, &TaskANOMALY_Handle, 1);
-  xTaskCreatePinnedToCore(PrimeCalculationTask, "FindPrime", 4096, NULL, 1, &TaskPRIME_Handle, 1);
+  xTaskCreatePinnedToCore(LightDetectorTask, "LEDRread", TASK_STACK, NULL, 1, &TaskLEDR_Handle, 0);
+  xTaskCreatePinnedToCore(LCDTask, "UpdateLCD", TASK_STACK, NULL, 1, &TaskLCD_Handle, 0);
+  xTaskCreatePinnedToCore(AnomalyAlarmTask, "DetectAnomaly", TASK_STACK, NULL, 2, &TaskANOMALY_Handle, 1);
+  for (int i = 0; i < PRIME_TASKS; i++) {
+    primeRanges[i].low = PrimeSieve::splitPoint(0, PRIME_LIMIT, i, PRIME_TASKS);
+    primeRanges[i].high = PrimeSieve::splitPoint(0, PRIME_LIMIT, i + 1, PRIME_TASKS);
+    primeRanges[i].profile = &profiles[PROFILE_PRIME + i];
+    xTaskCreatePinnedToCore(PrimeCalculationTask, "FindPrime", TASK_STACK, &primeRanges[i], 1, &TaskPRIME_Handle[i], (PRIME_TASKS - 1 - i) % 2);
+    profiledTasks[PROFILE_PRIME + i] = TaskPRIME_Handle[i];
+  }
+  profiledTasks[PROFILE_LEDR] = TaskLEDR_Handle;
+  profiledTasks[PROFILE_LCD] = TaskLCD_Handle;
+  profiledTasks[PROFILE_ANOMALY] = TaskANOMALY_Handle;
   // xTaskCreatePinnedToCore(schedulerTask, "scheduleAll", 4096, NULL, 2, &TaskPRIME_Handle, 1); // Commented out scheduler
 }
 
 
 //========= LOOP =========
 /**
- * @brief Empty main loop since tasks handle all operations
+ * @brief Tasks handle all operations; the main loop only answers profile dump requests
+ * @details On PROFILE_DUMP_KEY, reads every task's stack high-water mark (bytes left at the deepest
+ *          point so far) and prints the profiles.
  */
-void loop() {}
+void loop() {
+  if (Serial.available() > 0 && Serial.read() == PROFILE_DUMP_KEY) {
+    for (int i = 0; i < N_PROFILES; i++) {
+      if (profiledTasks[i] != NULL) profiles[i].stackHighWater(uxTaskGetStackHighWaterMark(profiledTasks[i]));
+    }
+    profileDump(Serial, profiles, N_PROFILES);
+  }
+  vTaskDelay(pdMS_TO_TICKS(50));
+}
 
 // void schedulerTask(void *arg){
 //   while (1) {
@@ -104,33 +198,33 @@ void loop() {}
 //========= TASKS =========
 
 /**
- * @brief Reads light sensor data, updates sliding window average (SMA), and sets flags.
+ * @brief Reads light sensor data, updates sliding window average (SMA), and publishes the sample.
  * @details This is meant to run on Core 0
  *           1. Initialize Variables -> initialized as globals already
  *           2. Loop Continuously
  *            - Read light level from the photoresistor.
- *            - Take semaphore
- *            - Calculate the simple moving average and update variables.
- *            - Give semaphore to signal data is ready.
- *            - Delay
+ *            - Calculate the simple moving average. Only this task touches the window, so no lock is needed.
+ *            - Overwrite the LCD mailbox and append to the alarm queue, never waiting on either.
+ *            - Record the read in its profile, then delay
  * @param arg Unused task parameter
  */
 void LightDetectorTask(void *arg) {
   while (1) {
-    int newRead = analogRead(LEDR);
+    LightSample sample;
+    sample.timestampUs = micros();
+    profiles[PROFILE_LEDR].begin(sample.timestampUs);
+    sample.lightLevel = analogRead(LEDR);
 
-    xSemaphoreTake(semaphore, portMAX_DELAY);
-    currSum -= window[currIndex];
-    window[currIndex] = newRead;
-    currSum += newRead;
-    currIndex = (currIndex + 1) % WINDOW_SIZE;
+    lightWindow.add(sample.lightLevel);
+    sample.sma = lightWindow.mean();  // rounded, and over the reads so far until the window fills
 
-    newLightLevel = newRead;
-    sma = currSum / WINDOW_SIZE;  //This means that the first few are most likely anomalies
-    updatedNewVal = true;
+    xQueueOverwrite(lcdMailbox, &sample);
+    if (xQueueSend(alarmQueue, &sample, 0) != pdTRUE) {
+      droppedAlarmSamples++;
+    }
+    profiles[PROFILE_LEDR].end(micros());
 
-    xSemaphoreGive(semaphore);
-    vTaskDelay(pdMS_TO_TICKS(500));  //creating a 0.5 second delay between each new read;
+    vTaskDelay(pdMS_TO_TICKS(SAMPLE_PERIOD_MS));  //creating a 0.5 second delay between each new read;
   }
 }
 
@@ -139,32 +233,26 @@ void LightDetectorTask(void *arg) {
  * @details This is meant to run on Core 0
  *          1. Initialize Variables
  *          2. Loop Continuously
- *            - Wait for semaphore.
- *            - If data has changed, update the LCD with the new light level and SMA. -> Why should it matter if its different?
- *            - Give back the semaphore.
- *            - Delay
+ *            - Block until the mailbox holds a sample. If the LCD fell behind, only the newest
+ *              sample is there; stale ones were overwritten and are skipped.
+ *            - Draw the light level and SMA into the frame and flush it. Only the digits that
+ *              changed are sent; if neither value changed nothing is.
+ *            - Record the update in its profile.
  * @param arg Unused task parameter
  */
 void LCDTask(void *arg) {
-  int prevVal = -1;
-  int prevSMA = -1;
+  LightSample sample;
   while (1) {
-    xSemaphoreTake(semaphore, portMAX_DELAY);
-    if (updatedNewVal && prevVal != newLightLevel && prevSMA != sma) {
-      lcd.clear();
-      lcd.setCursor(0, 0);
-      lcd.print("LEDR READ: ");
-      lcd.print(newLightLevel);
-      lcd.setCursor(0, 1);
-      lcd.print("SMA: ");
-      lcd.print(sma);
-
-      prevVal = newLightLevel;
-      prevSMA = sma;
-      updatedNewVal = false;
-    }
-    xSemaphoreGive(semaphore);
-    vTaskDelay(pdMS_TO_TICKS(250));
+    xQueueReceive(lcdMailbox, &sample, portMAX_DELAY);
+    profiles[PROFILE_LCD].begin(micros());
+    lcdFrame.clear();
+    lcdFrame.print("LEDR READ: ");
+    lcdFrame.print(sample.lightLevel);
+    lcdFrame.setCursor(0, 1);
+    lcdFrame.print("SMA: ");
+    lcdFrame.print(sample.sma);
+    lcdFrame.flush(lcd);
+    profiles[PROFILE_LCD].end(micros());
   }
 }
 
@@ -172,38 +260,69 @@ void LCDTask(void *arg) {
  * @brief Monitors SMA value and triggers LED alert if value exceeds threshold
  * @details This is meant to run on Core 1
  *          1. Loop Continuously
- *             - Wait for semaphore.
- *             - Get SMA value
- *             - Give back the semaphore.
- *             - Check if SMA indicates a light anomaly (outside thresholds).
- *             - If anomaly detected, flash a LED signal.
- *             - Delay
+ *             - Block until the light detector publishes a sample, or until the next LED edge
+ *               is due while the alarm is blinking.
+ *             - Check every sample received, in order; an anomaly is never skipped for a newer reading.
+ *             - Record the time from the sample being read to this check.
+ *             - Check if SMA indicates a light anomaly (outside thresholds). If so, start the
+ *               blink pattern, or extend it if it is already running.
+ *             - Every LATENCY_REPORT_EVERY checks, print the average and worst sample-to-alarm latency.
+ *             - Record the check in its profile.
+ *             - Apply any LED edge that is due. Blinking never blocks, so no sample waits on it.
  * @param arg Unused task parameter
  */
 void AnomalyAlarmTask(void *arg) {
+  LightSample sample;
+  uint32_t latencySum = 0;
+  uint32_t latencyMax = 0;
+  uint32_t samplesSeen = 0;
+
   while (1) {
-    //Should be better, since I am not using sma elsewhere in task
-    xSemaphoreTake(semaphore, portMAX_DELAY);
-    int currentSMA = sma;
-    xSemaphoreGive(semaphore);
-
-    if (currentSMA > 3800 || currentSMA < 300) {
-      for (int i = 0; i < 4; i++) {
-        digitalWrite(LED, HIGH);
-        vTaskDelay(pdMS_TO_TICKS(200));
-        digitalWrite(LED, LOW);
-        vTaskDelay(pdMS_TO_TICKS(200));
-      }
-      vTaskDelay(1000);
-    } else {
-      vTaskDelay(pdMS_TO_TICKS(200));
+    uint32_t untilEdge = alarmBlink.untilNextEdge(micros());
+    TickType_t wait = (untilEdge == UINT32_MAX) ? portMAX_DELAY : pdMS_TO_TICKS((untilEdge + 999) / 1000);
+    if (xQueueReceive(alarmQueue, &sample, wait) == pdTRUE) {
+      checkSample(sample, latencySum, latencyMax, samplesSeen);
     }
+    if (alarmBlink.poll(micros())) {
+      digitalWrite(LED, alarmBlink.level() ? HIGH : LOW);
+    }
+  }
+}
+
+/**
+ * @brief One anomaly check of AnomalyAlarmTask
+ * @details Called for every sample received, in order, so an anomalous sample followed by a
+ *          normal one before the task runs still raises the alarm. Updates the latency
+ *          statistics and prints them every LATENCY_REPORT_EVERY checks.
+ * @param sample the sample just received
+ * @param latencySum running sum of sample-to-check latencies, in us
+ * @param latencyMax worst latency since the last report, in us
+ * @param samplesSeen checks since the last report
+ */
+void checkSample(const LightSample &sample, uint32_t &latencySum, uint32_t &latencyMax, uint32_t &samplesSeen) {
+  profiles[PROFILE_ANOMALY].begin(micros());
+  uint32_t now = micros();
+  uint32_t latency = now - sample.timestampUs;
+  latencySum += latency;
+  if (latency > latencyMax) latencyMax = latency;
+  samplesSeen++;
+  if (samplesSeen == LATENCY_REPORT_EVERY) {
+    Serial.printf("Sample-to-alarm latency: avg %lu us, max %lu us, dropped %lu\n",
+                  (unsigned long)(latencySum / samplesSeen), (unsigned long)latencyMax,
+                  (unsigned long)droppedAlarmSamples);
+    latencySum = latencyMax = samplesSeen = 0;
   }
+
+  if (sample.sma > 3800 || sample.sma < 300) {
+    alarmBlink.trigger(now);
+  }
+  profiles[PROFILE_ANOMALY].end(micros());
 }
 
 /**
  * @brief Checks whether a number is prime
- * @details This is a helper functionf for Prime Calculation Task
+ * @details Trial division up to and including sqrt(n). PrimeCalculationTask uses PrimeSieve;
+ *          this is kept for spot checks.
  * @param n Integer to check
  * @return true if prime, false otherwise
  */
@@ -211,29 +330,39 @@ bool isPrime(int n) {
   if (n <= 1) {
     return false;
   }
-  for (int i = 2; i * i < n; i++) {
+  for (int i = 2; i * i <= n; i++) {
     if (n % i == 0) return false;
   }
   return true;
 }
 
 /**
- * @brief Calculates prime numbers from 0 to 5000 in background
- * @details This is meant to run on Core 1
- *            1. Loop from 2 to 5000
- *             - Check if the current number is prime.
- *             - If prime, print the number to the serial monitor.
- * @param arg Unused task parameter
+ * @brief Calculates the prime numbers of one share of 0 to PRIME_LIMIT in background
+ * @details One instance runs on each core.
+ *            1. Sieve the range one segment at a time.
+ *             - Print every prime of the segment to the serial monitor, one line per write so
+ *               the two tasks' lines do not interleave.
+ *             - Record the segment in the range's profile and yield for PRIME_YIELD_MS before the next.
+ *            The sieve keeps its segment (4 KB) off the task stack.
+ * @param arg PrimeRange to search
  */
-
 void PrimeCalculationTask(void *arg) {
-  for (int i = 0; i < 5000; i++) {
-    if (isPrime(i)) {
-      Serial.print("Prime found: ");
-      Serial.println(i);
-    }
-    vTaskDelay(pdMS_TO_TICKS(10));
+  const PrimeRange *range = (const PrimeRange *)arg;
+  PrimeSieve *sieve = new PrimeSieve(range->low, range->high);
+
+  while (sieve->ok()) {
+    uint32_t start = micros();
+    if (!sieve->nextSegment()) break;  // begin only for a segment that will get its end
+    range->profile->begin(start);
+    sieve->forEachPrime([](uint32_t p) {
+      char line[32];
+      snprintf(line, sizeof(line), "Prime found: %lu\n", (unsigned long)p);
+      Serial.print(line);
+    });
+    range->profile->end(micros());
+    vTaskDelay(pdMS_TO_TICKS(PRIME_YIELD_MS));
   }
 
+  delete sieve;
   vTaskSuspend(NULL);
 }
\ No newline at end of file
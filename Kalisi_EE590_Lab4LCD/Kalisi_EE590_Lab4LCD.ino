@@ -30,84 +30,139 @@
 
 // ========== DEFINEs =========== //
 #define I2C_ADDR      0x27 ///< I2C address of the LCD (apparently can be from 0x20 to 0x27)
+// Bus clock. The PCF8574 on most backpacks is only rated for 100 kHz; define LCD_I2C_FAST
+// for a PCF8574A or another expander whose datasheet rates it for 400 kHz.
+#ifdef LCD_I2C_FAST
+#define I2C_HZ        400000 ///< Fast-mode bus clock, for a 400 kHz rated expander only
+#else
+#define I2C_HZ        100000 ///< Standard-mode bus clock, within the PCF8574's rating
+#endif
 #define LCD_BACKLIGHT 0x08 ///< LCD backlight control bit (enabling on, iirc)
 #define ENABLE        0x04 ///< Enable datalatching bit (will be used for latching via pulse enable)
 #define RS            0x01 ///< Register select bit  (0 = command, 1 = data)
 
+#define LCD_BATCH_BYTES  120  ///< Expander bytes per I2C transmission; the ESP32 Wire buffer holds 128
+#define LCD_EXEC_US      50   ///< Time the HD44780 needs per instruction: 37 us typical, with margin for a slow oscillator
+#define LCD_SLOW_EXEC_US 2000 ///< Clear display and return home take 1.52 ms
+#define LCD_BYTE_NS (9000000000ULL / I2C_HZ) ///< Bus time of one expander byte with its ACK bit
+// Expander bytes between the latch ending one instruction and the first latch of the next:
+// enable high and enable low, plus idle bytes until LCD_EXEC_US has passed on the bus.
+#define LCD_GAP_BYTES ((LCD_EXEC_US * 1000ULL + LCD_BYTE_NS - 1) / LCD_BYTE_NS)
+#define LCD_PAD_BYTES (LCD_GAP_BYTES > 2 ? LCD_GAP_BYTES - 2 : 0)
+
 // ========== CONSTS and GLOBALs =========== //
 
 int cursorCol = 0; ///< Current Column Position of LED Cursor
 int cursorRow = 0; ///< Current Row Position of LED Cursor
 
+uint8_t lcdBatch[LCD_BATCH_BYTES]; ///< Expander bytes waiting for the next transmission
+size_t lcdBatchLen = 0;            ///< Bytes in lcdBatch
+uint8_t lcdLastData = 0;           ///< Last expander byte queued, without the backlight bit
+uint8_t lcdLastMode = 0xFF;        ///< RS level on the expander; 0xFF until the first byte
+int lcdPendingPad = 0;             ///< Idle bytes owed before the next instruction is latched
+
 // ========== HELPER FUNCTIONs =========== //
 
 /**
  * @name I2C LCD Transmission
+ * The LCD is driven through a PCF8574 expander, one output byte per I2C data byte. Rather
+ * than one transmission per output byte, every byte is queued in lcdBatch and the batch goes
+ * out as a single transmission from lcdFlush, so a string costs about one transmission.
+ * Timing comes from the bus: each byte holds the expander outputs for 9 bit times, which is
+ * the enable pulse width, and idle bytes between instructions cover the HD44780 execution
+ * time. Only clear and home, which take milliseconds, still wait on the CPU.
  * @{
  */
 
+/**
+ * Name: lcdFlush
+ * @brief Sends every queued expander byte in one I2C transmission.
+ */
+void lcdFlush() {
+  if (lcdBatchLen == 0) return;
+  Wire.beginTransmission(I2C_ADDR);
+  Wire.write(lcdBatch, lcdBatchLen);
+  Wire.endTransmission();
+  lcdBatchLen = 0;
+}
+
 /**
  * Name: i2cSend
- * @brief Sends a byte to the LCD via I2C with the backlight bit set if enabled.
+ * @brief Queues a byte for the LCD with the backlight bit set, flushing first if the batch is full.
  * @param data The byte to send to the LCD, part nibble, part information
  */
 void i2cSend(uint8_t data) {
-  Wire.beginTransmission(I2C_ADDR);
-  Wire.write(data | LCD_BACKLIGHT);
-  Wire.endTransmission();
+  if (lcdBatchLen == LCD_BATCH_BYTES) lcdFlush();
+  lcdBatch[lcdBatchLen++] = data | LCD_BACKLIGHT;
+  lcdLastData = data;
 }
 
 /**
  * Name: pulseEnable
  * @brief Pulses the enable pin to latch data into the LCD.
+ * @details The enable high byte lasts a full byte time on the bus, well over the 450 ns
+ *      minimum pulse, so no delay is needed. The LCD latches on the falling edge.
  * @param data The byte to latch with ENABLE bit toggled.
  */
 void pulseEnable(uint8_t data) {
   i2cSend(data | ENABLE);
-  delayMicroseconds(1); 
   i2cSend(data & ~ENABLE);
-  delayMicroseconds(1);
 }
 
 /**
  * Name: sendNibble
  * @brief Sends a 4-bit nibble to the LCD.
+ * @details RS has to settle before enable rises, so a byte with the new RS and enable low is
+ *      only sent first when RS changes; data lines only need to be stable at the falling edge.
  * @param nibble The upper or lower 4 bits of the data/command.
  * @param mode command mode or data mode, 0 for command, RS for data.
  */
 void sendNibble(uint8_t nibble, uint8_t mode) {
   uint8_t data = (nibble << 4) | mode;
-  i2cSend(data);
+  if (mode != lcdLastMode) {
+    i2cSend(data);
+    lcdLastMode = mode;
+  }
   pulseEnable(data);
 }
 
 /**
  * Name: sendByte
  * @brief Sends a full 8-bit byte to the LCD by splitting it into two nibbles.
+ * @details Queues the idle bytes owed to the previous instruction first, so the LCD has
+ *      finished it before this one is latched.
  * @param value value to send.
  * @param mode command mode or data mode, 0 for command, RS for data.
  */
 void sendByte(uint8_t value, uint8_t mode) {
+  for (; lcdPendingPad > 0; lcdPendingPad--) i2cSend(lcdLastData);
   sendNibble(value >> 4, mode);
-  delayMicroseconds(50); // Hope I am able to use delays here to pause, between sending nibbles.
   sendNibble(value & 0x0F, mode);
-  delayMicroseconds(50); // delays again
+  lcdPendingPad = LCD_PAD_BYTES;
 }
 
 /**
  * Name: lcdCommand
  * @brief Sends a command byte to the LCD via the sendByte Function.
  * Is different from the lcd Write char because of RS
+ * @details Clear display and return home are flushed and waited for here, since their
+ *      execution time is too long to fill with idle bytes.
  * @param cmd The command byte.
  */
 void lcdCommand(uint8_t cmd) {
   sendByte(cmd, 0);
+  if (cmd <= 0x03) {
+    lcdFlush();
+    delayMicroseconds(LCD_SLOW_EXEC_US);
+    lcdPendingPad = 0;
+  }
 }
 
 /**
  * Name: lcdWriteChar
  * @brief Writes a single character to the LCD at the current cursor location.
  * Is different from the lcd Command because of RS
+ * @details Only queued; it reaches the LCD with the next lcdFlush.
  * @param ch The character to display.
  */
 void lcdWriteChar(char ch) {
@@ -143,24 +198,25 @@ void lcdSetCursor(int col, int row) {
  */
 void setup() {
   Wire.begin(20, 21);
+  Wire.setClock(I2C_HZ);
   delay(50); // delay used to ensure wire is initialized as needed. Online says is useful for this particular LCD
 
   // found online that this triple-write is specified as required. Not sure as to why though. Maybe takes some time to load? 
   // I initially tried with just one, (the first one). didnt work
   // Tried just 4 bit, didnt work. Interesting
-  sendNibble(0x03, 0); delay(5); //8-bit mode
-  sendNibble(0x03, 0); delayMicroseconds(150); //reinforces 8-bit
-  sendNibble(0x03, 0); delayMicroseconds(150); //absolutely ensures 8-bit
-  sendNibble(0x02, 0); // 4-bit mode
+  sendNibble(0x03, 0); lcdFlush(); delay(5); //8-bit mode
+  sendNibble(0x03, 0); lcdFlush(); delayMicroseconds(150); //reinforces 8-bit
+  sendNibble(0x03, 0); lcdFlush(); delayMicroseconds(150); //absolutely ensures 8-bit
+  sendNibble(0x02, 0); lcdFlush(); delayMicroseconds(LCD_EXEC_US); // 4-bit mode
 
   lcdCommand(0x28); // Function set
   lcdCommand(0x0C); // Display ON
   lcdCommand(0x06); // Entry mode
-  lcdCommand(0x01); // should clear
-  delay(2); 
+  lcdCommand(0x01); // should clear, waits for it
   cursorCol = 0;
   cursorRow = 0;
   lcdSetCursor(cursorCol, cursorRow);
+  lcdFlush();
   Serial.begin(9600);
 }
 
@@ -169,6 +225,7 @@ void setup() {
  * @brief  loop to be run repeatedly. Equivalent to running everything in main whith a while(1).
  * @details Reads characters from Serial and displays them on the LCD.
  *        Handles newline and wrapping between two rows.
+ *        Everything that has arrived is queued, then sent in one transmission.
  */
 void loop() {
   while (Serial.available() > 0) {
@@ -190,6 +247,7 @@ void loop() {
       }
     }
   }
+  lcdFlush();
 }
 
 /**
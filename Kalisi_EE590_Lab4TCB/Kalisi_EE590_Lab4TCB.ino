@@ -7,6 +7,10 @@
  * This sketch holds the implementation corresponding to the Lab document for task 2.
  * Lab 4 arduino ESP 32 File.
  *
+ * Every task call made by scheduler(), and the LCD drain in loop(), is timed on timer group 0
+ * (TaskProfile.h): min/avg/max, a log2 histogram and calls longer than their deadline. Send
+ * PROFILE_DUMP_KEY over serial to print the profiles.
+ *
  * @section circuit Circuit
  * - LCD connected to SDA an SCL at pin 20 and 21.
  * - green LED connected at pin 1
@@ -16,6 +20,7 @@
  * - arduino-esp32 (https://github.com/espressif/arduino-esp32)
  * - Wire
  * - LiquidCrystal_I2C
+ * - EE590Common (LcdQueue, LcdFrame, MonotonicClock, TaskProfile)
  *
  * @section notes Notes
  * - Comments are Doxygen compatible.
@@ -34,22 +39,26 @@
 #include "soc/timer_group_reg.h" ///< Required for Timing
 #include "Wire.h" ///< Required for I2C communication
 #include <LiquidCrystal_I2C.h> ///< Required for Quick LCD usage
+#include <LcdQueue.h> ///< LCD requests queued by the tasks, sent from the idle part of loop()
+#include <MonotonicClock.h> ///< Timer group 0 read as microseconds, for the profiles
+#include <TaskProfile.h> ///< Per-task execution time statistics
+#include "TCBScheduler.h" ///< Ready-queue scheduler core, task states and TCBStruct
 
 // ========== CONSTS and DEFINEs =========== //
 const int LED1 = 1; ///< Green LED pin
 const int LED2 = 2; ///< Yellow/Orange LED pin
 
 #define TIMER_DIVIDER_VAL 80 ///< Timer partition
-#define N_MAX_TASKS       4 ///< Max number of tasks to consider. Should theoretically be 5, with last as NULL, but ignoring that for now
-
-// =============== ENUMS =============== //
-
-typedef enum taskstate{
-  STATE_INACTIVE = 0,
-  STATE_RUNNING,
-  STATE_READY,
-  STATE_WAITING, // not really used, kept from ICTE
-} taskstate; ///< All possible states for Tasks to be 
+#define N_LAB_TASKS       4 ///< Tasks this sketch registers. The scheduler core holds up to TCB_MAX_TASKS
+#define LAB_TASK_PRIORITY 1 ///< Shared priority, so the lab tasks take turns going first each round
+#define LCD_QUEUE_LEN     16 ///< LCD commands the tasks can queue between two drains
+#ifndef LOOP_IDLE_US
+#define LOOP_IDLE_US      15000 ///< Idle time per loop pass; the LCD drain is taken out of it
+#endif
+#define TASK_DEADLINE_US  2000 ///< A task call longer than this counts as an overrun
+#define PROFILE_LCD_DRAIN N_LAB_TASKS ///< Profile of the LCD drain, after the tasks'
+#define N_PROFILES        (N_LAB_TASKS + 1) ///< Profiles kept
+#define PROFILE_DUMP_KEY  'p' ///< Serial command that prints the profiles
 
 // =============== STRUCTS =============== //
 struct LEDControl {
@@ -88,27 +97,28 @@ struct PrintControl {
   bool isDone;          ///< if print is complete
 }; ///< Required variables for controlling Print of all alphabets. Might att len of "toPrint" variable to be more robust.
 
-typedef struct TCBstruct {
-  void (*ftpr)(void *p);  ///< Function pointer
-  void *arg_ptr;          ///< Arguements for the function
-  taskstate state;        ///< current state of task
-  int pid;                ///< Task ID
-  int priority;           ///< Task Priority. It is set by scheduler.
-  unsigned int delay;     ///< Delay after task. Not really used. Holdover from ICTE
-} TCBStruct; ///< All possible variables needed to develop a thread control block
-
 // =============== GLOBAL VARIABLES =============== //
 
 LCDControl lcdControl = {1, 0, 500, false};                                       ///< LCD Control task pre-initialization
 LiquidCrystal_I2C lcd(0x27, 16, 2);                                               ///< LCD pre-initialization
+LcdQueue<LCD_QUEUE_LEN, 16, 2> lcdQueue;                                          ///< LCD requests, drained to the LCD by loop()
 LEDControl led1 = {LED1, true, LOW, 0, 0, 62500, 0, false};                       ///< LED1 task pre-initialization
 LEDFreqControl ledcControl = {LED2, 100, 11, 0, 0, 1000000, false};               ///< ledc-Control task pre-initialization
 PrintControl printTask = {0, 1000000, 0, "ABCDEFGHIJKLMNOPQRSTUVWXYZ", false};    ///< print task pre-initialization
 
-TCBStruct TaskList[N_MAX_TASKS]; ///< list of all tasks 
+TCBHandle TaskHandles[N_LAB_TASKS]; ///< handles of the registered tasks, in registration order
+MonotonicClock hwClock(0, 1);        ///< Timer group 0, counting at 1 MHz once setup() configures it
+TaskProfile profiles[N_PROFILES];    ///< One per task, in TaskHandles order, then the LCD drain
+TaskProfile *slotProfiles[TCB_MAX_TASKS]; ///< Profile of the task in each scheduler slot, or NULL
+int roundTurn = 0;                   ///< Tasks completed so far this round; the next one's turn
+
+// =============== PROTOTYPES =============== //
+// Declared here as well as generated by the IDE so the sketch also builds as plain C++ (host/sim).
 
-int baseTaskIndex = 0;                ///< task priority modifier
-volatile int currentRunningTask = -1; ///< current Task index
+void handleLEDBlinking(LEDControl& led);
+void resetTasks();
+void reportCompleted(const char *name);
+TaskProfile *profileOf(const TCBStruct *task);
 
 // =============== TASK FUNCTIONS =============== //
 
@@ -128,13 +138,8 @@ volatile int currentRunningTask = -1; ///< current Task index
  */
 void taskA(void *p) {
   handleLEDBlinking(led1);
-  if (led1.isDone && TaskList[0].state != STATE_INACTIVE) {
-    TaskList[0].state = STATE_INACTIVE;
-    currentRunningTask = -1;
-
-    Serial.print("Task Blink LED, priority ");
-    Serial.print(TaskList[0].priority);
-    Serial.println(" Completed");
+  if (led1.isDone) {
+    reportCompleted("Task Blink LED");
   }
 }
 
@@ -145,35 +150,32 @@ void taskA(void *p) {
  * @details Modified version of TaskA logic, but for LCD Control
  *          if task is done, returns
  *          if time threshold passes, count is printed and updated, threshold is reset. 
- *          if count surpasses threshold, task is considered done, and task status is updated, printed as complete, with priority
+ *          The count is queued on lcdQueue, which returns at once; loop() sends it to the LCD
+ *          after the scheduler tick, so the task never waits on I2C.
+ *          if count surpasses threshold, task is considered done, and task status is updated, printed as complete, with its turn in the round
  */
 void taskB(void *p) {
   unsigned long currentMillis = millis();
 
   if (lcdControl.isDone) {
-    TaskList[1].state = STATE_INACTIVE; // might not be needed due to threshold logic. Keeping it here for now.
+    tcbComplete(tcbCurrent()); // might not be needed due to threshold logic. Keeping it here for now.
     return;
   }
 
   if (currentMillis - lcdControl.previousMillis >= lcdControl.interval) {
     lcdControl.previousMillis = currentMillis;
-    lcd.setCursor(7, 0);
-    lcd.print("   ");
-    delayMicroseconds(20000);
-    lcd.setCursor(7, 0);
-    lcd.print(lcdControl.currentCount);
-    delayMicroseconds(20000);
+    lcdQueue.beginUpdate();
+    lcdQueue.setCursor(7, 0);
+    lcdQueue.print(lcdControl.currentCount);
+    lcdQueue.clearToEnd();
+    lcdQueue.endUpdate();
 
     lcdControl.currentCount++;
 
     //threshold to meet to be considered complete
     if (lcdControl.currentCount > 10) {
       lcdControl.isDone = true;
-      TaskList[1].state = STATE_INACTIVE;
-      currentRunningTask = -1;
-      Serial.print("Task LCD Count, priority ");
-      Serial.print(TaskList[1].priority);
-      Serial.println(" Completed");
+      reportCompleted("Task LCD Count");
     }
   }
 }
@@ -186,12 +188,12 @@ void taskB(void *p) {
  *          if task is done, returns
  *          LED is constantly outputted at a given frequency
  *          if time threshold passes, intensity is and updated, time threshold is reset. 
- *          if count surpasses number of intensities to check, task is considered done, and task status is updated, printed as complete, with priority
+ *          if count surpasses number of intensities to check, task is considered done, and task status is updated, printed as complete, with its turn in the round
  */
 void taskC(void *p) {
   unsigned long currentMicros = micros();
   if (ledcControl.isDone) {
-    TaskList[2].state = STATE_INACTIVE; // might not be needed due to threshold logic. Keeping it here for now.
+    tcbComplete(tcbCurrent()); // might not be needed due to threshold logic. Keeping it here for now.
     return;
   }
   
@@ -204,11 +206,7 @@ void taskC(void *p) {
     if(ledcControl.variousFreqsChecked > 10) {
       ledcControl.variousFreqsChecked = 0;
       ledcControl.isDone = true;
-      TaskList[2].state = STATE_INACTIVE;
-      currentRunningTask = -1;
-      Serial.print("Task LED Intensity, priority ");
-      Serial.print(TaskList[2].priority);
-      Serial.println(" Completed");
+      reportCompleted("Task LED Intensity");
     }
   }
 }
@@ -220,12 +218,12 @@ void taskC(void *p) {
  * @details Modified version of TaskA logic, but for printing alphabet
  *          if task is done, returns
  *          if time threshold passes, value is printed and updated, time threshold is reset. 
- *          if count surpasses number of letters to check, task is considered done, and task status is updated, printed as complete, with priority
+ *          if count surpasses number of letters to check, task is considered done, and task status is updated, printed as complete, with its turn in the round
  */
 void taskD(void *p){
   unsigned long currentMicros = micros();
   if (printTask.isDone) {
-    TaskList[3].state = STATE_INACTIVE; // might not be needed due to threshold logic. Keeping it here for now.
+    tcbComplete(tcbCurrent()); // might not be needed due to threshold logic. Keeping it here for now.
     return;
   }
 
@@ -237,15 +235,32 @@ void taskD(void *p){
     if(printTask.currentCount > 25) {
       Serial.println();
       ledcControl.isDone = true;
-      TaskList[3].state = STATE_INACTIVE;
-      currentRunningTask = -1;
-      Serial.print("Alphabet Print, priority ");
-      Serial.print(TaskList[3].priority);
-      Serial.println(" Completed");
+      reportCompleted("Alphabet Print");
     }
   }
 }
 
+/**
+ * Name: reportCompleted
+ * @brief Marks the running task complete and prints its name, pid and turn
+ * @param name task name to print
+ * @details Replaces the per-task index bookkeeping: the task finds its own TCB through tcbCurrent()
+ *          The lab tasks share one priority, so the turn (1 for the task that ran first this
+ *          round) is printed instead, as the rotating priority was before.
+ */
+void reportCompleted(const char *name) {
+  TCBStruct *self = tcbCurrent();
+  if (self == NULL) return;
+  tcbComplete(self);
+
+  Serial.print(name);
+  Serial.print(", pid ");
+  Serial.print(self->pid);
+  Serial.print(", turn ");
+  Serial.print(++roundTurn);
+  Serial.println(" Completed");
+}
+
 /**
  * @}
  */
@@ -278,48 +293,48 @@ void handleLEDBlinking(LEDControl& led) {
   }
 }
 
+// =============== PROFILING =============== //
+
+/**
+ * Name: profileOf
+ * @brief Profile of a registered lab task, or NULL
+ * @param task TCB of the task
+ * @details Looked up by scheduler slot, filled in by setup(), so a dispatch costs no search
+ */
+TaskProfile *profileOf(const TCBStruct *task) {
+  int slot = tcbSlot(task);
+  return (slot >= 0) ? slotProfiles[slot] : NULL;
+}
+
 // =============== SCHEDULER =============== //
 /**
  * Name: scheduler
  * @brief handles running tasks in given order
  * @details if no task is running:
- *           - loops through all tasks and runs the first one that is ready, given the current offset it needs to follow
- *           - If state is ready runs only that task and nothing else for the cycle
+ *           - takes the first task of the highest non-empty priority from the ready lists (O(1), see TCBScheduler.h)
+ *           - runs only that task and nothing else for the cycle
  *          If a task is running:
- *           - Calls just that task
- *          If all tasks have run, calls resetTasks() function and updates starting index
+ *           - Calls just that task, timing the call into the task's profile
+ *          If no task is ready or running any more, calls resetTasks(), which also moves the starting task on by one
  */
 void scheduler() {
-  if (currentRunningTask == -1) {
-    for (int i = 0; i < N_MAX_TASKS; i++) {
-      int idx = (baseTaskIndex + i) % N_MAX_TASKS;
-      if (TaskList[idx].state == STATE_READY) {
-        Serial.print("Started task at ");
-        Serial.println(idx);
-        TaskList[idx].state = STATE_RUNNING;
-        currentRunningTask = idx;
-        TaskList[idx].ftpr(TaskList[idx].arg_ptr);
-        TaskList[idx].priority = i + 1;
-        break;  // Only one task runs at a time
-      }
+  TCBStruct *current = tcbCurrent();
+  if (current == NULL) {
+    current = tcbDispatch();
+    if (current != NULL) {
+      Serial.print("Started task pid ");
+      Serial.println(current->pid);
     }
-  } else {
-    // Serial.print("Continuing Task at ");
-    // Serial.println(currentRunningTask);
-    TaskList[currentRunningTask].ftpr(TaskList[currentRunningTask].arg_ptr);
   }
-
-  // Check if all are inactive, then rotate
-  bool allDone = true;
-  for (int i = 0; i < N_MAX_TASKS; i++) {
-    if (TaskList[i].state != STATE_INACTIVE) {
-      allDone = false;
-      break;
-    }
+  if (current != NULL) {
+    TaskProfile *profile = profileOf(current);
+    if (profile != NULL) profile->begin((uint32_t)hwClock.micros());
+    current->ftpr(current->arg_ptr);
+    if (profile != NULL) profile->end((uint32_t)hwClock.micros());
   }
 
-  if (allDone) {
-    baseTaskIndex = (baseTaskIndex + 1) % N_MAX_TASKS;
+  // active count is kept by the scheduler core as tasks change state
+  if (tcbActiveCount() == 0) {
     resetTasks();
   }
 }
@@ -328,7 +343,7 @@ void scheduler() {
  * Name: resetTasks
  * @brief resets all tasks to a working state
  * @details goes through all structs and sets isDone to false, and ensures all reach their starting values
- *          Sets the state of all tasks to STATE_READY, and dictates that no task is currently running
+ *          Releases all tasks for the next round; the round starts one task later than the last
  */
 void resetTasks() {
   //resetting blink
@@ -352,10 +367,8 @@ void resetTasks() {
   printTask.previousMicros = 0;
   printTask.isDone = false;
 
-  for (int i = 0; i < N_MAX_TASKS; i++) {
-    TaskList[i].state = STATE_READY;
-  }
-  currentRunningTask = -1;
+  roundTurn = 0;
+  tcbReleaseAll();
 }
 
 // =============== SETUP =============== //
@@ -364,7 +377,7 @@ void resetTasks() {
  * Name: setup
  * @brief sets up all pins and initializes tasks to the task list. 
  * @details Starts up serial, LED pins, I2C pins, LCD pins and Timer.
- *          Initializes array of tasks and their primary values
+ *          Registers the tasks with the scheduler core; their handles are their pids, and sets up their profiles
  */
 void setup() {
   Serial.begin(115200);
@@ -375,8 +388,8 @@ void setup() {
   Wire.begin(20, 21);
   lcd.init();
   lcd.backlight();
-  lcd.setCursor(0, 0);
-  lcd.print("Count: ");
+  lcdQueue.print("Count: ");
+  lcdQueue.drain(lcd);
 
   ledcAttach(ledcControl.pin, ledcControl.freq, ledcControl.resolution);
 
@@ -384,19 +397,41 @@ void setup() {
   *((volatile uint32_t *) TIMG_T0CONFIG_REG(0)) = timer_config;
   *((volatile uint32_t *) TIMG_T0UPDATE_REG(0)) = 1;
 
-  TaskList[0] = {taskA, NULL, STATE_READY, 1, 0, 0};
-  TaskList[1] = {taskB, NULL, STATE_READY, 2, 0, 0};
-  TaskList[2] = {taskC, NULL, STATE_READY, 3, 0, 0};
-  TaskList[3] = {taskD, NULL, STATE_READY, 4, 0, 0};
+  tcbClear();
+  roundTurn = 0;
+  TaskHandles[0] = tcbRegister(taskA, NULL, LAB_TASK_PRIORITY);
+  TaskHandles[1] = tcbRegister(taskB, NULL, LAB_TASK_PRIORITY);
+  TaskHandles[2] = tcbRegister(taskC, NULL, LAB_TASK_PRIORITY);
+  TaskHandles[3] = tcbRegister(taskD, NULL, LAB_TASK_PRIORITY);
+
+  static const char *const profileNames[N_PROFILES] = {"taskA", "taskB", "taskC", "taskD", "lcdDrain"};
+  for (int i = 0; i < N_LAB_TASKS; i++) {
+    profiles[i].setup(profileNames[i], TASK_DEADLINE_US);
+    int slot = tcbSlot(tcbGet(TaskHandles[i]));  // -1 if registration failed
+    if (slot >= 0) slotProfiles[slot] = &profiles[i];
+  }
+  profiles[PROFILE_LCD_DRAIN].setup(profileNames[PROFILE_LCD_DRAIN], LOOP_IDLE_US);
 }
 
 // =============== MAIN LOOP =============== //
 /**
  * Name: loop
  * @brief loop equivalent to while(1), runs scheduler every cycle and updates timer
+ * @details The idle part of the pass first sends the queued LCD requests, then waits out the
+ *          rest of LOOP_IDLE_US, so the LCD costs no task time and does not lengthen the pass.
+ *          A PROFILE_DUMP_KEY received over serial prints the profiles.
  */
 void loop() {
   *((volatile uint32_t *) TIMG_T0UPDATE_REG(0)) = 1; 
   scheduler(); 
-  delayMicroseconds(15000);
+
+  unsigned long idleStart = micros();
+  TaskProfile &drainProfile = profiles[PROFILE_LCD_DRAIN];
+  drainProfile.begin((uint32_t)hwClock.micros());
+  if (lcdQueue.drain(lcd) > 0) drainProfile.end((uint32_t)hwClock.micros());
+  if (Serial.available() > 0 && Serial.read() == PROFILE_DUMP_KEY) {
+    profileDump(Serial, profiles, N_PROFILES);
+  }
+  unsigned long spent = micros() - idleStart;
+  delayMicroseconds(spent < LOOP_IDLE_US ? LOOP_IDLE_US - spent : 0);
 }
\ No newline at end of file
@@ -0,0 +1,333 @@
+/**
+ * @file TCBScheduler.cpp
+ * @brief Implementation of the Lab 4 TCB scheduler core. See TCBScheduler.h.
+ */
+#include "TCBScheduler.h"
+
+#include <string.h>
+
+#define TCB_SLOT_BITS 6 ///< log2(TCB_MAX_TASKS); the low bits of pid - 1 are the slot
+#define TCB_NONE      (-1) ///< Empty link
+
+static_assert((1 << TCB_SLOT_BITS) == TCB_MAX_TASKS, "TCB_SLOT_BITS must match TCB_MAX_TASKS");
+static_assert(TCB_PRIORITY_LEVELS <= 32, "one bitmap word holds the ready levels");
+
+static TCBStruct tcbPool[TCB_MAX_TASKS];            ///< Task slots
+static int16_t readyHead[TCB_PRIORITY_LEVELS];      ///< First ready slot per priority
+static int16_t readyTail[TCB_PRIORITY_LEVELS];      ///< Last ready slot per priority
+static uint32_t readyLevels = 0;                    ///< Bit p set when priority p has a ready task
+static int16_t freeHead = TCB_NONE;                 ///< First free slot, chained through regNext
+static int16_t regHead = TCB_NONE;                  ///< Registration ring; first task of the current round
+static int16_t runningSlot = TCB_NONE;              ///< Slot of the running task
+static size_t activeCount = 0;                      ///< Tasks that are ready or running
+static size_t taskCount = 0;                        ///< Registered tasks
+static uint32_t rounds = 0;                         ///< tcbReleaseAll calls
+static bool initialised = false;
+
+// =============== INTERNALS =============== //
+
+/**
+ * Name: readyPush
+ * @brief Appends a slot to the ready list of its priority.
+ */
+static void readyPush(int16_t slot) {
+  TCBStruct *t = &tcbPool[slot];
+  int level = t->priority;
+  t->next = TCB_NONE;
+  t->prev = readyTail[level];
+  if (readyTail[level] == TCB_NONE) {
+    readyHead[level] = slot;
+  } else {
+    tcbPool[readyTail[level]].next = slot;
+  }
+  readyTail[level] = slot;
+  readyLevels |= 1u << level;
+}
+
+/**
+ * Name: readyRemove
+ * @brief Unlinks a slot from the ready list of its priority.
+ */
+static void readyRemove(int16_t slot) {
+  TCBStruct *t = &tcbPool[slot];
+  int level = t->priority;
+  if (t->prev == TCB_NONE) {
+    readyHead[level] = t->next;
+  } else {
+    tcbPool[t->prev].next = t->next;
+  }
+  if (t->next == TCB_NONE) {
+    readyTail[level] = t->prev;
+  } else {
+    tcbPool[t->next].prev = t->prev;
+  }
+  t->next = t->prev = TCB_NONE;
+  if (readyHead[level] == TCB_NONE) {
+    readyLevels &= ~(1u << level);
+  }
+}
+
+/**
+ * Name: slotOf
+ * @brief Slot of a valid handle, or TCB_NONE for a stale or malformed one.
+ */
+static int16_t slotOf(TCBHandle handle) {
+  if (handle <= 0) return TCB_NONE;
+  int16_t slot = (int16_t)((handle - 1) & (TCB_MAX_TASKS - 1));
+  const TCBStruct *t = &tcbPool[slot];
+  if (!initialised || !t->registered || t->pid != handle) return TCB_NONE;
+  return slot;
+}
+
+// =============== TASK REGISTRATION =============== //
+
+/**
+ * Name: tcbClear
+ * @brief Unregisters every task and empties the ready lists.
+ * @details Called automatically before the first registration. Slot serials survive,
+ *          so handles from before the clear stay invalid.
+ */
+void tcbClear() {
+  for (int i = 0; i < TCB_MAX_TASKS; i++) {
+    uint16_t serial = initialised ? tcbPool[i].serial + tcbPool[i].registered : 0;
+    memset(&tcbPool[i], 0, sizeof(TCBStruct));
+    tcbPool[i].serial = serial;
+    tcbPool[i].next = tcbPool[i].prev = tcbPool[i].regPrev = TCB_NONE;
+    tcbPool[i].regNext = (i + 1 < TCB_MAX_TASKS) ? i + 1 : TCB_NONE;
+  }
+  for (int p = 0; p < TCB_PRIORITY_LEVELS; p++) {
+    readyHead[p] = readyTail[p] = TCB_NONE;
+  }
+  readyLevels = 0;
+  freeHead = 0;
+  regHead = TCB_NONE;
+  runningSlot = TCB_NONE;
+  activeCount = 0;
+  taskCount = 0;
+  rounds = 0;
+  initialised = true;
+}
+
+/**
+ * Name: tcbRegister
+ * @brief Adds a task in STATE_READY.
+ * @param fn task body, called once per scheduler tick while the task is running.
+ * @param arg passed to fn.
+ * @param priority 0 to TCB_PRIORITY_LEVELS - 1; lower runs first.
+ * @retval the task's handle (and pid), or TCB_INVALID_HANDLE if the pool is full or
+ *      an argument is invalid.
+ */
+TCBHandle tcbRegister(void (*fn)(void *p), void *arg, int priority) {
+  if (!initialised) tcbClear();
+  if (fn == NULL || priority < 0 || priority >= TCB_PRIORITY_LEVELS || freeHead == TCB_NONE) {
+    return TCB_INVALID_HANDLE;
+  }
+
+  int16_t slot = freeHead;
+  TCBStruct *t = &tcbPool[slot];
+  freeHead = t->regNext;
+
+  t->ftpr = fn;
+  t->arg_ptr = arg;
+  t->priority = priority;
+  t->delay = 0;
+  t->pid = ((int)t->serial << TCB_SLOT_BITS) + slot + 1;
+  t->registered = true;
+
+  // append to the registration ring, as the last task of the current round
+  if (regHead == TCB_NONE) {
+    t->regNext = t->regPrev = slot;
+    regHead = slot;
+  } else {
+    int16_t last = tcbPool[regHead].regPrev;
+    t->regNext = regHead;
+    t->regPrev = last;
+    tcbPool[last].regNext = slot;
+    tcbPool[regHead].regPrev = slot;
+  }
+  taskCount++;
+
+  t->state = STATE_READY;
+  readyPush(slot);
+  activeCount++;
+  return t->pid;
+}
+
+/**
+ * Name: tcbUnregister
+ * @brief Removes a task in any state. If it is running, nothing runs until the next dispatch.
+ * @retval false if the handle is stale or invalid.
+ */
+bool tcbUnregister(TCBHandle handle) {
+  int16_t slot = slotOf(handle);
+  if (slot == TCB_NONE) return false;
+  TCBStruct *t = &tcbPool[slot];
+
+  if (t->state == STATE_READY) readyRemove(slot);
+  if (runningSlot == slot) runningSlot = TCB_NONE;
+  if (t->state != STATE_INACTIVE) activeCount--;
+
+  if (t->regNext == slot) {
+    regHead = TCB_NONE;
+  } else {
+    tcbPool[t->regPrev].regNext = t->regNext;
+    tcbPool[t->regNext].regPrev = t->regPrev;
+    if (regHead == slot) regHead = t->regNext;
+  }
+  taskCount--;
+
+  t->registered = false;
+  t->state = STATE_INACTIVE;
+  t->serial++;
+  t->regNext = freeHead;
+  t->regPrev = TCB_NONE;
+  freeHead = slot;
+  return true;
+}
+
+/**
+ * Name: tcbGet
+ * @brief TCB of a registered task, or NULL for a stale or invalid handle.
+ */
+TCBStruct *tcbGet(TCBHandle handle) {
+  int16_t slot = slotOf(handle);
+  return (slot == TCB_NONE) ? NULL : &tcbPool[slot];
+}
+
+/**
+ * Name: tcbSlot
+ * @brief Pool slot of a TCB returned by tcbGet, tcbDispatch or tcbCurrent, 0 to TCB_MAX_TASKS - 1.
+ * @details Lets callers keep per-task data in plain arrays indexed by slot.
+ * @retval -1 for NULL, e.g. tcbGet of a stale handle.
+ */
+int tcbSlot(const TCBStruct *task) {
+  if (task == NULL) return -1;
+  ptrdiff_t slot = task - tcbPool;
+  return (slot >= 0 && slot < TCB_MAX_TASKS) ? (int)slot : -1;
+}
+
+/**
+ * Name: tcbSetPriority
+ * @brief Changes a task's priority. A ready task moves to the back of its new level.
+ * @retval false if the handle or priority is invalid.
+ */
+bool tcbSetPriority(TCBHandle handle, int priority) {
+  int16_t slot = slotOf(handle);
+  if (slot == TCB_NONE || priority < 0 || priority >= TCB_PRIORITY_LEVELS) return false;
+  TCBStruct *t = &tcbPool[slot];
+  if (t->state == STATE_READY) {
+    readyRemove(slot);
+    t->priority = priority;
+    readyPush(slot);
+  } else {
+    t->priority = priority;
+  }
+  return true;
+}
+
+// =============== SCHEDULING =============== //
+
+/**
+ * Name: tcbDispatch
+ * @brief Task to call this tick.
+ * @details The running task keeps the CPU until it calls tcbComplete. Otherwise the
+ *          head of the highest non-empty priority level becomes STATE_RUNNING.
+ * @retval the task to run, or NULL if no task is ready.
+ */
+TCBStruct *tcbDispatch() {
+  if (runningSlot != TCB_NONE) return &tcbPool[runningSlot];
+  if (readyLevels == 0) return NULL;
+
+  int level = __builtin_ctz(readyLevels);
+  int16_t slot = readyHead[level];
+  readyRemove(slot);
+  tcbPool[slot].state = STATE_RUNNING;
+  runningSlot = slot;
+  return &tcbPool[slot];
+}
+
+/**
+ * Name: tcbCurrent
+ * @brief The running task, or NULL. Lets a task body find its own TCB.
+ */
+TCBStruct *tcbCurrent() {
+  return (runningSlot == TCB_NONE) ? NULL : &tcbPool[runningSlot];
+}
+
+/**
+ * Name: tcbComplete
+ * @brief Marks a task STATE_INACTIVE until the next release. Does nothing if it already is.
+ */
+void tcbComplete(TCBStruct *task) {
+  if (task == NULL || task->state == STATE_INACTIVE) return;
+  int16_t slot = (int16_t)(task - tcbPool);
+  if (task->state == STATE_READY) readyRemove(slot);
+  if (runningSlot == slot) runningSlot = TCB_NONE;
+  task->state = STATE_INACTIVE;
+  activeCount--;
+}
+
+/**
+ * Name: tcbSetReady
+ * @brief Makes an inactive task ready again, at the back of its priority level.
+ * @retval true if the task is now ready or already active.
+ */
+bool tcbSetReady(TCBHandle handle) {
+  int16_t slot = slotOf(handle);
+  if (slot == TCB_NONE) return false;
+  TCBStruct *t = &tcbPool[slot];
+  if (t->state == STATE_INACTIVE) {
+    t->state = STATE_READY;
+    readyPush(slot);
+    activeCount++;
+  }
+  return true;
+}
+
+/**
+ * Name: tcbReleaseAll
+ * @brief Starts a new round: every inactive task becomes ready.
+ * @details Tasks are queued in registration order, starting one task later than the
+ *          previous round, so equal-priority tasks take turns going first. The first
+ *          round, from registration, starts with the first task registered.
+ */
+void tcbReleaseAll() {
+  if (regHead == TCB_NONE) return;
+  regHead = tcbPool[regHead].regNext;
+
+  int16_t slot = regHead;
+  do {
+    TCBStruct *t = &tcbPool[slot];
+    if (t->state == STATE_INACTIVE) {
+      t->state = STATE_READY;
+      readyPush(slot);
+      activeCount++;
+    }
+    slot = t->regNext;
+  } while (slot != regHead);
+  rounds++;
+}
+
+/**
+ * Name: tcbActiveCount
+ * @brief Number of ready or running tasks; 0 means the round is over.
+ */
+size_t tcbActiveCount() {
+  return activeCount;
+}
+
+/**
+ * Name: tcbTaskCount
+ * @brief Number of registered tasks.
+ */
+size_t tcbTaskCount() {
+  return taskCount;
+}
+
+/**
+ * Name: tcbRounds
+ * @brief Number of rounds started by tcbReleaseAll since the last tcbClear.
+ */
+uint32_t tcbRounds() {
+  return rounds;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file TCBScheduler.h
+ * @brief Run-to-completion task scheduler core for the Lab 4 TCB sketch.
+ *
+ * @section description Description
+ * Tasks live in a fixed pool of TCBStruct slots and are addressed by handle. The handle
+ * is also the task's pid: it encodes the slot and a per-slot serial, so a stale handle
+ * of an unregistered task is rejected instead of touching whatever reused the slot.
+ *
+ * Ready tasks sit in one FIFO list per priority level, with a bitmap of the non-empty
+ * levels. Picking the next task is a find-first-set on the bitmap and a list pop, and
+ * the number of active (ready or running) tasks is kept as tasks change state, so
+ * neither step depends on how many tasks are registered.
+ *
+ * Lower priority values run first. Tasks of equal priority run in turn, and every
+ * tcbReleaseAll() starts the turn one task later, as the original scheduler did with
+ * baseTaskIndex.
+ *
+ * @section notes Notes
+ * - Cooperative only: none of these functions may be called from an ISR.
+ * - Every function is O(1) except tcbReleaseAll(), which is O(registered tasks) and
+ *   runs once per round rather than once per tick.
+ */
+#ifndef TCB_SCHEDULER_H
+#define TCB_SCHEDULER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TCB_MAX_TASKS       64 ///< Slots in the task pool
+#define TCB_PRIORITY_LEVELS 32 ///< Priorities 0 (first) to 31 (last); one bitmap bit each
+#define TCB_INVALID_HANDLE  (-1) ///< Returned when registration fails
+
+// =============== ENUMS =============== //
+
+typedef enum taskstate{
+  STATE_INACTIVE = 0,
+  STATE_RUNNING,
+  STATE_READY,
+  STATE_WAITING, // not really used, kept from ICTE
+} taskstate; ///< All possible states for Tasks to be
+
+// =============== STRUCTS =============== //
+
+typedef struct TCBstruct {
+  void (*ftpr)(void *p);  ///< Function pointer
+  void *arg_ptr;          ///< Arguements for the function
+  taskstate state;        ///< current state of task
+  int pid;                ///< Task ID, equal to the handle returned by tcbRegister
+  int priority;           ///< Task Priority. Lower values are picked first.
+  unsigned int delay;     ///< Delay after task. Not really used. Holdover from ICTE
+  int16_t next;           ///< Next slot in the ready list of this priority, or -1
+  int16_t prev;           ///< Previous slot in the ready list of this priority, or -1
+  int16_t regNext;        ///< Next slot in registration order (circular), or next free slot
+  int16_t regPrev;        ///< Previous slot in registration order (circular)
+  uint16_t serial;        ///< Bumped each time the slot is reused, part of the pid
+  bool registered;        ///< Slot holds a task
+} TCBStruct; ///< All possible variables needed to develop a thread control block
+
+typedef int TCBHandle; ///< Task handle, same value as TCBStruct::pid
+
+// =============== FUNCTIONS =============== //
+
+/**
+ * @name Task Registration
+ * @{
+ */
+TCBHandle tcbRegister(void (*fn)(void *p), void *arg, int priority);
+bool tcbUnregister(TCBHandle handle);
+TCBStruct *tcbGet(TCBHandle handle);
+int tcbSlot(const TCBStruct *task);
+bool tcbSetPriority(TCBHandle handle, int priority);
+void tcbClear();
+/** @} */
+
+/**
+ * @name Scheduling
+ * @{
+ */
+TCBStruct *tcbDispatch();
+TCBStruct *tcbCurrent();
+void tcbComplete(TCBStruct *task);
+bool tcbSetReady(TCBHandle handle);
+void tcbReleaseAll();
+size_t tcbActiveCount();
+size_t tcbTaskCount();
+uint32_t tcbRounds();
+/** @} */
+
+#endif
@@ -7,15 +7,31 @@
  * This sketch holds the implementation corresponding to the Lab document for task 3.
  * Lab 4 arduino ESP 32 File.
  *
+ * The button ISR and the BLE write callback push timestamped events into an EventQueue
+ * instead of setting flags, and loop() drains it every pass without blocking. Each event
+ * shows its message on the second row for OVERLAY_MS, timed from the event, while the
+ * counter keeps running on the first. A press or message during an overlay restarts it and
+ * is counted; none is merged into an earlier one. Button bounce is filtered from the
+ * event timestamps: an edge less than DEBOUNCE_US after the previous edge is ignored.
+ *
+ * The characteristic also streams light telemetry. The photoresistor is read every
+ * SAMPLE_MS and each reading, with its moving average, goes to a TelemetryPublisher. Once
+ * every TELEMETRY_INTERVAL_MS the publisher sends as many samples as fit the negotiated
+ * MTU in one notification, instead of one notification per sample. While the client
+ * falls behind (failed notifications, or the stack reporting congestion) the samples wait
+ * in its backlog, and when that fills neighbouring records are merged pairwise into averages.
+ *
  * @section circuit Circuit
  * - LCD connected to SDA an SCL at pin 20 and 21.
  * - Button connected to pin 13
+ * - Photoresistor on pin 18
  *
  * @section libraries Libraries
  * - arduino-esp32 (https://github.com/espressif/arduino-esp32)
  * - Arduino BLE
  * - Wire
  * - LiquidCrystal_I2C
+ * - EE590Common (EventQueue, LcdFrame, Telemetry, WindowedStats)
  *
  * @section notes Notes
  * - Comments are Doxygen compatible.
@@ -32,6 +48,10 @@
 #include <BLEServer.h>          ///< Required for BLE Server Handling
 #include "Wire.h"               ///< Required for I2C
 #include <LiquidCrystal_I2C.h>  ///< Required for quick LCD handling
+#include <EventQueue.h>         ///< Lock-free queue of ISR and callback events
+#include <LcdFrame.h>           ///< Shadow framebuffer, only changed cells are sent to the LCD
+#include <Telemetry.h>          ///< Batches light samples into MTU sized notifications
+#include <WindowedStats.h>      ///< Moving average of the light readings
 
 // ========== CONSTS and DEFINEs =========== //
 // Generate random Service and Characteristic UUIDs: https://www.uuidgenerator.net/
@@ -39,18 +59,45 @@
 #define SERVICE_UUID        "abac6fe4-7fce-47a5-bc1b-85f92ecd786b" ///< Service UUID
 #define CHARACTERISTIC_UUID "d7b62563-544f-4e33-9251-f29577256ead" ///< Characteristic UUID
 #define BUTTON_PIN 13                                              ///< Push Button Pin
+#define EVENT_QUEUE_LEN 32                                         ///< Events that can wait for loop(); a power of two
+#define DEBOUNCE_US 50000                                          ///< Button edges closer than this are bounce
+#define OVERLAY_MS 2000                                            ///< How long an event's message stays up
+#define LEDR 18                                                    ///< Input photoresistor pin
+#define SAMPLE_MS 50                                               ///< Light sampling period
+#define WINDOW_SIZE 5                                              ///< Samples in the moving average
+#define TELEMETRY_BACKLOG 256                                      ///< Samples kept while the client is behind
+#define TELEMETRY_INTERVAL_MS 1000                                 ///< At most one notification per interval
+#define TELEMETRY_MTU 247                                          ///< ATT MTU requested from the client
 
 // ========== GLOBALs =========== //
 LiquidCrystal_I2C lcd(0x27, 16, 2); ///< LCD Pre-initialization
+LcdFrame<16, 2> lcdFrame;           ///< What the LCD should show; flushed as a diff
+BLECharacteristic *pCharacteristic = NULL;  ///< Write trigger and telemetry notifications
+WindowedMoments<WINDOW_SIZE> lightWindow;   ///< Moving average of the light readings
+TelemetryPublisher<TELEMETRY_BACKLOG> telemetry(TELEMETRY_SUMMARIZE, TELEMETRY_INTERVAL_MS); ///< Batches samples into notifications
 
-volatile bool newMessageReceived = false; //< Checks if new message has been received from the BLE
 hw_timer_t * timer = NULL; ///< timer pre-initialized to null. Will be updated in setup
 portMUX_TYPE timerMux = portMUX_INITIALIZER_UNLOCKED; ///< Assuming we need a mutex for timer stuff. Asked Gokul. Said should be fine
 
 volatile unsigned long counter = 0;     ///< current count
-volatile bool updateDisplay = true;     ///< whether to update the display, flag
-volatile bool buttonInterrupt = false;  ///< whether an interrupt took place with regard to buttons, flag
-volatile bool bleInterrupt = false;     ///< whether an interrupt took place with regard to ble, flag
+
+/**
+ * @brief Event types pushed into events
+ */
+enum EventType : uint16_t {
+  EVENT_BUTTON,   ///< Button edge; payload unused
+  EVENT_MESSAGE,  ///< BLE write; payload is the value's length
+};
+
+EventQueue<EVENT_QUEUE_LEN> events;     ///< Filled by the ISRs and BLE callbacks, drained by loop()
+
+// Consumer side, owned by loop()
+const char *overlayText = NULL;         ///< Message on the second row, NULL for none
+uint32_t overlayEndUs = 0;              ///< micros() the overlay expires at
+uint32_t lastButtonEdgeUs = 0;          ///< Timestamp of the previous button edge, for debouncing
+bool buttonEdgeSeen = false;            ///< lastButtonEdgeUs is valid
+unsigned long buttonPresses = 0;        ///< Debounced presses handled
+unsigned long messagesReceived = 0;     ///< BLE writes handled
 
 // ========== ISRs =========== //
 // ==============> TODO: Write your timer ISR here.
@@ -62,33 +109,67 @@ volatile bool bleInterrupt = false;     ///< whether an interrupt took place wit
  */
 void IRAM_ATTR onTimer() {
   portENTER_CRITICAL_ISR(&timerMux);
-  if (updateDisplay) counter++;
+  counter++;
   portEXIT_CRITICAL_ISR(&timerMux);
 }
 
 // ==============> TODO: Create an ISR function to handle button press here.
 /**
  * Name: onButtonPress
- * @brief ISR to handle button press flag setting on button interrupt call
+ * @brief ISR for a button edge; queues it with its time, loop() debounces
  */
 void IRAM_ATTR onButtonPress() {
-  buttonInterrupt = true;
+  events.push(EVENT_BUTTON, micros());
 }
 
 // ========== CLASSs =========== //
 /**
  * Name: onWrite
- * @brief Callback from BLE if written, will set flag to true. Used as ISR
+ * @brief Callback from BLE if written, queues a message event. Runs in the BLE task
  */
 class MyCallbacks: public BLECharacteristicCallbacks {
    void onWrite(BLECharacteristic *pCharacteristic) {
      // =========> TODO: This callback function will be invoked when signal is
      // 		     received over BLE. Implement the necessary functionality that
      //		     will trigger the message to the LCD.
-     bleInterrupt = true;
+     events.push(EVENT_MESSAGE, micros(), pCharacteristic->getValue().length());
+   }
+
+   /**
+    * Name: onStatus
+    * @brief Tells the telemetry publisher whether its notification went out
+    */
+   void onStatus(BLECharacteristic *pCharacteristic, Status s, uint32_t code) {
+     telemetry.notifyResult(s == SUCCESS_NOTIFY);
    }
 };
 
+/**
+ * Name: ServerCallbacks
+ * @brief Follows the MTU the client negotiated, and advertises again after a disconnect
+ * @details Runs in the BLE stack's task; setMtu and setCongested only store atomics that
+ *      the loop's next poll() reads.
+ */
+class ServerCallbacks: public BLEServerCallbacks {
+   void onMtuChanged(BLEServer *pServer, esp_ble_gatts_cb_param_t *param) {
+     telemetry.setMtu(param->mtu.mtu);
+   }
+
+   void onDisconnect(BLEServer *pServer) {
+     telemetry.setMtu(TELEMETRY_DEFAULT_MTU);
+     telemetry.setCongested(false);
+     pServer->getAdvertising()->start();
+   }
+};
+
+/**
+ * Name: onGattsEvent
+ * @brief Holds telemetry while the stack's notification buffers are full
+ */
+void onGattsEvent(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param) {
+  if (event == ESP_GATTS_CONGEST_EVT) telemetry.setCongested(param->congest.congested);
+}
+
 /**
  * Name: setup
  * @brief sets up bluetooth, LCD, timer and button
@@ -96,9 +177,13 @@ class MyCallbacks: public BLECharacteristicCallbacks {
  */
 void setup() {
   BLEDevice::init("SJK_ESP32");
+  BLEDevice::setMTU(TELEMETRY_MTU);
+  BLEDevice::setCustomGattsHandler(onGattsEvent);
   BLEServer *pServer = BLEDevice::createServer();
+  pServer->setCallbacks(new ServerCallbacks());
   BLEService *pService = pServer->createService(SERVICE_UUID);
-  BLECharacteristic *pCharacteristic = pService->createCharacteristic(CHARACTERISTIC_UUID, BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_WRITE);
+  pCharacteristic = pService->createCharacteristic(CHARACTERISTIC_UUID, BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_NOTIFY);
+  pCharacteristic->addDescriptor(new BLE2902());  // lets the client enable notifications
 
   pCharacteristic->setCallbacks(new MyCallbacks());
   pService->start();
@@ -121,11 +206,64 @@ void setup() {
     // ========> TODO: Set button pin as input and attach an interrupt
   pinMode(BUTTON_PIN, INPUT_PULLUP);
   attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), onButtonPress, FALLING);
+
+  pinMode(LEDR, INPUT);
+}
+
+/**
+ * Name: sampleLight
+ * @brief Reads the photoresistor every SAMPLE_MS and queues the reading for telemetry
+ */
+void sampleLight() {
+  static unsigned long lastSample = 0;
+  unsigned long now = millis();
+  if (now - lastSample < SAMPLE_MS) return;
+  lastSample = now;
+
+  int level = analogRead(LEDR);
+  lightWindow.add(level);
+  telemetry.add(micros(), (uint16_t)level, (uint16_t)lightWindow.mean());
+}
+
+/**
+ * Name: showOverlay
+ * @brief Puts text on the second row for OVERLAY_MS from timeUs
+ */
+void showOverlay(const char *text, uint32_t timeUs) {
+  overlayText = text;
+  overlayEndUs = timeUs + OVERLAY_MS * 1000UL;
+}
+
+/**
+ * Name: handleEvent
+ * @brief Reacts to one queued event
+ * @details A button edge within DEBOUNCE_US of the previous edge is bounce and only moves the
+ *      debounce window along.
+ */
+void handleEvent(const Event &e) {
+  switch (e.type) {
+    case EVENT_BUTTON: {
+      bool bounce = buttonEdgeSeen && e.timeUs - lastButtonEdgeUs < DEBOUNCE_US;
+      lastButtonEdgeUs = e.timeUs;
+      buttonEdgeSeen = true;
+      if (bounce) return;
+      buttonPresses++;
+      showOverlay("Button Pressed", e.timeUs);
+      break;
+    }
+    case EVENT_MESSAGE:
+      messagesReceived++;
+      showOverlay("New Message!", e.timeUs);
+      break;
+  }
 }
 
 /**
  * Name: loop
- * @brief Equivalent to while (1) in main. Checks three things each time, if it needs to update, if it has been interrupted via BLE, or via Button Press
+ * @brief Equivalent to while (1) in main. Handles every queued event, then redraws the counter and any overlay
+ * @details Nothing here blocks: overlays expire by time, so the counter keeps updating under them. Every screen is
+ *      drawn into lcdFrame and flushed, so a counter tick sends only the digits that changed.
+ *      Each pass also samples the light level and lets the telemetry publisher send a batch when one is due.
  */
 void loop() {
  // =========> TODO: Print out an incrementing counter to the LCD.
@@ -133,41 +271,26 @@ void loop() {
  //                  Message!” on the LCD.
  //                  If the button has been pressed, print out "Button Pressed"
  //                  on the LCD.
- static unsigned long lastDisplayed = -1;
-
-  // Display counter if changed
-  if (updateDisplay && counter != lastDisplayed) {
-    lastDisplayed = counter;
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print("Count: ");
-    lcd.setCursor(7, 0);
-    lcd.print(counter);
-  }
+  Event e;
+  while (events.pop(e)) handleEvent(e);
 
-  // Handle button press
-  if (buttonInterrupt) {
-    updateDisplay = false;
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print("Button Pressed");
-    delay(2000);
-    buttonInterrupt = false;
-    updateDisplay = true;
-    lastDisplayed = -1; // Force update
-  }
+  if (overlayText != NULL && (int32_t)(micros() - overlayEndUs) >= 0) overlayText = NULL;
 
-  // Handle BLE message
-  if (bleInterrupt) {
-    updateDisplay = false;
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print("New Message!");
-    delay(2000);
-    bleInterrupt = false;
-    updateDisplay = true;
-    lastDisplayed = -1; // Force update
+  portENTER_CRITICAL(&timerMux);
+  unsigned long count = counter;
+  portEXIT_CRITICAL(&timerMux);
+
+  lcdFrame.clear();
+  lcdFrame.print("Count: ");
+  lcdFrame.print(count);
+  if (overlayText != NULL) {
+    lcdFrame.setCursor(0, 1);
+    lcdFrame.print(overlayText);
   }
+  lcdFrame.flush(lcd);
+
+  sampleLight();
+  telemetry.poll(*pCharacteristic, micros());
 
   delayMicroseconds(1000);  // Small delay to reduce CPU load
 }
@@ -19,9 +19,14 @@
 
 // =========== Libraries ===========
 #include "590Lab3.h"
+#include "Alloc590.h"
+#include "ArrayTransform.h"
 #include "Special590functions.h"
+#include "Trace590.h"
 #include "Arduino.h"
+#include <MonotonicClock.h>
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -34,31 +39,74 @@
  * @{
  */
 
+// Lookup tables built by the compiler, so fibonacci and factorial never compute or allocate them
+struct FibonacciTable {
+  unsigned long long value[FIB_TABLE_SIZE];
+  constexpr FibonacciTable() : value() {
+    value[1] = 1;
+    for (int i = 2; i < FIB_TABLE_SIZE; i++) value[i] = value[i - 1] + value[i - 2];
+  }
+};
+
+struct FactorialTable {
+  unsigned long long value[FACT_TABLE_SIZE];
+  constexpr FactorialTable() : value() {
+    value[0] = 1;
+    for (int i = 1; i < FACT_TABLE_SIZE; i++) value[i] = value[i - 1] * i;
+  }
+};
+
+static constexpr FibonacciTable fibTable;
+static constexpr FactorialTable factTable;
+static_assert(fibTable.value[93] == 12200160415121876738ULL, "F(93) is the last 64 bit Fibonacci number");
+static_assert(factTable.value[20] == 2432902008176640000ULL, "20! is the last 64 bit factorial");
+
 /**
  * Name: fibonacci
  * @brief Demo Task 2.1: Fibonacci Sequence
  * @details Observed Behavior: Generates a Fibonacci sequence of length N and stores it in a dynamic array.
  *      Commented Purpose: Illustrates recursive or iterative numerical computation.
- *      Edge Case Handling: Exit early if N <= 0.
- *      Error Handling: Assumes memory is properly allocated for sequence.
+ *      Edge Case Handling: Exit early if N <= 0. The terms are copied from a compile time table.
+ *      Error Handling: *sequence is NULL if N < 0, N > FIB_TABLE_SIZE (the terms would not fit
+ *      in 64 bits; see bigintFibonacci) or the allocation fails. Callers that only need terms should
+ *      use fibonacciTerm, which does not allocate. Free the sequence with freeFibonacci.
  * @param N length of the fibonacci series.
  * @param sequence address of the pointer provided, which holds the fibonacci series. 
  */
 void fibonacci(int N, unsigned long long **sequence) {
   // to do
   // task 2 step 1: Print the fibonacdi sequence upto digit n
-  if(N < 0) return;
+  *sequence = NULL;
+  if(N < 0 || N > FIB_TABLE_SIZE) return;
 
-  *sequence = (unsigned long long*) malloc(N * sizeof(unsigned long long));
+  *sequence = (unsigned long long*) labAlloc(ALLOC_TAG_FIBONACCI, N * sizeof(unsigned long long));
 
   if(*sequence == NULL) return;
 
-  if(N > 0) (*sequence)[0] = 0;
-  if(N > 1) (*sequence)[1] = 1;
+  memcpy(*sequence, fibTable.value, N * sizeof(unsigned long long));
+}
 
-  for (int i = 2; i < N; i++) {
-    (*sequence)[i] = (*sequence)[i-1] + (*sequence)[i-2];
-  }
+/**
+ * Name: freeFibonacci
+ * @brief Frees a sequence from fibonacci.
+ * @param sequence the sequence, may be NULL.
+ * @param N the length it was created with.
+ */
+void freeFibonacci(unsigned long long *sequence, int N) {
+  labFree(ALLOC_TAG_FIBONACCI, sequence, N * sizeof(unsigned long long));
+}
+
+/**
+ * Name: fibonacciTerm
+ * @brief F(n) from the compile time table, O(1) and without allocation.
+ * @param n index, F(0) = 0.
+ * @param result where F(n) is stored.
+ * @retval false if n < 0 or F(n) does not fit in 64 bits (n >= FIB_TABLE_SIZE).
+ */
+bool fibonacciTerm(int n, unsigned long long *result) {
+  if(n < 0 || n >= FIB_TABLE_SIZE) return false;
+  *result = fibTable.value[n];
+  return true;
 }
 
 /**
@@ -66,23 +114,225 @@ void fibonacci(int N, unsigned long long **sequence) {
  * @brief Demo Task 2.2: Factorial Calculation
  * @details Observed Behavior: Computes the factorial of a given non-negative integer.
  * Commented Purpose: Basic recursion/iteration exercise for mathematical operations.
- * Edge Case Handling: For n = 0, result is 1.
- * Error Handling: Returns -1 for negative input.
+ * Edge Case Handling: For n = 0, result is 1. Looked up in a compile time table.
+ * Error Handling: Reports negative input and results beyond 20!, which do not fit in 64 bits
+ *      (see bigintFactorial), instead of returning a wrapped value.
  * @param n number for which a factorial is taken
- * @param result address of the unsigned long long which holds the fibonacci result 
- * @retval -1 if n < 0
+ * @param result address of the unsigned long long which holds the factorial result; untouched on error
+ * @retval MATH_OK on success
+ * @retval MATH_INVALID if n < 0
+ * @retval MATH_OVERFLOW if n! does not fit in 64 bits
  */
 int factorial(int n, unsigned long long *result) {
-  // to do
-  // task 2 step 1: Print the fibonacdi sequence upto digit n
-  if (n < 0) return -1;
-  if (n == 0 || n == 1) {
-    *result = 1;
-    return 1;
+  if (n < 0) return MATH_INVALID;
+  if (n >= FACT_TABLE_SIZE) return MATH_OVERFLOW;
+  *result = factTable.value[n];
+  return MATH_OK;
+}
+
+// =========== BigUInt helpers ===========
+
+/**
+ * Name: bigSet
+ * @brief x = value.
+ */
+static void bigSet(BigUInt *x, uint64_t value) {
+  x->limb[0] = (uint32_t)value;
+  x->limb[1] = (uint32_t)(value >> 32);
+  x->used = (value >> 32) ? 2 : (value ? 1 : 0);
+}
+
+/**
+ * Name: bigTrim
+ * @brief Drops zero limbs from the top.
+ */
+static void bigTrim(BigUInt *x) {
+  while(x->used > 0 && x->limb[x->used - 1] == 0) x->used--;
+}
+
+/**
+ * Name: bigAdd
+ * @brief r = a + b. r may be a or b.
+ * @retval false on overflow; r is then not valid.
+ */
+static bool bigAdd(BigUInt *r, const BigUInt *a, const BigUInt *b) {
+  int n = (a->used > b->used) ? a->used : b->used;
+  uint64_t carry = 0;
+  for (int i = 0; i < n; i++) {
+    uint64_t sum = carry + (i < a->used ? a->limb[i] : 0) + (i < b->used ? b->limb[i] : 0);
+    r->limb[i] = (uint32_t)sum;
+    carry = sum >> 32;
+  }
+  if(carry) {
+    if(n == BIGINT_LIMBS) return false;
+    r->limb[n++] = (uint32_t)carry;
+  }
+  r->used = n;
+  return true;
+}
+
+/**
+ * Name: bigSub
+ * @brief r = a - b, for a >= b. r may be a or b.
+ */
+static void bigSub(BigUInt *r, const BigUInt *a, const BigUInt *b) {
+  int64_t borrow = 0;
+  for (int i = 0; i < a->used; i++) {
+    int64_t diff = (int64_t)a->limb[i] - (i < b->used ? b->limb[i] : 0) - borrow;
+    borrow = diff < 0;
+    r->limb[i] = (uint32_t)(diff + (borrow << 32));
+  }
+  r->used = a->used;
+  bigTrim(r);
+}
+
+/**
+ * Name: bigMul
+ * @brief r = a * b, schoolbook. r must not be a or b.
+ * @retval false on overflow; r is then not valid.
+ */
+static bool bigMul(BigUInt *r, const BigUInt *a, const BigUInt *b) {
+  if(a->used == 0 || b->used == 0) {
+    r->used = 0;
+    return true;
+  }
+  if(a->used + b->used - 1 > BIGINT_LIMBS) return false;
+  int n = a->used + b->used;
+  if(n > BIGINT_LIMBS) n = BIGINT_LIMBS;
+  memset(r->limb, 0, n * sizeof(uint32_t));
+
+  for (int i = 0; i < a->used; i++) {
+    uint64_t carry = 0;
+    for (int j = 0; j < b->used; j++) {
+      uint64_t cur = (uint64_t)a->limb[i] * b->limb[j] + r->limb[i + j] + carry;
+      r->limb[i + j] = (uint32_t)cur;
+      carry = cur >> 32;
+    }
+    if(carry) {
+      if(i + b->used == BIGINT_LIMBS) return false;
+      r->limb[i + b->used] = (uint32_t)carry;
+    }
+  }
+  r->used = n;
+  bigTrim(r);
+  return true;
+}
+
+/**
+ * Name: bigintFibonacci
+ * @brief F(n) of any size up to BIGINT_LIMBS limbs, by fast doubling in O(log n) multiplications.
+ * @details Walks the bits of n from the top, keeping (F(k), F(k+1)) and using
+ *      F(2k) = F(k) (2 F(k+1) - F(k)) and F(2k+1) = F(k)^2 + F(k+1)^2.
+ *      Only F(n) itself is formed on the last step, so overflow is reported exactly
+ *      when F(n) does not fit. About 1.3 KB of stack.
+ * @param n index, F(0) = 0.
+ * @param result where F(n) is stored.
+ * @retval false if n < 0 or F(n) needs more than BIGINT_LIMBS limbs.
+ */
+bool bigintFibonacci(int n, BigUInt *result) {
+  if(n < 0) return false;
+  if(n < FIB_TABLE_SIZE) {
+    bigSet(result, fibTable.value[n]);
+    return true;
+  }
+
+  BigUInt a, b, c, d, t;  // a = F(k), b = F(k+1)
+  bigSet(&a, 0);
+  bigSet(&b, 1);
+  int bit = 31 - __builtin_clz((unsigned)n);
+  for (; bit >= 0; bit--) {
+    bool one = (n >> bit) & 1;
+    bool last = (bit == 0);
+
+    if(!last || !one) {
+      // c = F(2k) = a * (2b - a)
+      if(!bigAdd(&t, &b, &b)) return false;
+      bigSub(&t, &t, &a);
+      if(!bigMul(&c, &a, &t)) return false;
+    }
+    if(!last || one) {
+      // d = F(2k+1) = a^2 + b^2
+      if(!bigMul(&d, &a, &a)) return false;
+      if(!bigMul(&t, &b, &b)) return false;
+      if(!bigAdd(&d, &d, &t)) return false;
+    }
+
+    if(last) {
+      *result = one ? d : c;
+    } else if(one) {
+      a = d;
+      if(!bigAdd(&b, &c, &d)) return false;
+    } else {
+      a = c;
+      b = d;
+    }
+  }
+  return true;
+}
+
+/**
+ * Name: bigintFactorial
+ * @brief n! of any size up to BIGINT_LIMBS limbs.
+ * @param n number for which a factorial is taken.
+ * @param result where n! is stored.
+ * @retval false if n < 0 or n! needs more than BIGINT_LIMBS limbs.
+ */
+bool bigintFactorial(int n, BigUInt *result) {
+  if(n < 0) return false;
+  int start = (n < FACT_TABLE_SIZE) ? n : FACT_TABLE_SIZE - 1;
+  bigSet(result, factTable.value[start]);
+
+  for (int k = start + 1; k <= n; k++) {
+    uint64_t carry = 0;
+    for (int i = 0; i < result->used; i++) {
+      uint64_t cur = (uint64_t)result->limb[i] * (uint32_t)k + carry;
+      result->limb[i] = (uint32_t)cur;
+      carry = cur >> 32;
+    }
+    if(carry) {
+      if(result->used == BIGINT_LIMBS) return false;
+      result->limb[result->used++] = (uint32_t)carry;
+    }
+  }
+  return true;
+}
+
+/**
+ * Name: printBigUInt
+ * @brief Prints x in decimal.
+ * @details Divides a copy by 10^9 repeatedly and prints the 9 digit groups from the top.
+ */
+void printBigUInt(const BigUInt *x) {
+  uint32_t groups[BIGINT_LIMBS * 32 / 29 + 1];  // 10^9 > 2^29
+  int count = 0;
+  BigUInt rest = *x;
+
+  while(rest.used > 0) {
+    uint64_t rem = 0;
+    for (int i = rest.used - 1; i >= 0; i--) {
+      uint64_t cur = (rem << 32) | rest.limb[i];
+      rest.limb[i] = (uint32_t)(cur / 1000000000u);
+      rem = cur % 1000000000u;
+    }
+    bigTrim(&rest);
+    groups[count++] = (uint32_t)rem;
+  }
+
+  if(count == 0) {
+    printString("0");
+    return;
+  }
+  printUInt(groups[count - 1]);
+  char digits[10];
+  digits[9] = '\0';
+  for (int g = count - 2; g >= 0; g--) {
+    uint32_t v = groups[g];
+    for (int d = 8; d >= 0; d--) {
+      digits[d] = '0' + v % 10;
+      v /= 10;
+    }
+    printString(digits);
   }
-  
-  *result = n * factorial(n - 1, result);
-  return *result;
 }
 
 /**
@@ -100,7 +350,7 @@ int factorial(int n, unsigned long long *result) {
  * @details Observed Behavior: Initializes a dynamic integer array with specified capacity.
  * Commented Purpose: Teaches dynamic memory allocation.
  * Edge Case Handling: Ensures zero-size start is not allowed.
- * Error Handling: Returns on malloc failure.
+ * Error Handling: Returns on allocation failure.
  * @param arr Dynamic Array to be initialized
  * @param initialCapacity Capacity for which the array memory needs to be initialized.
  */
@@ -109,22 +359,149 @@ void initArray(DynamicArray *arr, int initialCapacity) {
   // Set the array’s size to 0.
   // Set the array’s capacity to the value of initialCapacity.
   // If memory allocation fails, print an error message to the Serial Monitor and exit the function.
+  if(initialCapacity < 1) initialCapacity = 1;
   arr->size = 0;
   arr->capacity = initialCapacity;
-  arr->data = (int *) malloc(sizeof(int) * initialCapacity);
+  arr->fixedStorage = false;
+  arr->history = NULL;
+  arr->data = (int *) labAlloc(ALLOC_TAG_ARRAY, sizeof(int) * initialCapacity);
 
   if(arr->data == NULL) {
+    arr->capacity = 0;
     printString("Initialization of Array failed.\n");
   }
 }
 
+/**
+ * Name: initArrayStatic
+ * @brief Initialize Dynamic Array over caller owned storage
+ * @details The array never allocates: once storage is full, addElement applies the retention
+ *      policy if one is set, otherwise it drops the element. storage can be a static array or
+ *      a slice of an arena, and is not freed by freeArray.
+ * @param arr Dynamic Array to be initialized
+ * @param storage memory for capacity integers
+ * @param capacity number of integers storage holds
+ */
+void initArrayStatic(DynamicArray *arr, int *storage, int capacity) {
+  arr->data = storage;
+  arr->size = 0;
+  arr->capacity = capacity;
+  arr->fixedStorage = true;
+  arr->history = NULL;
+}
+
+/**
+ * Name: reserveArray
+ * @brief Ensures capacity for at least capacity elements.
+ * @details Reallocates through a temporary so the original data survives a failed realloc.
+ *      An array without data (a failed initArray, or after freeArray) gets its first block here.
+ * @param arr Dynamic Array
+ * @param capacity number of elements that must fit
+ * @retval true if the array can now hold capacity elements.
+ * @retval false if realloc failed or the array has fixed storage that is too small.
+ */
+bool reserveArray(DynamicArray *arr, int capacity) {
+  if(capacity <= arr->capacity && arr->data != NULL) return true;
+  if(arr->fixedStorage) return false;
+  if(capacity < 1) capacity = 1;
+
+  int *grown = (int *) labRealloc(ALLOC_TAG_ARRAY, arr->data, arr->capacity * sizeof(int), capacity * sizeof(int));
+  if(grown == NULL) {
+    TRACE_ERROR(TRACE_EV_ARRAY_GROW_FAILED, arr->capacity, 0);
+    return false;
+  }
+  arr->data = grown;
+  arr->capacity = capacity;
+  TRACE_DEBUG(TRACE_EV_ARRAY_GROW, arr->capacity, 0);
+  return true;
+}
+
+/**
+ * Name: shrinkArrayToFit
+ * @brief Releases capacity beyond the current size.
+ * @retval true if shrunk, or there was nothing to do.
+ * @retval false if realloc failed (the array is unchanged) or the storage is fixed.
+ */
+bool shrinkArrayToFit(DynamicArray *arr) {
+  if(arr->fixedStorage) return false;
+  int capacity = (arr->size > 0) ? arr->size : 1;
+  if(capacity == arr->capacity) return true;
+
+  int *shrunk = (int *) labRealloc(ALLOC_TAG_ARRAY, arr->data, arr->capacity * sizeof(int), capacity * sizeof(int));
+  if(shrunk == NULL) return false;
+  arr->data = shrunk;
+  arr->capacity = capacity;
+  return true;
+}
+
+/**
+ * Name: setArrayRetention
+ * @brief Bounds the array to its current capacity by summarizing old elements.
+ * @details When the array is full, the window oldest elements are folded into one
+ *      min/max/mean summary in history and the rest move down, so the array always holds
+ *      at least capacity - window of the newest elements and memory use never changes.
+ *      The array stops growing on the heap once a retention policy is set.
+ * @param arr Dynamic Array
+ * @param history history state to use, owned by the caller
+ * @param windows caller owned ring of historyCapacity summaries
+ * @param historyCapacity number of summaries to keep
+ * @param window elements per summary, between 1 and the array capacity
+ */
+void setArrayRetention(DynamicArray *arr, ArrayHistory *history, ArraySummary *windows, int historyCapacity, int window) {
+  if(window < 1) window = 1;
+  if(window > arr->capacity) window = arr->capacity;
+
+  history->windows = windows;
+  history->capacity = historyCapacity;
+  history->start = 0;
+  history->count = 0;
+  history->window = window;
+  history->overwritten = 0;
+  arr->history = history;
+}
+
+/**
+ * Name: evictOldest
+ * @brief Folds the history window oldest elements into one summary and moves the rest down.
+ * @param arr Dynamic Array with a retention policy
+ */
+static void evictOldest(DynamicArray *arr) {
+  ArrayHistory *h = arr->history;
+  int n = (h->window < arr->size) ? h->window : arr->size;
+
+  ArraySummary summary = {arr->data[0], arr->data[0], 0, n};
+  long long sum = 0;
+  for (int i = 0; i < n; i++) {
+    int v = arr->data[i];
+    if(v < summary.min) summary.min = v;
+    if(v > summary.max) summary.max = v;
+    sum += v;
+  }
+  summary.mean = (int)(sum / n);
+
+  if(h->capacity > 0) {
+    if(h->count == h->capacity) {
+      h->start = (h->start + 1) % h->capacity;
+      h->count--;
+      h->overwritten++;
+    }
+    h->windows[(h->start + h->count) % h->capacity] = summary;
+    h->count++;
+  }
+
+  memmove(arr->data, arr->data + n, (arr->size - n) * sizeof(int));
+  arr->size -= n;
+  TRACE_INFO(TRACE_EV_ARRAY_EVICT, n, summary.mean);
+}
+
 /**
  * Name: addElement
  * @brief Demo Task 3.2: Add Element to Dynamic Array
  * @details Observed Behavior: Adds an element to the array; resizes if needed.
  * Commented Purpose: Demonstrates array growth logic.
- * Edge Case Handling: Handles capacity overflow.
- * Error Handling: Memory errors should be caught and reported.
+ * Edge Case Handling: Handles capacity overflow. With a retention policy the oldest
+ *      elements are summarized instead of growing; fixed storage without one drops the element.
+ * Error Handling: Memory errors are traced and the original data is kept.
  * @param arr Dynamic Array to which an additional element needs to be added
  * @param element Element which needs to be added
  */
@@ -133,28 +510,29 @@ void addElement(DynamicArray *arr, int element) {
   // If so, reallocate memory to double the current capacity and update the internal capacity value.
   // After ensuring space is available, insert the new value at the current size index.
   // Increment the size field.
+  if(arr->data == NULL && !reserveArray(arr, 1)) return;  // initArray failed or the array was freed
   if(arr->size > arr->capacity - 1) {
-    arr->data = (int *) realloc(arr->data, arr->capacity * 2 * sizeof(int));
-    if(arr->data == NULL) {
-      printString("Increasing Capacity failed.\n");
-    } else {
-      arr->capacity = arr->capacity * 2;
+    if(arr->history != NULL) {
+      evictOldest(arr);
+    } else if(arr->fixedStorage) {
+      TRACE_WARN(TRACE_EV_ARRAY_FULL, element, 0);
+      return;
+    } else if(!reserveArray(arr, arr->capacity * 2)) {
+      return;
     }
   }
 
   arr->data[arr->size] = element;
   arr->size++;
-  printString("addElement: ");
-  printInt(element);
-  printString("\n");
+  TRACE_INFO(TRACE_EV_ADD_ELEMENT, element, 0);
 }
 
 /**
  * Name: printArray
  * @brief Demo Task 3.3: Print Dynamic Array
- * @details Observed Behavior: Prints each element of the array to the serial monitor.
+ * @details Observed Behavior: Prints the newest ARRAY_PRINT_WINDOW elements of the array to the serial monitor.
  * Commented Purpose: Provides output visibility of internal data.
- * Edge Case Handling: Prints only "[]" if empty.
+ * Edge Case Handling: Prints only "[]" if empty. Older elements are elided as "...".
  * Error Handling: Assumes array is initialized.
  * @param arr Dynamic Array to which an additional element needs to be printed
  */
@@ -162,28 +540,56 @@ void printArray(DynamicArray *arr) {
   // Loop through the array and print each integer.
   // Separate values using commas or tabs.
   // Print a newline character after the last value for formatting.
+  int first = (arr->size > ARRAY_PRINT_WINDOW) ? arr->size - ARRAY_PRINT_WINDOW : 0;
+
   printString("[");
-  for (int i = 0; i < arr->size - 1; i++){
+  if(first > 0) printString("..., ");
+  for (int i = first; i < arr->size; i++){
     printInt(arr->data[i]);
-    printString(", ");
+    if(i < arr->size - 1) printString(", ");
   }
-  printInt(arr->data[arr->size-1]);
   printString("]\n");
 }
 
+/**
+ * Name: printArrayHistory
+ * @brief Prints the min/max/mean summaries kept by the retention policy, oldest first.
+ * @param arr Dynamic Array
+ */
+void printArrayHistory(DynamicArray *arr) {
+  ArrayHistory *h = arr->history;
+  if(h == NULL) return;
+
+  printString("History (min/max/mean per ");
+  printInt(h->window);
+  printString("): ");
+  for (int i = 0; i < h->count; i++) {
+    const ArraySummary *w = &h->windows[(h->start + i) % h->capacity];
+    printInt(w->min);
+    printString("/");
+    printInt(w->max);
+    printString("/");
+    printInt(w->mean);
+    printString(" ");
+  }
+  printString("\n");
+}
+
 /**
  * Name: freeArray
  * @brief COMPLETED SAMPLE FUNCTION Free Dynamic Array
- * @details  Observed Behavior: Frees memory and resets array fields.
+ * @details  Observed Behavior: Frees memory and resets array fields. Fixed storage is left to its owner.
  * Commented Purpose: Demonstrates cleanup of dynamic structures.
  * Edge Case Handling: Can be safely called multiple times.
  * @param arr Dynamic Array to which an additional element needs to be printed
  */
 void freeArray(DynamicArray *arr) {
-  free(arr->data);
+  if(!arr->fixedStorage) labFree(ALLOC_TAG_ARRAY, arr->data, arr->capacity * sizeof(int));
   arr->data = NULL;
   arr->size = 0;
   arr->capacity = 0;
+  arr->fixedStorage = false;
+  arr->history = NULL;
 }
 
 /**
@@ -216,25 +622,86 @@ int pointer_distance(int *ptr1, int *ptr2, int *array_start, int *array_end) {
   return INT_MAX;
 }
 
+// =========== Word-at-a-time helpers ===========
+// mem_copy, reverseString and str_to_int work a machine word (4 bytes on the ESP32,
+// 8 on a 64 bit host) at a time. Loads and stores through these helpers compile to single
+// word accesses where the target allows them, and stay correct for unaligned pointers.
+// The byte arithmetic assumes a little endian target, which both are.
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "word kernels assume little endian");
+
+typedef size_t Word;
+#define WORD_BYTES sizeof(Word)
+
+static inline Word loadWord(const void *p) {
+  Word w;
+  memcpy(&w, p, WORD_BYTES);
+  return w;
+}
+
+static inline void storeWord(void *p, Word w) {
+  memcpy(p, &w, WORD_BYTES);
+}
+
+/**
+ * Name: byteSwapWord
+ * @brief Reverses the order of the bytes in a word.
+ */
+static inline Word byteSwapWord(Word w) {
+  if (WORD_BYTES == 8) return (Word)__builtin_bswap64((uint64_t)w);
+  return (Word)__builtin_bswap32((uint32_t)w);
+}
+
 /**
  * Name: mem_copy
  * @brief Demo Task 4.2: Memory Copy
- * @details  Copies `n` bytes from `src` to `dest`.
+ * @details  Copies `n` bytes from `src` to `dest`, which must not overlap.
+ *      Bytes are copied one at a time until dest is word aligned, then four words per
+ *      iteration, then single words, then the remaining tail bytes. When src has a different
+ *      alignment from dest only the stores are aligned.
  * @param dest pointer to destination
  * @param src pointer to source
  * @param n number of bytes to copy
  */
 void mem_copy(void *dest, const void *src, size_t n) {
   // complete the function
-  if (n <= 0){
+  if (n == 0){
     return;
   }
 
   char *d = (char *)dest;
   const char *s = (const char *)src;
-  
-  for (size_t i = 0; i < n; i++){
-    d[i] = s[i];
+
+  // head: up to the first word boundary of dest
+  while (n > 0 && ((uintptr_t)d & (WORD_BYTES - 1)) != 0) {
+    *d++ = *s++;
+    n--;
+  }
+
+  // body
+  while (n >= 4 * WORD_BYTES) {
+    Word w0 = loadWord(s);
+    Word w1 = loadWord(s + WORD_BYTES);
+    Word w2 = loadWord(s + 2 * WORD_BYTES);
+    Word w3 = loadWord(s + 3 * WORD_BYTES);
+    storeWord(d, w0);
+    storeWord(d + WORD_BYTES, w1);
+    storeWord(d + 2 * WORD_BYTES, w2);
+    storeWord(d + 3 * WORD_BYTES, w3);
+    d += 4 * WORD_BYTES;
+    s += 4 * WORD_BYTES;
+    n -= 4 * WORD_BYTES;
+  }
+  while (n >= WORD_BYTES) {
+    storeWord(d, loadWord(s));
+    d += WORD_BYTES;
+    s += WORD_BYTES;
+    n -= WORD_BYTES;
+  }
+
+  // tail
+  while (n > 0) {
+    *d++ = *s++;
+    n--;
   }
 }
 
@@ -242,6 +709,9 @@ void mem_copy(void *dest, const void *src, size_t n) {
  * Name: array_modify
  * @brief Demo Task 4.3: Array Modify
  * @details Modifies each element of the array using a function pointer.
+ *      Kept for existing callers: every element costs an indirect call. New code should
+ *      pass a lambda or makePipeline(...) to transformArray (ArrayTransform.h) instead,
+ *      which inlines the transforms and fuses several into one pass.
  * @param arr pointer to static (non dynamic) array to modify
  * @param len length of array
  * @param mod_func function pointer which points to the function to apply to each element
@@ -250,14 +720,11 @@ void mem_copy(void *dest, const void *src, size_t n) {
  */
 int array_modify(int *arr, size_t len, int (*mod_func)(int)) {
   // complete the function
-  if(arr == NULL || mod_func == NULL) {
+  if(mod_func == NULL) {
     return -1;
   }
 
-  for(int i = 0; i < len; i++){
-    arr[i] = mod_func(arr[i]);
-  }
-  return 0;
+  return transformArray(arr, len, mod_func);
 }
 
 /**
@@ -280,37 +747,360 @@ void print_static_array(int *arr, size_t len){
   printString("]\n");
 }
 
+/**
+ * Name: allDigits4
+ * @brief True if the 4 bytes of v are all '0' to '9'.
+ * @details The first test keeps every byte in 0x30 to 0x3F, so adding 6 cannot carry between
+ *      bytes; the second then pushes 0x3A to 0x3F out of that range.
+ */
+static inline bool allDigits4(uint32_t v) {
+  return (v & 0xF0F0F0F0u) == 0x30303030u && ((v + 0x06060606u) & 0xF0F0F0F0u) == 0x30303030u;
+}
+
+/**
+ * Name: allDigits8
+ * @brief True if the 8 bytes of v are all '0' to '9'. See allDigits4.
+ */
+static inline bool allDigits8(uint64_t v) {
+  return (v & 0xF0F0F0F0F0F0F0F0ull) == 0x3030303030303030ull &&
+         ((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) == 0x3030303030303030ull;
+}
+
+/**
+ * Name: parseDigits4
+ * @brief Value of 4 ASCII digits, the first in the low byte.
+ * @details Forms the pairs d0d1 and d2d3 in bytes 0 and 2 with one multiply, then combines them.
+ */
+static inline uint32_t parseDigits4(uint32_t v) {
+  v -= 0x30303030u;
+  v = v * 10 + (v >> 8);
+  return (v & 0xFF) * 100 + ((v >> 16) & 0xFF);
+}
+
+/**
+ * Name: parseDigits8
+ * @brief Value of 8 ASCII digits, the first in the low byte.
+ * @details Pairs as in parseDigits4, then two multiplies place the four pairs at
+ *      10^6, 10^4, 10^2 and 1 in the upper half of the product.
+ */
+static inline uint32_t parseDigits8(uint64_t v) {
+  v -= 0x3030303030303030ull;
+  v = v * 10 + (v >> 8);
+  v = ((v & 0x000000FF000000FFull) * (100 + (1000000ull << 32)) +
+       ((v >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32))) >> 32;
+  return (uint32_t)v;
+}
+
 /**
  * Name: str_to_int
  * @brief Demo Task 4.4: String Array
  * @details Converts a string representing a positive unsigned integer into its numeric equivalent
- *      String representing a positive unsigned integer into its numeric equivalent
+ *      String representing a positive unsigned integer into its numeric equivalent.
+ *      An optional leading '-' makes it negative. The string is measured once, then read
+ *      8 and 4 digits at a time, each group validated and converted with word arithmetic.
+ *      The running value is checked against the int range after every group, so any
+ *      number of leading zeros is accepted but no value outside INT_MIN..INT_MAX is.
  * @param str pointer to string
- * @retval -1 if error
+ * @retval -1 if error: NULL, no digits, a character other than '0' to '9', or out of range
  * @return integer equivalent of the string
  */
 int str_to_int(const char *str) {
   if(str == NULL) return -1;
   bool isNeg = false;
 
-  if(str[0] == '-') isNeg = true;
+  if(str[0] == '-') {
+    isNeg = true;
+    str++;
+  }
+
+  size_t len = strlen(str);
+  if(len == 0) return -1;
 
-  int currNum = 0;
-  for (int i = 0; i < strlen(str); i++){
-    if(isNeg && i > 0) {
-      if(str[i] < 48 || str[i] > 58) {
-        return -1;
-      }
-      currNum = currNum * 10 + (str[i] - 48);
+  const uint64_t limit = isNeg ? (uint64_t)INT_MAX + 1 : (uint64_t)INT_MAX;
+  uint64_t currNum = 0;
+
+  while (len >= 8) {
+    uint64_t v;
+    memcpy(&v, str, 8);
+    if(!allDigits8(v)) return -1;
+    currNum = currNum * 100000000u + parseDigits8(v);
+    if(currNum > limit) return -1;
+    str += 8;
+    len -= 8;
+  }
+  if (len >= 4) {
+    uint32_t v;
+    memcpy(&v, str, 4);
+    if(!allDigits4(v)) return -1;
+    currNum = currNum * 10000u + parseDigits4(v);
+    str += 4;
+    len -= 4;
+  }
+  while (len > 0) {
+    if(*str < '0' || *str > '9') return -1;
+    currNum = currNum * 10 + (*str - '0');
+    str++;
+    len--;
+  }
+  if(currNum > limit) return -1;
+
+  return isNeg ? (int)(0 - currNum) : (int)currNum;
+}
+
+// =========== BitSet ===========
+
+/**
+ * Name: packBinary8
+ * @brief Packs 8 characters '0'/'1', first one most significant, into a byte.
+ * @details One multiply gathers the low bit of each byte into the top byte of the product.
+ * @retval false if any of the 8 characters is not '0' or '1'.
+ */
+static inline bool packBinary8(const char *p, uint8_t *out) {
+  uint64_t v;
+  memcpy(&v, p, 8);
+  if ((v & 0xFEFEFEFEFEFEFEFEull) != 0x3030303030303030ull) return false;
+  *out = (uint8_t)(((v - 0x3030303030303030ull) * 0x8040201008040201ull) >> 56);
+  return true;
+}
+
+/**
+ * Name: unpackBinary8
+ * @brief Writes the 8 bits of a byte as characters '0'/'1', most significant first.
+ */
+static inline void unpackBinary8(uint8_t byte, char *p) {
+  uint64_t v = ((((uint64_t)byte * 0x8040201008040201ull) >> 7) & 0x0101010101010101ull) | 0x3030303030303030ull;
+  memcpy(p, &v, 8);
+}
+
+/**
+ * Name: topWordMask
+ * @brief Bits of the top word that lie within the width of the set.
+ */
+static inline uint64_t topWordMask(const BitSet *set) {
+  size_t rem = set->bits % 64;
+  return rem ? ((1ull << rem) - 1) : ~0ull;
+}
+
+/**
+ * Name: initBitSet
+ * @brief Initializes a BitSet of the given width with every bit 0.
+ * @param set BitSet to initialize; must not hold words already.
+ * @param bits width in bits, may be 0.
+ * @retval false if the words could not be allocated; the set then has width 0.
+ */
+bool initBitSet(BitSet *set, size_t bits) {
+  set->bits = bits;
+  set->nwords = (bits + 63) / 64;
+  set->words = NULL;
+  if (set->nwords == 0) return true;
+
+  set->words = (uint64_t *)labCalloc(ALLOC_TAG_BITSET, set->nwords, sizeof(uint64_t));
+  if (set->words == NULL) {
+    set->bits = set->nwords = 0;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Name: freeBitSet
+ * @brief Frees the words of a BitSet and leaves it with width 0.
+ */
+void freeBitSet(BitSet *set) {
+  labFree(ALLOC_TAG_BITSET, set->words, set->nwords * sizeof(uint64_t));
+  set->words = NULL;
+  set->bits = set->nwords = 0;
+}
+
+/**
+ * Name: bitsetFromString
+ * @brief Initializes a BitSet from a binary string such as "10110", last character bit 0.
+ * @details Reads 8 characters per step from the end of the string, validating and packing
+ *      them with packBinary8, so a wide string costs O(bits / 8) steps.
+ * @param set BitSet to initialize; must not hold words already.
+ * @param str string of '0' and '1' characters.
+ * @param minBits the set is zero-extended to at least this width.
+ * @retval false if str is NULL, holds another character or the words could not be allocated;
+ *      the set then has width 0.
+ */
+bool bitsetFromString(BitSet *set, const char *str, size_t minBits) {
+  if (str == NULL) {
+    initBitSet(set, 0);
+    return false;
+  }
+  size_t len = strlen(str);
+  if (!initBitSet(set, len > minBits ? len : minBits)) return false;
+
+  const char *end = str + len;
+  size_t bit = 0;
+  while (end - str >= 8) {
+    end -= 8;
+    uint8_t byte;
+    if (!packBinary8(end, &byte)) {
+      freeBitSet(set);
+      return false;
     }
-    else if(!isNeg && i >=0) {
-      if(str[i] < 48 || str[i] > 58) {
-        return -1;
-      }
-      currNum = currNum * 10 + (str[i] - 48);
+    set->words[bit / 64] |= (uint64_t)byte << (bit % 64);
+    bit += 8;
+  }
+  while (end > str) {
+    end--;
+    if (*end != '0' && *end != '1') {
+      freeBitSet(set);
+      return false;
     }
+    set->words[bit / 64] |= (uint64_t)(*end - '0') << (bit % 64);
+    bit++;
   }
-  return isNeg ? -1 * currNum : currNum;
+  return true;
+}
+
+/**
+ * Name: bitsetTest
+ * @brief Value of one bit; false past the width.
+ */
+bool bitsetTest(const BitSet *set, size_t bit) {
+  if (bit >= set->bits) return false;
+  return (set->words[bit / 64] >> (bit % 64)) & 1;
+}
+
+/**
+ * Name: bitsetAnd
+ * @brief dst = a AND b, a word at a time. dst may be a or b.
+ * @retval false unless all three have the same width.
+ */
+bool bitsetAnd(BitSet *dst, const BitSet *a, const BitSet *b) {
+  if (dst->bits != a->bits || a->bits != b->bits) return false;
+  for (size_t i = 0; i < dst->nwords; i++) dst->words[i] = a->words[i] & b->words[i];
+  return true;
+}
+
+/**
+ * Name: bitsetOr
+ * @brief dst = a OR b, a word at a time. dst may be a or b.
+ * @retval false unless all three have the same width.
+ */
+bool bitsetOr(BitSet *dst, const BitSet *a, const BitSet *b) {
+  if (dst->bits != a->bits || a->bits != b->bits) return false;
+  for (size_t i = 0; i < dst->nwords; i++) dst->words[i] = a->words[i] | b->words[i];
+  return true;
+}
+
+/**
+ * Name: bitsetXor
+ * @brief dst = a XOR b, a word at a time. dst may be a or b.
+ * @retval false unless all three have the same width.
+ */
+bool bitsetXor(BitSet *dst, const BitSet *a, const BitSet *b) {
+  if (dst->bits != a->bits || a->bits != b->bits) return false;
+  for (size_t i = 0; i < dst->nwords; i++) dst->words[i] = a->words[i] ^ b->words[i];
+  return true;
+}
+
+/**
+ * Name: bitsetNot
+ * @brief dst = NOT a within the width, a word at a time. dst may be a.
+ * @retval false unless both have the same width.
+ */
+bool bitsetNot(BitSet *dst, const BitSet *a) {
+  if (dst->bits != a->bits) return false;
+  for (size_t i = 0; i < dst->nwords; i++) dst->words[i] = ~a->words[i];
+  if (dst->nwords > 0) dst->words[dst->nwords - 1] &= topWordMask(dst);
+  return true;
+}
+
+/**
+ * Name: bitsetCount
+ * @brief Number of bits set, with one hardware popcount per word.
+ */
+size_t bitsetCount(const BitSet *set) {
+  size_t ones = 0;
+  for (size_t i = 0; i < set->nwords; i++) ones += __builtin_popcountll(set->words[i]);
+  return ones;
+}
+
+/**
+ * Name: bitsetStats
+ * @brief Bits set and the lowest and highest set bit, in one pass over the words.
+ */
+void bitsetStats(const BitSet *set, BitSetStats *stats) {
+  stats->ones = 0;
+  stats->lowest = -1;
+  stats->highest = -1;
+  for (size_t i = 0; i < set->nwords; i++) {
+    uint64_t w = set->words[i];
+    if (w == 0) continue;
+    stats->ones += __builtin_popcountll(w);
+    if (stats->lowest < 0) stats->lowest = (long)(64 * i + __builtin_ctzll(w));
+    stats->highest = (long)(64 * i + 63 - __builtin_clzll(w));
+  }
+}
+
+/**
+ * Name: printBitSet
+ * @brief Prints the set as a binary string, most significant bit first.
+ * @details Each word is expanded 8 bits per step into a line buffer and printed with one
+ *      printString, so a wide set costs O(bits / 64) prints.
+ */
+void printBitSet(const BitSet *set) {
+  char line[65];
+  for (size_t w = set->nwords; w-- > 0;) {
+    uint64_t word = set->words[w];
+    size_t n = (w == set->nwords - 1) ? set->bits - 64 * w : 64;  // only the top word is partial
+    char *p = line;
+    size_t lead = n % 8;
+    for (size_t i = lead; i-- > 0;) *p++ = '0' + ((word >> (n - lead + i)) & 1);
+    for (size_t i = n - lead; i >= 8; i -= 8, p += 8) unpackBinary8((uint8_t)(word >> (i - 8)), p);
+    *p = '\0';
+    printString(line);
+  }
+}
+
+/**
+ * Name: string_to_binary
+ * @brief Converts a binary string such as "10110" into its value.
+ * @details Packs 8 characters per step with packBinary8. Leading zeros are accepted in any number.
+ * @param str pointer to string of '0' and '1' characters
+ * @retval -1 if error: NULL, empty, another character or more than 31 significant bits
+ * @return value of the string
+ */
+int string_to_binary(const char *str) {
+  if(str == NULL) return -1;
+  size_t len = strlen(str);
+  while(len > 31 && *str == '0') {
+    str++;
+    len--;
+  }
+  if(len == 0 || len > 31) return -1;
+
+  uint32_t value = 0;
+  while(len >= 8) {
+    uint8_t byte;
+    if(!packBinary8(str, &byte)) return -1;
+    value = (value << 8) | byte;
+    str += 8;
+    len -= 8;
+  }
+  while(len > 0) {
+    if(*str != '0' && *str != '1') return -1;
+    value = (value << 1) | (uint32_t)(*str - '0');
+    str++;
+    len--;
+  }
+  return (int)value;
+}
+
+/**
+ * Name: printTruthRow
+ * @brief One row of print_truth_table: label, bits set, then the bits.
+ */
+static void printTruthRow(const char *label, const BitSet *set) {
+  printString(label);
+  printString("\t");
+  printUInt(bitsetCount(set));
+  printString("\t");
+  printBitSet(set);
+  printString("\n");
 }
 
 /**
@@ -318,51 +1108,137 @@ int str_to_int(const char *str) {
  * @brief Demo Task 4.5: Print Truth Table
  * @details Observed Behavior: Computes and displays a truth table from two binary strings.
  *      Commented Purpose: Explains bitwise operations and string parsing.
- *      Edge Case Handling: Limits output to 16 bits max.
- *      Function to print the truth table for bitwise operations
- * @param a pointer to string which contains only numbers
- * @param b pointer to string which contains only numbers
+ *      Edge Case Handling: Operands of any width; the shorter one is zero-extended.
+ *      Function to print the truth table for bitwise operations.
+ *      Each row is one operand or operation over every bit position, most significant first,
+ *      computed a 64 bit word at a time with the BitSet functions.
+ * @param a pointer to string which contains only '0' and '1'
+ * @param b pointer to string which contains only '0' and '1'
  */
 void print_truth_table(const char *a, const char *b) {
-  int binary_a = str_to_int(a);
-  int binary_b = str_to_int(b);
+  if(a == NULL || b == NULL) return;
+  size_t width = strlen(a) > strlen(b) ? strlen(a) : strlen(b);
+
+  BitSet setA, setB, result;
+  bool ok = bitsetFromString(&setA, a, width);
+  ok = bitsetFromString(&setB, b, width) && ok;
+  ok = initBitSet(&result, width) && ok;
+  if(!ok) {
+    printString("Truth table needs two binary strings.\n");
+    freeBitSet(&setA);
+    freeBitSet(&setB);
+    freeBitSet(&result);
+    return;
+  }
 
   // Print table header using Special590functions
   printString("\nTruth Table for Bitwise Operations\n");
   printString("------------------------------------------\n");
-  printString("Index\tA\tB\tA AND B\tA OR B\tA XOR B\tNOT A\tNOT B\n");
+  printString("Row\tOnes\tBits (MSB first)\n");
   printString("------------------------------------------\n");
 
-  // Loop through each bit position (up to 16 bits)
-  for (int i = 0; i <= 15; i++) {
-    if((binary_a >> i) > 0 ||  (binary_b >> i) > 0) {
-      int bit_A = (binary_a >> i) & 1;
-      int bit_B = (binary_b >> i) & 1;
-      int bit_and = bit_A & bit_B;
-      int bit_xor = bit_A ^ bit_B;
-      int bit_or = bit_A | bit_B;
-      int bit_not_A = (~binary_a >> i) & 1;
-      int bit_not_B = (~binary_b >> i) & 1;
-
-      printInt(i);
-      printString("\t");
-      printInt(bit_A);
-      printString("\t");
-      printInt(bit_B);
-      printString("\t");
-      printInt(bit_and);
-      printString("\t");
-      printInt(bit_or);
+  printTruthRow("A", &setA);
+  printTruthRow("B", &setB);
+  bitsetAnd(&result, &setA, &setB);
+  printTruthRow("A AND B", &result);
+  bitsetOr(&result, &setA, &setB);
+  printTruthRow("A OR B", &result);
+  bitsetXor(&result, &setA, &setB);
+  printTruthRow("A XOR B", &result);
+  bitsetNot(&result, &setA);
+  printTruthRow("NOT A", &result);
+  bitsetNot(&result, &setB);
+  printTruthRow("NOT B", &result);
+  printString("------------------------------------------\n");
+
+  freeBitSet(&setA);
+  freeBitSet(&setB);
+  freeBitSet(&result);
+}
+
+/**
+ * Name: fillBitSetPattern
+ * @brief Fills a set with xorshift64 bits from a seed, for printOperationComparisonTable.
+ */
+static void fillBitSetPattern(BitSet *set, uint64_t seed) {
+  uint64_t x = seed | 1;
+  for (size_t i = 0; i < set->nwords; i++) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    set->words[i] = x;
+  }
+  if (set->nwords > 0) set->words[set->nwords - 1] &= topWordMask(set);
+}
+
+/**
+ * Name: printOperationComparisonTable
+ * @brief Compares AND, OR, XOR and NOT over operand pairs of increasing width.
+ * @details The first pair is the Task 4 example ("10000", "1100"); the wider ones are
+ *      pseudo-random. Each row gives the bits set in the operands and in each result,
+ *      and the highest bit where the operands differ. One row costs O(bits / 64) word
+ *      operations and popcounts and a fixed number of prints.
+ */
+void printOperationComparisonTable() {
+  static const size_t widths[] = {0, 64, 1024, 8192};  // 0: the Task 4 example strings
+
+  printString("\nBitwise Operation Comparison (bits set)\n");
+  printString("--------------------------------------------------------------------\n");
+  printString("Bits\t|A|\t|B|\tAND\tOR\tXOR\tNOT A\tNOT B\tTop diff\n");
+  printString("--------------------------------------------------------------------\n");
+
+  for (size_t row = 0; row < sizeof(widths) / sizeof(widths[0]); row++) {
+    BitSet setA, setB, result;
+    bool ok;
+    if (widths[row] == 0) {
+      ok = bitsetFromString(&setA, "10000", 5);
+      ok = bitsetFromString(&setB, "1100", 5) && ok;
+    } else {
+      ok = initBitSet(&setA, widths[row]);
+      ok = initBitSet(&setB, widths[row]) && ok;
+      if (ok) {
+        fillBitSetPattern(&setA, 0x9E3779B97F4A7C15ull + row);
+        fillBitSetPattern(&setB, 0xC2B2AE3D27D4EB4Full + row);
+      }
+    }
+    ok = initBitSet(&result, setA.bits) && ok;
+
+    if (ok) {
+      size_t counts[5];
+      bitsetAnd(&result, &setA, &setB);
+      counts[0] = bitsetCount(&result);
+      bitsetOr(&result, &setA, &setB);
+      counts[1] = bitsetCount(&result);
+      bitsetXor(&result, &setA, &setB);
+      counts[2] = bitsetCount(&result);
+      BitSetStats diff;
+      bitsetStats(&result, &diff);
+      counts[3] = setA.bits - bitsetCount(&setA);  // |NOT A| without forming it
+      counts[4] = setB.bits - bitsetCount(&setB);
+
+      printUInt(setA.bits);
       printString("\t");
-      printInt(bit_xor);
+      printUInt(bitsetCount(&setA));
       printString("\t");
-      printInt(bit_not_A);
+      printUInt(bitsetCount(&setB));
+      for (int i = 0; i < 5; i++) {
+        printString("\t");
+        printUInt(counts[i]);
+      }
       printString("\t");
-      printInt(bit_not_B);
+      printInt(diff.highest);
+      printString("\n");
+    } else {
+      printString("Out of memory for width ");
+      printUInt(widths[row]);
       printString("\n");
     }
+
+    freeBitSet(&setA);
+    freeBitSet(&setB);
+    freeBitSet(&result);
   }
-  printString("------------------------------------------\n");
+  printString("--------------------------------------------------------------------\n");
 }
 
 /**
@@ -378,6 +1254,8 @@ void print_truth_table(const char *a, const char *b) {
  * Name: reverseString
  * @brief Demo Task 5.1: String Manipulation
  * @details Reverses a null-terminated string provided in place. 
+ *      While the two ends are at least two words apart, a word is taken from each end,
+ *      byte swapped and stored at the other end; the middle is finished a byte at a time.
  * @param str pointer to string which will be reversed.
  */
 void reverseString(char *str) {
@@ -393,8 +1271,19 @@ void reverseString(char *str) {
   char temp;
 
   ptr_beg = str;
-  ptr_end = str + strlen(str) - 1;
+  ptr_end = str + strlen(str);  // one past the last character
+
+  while (ptr_end - ptr_beg >= (ptrdiff_t)(2 * WORD_BYTES)) {
+    Word front = loadWord(ptr_beg);
+    Word back = loadWord(ptr_end - WORD_BYTES);
+    storeWord(ptr_beg, byteSwapWord(back));
+    storeWord(ptr_end - WORD_BYTES, byteSwapWord(front));
 
+    ptr_beg += WORD_BYTES;
+    ptr_end -= WORD_BYTES;
+  }
+
+  ptr_end--;
   while (ptr_beg < ptr_end) {
     temp = *ptr_beg;
     *ptr_beg = *ptr_end;
@@ -408,12 +1297,12 @@ void reverseString(char *str) {
 /**
  * Name: initBuffer
  * @brief Demo Task 5.2: Circular Buffer
- * @details COMPLETED SAMPLE FUNCTION. Mallocs buffer, sets up head, tail, count and max size
+ * @details COMPLETED SAMPLE FUNCTION. Allocates buffer, sets up head, tail, count and max size
  * @param cb pointer to circular buffer to be initialized.
  * @param size size of which to initialize the buffer
  */
 void initBuffer(CircularBuffer *cb, size_t size) {
-  cb->buffer = (int *)malloc(size * sizeof(int));
+  cb->buffer = (int *)labAlloc(ALLOC_TAG_BUFFER, size * sizeof(int));
   cb->head = 0;
   cb->tail = 0;
   cb->count = 0;
@@ -427,7 +1316,7 @@ void initBuffer(CircularBuffer *cb, size_t size) {
  * @param cb pointer to circular buffer to be freed.
  */
 void freeBuffer(CircularBuffer *cb) {
-  free(cb->buffer);
+  labFree(ALLOC_TAG_BUFFER, cb->buffer, cb->max_size * sizeof(int));
   cb->buffer = NULL;
   cb->head = 0;
   cb->tail = 0;
@@ -485,11 +1374,9 @@ void writeBuffer(CircularBuffer *cb, int value) {
     }
     cb->count++;
 
-    printString("Write: ");
-    printInt(value);
-    printString("\n");
+    TRACE_INFO(TRACE_EV_WRITE, value, 0);
   } else {
-    printString("Buffer is Full. Unable to write more.\n");
+    TRACE_WARN(TRACE_EV_WRITE_FULL, value, 0);
   }
 }
 
@@ -507,9 +1394,7 @@ int readBuffer(CircularBuffer *cb) {
   // Read value at tail.
   // Return value.
   if(isEmpty(cb)) return -1;
-  printString("Read -> ");
-  printInt(cb->buffer[cb->tail]);
-  printString("\n");
+  TRACE_INFO(TRACE_EV_READ, cb->buffer[cb->tail], 0);
   return cb->buffer[cb->tail];
 }
 
@@ -527,9 +1412,7 @@ int popBuffer(CircularBuffer *cb) {
   // Advance tail, reduce size.
   // Return value.
   if(isEmpty(cb)) {
-    printString("Pop ");
-    printInt(-1);
-    printString("\n");
+    TRACE_WARN(TRACE_EV_POP_EMPTY, -1, 0);
     return -1;
   }
   
@@ -543,11 +1426,7 @@ int popBuffer(CircularBuffer *cb) {
   cb->count--;
 
   //Documentation
-  printString("Pop ");
-  printInt(value);
-  printString(". Tail at: ");
-  printInt(cb->tail);
-  printString("\n");
+  TRACE_INFO(TRACE_EV_POP, value, cb->tail);
 
   //return
   return value;
@@ -566,70 +1445,61 @@ void pushBuffer(CircularBuffer *cb, int value) {
   // Write at head.
   // Advance head.
   // If not full, increment size.
-  printString("Push ");
-  printInt(value);
-  printString("\n");
-
   if(!isFull(cb)){
     cb->count++;
   } else {
-    printString("Overwrote Tail. Was full. Initial at ");
-    printInt(cb->tail);
-    printString(". Tail is now at ");
+    size_t old_tail = cb->tail;
     if(cb->tail == cb->max_size) {
       cb->tail = 0;
     } else {
       cb->tail++;
     }
-    printInt(cb->tail);
-    printString("\n");
+    TRACE_INFO(TRACE_EV_PUSH_OVERWRITE, old_tail, cb->tail);
   }
   
-  printString("Head rewritten at ");
-  printInt(cb->head);
-  printString(". New Head at ");
   cb->buffer[cb->head] = value;
   if(cb->head == cb->max_size - 1) {
     cb->head = 0;
   } else {
     cb->head++;
   }  
-  printInt(cb->head);
-  printString("\n");
+  TRACE_INFO(TRACE_EV_PUSH, value, cb->head);
 }
 
 /**
  * Name: resizeBuffer
  * @brief Demo Task 5.2: Circular Buffer
- * @details resizes buffer, keeping FIFO order
+ * @details resizes buffer, keeping FIFO order. The contents are moved with at most two
+ *      memcpy calls (tail to end of buffer, then start of buffer to head).
  * @param cb pointer to circular buffer.
- * @param new_size Size that is larger than the original size of the cb. 
+ * @param new_size New size, which may be smaller than the original as long as it still holds count elements.
  */
 void resizeBuffer(CircularBuffer *cb, size_t new_size) {
   // Allocate a new array with the new capacity.
   // Copy the old values (in correct FIFO order) into the new buffer.
   // Free the old buffer.
   // Update buffer pointers and capacity.
-  printString("Attempting resize from ");
-  printInt(cb->max_size);
-  printString(" to ");
-  printInt(new_size);
-  printString("\n");
-
-  if(new_size < cb->max_size) {
-    printString("New size cannot be smaller than the old size. Keeping things the same.\n");
+  if(new_size < cb->count || new_size == 0) {
+    TRACE_WARN(TRACE_EV_RESIZE_REJECTED, cb->max_size, new_size);
     return;
   }
   
-  int* buffer2 = (int *)malloc(new_size * sizeof(int));
-  for (int i = 0; i < cb->count; i++){
-    buffer2[i] = cb->buffer[(cb->tail + i) % cb->max_size];
+  int* buffer2 = (int *)labAlloc(ALLOC_TAG_BUFFER, new_size * sizeof(int));
+  if(buffer2 == NULL) {
+    TRACE_WARN(TRACE_EV_RESIZE_REJECTED, cb->max_size, new_size);
+    return;
   }
 
-  free(cb->buffer);
+  size_t first = cb->max_size - cb->tail;
+  if(first > cb->count) first = cb->count;
+  memcpy(buffer2, cb->buffer + cb->tail, first * sizeof(int));
+  memcpy(buffer2 + first, cb->buffer, (cb->count - first) * sizeof(int));
+
+  labFree(ALLOC_TAG_BUFFER, cb->buffer, cb->max_size * sizeof(int));
   cb->buffer = buffer2;
-  cb->head = cb->count;
+  cb->head = (cb->count == new_size) ? 0 : cb->count;
   cb->tail = 0;
+  TRACE_INFO(TRACE_EV_RESIZE, cb->max_size, new_size);
   cb->max_size = new_size;
 }
 
@@ -637,55 +1507,672 @@ void resizeBuffer(CircularBuffer *cb, size_t new_size) {
  * @}
  */
 
+/**
+ * @name SPSC Circular Buffer
+ * @{
+ */
+
+/**
+ * Name: initSpscBuffer
+ * @brief Lock-free Circular Buffer
+ * @details Allocates buffer with the capacity rounded up to the next power of two so the
+ *      index wrap is a mask instead of a branch or modulo. head and tail start at 0.
+ *      Error Handling: prints an error and leaves the buffer with capacity 0 on allocation failure.
+ * @param cb pointer to SPSC circular buffer to be initialized.
+ * @param size minimum number of elements the buffer must hold.
+ */
+void initSpscBuffer(SpscCircularBuffer *cb, size_t size) {
+  size_t capacity = 1;
+  while (capacity < size) {
+    capacity <<= 1;
+  }
+
+  cb->buffer = (int *)labAlloc(ALLOC_TAG_SPSC, capacity * sizeof(int));
+  cb->mask = (cb->buffer == NULL) ? 0 : capacity - 1;
+  cb->head.store(0, std::memory_order_relaxed);
+  cb->tail.store(0, std::memory_order_relaxed);
+
+  if (cb->buffer == NULL) {
+    printString("Initialization of SPSC Buffer failed.\n");
+  }
+}
+
+/**
+ * Name: freeSpscBuffer
+ * @brief Lock-free Circular Buffer
+ * @details frees buffer, sets pointer to NULL, resets indices. Must not race with either side.
+ * @param cb pointer to SPSC circular buffer to be freed.
+ */
+void freeSpscBuffer(SpscCircularBuffer *cb) {
+  labFree(ALLOC_TAG_SPSC, cb->buffer, (cb->mask + 1) * sizeof(int));
+  cb->buffer = NULL;
+  cb->mask = 0;
+  cb->head.store(0, std::memory_order_relaxed);
+  cb->tail.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * Name: writeSpscBuffer
+ * @brief Lock-free Circular Buffer (producer side)
+ * @details Writes a value at head if not full, then publishes it with a release store so
+ *      the consumer never observes the index before the data. Does not print, so it is
+ *      safe to call from a timer ISR while a task pops.
+ * @param cb pointer to SPSC circular buffer to be written to.
+ * @param value value to be written.
+ * @retval true if the value was written.
+ * @retval false if the buffer was full and the value was dropped.
+ */
+bool IRAM_ATTR writeSpscBuffer(SpscCircularBuffer *cb, int value) {
+  size_t head = cb->head.load(std::memory_order_relaxed);
+  size_t tail = cb->tail.load(std::memory_order_acquire);
+
+  if (cb->buffer == NULL || head - tail > cb->mask) {
+    return false;
+  }
+
+  cb->buffer[head & cb->mask] = value;
+  cb->head.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+/**
+ * Name: readSpscBuffer
+ * @brief Lock-free Circular Buffer (consumer side)
+ * @details Copies the value at tail without consuming it.
+ * @param cb pointer to SPSC circular buffer.
+ * @param value where the oldest value is stored.
+ * @retval true if a value was read.
+ * @retval false if empty.
+ */
+bool readSpscBuffer(SpscCircularBuffer *cb, int *value) {
+  size_t tail = cb->tail.load(std::memory_order_relaxed);
+  size_t head = cb->head.load(std::memory_order_acquire);
+
+  if (head == tail) {
+    return false;
+  }
+
+  *value = cb->buffer[tail & cb->mask];
+  return true;
+}
+
+/**
+ * Name: popSpscBuffer
+ * @brief Lock-free Circular Buffer (consumer side)
+ * @details Copies the value at tail, then releases the slot back to the producer by
+ *      advancing tail with a release store.
+ * @param cb pointer to SPSC circular buffer.
+ * @param value where the popped value is stored.
+ * @retval true if a value was popped.
+ * @retval false if empty.
+ */
+bool IRAM_ATTR popSpscBuffer(SpscCircularBuffer *cb, int *value) {
+  size_t tail = cb->tail.load(std::memory_order_relaxed);
+  size_t head = cb->head.load(std::memory_order_acquire);
+
+  if (head == tail) {
+    return false;
+  }
+
+  *value = cb->buffer[tail & cb->mask];
+  cb->tail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+/**
+ * Name: spscBufferCount
+ * @brief Lock-free Circular Buffer
+ * @details Number of elements currently held. Can be called from either side; the value
+ *      may already be stale by the time it returns if the other side is running.
+ * @param cb pointer to SPSC circular buffer.
+ * @return number of elements in the buffer.
+ */
+size_t spscBufferCount(SpscCircularBuffer *cb) {
+  // tail first: head can only have moved further by the time it is read, so this never underflows
+  size_t tail = cb->tail.load(std::memory_order_acquire);
+  return cb->head.load(std::memory_order_acquire) - tail;
+}
+
+/**
+ * Name: isSpscEmpty
+ * @brief Lock-free Circular Buffer
+ * @param cb pointer to SPSC circular buffer.
+ * @retval true if buffer holds no elements.
+ */
+bool isSpscEmpty(SpscCircularBuffer *cb) {
+  return spscBufferCount(cb) == 0;
+}
+
+/**
+ * Name: isSpscFull
+ * @brief Lock-free Circular Buffer
+ * @param cb pointer to SPSC circular buffer.
+ * @retval true if buffer holds capacity elements.
+ */
+bool isSpscFull(SpscCircularBuffer *cb) {
+  return cb->buffer == NULL || spscBufferCount(cb) > cb->mask;
+}
+
+/**
+ * @}
+ */
+
+static int32_t sensorSum = 0; // sum of the samples held in the ring buffer, reset when it is drained
+
+/**
+ * Name: sampleSensor
+ * @brief Demo Task 6 part a: reads the LDR once and stores the value in the ring buffer.
+ * @details Meant to run every SENSOR_SAMPLE_US, e.g. as a soft timer job.
+ * @param cb pointer to the sample ring buffer.
+ */
+void sampleSensor(SensorBuffer *cb) {
+  int sample = analogRead(LEDR);
+  if(cb->push(sample)) {
+    sensorSum += sample;
+    TRACE_INFO(TRACE_EV_WRITE, sample, 0);
+  } else {
+    TRACE_WARN(TRACE_EV_WRITE_FULL, sample, 0);
+  }
+}
+
+/**
+ * Name: averageSensor
+ * @brief Demo Task 6 part b: stores the average of the recent samples and prints the array.
+ * @details Meant to run every SENSOR_AVERAGE_US.
+ *          • Compute the average of the values currently in the circular buffer.
+ *          • Store this average in the dynamic array.
+ *          • Print the contents of the dynamic array to the serial monitor.
+ *          • Clear the Circular buffer
+ *          The sum of the buffered samples is kept as they are pushed, so the average is
+ *          one division and the buffer is cleared without reading it. The mean is rounded,
+ *          and is 0 if no sample was taken since the last average.
+ * @param cb pointer to the sample ring buffer.
+ * @param processedData pointer to Dynamic Array.
+ */
+void averageSensor(SensorBuffer *cb, DynamicArray *processedData) {
+  int32_t n = (int32_t)cb->size();
+  int i = (n > 0) ? (int)((sensorSum + n / 2) / n) : 0;
+  cb->consume(n);  // drains the whole buffer in one call
+  sensorSum = 0;
+
+  addElement(processedData, i);
+  printArray(processedData);
+}
+
 /**
  * Name: simulateSensorData
- * @brief Demo Task 6: Buffer Operations (NOT USED)
- * @details Observed Behavior: Reads LDR sensor values at 2 Hz and computes averaged brightness at 1 Hz.
+ * @brief Demo Task 6: Buffer Operations, for callers that poll it every pass instead of using soft timers
+ * @details Observed Behavior: Reads LDR sensor values at 2 Hz and computes averaged brightness every 2.5 s.
  *      Commented Purpose: Integrates sensor input, buffer management, and real-time processing.
- *      Edge Case Handling: Ensures LED brightness updates only on valid data.
+ *      Edge Case Handling: Deadlines are 64 bit times from timer group 0 (1 MHz), so they never wrap.
  *      Error Handling: Assumes circular buffer and dynamic array are initialized.
- * @param cb pointer to circular buffer.
+ * @param cb pointer to the sample ring buffer.
  * @param processedData pointer to Dynamic Array. 
  */
-void simulateSensorData(CircularBuffer *cb, DynamicArray *processedData) {
+void simulateSensorData(SensorBuffer *cb, DynamicArray *processedData) {
   //This function prototype is predefined. You are allowed to modify the function as needed.
   //Note that the functionality of this task is implemented in the loop function. 
 
-  static uint32_t AVG_timer = 0; //basic timer
-  static uint32_t LEDR_timer = 0; //basic timer
-  uint32_t curr_time = *(volatile uint32_t *) TIMG_T0LO_REG(0);
-
-  // 2. Inside the main loop:
-  //    a. Check if 500 milliseconds have passed since the last sample:
-  //       - If yes:
-  //          • Read the current value from the LDR sensor.
-  //          • Store this value into the circular buffer.
-  //          • Reset the 500 ms timer.
-  if(curr_time - LEDR_timer > 1000000/2) {
-    writeBuffer(cb, analogRead(LEDR));
-    LEDR_timer = curr_time;
-  }
-
-  //    b. Check if 2.5 seconds have passed since the last average:
-  //       - If yes:
-  //          • Compute the average of the values currently in the circular buffer.
-  //          • Store this average in the dynamic array.
-  //          • Print the contents of the dynamic array to the serial monitor.
-  //          • Clear the Circular buffer 
-  //          • Reset the 2500 ms timer.
-  if(curr_time - AVG_timer > 1000000 * 5 / 2) {
-    int i = 0; 
-    while(!isEmpty(cb)) {
-      i += popBuffer(cb);
-    }
-    i /= 5;
-    
-    // printString("Current avg circular buffer: ");
-    // printInt(i);
-    // printString("\n");
-
-    addElement(processedData, i);
-    printArray(processedData);
-    AVG_timer = curr_time;
+  static MonotonicClock sensorClock(0, 1);
+  static uint64_t nextSample = SENSOR_SAMPLE_US;
+  static uint64_t nextAverage = SENSOR_AVERAGE_US;
+  uint64_t now = sensorClock.micros();
+
+  if(now >= nextSample) {
+    sampleSensor(cb);
+    nextSample = now + SENSOR_SAMPLE_US;
+  }
+  if(now >= nextAverage) {
+    averageSensor(cb, processedData);
+    nextAverage = now + SENSOR_AVERAGE_US;
+  }
+}
+
+/**
+ * @name Scheduler Simulation
+ * @{
+ */
+
+#define TASK_MAX_RUN_MS 40      // initialize_tasks run times are 1 to this
+#define TASK_MAX_GAP_MS 44      // and arrivals 0 to this apart, about 93% load
+#define TASK_PRIORITY_LEVELS 8  // and priorities 0 to this - 1
+
+static SchedulerPolicy schedPolicy = SCHED_ROUND_ROBIN;
+static uint32_t schedQuantum = SCHED_DEFAULT_QUANTUM_MS;
+static SchedulerStats schedStats;  // Filled in by the last run_scheduler call
+
+static uint32_t *chart = NULL;  // Flowchart being recorded
+static int chartSize = 0;
+static int chartUsed = 0;
+static int lastTask = -1;       // Index of the last task recorded, for counting context switches
+static const Task *sortTasks;   // Task array seen by compareArrival
+
+/**
+ * Name: recordRun
+ * @brief Appends length ms of the task at index (or FLOWCHART_IDLE) to the flowchart.
+ * @details A run of the same task as the last entry extends that entry instead of
+ *      using a new one, so a task that keeps the CPU over several slices costs one entry.
+ *      Once the flowchart is full nothing more is recorded, but the statistics go on.
+ */
+static void recordRun(uint32_t index, uint32_t length) {
+  if(length == 0) return;
+  if(index == FLOWCHART_IDLE) {
+    schedStats.idle += length;
+  } else {
+    if(lastTask >= 0 && (uint32_t)lastTask != index) schedStats.context_switches++;
+    lastTask = index;
+  }
+  if(schedStats.truncated) return;
+
+  while(length > 0) {
+    if(chartUsed > 0 && FLOWCHART_INDEX(chart[chartUsed - 1]) == index) {
+      uint32_t room = FLOWCHART_MAX_RUN - FLOWCHART_LENGTH(chart[chartUsed - 1]);
+      uint32_t add = (length < room) ? length : room;
+      chart[chartUsed - 1] += add;
+      length -= add;
+      if(length == 0) break;
+    }
+    if(chartUsed == chartSize) {
+      schedStats.truncated = true;
+      return;
+    }
+    uint32_t run = (length < FLOWCHART_MAX_RUN) ? length : FLOWCHART_MAX_RUN;
+    chart[chartUsed++] = FLOWCHART_ENTRY(index, run);
+    length -= run;
+  }
+}
+
+/**
+ * Name: finishTask
+ * @brief Marks a task DONE at time now and adds it to the statistics.
+ */
+static void finishTask(Task *t, uint32_t now) {
+  t->state = DONE;
+  t->finish_time = now;
+  uint32_t turnaround = now - t->arrival_time;
+  uint32_t waiting = turnaround - t->run_time;
+  schedStats.total_turnaround += turnaround;
+  schedStats.total_waiting += waiting;
+  if(waiting > schedStats.max_waiting) schedStats.max_waiting = waiting;
+}
+
+/**
+ * Name: compareArrival
+ * @brief qsort order of task indices: arrival time, then position in the array.
+ */
+static int compareArrival(const void *a, const void *b) {
+  int ia = *(const int *)a;
+  int ib = *(const int *)b;
+  uint32_t ta = sortTasks[ia].arrival_time;
+  uint32_t tb = sortTasks[ib].arrival_time;
+  if(ta != tb) return (ta < tb) ? -1 : 1;
+  return (ia < ib) ? -1 : (ia > ib);
+}
+
+/**
+ * Name: heapPush
+ * @brief Adds a key to a binary min-heap of count keys.
+ */
+static void heapPush(uint64_t *heap, int *count, uint64_t key) {
+  int i = (*count)++;
+  while(i > 0) {
+    int parent = (i - 1) / 2;
+    if(heap[parent] <= key) break;
+    heap[i] = heap[parent];
+    i = parent;
+  }
+  heap[i] = key;
+}
+
+/**
+ * Name: heapPop
+ * @brief Removes the smallest key of a non-empty binary min-heap.
+ */
+static void heapPop(uint64_t *heap, int *count) {
+  uint64_t key = heap[--(*count)];
+  int i = 0;
+  for(;;) {
+    int child = 2 * i + 1;
+    if(child >= *count) break;
+    if(child + 1 < *count && heap[child + 1] < heap[child]) child++;
+    if(key <= heap[child]) break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = key;
+}
+
+/**
+ * Name: heapKey
+ * @brief Heap key ordering by primary, then by arrival order; the low half is the
+ *      position in byArrival.
+ */
+static inline uint64_t heapKey(uint32_t primary, int order) {
+  return ((uint64_t)primary << 32) | (uint32_t)order;
+}
+
+/**
+ * Name: runRoundRobin
+ * @brief SCHED_ROUND_ROBIN: the head of a FIFO runs for up to one quantum, then goes to the back.
+ * @details Tasks that arrive during a slice are queued ahead of the task it preempts.
+ *      Cost is one step per slice plus one per idle gap, independent of the time span.
+ * @param byArrival task indices in arrival order.
+ * @param ring scratch for num_tasks queued indices.
+ * @retval finish time of the last task.
+ */
+static uint32_t runRoundRobin(Task *tasks, int num_tasks, const int *byArrival, uint64_t *ring) {
+  int next = 0, head = 0, count = 0, done = 0;
+  uint32_t now = 0;
+
+  while(done < num_tasks) {
+    while(next < num_tasks && tasks[byArrival[next]].arrival_time <= now) {
+      tasks[byArrival[next]].state = READY;
+      ring[(head + count++) % num_tasks] = byArrival[next++];
+    }
+    if(count == 0) {
+      uint32_t arrival = tasks[byArrival[next]].arrival_time;
+      recordRun(FLOWCHART_IDLE, arrival - now);
+      now = arrival;
+      continue;
+    }
+
+    int i = (int)ring[head];
+    head = (head + 1) % num_tasks;
+    count--;
+    Task *t = &tasks[i];
+    uint32_t slice = (t->remaining < schedQuantum) ? t->remaining : schedQuantum;
+    t->state = RUNNING;
+    recordRun(i, slice);
+    now += slice;
+    t->remaining -= slice;
+
+    while(next < num_tasks && tasks[byArrival[next]].arrival_time <= now) {
+      tasks[byArrival[next]].state = READY;
+      ring[(head + count++) % num_tasks] = byArrival[next++];
+    }
+    if(t->remaining == 0) {
+      finishTask(t, now);
+      done++;
+    } else {
+      t->state = READY;
+      ring[(head + count++) % num_tasks] = i;
+    }
+  }
+  return now;
+}
+
+/**
+ * Name: runByKey
+ * @brief SCHED_PRIORITY and SCHED_SHORTEST_JOB: the ready task with the smallest key runs.
+ * @details Priority keys are the task priority and the running task is preempted when a
+ *      more urgent one arrives; shortest job keys are run_time and a task runs to
+ *      completion. Ties go to the earlier arrival. Time advances straight to the next
+ *      completion or arrival, so the cost is O(n log n) in the number of tasks.
+ * @param byArrival task indices in arrival order.
+ * @param heap scratch for num_tasks keys.
+ * @retval finish time of the last task.
+ */
+static uint32_t runByKey(Task *tasks, int num_tasks, const int *byArrival, uint64_t *heap, bool preemptive) {
+  int next = 0, count = 0, done = 0;
+  uint32_t now = 0;
+
+  while(done < num_tasks) {
+    while(next < num_tasks && tasks[byArrival[next]].arrival_time <= now) {
+      Task *a = &tasks[byArrival[next]];
+      a->state = READY;
+      heapPush(heap, &count, heapKey(preemptive ? a->priority : a->run_time, next));
+      next++;
+    }
+    if(count == 0) {
+      uint32_t arrival = tasks[byArrival[next]].arrival_time;
+      recordRun(FLOWCHART_IDLE, arrival - now);
+      now = arrival;
+      continue;
+    }
+
+    int i = byArrival[(uint32_t)heap[0]];
+    Task *t = &tasks[i];
+    uint32_t run = t->remaining;
+    if(preemptive && next < num_tasks) {
+      uint32_t untilArrival = tasks[byArrival[next]].arrival_time - now;
+      if(untilArrival < run) run = untilArrival;
+    }
+    t->state = RUNNING;
+    recordRun(i, run);
+    now += run;
+    t->remaining -= run;
+
+    if(t->remaining == 0) {
+      heapPop(heap, &count);
+      finishTask(t, now);
+      done++;
+    }
   }
+  return now;
 }
+
+/**
+ * Name: initialize_tasks
+ * @brief Fills tasks with a reproducible workload for run_scheduler.
+ * @details Task ids are 1 to num_tasks. Run times are 1 to TASK_MAX_RUN_MS, priorities
+ *      0 to TASK_PRIORITY_LEVELS - 1 and arrivals 0 to TASK_MAX_GAP_MS apart, starting at
+ *      0, from a fixed-seed generator, so every call with the same num_tasks gives the
+ *      same set and the policies can be compared on it.
+ * @param tasks array of num_tasks tasks.
+ * @param num_tasks number of tasks.
+ */
+void initialize_tasks(Task *tasks, int num_tasks) {
+  uint32_t seed = 590;
+  uint32_t arrival = 0;
+  for (int i = 0; i < num_tasks; i++) {
+    Task *t = &tasks[i];
+    seed = seed * 1664525u + 1013904223u;
+    t->run_time = 1 + (seed >> 8) % TASK_MAX_RUN_MS;
+    seed = seed * 1664525u + 1013904223u;
+    t->priority = (seed >> 8) % TASK_PRIORITY_LEVELS;
+    if(i > 0) {
+      seed = seed * 1664525u + 1013904223u;
+      arrival += (seed >> 8) % (TASK_MAX_GAP_MS + 1);
+    }
+    t->task_id = i + 1;
+    t->state = READY;
+    t->arrival_time = arrival;
+    t->remaining = t->run_time;
+    t->finish_time = 0;
+  }
+}
+
+/**
+ * Name: setSchedulerPolicy
+ * @brief Selects the policy used by later run_scheduler calls.
+ * @param policy SCHED_ROUND_ROBIN, SCHED_PRIORITY or SCHED_SHORTEST_JOB.
+ * @param quantum_ms round robin time slice; 0 is taken as 1.
+ */
+void setSchedulerPolicy(SchedulerPolicy policy, uint32_t quantum_ms) {
+  schedPolicy = policy;
+  schedQuantum = (quantum_ms == 0) ? 1 : quantum_ms;
+}
+
+/**
+ * Name: run_scheduler
+ * @brief Simulates the tasks on one CPU under the selected policy and records the timeline.
+ * @details Observed Behavior: Every task runs from its arrival_time until its run_time is used
+ *      up; each one ends DONE with its finish_time set, and the statistics are available
+ *      from getSchedulerStats.
+ *      Commented Purpose: Compares scheduling policies on the same workload.
+ *      Edge Case Handling: The simulation jumps from event to event (arrival, completion,
+ *      end of a slice) rather than stepping per millisecond, so thousands of tasks and long
+ *      spans cost only the events. If the flowchart fills up, later runs are not recorded
+ *      and stats.truncated is set; otherwise a 0 entry follows the last run.
+ *      Error Handling: Prints an error and returns if scratch memory cannot be allocated or
+ *      there are more tasks than a flowchart entry can name. Times must stay below 2^32 ms.
+ * @param tasks array of num_tasks tasks with run_time, priority and arrival_time set.
+ * @param num_tasks number of tasks.
+ * @param flowchart run-length timeline, see FLOWCHART_ENTRY. May be NULL for statistics only.
+ * @param flowchart_size number of entries flowchart holds.
+ */
+void run_scheduler(Task *tasks, int num_tasks, uint32_t *flowchart, int flowchart_size) {
+  memset(&schedStats, 0, sizeof(schedStats));
+  schedStats.policy = schedPolicy;
+  chart = flowchart;
+  chartSize = (flowchart == NULL || flowchart_size < 0) ? 0 : flowchart_size;
+  chartUsed = 0;
+  lastTask = -1;
+
+  if(num_tasks > (int)FLOWCHART_IDLE) {
+    printString("run_scheduler: too many tasks.\n");
+    return;
+  }
+  if(num_tasks > 0) {
+    int *byArrival = (int *)labAlloc(ALLOC_TAG_SCHEDULER, num_tasks * sizeof(int));
+    uint64_t *ready = (uint64_t *)labAlloc(ALLOC_TAG_SCHEDULER, num_tasks * sizeof(uint64_t));  // FIFO ring for round robin, heap otherwise
+    if(byArrival == NULL || ready == NULL) {
+      labFree(ALLOC_TAG_SCHEDULER, byArrival, num_tasks * sizeof(int));
+      labFree(ALLOC_TAG_SCHEDULER, ready, num_tasks * sizeof(uint64_t));
+      printString("run_scheduler: allocation failed.\n");
+      return;
+    }
+
+    for (int i = 0; i < num_tasks; i++) {
+      byArrival[i] = i;
+      tasks[i].state = BLOCKED;  // until it arrives
+      tasks[i].remaining = tasks[i].run_time;
+      tasks[i].finish_time = 0;
+    }
+    sortTasks = tasks;
+    qsort(byArrival, num_tasks, sizeof(int), compareArrival);
+
+    if(schedPolicy == SCHED_ROUND_ROBIN) {
+      schedStats.makespan = runRoundRobin(tasks, num_tasks, byArrival, ready);
+    } else {
+      schedStats.makespan = runByKey(tasks, num_tasks, byArrival, ready, schedPolicy == SCHED_PRIORITY);
+    }
+    labFree(ALLOC_TAG_SCHEDULER, byArrival, num_tasks * sizeof(int));
+    labFree(ALLOC_TAG_SCHEDULER, ready, num_tasks * sizeof(uint64_t));
+    schedStats.tasks = num_tasks;
+  }
+
+  if(chartUsed < chartSize) chart[chartUsed] = 0;
+  schedStats.entries = chartUsed;
+}
+
+/**
+ * Name: getSchedulerStats
+ * @brief Copies the statistics of the last run_scheduler call.
+ */
+void getSchedulerStats(SchedulerStats *stats) {
+  *stats = schedStats;
+}
+
+/**
+ * Name: print_flowchart
+ * @brief Prints a flowchart as a Gantt chart of GANTT_COLUMNS time columns.
+ * @details Observed Behavior: One CPU row ('#' busy, '+' partly busy, '.' idle) and a row for
+ *      each of the first GANTT_ROWS tasks ('#' running, '-' waiting), followed by the average
+ *      waiting and turnaround times of all the tasks.
+ *      Commented Purpose: Shows the timeline of run_scheduler at a glance.
+ *      Edge Case Handling: The time scale is chosen so the whole timeline fits the columns,
+ *      and the output is about 1.2 KB whatever the number of tasks or runs, so it fits the
+ *      print staging buffer instead of flooding the UART. Cost is one pass over the entries.
+ *      Error Handling: Prints a note for an empty flowchart.
+ * @param flowchart timeline written by run_scheduler.
+ * @param flowchart_size number of entries flowchart holds.
+ * @param num_tasks number of tasks.
+ * @param tasks the tasks passed to run_scheduler.
+ */
+void print_flowchart(const uint32_t *flowchart, int flowchart_size, int num_tasks, const Task *tasks) {
+  static char grid[GANTT_ROWS][GANTT_COLUMNS];
+  static uint32_t busy[GANTT_COLUMNS];
+  char line[GANTT_COLUMNS + 16];
+
+  int entries = 0;
+  uint64_t span = 0;
+  while(entries < flowchart_size && flowchart[entries] != 0) {
+    span += FLOWCHART_LENGTH(flowchart[entries]);
+    entries++;
+  }
+  if(span == 0) {
+    printString("Flowchart is empty.\n");
+    return;
+  }
+
+  uint64_t width = (span + GANTT_COLUMNS - 1) / GANTT_COLUMNS;  // whole ms per column
+  int columns = (int)((span + width - 1) / width);
+  int rows = (num_tasks < GANTT_ROWS) ? num_tasks : GANTT_ROWS;
+
+  for (int r = 0; r < rows; r++) {
+    uint64_t end = (tasks[r].state == DONE) ? tasks[r].finish_time : span;
+    for (int c = 0; c < columns; c++) {
+      bool present = tasks[r].arrival_time < (c + 1) * width && end > c * width;
+      grid[r][c] = present ? '-' : ' ';
+    }
+  }
+  memset(busy, 0, sizeof(busy));
+
+  uint64_t start = 0;
+  for (int e = 0; e < entries; e++) {
+    uint32_t index = FLOWCHART_INDEX(flowchart[e]);
+    uint64_t end = start + FLOWCHART_LENGTH(flowchart[e]);
+    if(index != FLOWCHART_IDLE) {
+      for (uint64_t c = start / width; c <= (end - 1) / width; c++) {
+        uint64_t from = (start > c * width) ? start : c * width;
+        uint64_t to = (end < (c + 1) * width) ? end : (c + 1) * width;
+        busy[c] += (uint32_t)(to - from);
+        if(index < (uint32_t)rows) grid[index][c] = '#';
+      }
+    }
+    start = end;
+  }
+
+  printString("Gantt chart, 0 to ");
+  printUInt((uint32_t)span);
+  printString(" ms, ");
+  printUInt((uint32_t)width);
+  printString(" ms per column. # running, - waiting, + partly busy, . idle\n");
+
+  memcpy(line, "CPU    |", 8);
+  for (int c = 0; c < columns; c++) {
+    uint64_t columnEnd = ((c + 1) * width < span) ? (c + 1) * width : span;
+    uint64_t length = columnEnd - c * width;
+    line[8 + c] = (busy[c] == 0) ? '.' : (busy[c] == length) ? '#' : '+';
+  }
+  memcpy(&line[8 + columns], "|\n", 3);
+  printString(line);
+
+  for (int r = 0; r < rows; r++) {
+    snprintf(line, sizeof(line), "T%-6d|", tasks[r].task_id);
+    memcpy(&line[8], grid[r], columns);
+    memcpy(&line[8 + columns], "|\n", 3);
+    printString(line);
+  }
+  if(num_tasks > rows) {
+    printString("(");
+    printInt(num_tasks - rows);
+    printString(" more tasks, counted in the CPU row)\n");
+  }
+  if(entries == flowchart_size) {
+    printString("(flowchart full, later runs not shown)\n");
+  }
+
+  uint64_t waiting = 0, turnaround = 0;
+  int finished = 0;
+  for (int i = 0; i < num_tasks; i++) {
+    if(tasks[i].state != DONE) continue;
+    turnaround += tasks[i].finish_time - tasks[i].arrival_time;
+    waiting += tasks[i].finish_time - tasks[i].arrival_time - tasks[i].run_time;
+    finished++;
+  }
+  if(finished > 0) {
+    printString("Average waiting ");
+    printFloat((float)waiting / finished);
+    printString(" ms, average turnaround ");
+    printFloat((float)turnaround / finished);
+    printString(" ms over ");
+    printInt(finished);
+    printString(" tasks\n");
+  }
+}
+
+/**
+ * @}
+ */
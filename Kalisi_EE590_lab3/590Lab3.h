@@ -11,8 +11,32 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <string>
+#include <atomic>
+#include "RingBuffer.h"
 
 #define BUFFER_SIZE 5
+#define SENSOR_BUFFER_SIZE 8  // Power of two above the 5 samples taken per 2.5 s average
+
+#define ARRAY_PRINT_WINDOW 10  // printArray shows at most this many of the newest elements
+
+// Summary of a window of elements evicted from a DynamicArray by its retention policy
+typedef struct {
+  int min;
+  int max;
+  int mean;
+  int count;
+} ArraySummary;
+
+// Downsampled tail of a DynamicArray. Summaries are kept in a ring; once full, the
+// oldest summary is overwritten.
+typedef struct {
+  ArraySummary *windows;  // Caller provided ring of summaries
+  int capacity;           // Number of summaries the ring holds
+  int start;              // Index of the oldest summary
+  int count;              // Number of summaries held
+  int window;             // Oldest elements folded into one summary on each eviction
+  long overwritten;       // Summaries lost because the ring was full
+} ArrayHistory;
 
 /*Task 3 dynamic array definition
 
@@ -21,6 +45,8 @@ typedef struct {
   int *data;
   int size;
   int capacity;
+  bool fixedStorage;      // data is caller owned, never reallocated or freed
+  ArrayHistory *history;  // Retention policy, NULL keeps every element
 } DynamicArray;
 
 typedef struct {
@@ -31,26 +57,121 @@ typedef struct {
   size_t max_size;  // Maximum capacity of the buffer
 } CircularBuffer;
 
+// Single-producer/single-consumer variant of CircularBuffer. head is only
+// written by the producer and tail only by the consumer; both run freely and
+// are wrapped with mask, so there is no shared count field.
+typedef struct {
+  int *buffer;                          // Pointer to dynamically allocated buffer
+  size_t mask;                          // Capacity - 1, capacity is a power of two
+  alignas(64) std::atomic<size_t> head; // Total number of elements ever written
+  alignas(64) std::atomic<size_t> tail; // Total number of elements ever read
+} SpscCircularBuffer;
+
+#define FIB_TABLE_SIZE 94   // F(0) to F(93), every Fibonacci number that fits in 64 bits
+#define FACT_TABLE_SIZE 21  // 0! to 20!, every factorial that fits in 64 bits
+#define BIGINT_LIMBS 64     // 2048 bit BigUInt: up to F(2951) and 300!
+
+// Status returned by factorial
+#define MATH_OK 0
+#define MATH_INVALID -1   // Negative argument
+#define MATH_OVERFLOW -2  // Result does not fit; use the BigUInt version
+
+// Unsigned integer of up to BIGINT_LIMBS 32 bit limbs, least significant first.
+// Fixed size, so it lives on the stack or in a global with no allocation.
+typedef struct {
+  uint32_t limb[BIGINT_LIMBS];
+  int used;  // Limbs in use, the top one non-zero; 0 for the value 0
+} BigUInt;
+
+// Bit string of any width in 64 bit words, bit 0 in the low bit of words[0].
+// Bits past the width in the top word are kept 0.
+typedef struct {
+  uint64_t *words;  // Pointer to dynamically allocated words, NULL for width 0
+  size_t bits;      // Width in bits
+  size_t nwords;    // (bits + 63) / 64
+} BitSet;
+
+// Summary of a BitSet from one pass over its words
+typedef struct {
+  size_t ones;   // Bits set
+  long lowest;   // Index of the lowest set bit, -1 if none
+  long highest;  // Index of the highest set bit, -1 if none
+} BitSetStats;
+
+// Holds LDR samples between averages in simulateSensorData
+typedef RingBuffer<int, SENSOR_BUFFER_SIZE> SensorBuffer;
+
 // Task States
 typedef enum {
   READY,
   RUNNING,
-  BLOCKED
+  BLOCKED,
+  DONE      // Finished; finish_time is valid
 } TaskState;
 
 // Abridged Task Control Block (TCB)
 typedef struct {
-  int task_id;        // Unique task identifier
-  TaskState state;    // Current state of the task
-  uint32_t run_time;  // Time the task should run in milliseconds
+  int task_id;            // Unique task identifier
+  TaskState state;        // Current state of the task
+  uint32_t run_time;      // Time the task should run in milliseconds
+  uint32_t priority;      // Lower runs first under SCHED_PRIORITY
+  uint32_t arrival_time;  // Milliseconds after the start of the run at which the task becomes ready
+  uint32_t remaining;     // Part of run_time not executed yet
+  uint32_t finish_time;   // Milliseconds after the start of the run at which the task completed
 } Task;
 
+// Policies simulated by run_scheduler
+typedef enum {
+  SCHED_ROUND_ROBIN,  // FIFO, preempted every quantum
+  SCHED_PRIORITY,     // Lowest priority value first, preempted by a more urgent arrival
+  SCHED_SHORTEST_JOB  // Shortest run_time first, runs to completion
+} SchedulerPolicy;
+
+// Timeline of a run_scheduler run. Each flowchart entry is one run of a task:
+// (task index << FLOWCHART_LENGTH_BITS) | length in ms. Runs longer than
+// FLOWCHART_MAX_RUN are split, idle time uses FLOWCHART_IDLE as its index, and a
+// 0 entry ends the timeline if it does not fill the array.
+#define FLOWCHART_LENGTH_BITS 16
+#define FLOWCHART_MAX_RUN ((1u << FLOWCHART_LENGTH_BITS) - 1)
+#define FLOWCHART_IDLE 0xFFFF  // Index of idle runs; tasks beyond it are not supported
+#define FLOWCHART_ENTRY(index, length) (((uint32_t)(index) << FLOWCHART_LENGTH_BITS) | (length))
+#define FLOWCHART_INDEX(entry) ((entry) >> FLOWCHART_LENGTH_BITS)
+#define FLOWCHART_LENGTH(entry) ((entry) & FLOWCHART_MAX_RUN)
+
+#define SCHED_DEFAULT_QUANTUM_MS 10  // Round robin time slice
+#define GANTT_COLUMNS 64             // Time columns printed by print_flowchart
+#define GANTT_ROWS 12                // Task rows printed by print_flowchart, the rest only count in the CPU row
+
+// Outcome of the last run_scheduler call, all times in milliseconds
+typedef struct {
+  SchedulerPolicy policy;
+  int tasks;                  // Tasks simulated
+  uint32_t makespan;          // Finish time of the last task
+  uint32_t idle;              // Time with no task ready
+  uint64_t total_waiting;     // Sum over tasks of (finish - arrival - run_time)
+  uint64_t total_turnaround;  // Sum over tasks of (finish - arrival)
+  uint32_t max_waiting;
+  uint32_t context_switches;  // Changes from one task to a different one
+  int entries;                // Flowchart entries written
+  bool truncated;             // The flowchart filled up; the statistics still cover the whole run
+} SchedulerStats;
+
 
 void fibonacci(int N, unsigned long long **sequence);
+void freeFibonacci(unsigned long long *sequence, int N);
+bool fibonacciTerm(int n, unsigned long long *result);
 int factorial(int n, unsigned long long *result);
+bool bigintFibonacci(int n, BigUInt *result);
+bool bigintFactorial(int n, BigUInt *result);
+void printBigUInt(const BigUInt *x);
 void initArray(DynamicArray *arr, int initialCapacity);
+void initArrayStatic(DynamicArray *arr, int *storage, int capacity);
+bool reserveArray(DynamicArray *arr, int capacity);
+bool shrinkArrayToFit(DynamicArray *arr);
+void setArrayRetention(DynamicArray *arr, ArrayHistory *history, ArraySummary *windows, int historyCapacity, int window);
 void addElement(DynamicArray *arr, int element);
 void printArray(DynamicArray *arr);
+void printArrayHistory(DynamicArray *arr);
 void freeArray(DynamicArray *arr);
 void reverseString(char *str);
 
@@ -63,6 +184,18 @@ int str_to_int(const char *str);
 int string_to_binary(const char *str);
 void print_truth_table(const char *a, const char *b);
 
+bool initBitSet(BitSet *set, size_t bits);
+void freeBitSet(BitSet *set);
+bool bitsetFromString(BitSet *set, const char *str, size_t minBits);
+bool bitsetTest(const BitSet *set, size_t bit);
+bool bitsetAnd(BitSet *dst, const BitSet *a, const BitSet *b);
+bool bitsetOr(BitSet *dst, const BitSet *a, const BitSet *b);
+bool bitsetXor(BitSet *dst, const BitSet *a, const BitSet *b);
+bool bitsetNot(BitSet *dst, const BitSet *a);
+size_t bitsetCount(const BitSet *set);
+void bitsetStats(const BitSet *set, BitSetStats *stats);
+void printBitSet(const BitSet *set);
+
 
 void initBuffer(CircularBuffer *cb, size_t size);
 void resizeBuffer(CircularBuffer *cb, size_t new_size);
@@ -74,11 +207,27 @@ void pushBuffer(CircularBuffer *cb, int value);
 int popBuffer(CircularBuffer *cb);
 void freeBuffer(CircularBuffer *cb);
 
-void simulateSensorData(CircularBuffer *cb, DynamicArray *processedData);
+void initSpscBuffer(SpscCircularBuffer *cb, size_t size);
+void freeSpscBuffer(SpscCircularBuffer *cb);
+bool writeSpscBuffer(SpscCircularBuffer *cb, int value);
+bool readSpscBuffer(SpscCircularBuffer *cb, int *value);
+bool popSpscBuffer(SpscCircularBuffer *cb, int *value);
+size_t spscBufferCount(SpscCircularBuffer *cb);
+bool isSpscEmpty(SpscCircularBuffer *cb);
+bool isSpscFull(SpscCircularBuffer *cb);
+
+#define SENSOR_SAMPLE_US 500000   // LDR sampling period
+#define SENSOR_AVERAGE_US 2500000 // Averaging period
+
+void sampleSensor(SensorBuffer *cb);
+void averageSensor(SensorBuffer *cb, DynamicArray *processedData);
+void simulateSensorData(SensorBuffer *cb, DynamicArray *processedData);
 
 
 void initialize_tasks(Task *tasks, int num_tasks);
+void setSchedulerPolicy(SchedulerPolicy policy, uint32_t quantum_ms);
 void run_scheduler(Task *tasks, int num_tasks, uint32_t *flowchart, int flowchart_size);
+void getSchedulerStats(SchedulerStats *stats);
 void print_flowchart(const uint32_t *flowchart, int flowchart_size, int num_tasks, const Task *tasks);
 
 void printOperationComparisonTable();
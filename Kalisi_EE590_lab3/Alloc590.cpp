@@ -0,0 +1,467 @@
+/**
+ * @file Alloc590.cpp
+ *
+ * @section description Description
+ * Tracked allocation for the Lab 3 library. labAlloc, labRealloc and labFree charge each
+ * block to an AllocTag and pass the request on to the current Allocator, so live and peak
+ * bytes, call counts, request sizes and the bytes reallocs had to copy are known per
+ * subsystem. The heap allocator wraps malloc; an AllocPool serves the same calls from a
+ * fixed arena, so a steady-state loop can be shown not to touch the heap at all.
+ *
+ * @section notes Notes
+ * - Comments are Doxygen compatible.
+ * - Like the data structures that call it, the tracker is used from one context only;
+ *   the counters are not atomic.
+ * - Callers pass the size of a block back when they resize or free it. Every Lab 3
+ *   structure already knows its capacity, so blocks carry no header.
+ *
+ * @section author Author
+ * - Created by Sai Jayanth Kalisi.
+ */
+
+// =========== Libraries ===========
+#include "Alloc590.h"
+#include "Special590functions.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+// =========== GLOBALS ===========
+
+static const char *const allocTagNames[ALLOC_TAG_COUNT] = {
+  "fibonacci", "array", "buffer", "spsc", "ring", "bitset", "scheduler", "sketch",
+};
+
+static AllocStats tagStats[ALLOC_TAG_COUNT];  ///< Counters per tag
+static AllocStats totalStats;                 ///< Counters over every tag
+static const Allocator *currentAllocator = &heapAllocator;
+
+// =========== HEAP ALLOCATOR ===========
+
+static void *heapAlloc(void *, size_t size) {
+  return malloc(size);
+}
+
+static void *heapResize(void *, void *ptr, size_t, size_t newSize) {
+  return realloc(ptr, newSize);
+}
+
+static void heapRelease(void *, void *ptr, size_t) {
+  free(ptr);
+}
+
+/**
+ * Name: heapFreeBytes
+ * @brief Free 8 bit capable heap on the ESP32. The host heap cannot tell.
+ */
+static size_t heapFreeBytes(void *) {
+#ifdef ESP_PLATFORM
+  return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+#else
+  return ALLOC_UNKNOWN;
+#endif
+}
+
+/**
+ * Name: heapLargestFree
+ * @brief Largest 8 bit capable heap block on the ESP32. The host heap cannot tell.
+ */
+static size_t heapLargestFree(void *) {
+#ifdef ESP_PLATFORM
+  return heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+#else
+  return ALLOC_UNKNOWN;
+#endif
+}
+
+const Allocator heapAllocator = {
+  "heap", heapAlloc, heapResize, heapRelease, heapFreeBytes, heapLargestFree, NULL,
+};
+
+// =========== POOL ALLOCATOR ===========
+
+/**
+ * Name: poolClassOf
+ * @brief Size class holding size bytes: class k has blocks of 16 << k bytes.
+ * @retval ALLOC_POOL_CLASSES if size is larger than the largest class.
+ */
+static size_t poolClassOf(size_t size) {
+  size_t k = 0;
+  while (k < ALLOC_POOL_CLASSES && ((size_t)1 << (ALLOC_POOL_MIN_SHIFT + k)) < size) k++;
+  return k;
+}
+
+static size_t poolBlockSize(size_t k) {
+  return (size_t)1 << (ALLOC_POOL_MIN_SHIFT + k);
+}
+
+/**
+ * Name: poolAlloc
+ * @brief A block from the free list of the size's class, or a new one carved from the arena.
+ * @retval NULL if the size is over the largest class or the arena is used up.
+ */
+static void *poolAlloc(void *ctx, size_t size) {
+  AllocPool *pool = (AllocPool *)ctx;
+  size_t k = poolClassOf(size);
+  if (k >= ALLOC_POOL_CLASSES) return NULL;
+
+  void *block = pool->freeList[k];
+  if (block != NULL) {
+    pool->freeList[k] = *(void **)block;
+    pool->freeCount[k]--;
+    return block;
+  }
+
+  size_t bytes = poolBlockSize(k);
+  if (pool->size - pool->carved < bytes) return NULL;
+  block = pool->arena + pool->carved;
+  pool->carved += bytes;
+  return block;
+}
+
+static void poolRelease(void *ctx, void *ptr, size_t size) {
+  AllocPool *pool = (AllocPool *)ctx;
+  if (ptr == NULL) return;
+  size_t k = poolClassOf(size);
+  *(void **)ptr = pool->freeList[k];
+  pool->freeList[k] = ptr;
+  pool->freeCount[k]++;
+}
+
+/**
+ * Name: poolResize
+ * @brief Keeps the block if the new size is in the same class, else moves it to a new one.
+ * @retval NULL if no block of the new class is available; ptr is then unchanged.
+ */
+static void *poolResize(void *ctx, void *ptr, size_t oldSize, size_t newSize) {
+  if (ptr == NULL) return poolAlloc(ctx, newSize);
+  if (poolClassOf(oldSize) == poolClassOf(newSize)) return ptr;
+
+  void *moved = poolAlloc(ctx, newSize);
+  if (moved == NULL) return NULL;
+  memcpy(moved, ptr, (oldSize < newSize) ? oldSize : newSize);
+  poolRelease(ctx, ptr, oldSize);
+  return moved;
+}
+
+/**
+ * Name: poolFreeBytes
+ * @brief Uncarved arena plus every block waiting on a free list.
+ */
+static size_t poolFreeBytes(void *ctx) {
+  AllocPool *pool = (AllocPool *)ctx;
+  size_t bytes = pool->size - pool->carved;
+  for (size_t k = 0; k < ALLOC_POOL_CLASSES; k++) bytes += pool->freeCount[k] * poolBlockSize(k);
+  return bytes;
+}
+
+/**
+ * Name: poolLargestFree
+ * @brief Largest of the uncarved arena and the biggest class with a free block.
+ */
+static size_t poolLargestFree(void *ctx) {
+  AllocPool *pool = (AllocPool *)ctx;
+  size_t largest = pool->size - pool->carved;
+  for (size_t k = 0; k < ALLOC_POOL_CLASSES; k++) {
+    if (pool->freeCount[k] > 0 && poolBlockSize(k) > largest) largest = poolBlockSize(k);
+  }
+  return largest;
+}
+
+// =========== TRACKING ===========
+
+/**
+ * Name: noteLive
+ * @brief Applies a change in live bytes and blocks to stats and updates its peak.
+ */
+static void noteLive(AllocStats *stats, size_t added, size_t removed, int blocks) {
+  stats->liveBytes = stats->liveBytes + added - removed;
+  stats->liveBlocks += blocks;
+  if (stats->liveBytes > stats->peakBytes) stats->peakBytes = stats->liveBytes;
+}
+
+/**
+ * Name: noteRequest
+ * @brief Counts a successful alloc or realloc of size bytes.
+ */
+static void noteRequest(AllocStats *stats, size_t size) {
+  stats->requestedBytes += size;
+  if (size > stats->largestRequest) stats->largestRequest = size;
+}
+
+/**
+ * Name: labAlloc
+ * @brief Allocates size bytes from the current allocator, charged to tag.
+ * @retval NULL if the allocator could not satisfy the request (counted as a failure).
+ */
+void *labAlloc(AllocTag tag, size_t size) {
+  AllocStats *stats = &tagStats[tag];
+  void *ptr = currentAllocator->alloc(currentAllocator->ctx, size);
+  if (ptr == NULL) {
+    if (size > 0) {
+      stats->failures++;
+      totalStats.failures++;
+    }
+    return NULL;
+  }
+
+  stats->allocs++;
+  totalStats.allocs++;
+  noteRequest(stats, size);
+  noteRequest(&totalStats, size);
+  noteLive(stats, size, 0, 1);
+  noteLive(&totalStats, size, 0, 1);
+  return ptr;
+}
+
+/**
+ * Name: labCalloc
+ * @brief labAlloc of count * size bytes, zeroed.
+ * @retval NULL if the product overflows or the allocation failed.
+ */
+void *labCalloc(AllocTag tag, size_t count, size_t size) {
+  if (size != 0 && count > SIZE_MAX / size) {
+    tagStats[tag].failures++;
+    totalStats.failures++;
+    return NULL;
+  }
+  void *ptr = labAlloc(tag, count * size);
+  if (ptr != NULL) memset(ptr, 0, count * size);
+  return ptr;
+}
+
+/**
+ * Name: labRealloc
+ * @brief Resizes a block from labAlloc, keeping its contents.
+ * @details If the allocator has to move the block, the bytes it copied are counted in
+ *      copiedBytes. A NULL ptr allocates; a newSize of 0 frees and returns NULL.
+ * @param tag tag the block was allocated with.
+ * @param ptr block to resize, or NULL.
+ * @param oldSize size the block was allocated or last resized with.
+ * @param newSize size wanted.
+ * @retval the block, possibly moved, or NULL on failure with ptr still valid.
+ */
+void *labRealloc(AllocTag tag, void *ptr, size_t oldSize, size_t newSize) {
+  if (ptr == NULL) return labAlloc(tag, newSize);
+  if (newSize == 0) {
+    labFree(tag, ptr, oldSize);
+    return NULL;
+  }
+
+  AllocStats *stats = &tagStats[tag];
+  void *resized = currentAllocator->resize(currentAllocator->ctx, ptr, oldSize, newSize);
+  if (resized == NULL) {
+    stats->failures++;
+    totalStats.failures++;
+    return NULL;
+  }
+
+  stats->reallocs++;
+  totalStats.reallocs++;
+  noteRequest(stats, newSize);
+  noteRequest(&totalStats, newSize);
+  noteLive(stats, newSize, oldSize, 0);
+  noteLive(&totalStats, newSize, oldSize, 0);
+  if (resized != ptr) {
+    size_t copied = (oldSize < newSize) ? oldSize : newSize;
+    stats->copiedBytes += copied;
+    totalStats.copiedBytes += copied;
+  }
+  return resized;
+}
+
+/**
+ * Name: labFree
+ * @brief Returns a block from labAlloc to the allocator. NULL is ignored.
+ * @param tag tag the block was allocated with.
+ * @param ptr block to free.
+ * @param size size the block was allocated or last resized with.
+ */
+void labFree(AllocTag tag, void *ptr, size_t size) {
+  if (ptr == NULL) return;
+  currentAllocator->release(currentAllocator->ctx, ptr, size);
+  tagStats[tag].frees++;
+  totalStats.frees++;
+  noteLive(&tagStats[tag], 0, size, -1);
+  noteLive(&totalStats, 0, size, -1);
+}
+
+/**
+ * Name: setAllocator
+ * @brief Makes allocator the source of every later labAlloc.
+ * @details Blocks must be freed by the allocator that made them, so the switch is only
+ *      allowed while no tracked block is live.
+ * @retval false if blocks are still live; the allocator is unchanged.
+ */
+bool setAllocator(const Allocator *allocator) {
+  if (totalStats.liveBlocks != 0) return false;
+  currentAllocator = (allocator != NULL) ? allocator : &heapAllocator;
+  return true;
+}
+
+/**
+ * Name: getAllocator
+ * @brief The allocator labAlloc currently uses.
+ */
+const Allocator *getAllocator() {
+  return currentAllocator;
+}
+
+/**
+ * Name: initAllocPool
+ * @brief Sets up pool over arena and fills in pool->allocator for setAllocator.
+ * @details The arena is aligned up to 16 bytes; blocks are powers of two from 16 bytes,
+ *      so every block stays 16 byte aligned. The arena must outlive the pool.
+ * @retval false if the arena cannot hold a single block.
+ */
+bool initAllocPool(AllocPool *pool, void *arena, size_t size) {
+  uintptr_t start = ((uintptr_t)arena + 15) & ~(uintptr_t)15;
+  size_t skipped = start - (uintptr_t)arena;
+
+  memset(pool, 0, sizeof(*pool));
+  pool->arena = (uint8_t *)start;
+  pool->size = (size > skipped) ? size - skipped : 0;
+  pool->allocator.name = "pool";
+  pool->allocator.alloc = poolAlloc;
+  pool->allocator.resize = poolResize;
+  pool->allocator.release = poolRelease;
+  pool->allocator.freeBytes = poolFreeBytes;
+  pool->allocator.largestFree = poolLargestFree;
+  pool->allocator.ctx = pool;
+  return pool->size >= poolBlockSize(0);
+}
+
+/**
+ * Name: getAllocStats
+ * @brief Copies the counters of one tag.
+ */
+void getAllocStats(AllocTag tag, AllocStats *stats) {
+  *stats = tagStats[tag];
+}
+
+/**
+ * Name: getAllocTotals
+ * @brief Copies the counters over every tag. peakBytes is the peak of the sum, not a sum of peaks.
+ */
+void getAllocTotals(AllocStats *stats) {
+  *stats = totalStats;
+}
+
+/**
+ * Name: resetAllocStats
+ * @brief Clears every counter except the live bytes and blocks; peaks restart from the live bytes.
+ */
+void resetAllocStats() {
+  for (int t = 0; t <= ALLOC_TAG_COUNT; t++) {
+    AllocStats *stats = (t < ALLOC_TAG_COUNT) ? &tagStats[t] : &totalStats;
+    size_t live = stats->liveBytes;
+    uint32_t blocks = stats->liveBlocks;
+    memset(stats, 0, sizeof(*stats));
+    stats->liveBytes = stats->peakBytes = live;
+    stats->liveBlocks = blocks;
+  }
+}
+
+/**
+ * Name: allocFreeBytes
+ * @brief Free memory of the current allocator, or ALLOC_UNKNOWN.
+ */
+size_t allocFreeBytes() {
+  return currentAllocator->freeBytes(currentAllocator->ctx);
+}
+
+/**
+ * Name: allocLargestFree
+ * @brief Largest block the current allocator could hand out now, or ALLOC_UNKNOWN.
+ */
+size_t allocLargestFree() {
+  return currentAllocator->largestFree(currentAllocator->ctx);
+}
+
+/**
+ * Name: allocTagName
+ * @brief Short name of a tag, as printed by printAllocReport.
+ */
+const char *allocTagName(AllocTag tag) {
+  return (tag < ALLOC_TAG_COUNT) ? allocTagNames[tag] : "?";
+}
+
+/**
+ * Name: printSize
+ * @brief Prints a size, or "-" for ALLOC_UNKNOWN.
+ */
+static void printSize(size_t size) {
+  if (size == ALLOC_UNKNOWN) {
+    printString("-");
+  } else {
+    printUInt((uint32_t)size);
+  }
+}
+
+/**
+ * Name: printStatsLine
+ * @brief One "alloc <name> key=value ..." line of printAllocReport.
+ */
+static void printStatsLine(const char *name, const AllocStats *stats) {
+  printString("alloc ");
+  printString(name);
+  printString(" live=");
+  printUInt((uint32_t)stats->liveBytes);
+  printString(" peak=");
+  printUInt((uint32_t)stats->peakBytes);
+  printString(" blocks=");
+  printUInt(stats->liveBlocks);
+  printString(" allocs=");
+  printUInt(stats->allocs);
+  printString(" reallocs=");
+  printUInt(stats->reallocs);
+  printString(" frees=");
+  printUInt(stats->frees);
+  printString(" fail=");
+  printUInt(stats->failures);
+  printString(" req=");
+  printUInt((uint32_t)stats->requestedBytes);
+  printString(" max=");
+  printUInt((uint32_t)stats->largestRequest);
+  printString(" copied=");
+  printUInt((uint32_t)stats->copiedBytes);
+  printString("\n");
+}
+
+/**
+ * Name: printAllocReport
+ * @brief Prints the allocator's free memory and fragmentation, then the counters of every
+ *      tag that has been used and the totals.
+ * @details Fragmentation is the share of free memory outside the largest free block, so
+ *      0% means every free byte could be handed out as one block. Byte counts over 2^32 wrap.
+ */
+void printAllocReport() {
+  size_t freeBytes = allocFreeBytes();
+  size_t largest = allocLargestFree();
+
+  printString("alloc ");
+  printString(currentAllocator->name);
+  printString(" free=");
+  printSize(freeBytes);
+  printString(" largest=");
+  printSize(largest);
+  printString(" frag=");
+  if (freeBytes == ALLOC_UNKNOWN || largest == ALLOC_UNKNOWN || freeBytes == 0) {
+    printString("-");
+  } else {
+    printUInt((uint32_t)(100 - (uint64_t)largest * 100 / freeBytes));
+    printString("%");
+  }
+  printString("\n");
+
+  for (int t = 0; t < ALLOC_TAG_COUNT; t++) {
+    const AllocStats *stats = &tagStats[t];
+    if (stats->allocs == 0 && stats->liveBlocks == 0 && stats->failures == 0) continue;
+    printStatsLine(allocTagNames[t], stats);
+  }
+  printStatsLine("total", &totalStats);
+}
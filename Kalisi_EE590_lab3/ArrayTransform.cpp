@@ -0,0 +1,322 @@
+/**
+ * @file ArrayTransform.cpp
+ *
+ * @section description Description
+ * Parallel runtime behind transformArrayParallel. transformRunChunks splits [0, len)
+ * into one chunk per worker plus one for the caller, runs them at once and returns when
+ * all are done.
+ * - ESP32: one helper task pinned to the core the caller is not on, woken by a task
+ *   notification, so a call from loop() (core 1) also uses core 0.
+ * - Host: a std::thread pool of hardware_concurrency() - 1 threads, started on first use.
+ *   transformSetWorkers changes the count, so a single core host can still run chunks in
+ *   parallel to check them.
+ *
+ * @section notes Notes
+ * - Comments are Doxygen compatible.
+ * - Calls are serialized; a second caller waits for the first to finish.
+ *
+ * @section author Author
+ * - Created by Sai Jayanth Kalisi.
+ */
+
+// =========== Libraries ===========
+#include "ArrayTransform.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#else
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+#ifdef ESP_PLATFORM
+#define TRANSFORM_HELPER_STACK 2048 ///< Bytes of stack for the helper task
+#define TRANSFORM_HELPER_PRIORITY 1 ///< Same as loop()
+#endif
+
+// =========== INTERNALS ===========
+
+/**
+ * Name: chunkBoundary
+ * @brief Start of chunk part of parts over [0, len), on a TRANSFORM_CHUNK_ALIGN boundary.
+ */
+static size_t chunkBoundary(size_t len, int part, int parts) {
+  if (part >= parts) return len;
+  size_t point = (size_t)((unsigned long long)len * part / parts);
+  return point & ~(size_t)(TRANSFORM_CHUNK_ALIGN - 1);
+}
+
+#ifdef ESP_PLATFORM
+
+static TaskHandle_t helperTask = NULL;
+static BaseType_t helperCore = -1;
+static SemaphoreHandle_t helperDone = NULL;
+static SemaphoreHandle_t callerLock = NULL;
+static bool helperFailed = false;  ///< The helper could not be created; not retried
+static portMUX_TYPE helperInitMux = portMUX_INITIALIZER_UNLOCKED;
+
+// The job handed to the helper; written before the notification, read after it
+static TransformChunkFn jobFn;
+static void *jobContext;
+static size_t jobBegin;
+static size_t jobEnd;
+
+/**
+ * Name: helperLoop
+ * @brief Runs one chunk per notification and signals helperDone.
+ */
+static void helperLoop(void *) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    jobFn(jobContext, jobBegin, jobEnd);
+    xSemaphoreGive(helperDone);
+  }
+}
+
+/**
+ * Name: createCallerLock
+ * @brief Creates callerLock once, even when two tasks get here at the same time.
+ * @details The mutex cannot be created inside a critical section, so each racing caller
+ *      creates one and only the first to install it keeps it.
+ */
+static SemaphoreHandle_t createCallerLock() {
+  if (callerLock != NULL) return callerLock;
+  SemaphoreHandle_t made = xSemaphoreCreateMutex();
+  taskENTER_CRITICAL(&helperInitMux);
+  if (callerLock == NULL) {
+    callerLock = made;
+    made = NULL;
+  }
+  taskEXIT_CRITICAL(&helperInitMux);
+  if (made != NULL) vSemaphoreDelete(made);
+  return callerLock;
+}
+
+/**
+ * Name: startHelper
+ * @brief Creates the helper on the other core the first time.
+ * @details Creation runs under callerLock, so concurrent first callers create one helper.
+ *      helperDone is made once and kept if the task cannot be created, and a failure is
+ *      not retried on every call.
+ * @retval false if it could not be created.
+ */
+static bool startHelper() {
+  if (helperTask != NULL) return true;
+  if (helperFailed || createCallerLock() == NULL) return false;
+
+  xSemaphoreTake(callerLock, portMAX_DELAY);
+  if (helperTask == NULL && !helperFailed) {
+    if (helperDone == NULL) helperDone = xSemaphoreCreateBinary();
+    helperCore = 1 - xPortGetCoreID();
+    TaskHandle_t task = NULL;
+    if (helperDone == NULL ||
+        xTaskCreatePinnedToCore(helperLoop, "Transform", TRANSFORM_HELPER_STACK, NULL,
+                                TRANSFORM_HELPER_PRIORITY, &task, helperCore) != pdPASS) {
+      helperFailed = true;
+    } else {
+      helperTask = task;
+    }
+  }
+  xSemaphoreGive(callerLock);
+  return helperTask != NULL;
+}
+
+/**
+ * Name: transformWorkers
+ * @brief Workers besides the caller: 1 on the dual core ESP32, 0 on a single core part.
+ */
+int transformWorkers() {
+  return (portNUM_PROCESSORS > 1 && startHelper()) ? 1 : 0;
+}
+
+/**
+ * Name: transformRunChunks
+ * @brief Runs fn over the first half of [0, len) on the helper and the second on the caller.
+ * @details If the caller is on the helper's own core the whole range runs on the caller.
+ */
+void transformRunChunks(size_t len, TransformChunkFn fn, void *context) {
+  if (transformWorkers() == 0 || xPortGetCoreID() == helperCore) {
+    fn(context, 0, len);
+    return;
+  }
+
+  xSemaphoreTake(callerLock, portMAX_DELAY);
+  size_t split = chunkBoundary(len, 1, 2);
+  jobFn = fn;
+  jobContext = context;
+  jobBegin = 0;
+  jobEnd = split;
+  xTaskNotifyGive(helperTask);
+
+  fn(context, split, len);
+
+  xSemaphoreTake(helperDone, portMAX_DELAY);
+  xSemaphoreGive(callerLock);
+}
+
+#else
+
+/**
+ * @brief Fixed set of threads that take chunks of the current job until none are left.
+ */
+class TransformPool {
+public:
+  TransformPool() { startWorkers(defaultWorkers()); }
+
+  ~TransformPool() { stopWorkers(); }
+
+  int workers() const { return (int)threads_.size(); }
+
+  /**
+   * Name: defaultWorkers
+   * @brief hardware_concurrency() - 1, the caller being the last core.
+   */
+  static int defaultWorkers() {
+    unsigned cpus = std::thread::hardware_concurrency();
+    return (cpus > 1) ? (int)cpus - 1 : 0;
+  }
+
+  /**
+   * Name: resize
+   * @brief Replaces the threads with workers new ones once the running job, if any, is done.
+   */
+  void resize(int workers) {
+    std::lock_guard<std::mutex> caller(callerMutex_);
+    stopWorkers();
+    startWorkers(workers);
+  }
+
+  /**
+   * Name: run
+   * @brief Runs every chunk of [0, len) on the workers and the caller; returns when done.
+   */
+  void run(size_t len, TransformChunkFn fn, void *context) {
+    std::lock_guard<std::mutex> caller(callerMutex_);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      fn_ = fn;
+      context_ = context;
+      len_ = len;
+      nextPart_.store(0);
+      donePart_ = 0;
+      generation_++;
+    }
+    wake_.notify_all();
+
+    int finished = runParts();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    donePart_ += finished;
+    done_.wait(lock, [this] { return donePart_ == parts_; });
+  }
+
+private:
+  /**
+   * Name: runParts
+   * @brief Takes and runs chunks until none are left.
+   * @retval number of chunks run.
+   */
+  int runParts() {
+    int finished = 0;
+    for (;;) {
+      int part = nextPart_.fetch_add(1);
+      if (part >= parts_) return finished;
+      fn_(context_, chunkBoundary(len_, part, parts_), chunkBoundary(len_, part + 1, parts_));
+      finished++;
+    }
+  }
+
+  void startWorkers(int workers) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = false;
+    parts_ = workers + 1;
+    unsigned long seen = generation_;  // jobs before this one are not theirs
+    for (int i = 0; i < workers; i++) threads_.emplace_back([this, seen] { workerLoop(seen); });
+  }
+
+  void stopWorkers() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread &t : threads_) t.join();
+    threads_.clear();
+  }
+
+  void workerLoop(unsigned long seen) {
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+        if (stop_) return;
+        seen = generation_;
+      }
+      int finished = runParts();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        donePart_ += finished;
+        if (donePart_ == parts_) done_.notify_one();
+      }
+    }
+  }
+
+  std::vector<std::thread> threads_;
+  std::mutex callerMutex_;           ///< One job at a time
+  std::mutex mutex_;
+  std::condition_variable wake_;     ///< Workers wait here for the next job
+  std::condition_variable done_;     ///< The caller waits here for the last chunk
+  bool stop_ = false;
+  unsigned long generation_ = 0;     ///< Bumped per job
+  TransformChunkFn fn_ = NULL;
+  void *context_ = NULL;
+  size_t len_ = 0;
+  int parts_ = 1;                    ///< Chunks per job: one per thread plus the caller
+  std::atomic<int> nextPart_{0};
+  int donePart_ = 0;
+};
+
+/**
+ * Name: transformPool
+ * @brief The pool, started on first use.
+ */
+static TransformPool &transformPool() {
+  static TransformPool pool;
+  return pool;
+}
+
+/**
+ * Name: transformWorkers
+ * @brief Pool threads besides the caller: hardware_concurrency() - 1.
+ */
+int transformWorkers() {
+  return transformPool().workers();
+}
+
+/**
+ * Name: transformSetWorkers
+ * @brief Host only: runs later jobs on workers pool threads, or hardware_concurrency() - 1
+ *      if workers is negative. Waits for a job in progress; do not call it from a chunk.
+ */
+void transformSetWorkers(int workers) {
+  transformPool().resize(workers < 0 ? TransformPool::defaultWorkers() : workers);
+}
+
+/**
+ * Name: transformRunChunks
+ * @brief Runs fn over one chunk of [0, len) per pool thread plus one on the caller.
+ */
+void transformRunChunks(size_t len, TransformChunkFn fn, void *context) {
+  if (transformWorkers() == 0) {
+    fn(context, 0, len);
+    return;
+  }
+  transformPool().run(len, fn, context);
+}
+
+#endif
@@ -0,0 +1,130 @@
+// Filename: ArrayTransform.h
+// Author: Sai Jayanth Kalisi
+// Date: 10/17/26
+// Description: Element-wise array transforms that the compiler can inline.
+//   transformArray(arr, len, fn) applies any functor or lambda in one pass; with a lambda
+//   the call is inlined and the loop can be vectorized, unlike array_modify's function
+//   pointer. makePipeline(f, g, h) composes transforms so that f, then g, then h are
+//   applied in the same pass instead of one pass each. transformArrayParallel splits a
+//   large array into chunks run at once: on a host thread pool, or on both ESP32 cores.
+
+#ifndef ARRAYTRANSFORM_H
+#define ARRAYTRANSFORM_H
+
+#include <stddef.h>
+
+#ifndef TRANSFORM_PARALLEL_MIN
+#define TRANSFORM_PARALLEL_MIN 4096 ///< Shorter arrays are not worth waking another core for
+#endif
+#define TRANSFORM_CHUNK_ALIGN 16    ///< Chunk boundaries fall on multiples of this many elements
+
+/**
+ * @brief Called by transformRunChunks for each chunk [begin, end) of the array.
+ */
+typedef void (*TransformChunkFn)(void *context, size_t begin, size_t end);
+
+/**
+ * @name Parallel runtime (ArrayTransform.cpp)
+ * @{
+ */
+int transformWorkers();
+void transformRunChunks(size_t len, TransformChunkFn fn, void *context);
+#ifndef ESP_PLATFORM
+void transformSetWorkers(int workers);
+#endif
+/** @} */
+
+/**
+ * @brief Applies several transforms in order as one functor.
+ * @details Built with makePipeline. Each stage is stored by value, so lambdas and
+ *      functors are inlined into the caller's loop.
+ */
+template <typename... Fns>
+class TransformPipeline;
+
+template <>
+class TransformPipeline<> {
+public:
+  template <typename T>
+  T operator()(T x) const { return x; }
+};
+
+template <typename First, typename... Rest>
+class TransformPipeline<First, Rest...> {
+public:
+  explicit TransformPipeline(First first, Rest... rest) : first_(first), rest_(rest...) {}
+
+  template <typename T>
+  T operator()(T x) const { return rest_(first_(x)); }
+
+private:
+  First first_;
+  TransformPipeline<Rest...> rest_;
+};
+
+/**
+ * Name: makePipeline
+ * @brief Composes transforms, applied left to right: makePipeline(f, g)(x) is g(f(x)).
+ */
+template <typename... Fns>
+TransformPipeline<Fns...> makePipeline(Fns... fns) {
+  return TransformPipeline<Fns...>(fns...);
+}
+
+/**
+ * Name: transformArray
+ * @brief Replaces each element of arr with fn(element), in one pass.
+ * @param arr array to modify
+ * @param len length of array
+ * @param fn functor, lambda or pipeline taking and returning T
+ * @retval -1 if arr is NULL
+ * @retval 0 if successfully modified array
+ */
+template <typename T, typename Fn>
+int transformArray(T *arr, size_t len, Fn fn) {
+  if (arr == NULL) return -1;
+  for (size_t i = 0; i < len; i++) arr[i] = fn(arr[i]);
+  return 0;
+}
+
+namespace arraytransform_detail {
+
+template <typename T, typename Fn>
+struct ChunkContext {
+  T *arr;
+  const Fn *fn;
+};
+
+/**
+ * Name: runChunk
+ * @brief transformArray over one chunk; one indirect call per chunk, none per element.
+ */
+template <typename T, typename Fn>
+void runChunk(void *context, size_t begin, size_t end) {
+  ChunkContext<T, Fn> *ctx = (ChunkContext<T, Fn> *)context;
+  Fn fn = *ctx->fn;
+  transformArray(ctx->arr + begin, end - begin, fn);
+}
+
+} // namespace arraytransform_detail
+
+/**
+ * Name: transformArrayParallel
+ * @brief transformArray with the array split into chunks run concurrently.
+ * @details Arrays shorter than TRANSFORM_PARALLEL_MIN, or with no worker available, are
+ *      done in one pass on the caller. fn must be safe to call from several threads at
+ *      once, which a stateless lambda or pipeline is. Returns once every chunk is done.
+ * @retval -1 if arr is NULL
+ * @retval 0 if successfully modified array
+ */
+template <typename T, typename Fn>
+int transformArrayParallel(T *arr, size_t len, Fn fn) {
+  if (arr == NULL) return -1;
+  if (len < TRANSFORM_PARALLEL_MIN || transformWorkers() == 0) return transformArray(arr, len, fn);
+
+  arraytransform_detail::ChunkContext<T, Fn> ctx = {arr, &fn};
+  transformRunChunks(len, &arraytransform_detail::runChunk<T, Fn>, &ctx);
+  return 0;
+}
+
+#endif
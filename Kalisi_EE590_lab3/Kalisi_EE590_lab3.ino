@@ -32,35 +32,60 @@
 
 // =========== Libraries ===========
 #include "590Lab3.h"
+#include "Alloc590.h"
+#include "ArrayTransform.h"
 #include "Special590functions.h"
+#include "Trace590.h"
 #include "driver/gpio.h"
 #include "soc/io_mux_reg.h"
 #include "soc/gpio_reg.h"
 #include "soc/gpio_periph.h"
 #include "soc/timer_group_reg.h"
+#include <MonotonicClock.h>
+#include <SoftTimer.h>
 
 
 // =========== Defines ===========
 #define INITIAL_BUFFER_SIZE 5 ///< Buffer size initial for testing Task 3.
 #define FIB_SIZE 10 ///< N elements of the Fibonacci Series to find. 
 #define FACT_VAL 10 ///< Value for which the Factorial needs to be found.
+#define FIB_BIG_N 300 ///< Fibonacci term past 64 bits, found with the BigUInt version.
+#define FACT_BIG_N 50 ///< Factorial past 64 bits, found with the BigUInt version.
 
 #define TIME_DIV 80 ///< dividing the 80Mhz to 1Mhz.
 #define TIME_EN (1<<31) ///< enabling timer.
 #define TIME_INCREMENT_MODE (1<<30) ///< choosing to increment timer instead of decrement.
 #define COUNT 1000000 ///< num cycles to count to, which is equivalent to 1 second.
+#define COUNTS_PER_US 1 ///< timer counts per microsecond after TIME_DIV.
+#define TIMER_TICK_US 1000 ///< Soft timer resolution, 1 ms.
+#define N_SOFT_TIMERS 4 ///< Periodic jobs run from loop(): sample, average, LED, background.
 
 #define LED 1 ///< LED output.
+#define TRACE_DRAIN_PER_PASS 4 ///< Most trace records formatted per loop pass.
+#define PRINT_MAX_AGE 10000 ///< Microseconds staged output may wait before printPoll sends it.
+#define PROCESSED_KEEP 24 ///< Newest averages always kept in processedData (1 minute at one per 2.5 s).
+#define PROCESSED_WINDOW 8 ///< Older averages folded into each min/max/mean summary (20 s).
+#define PROCESSED_SUMMARIES 45 ///< Summaries kept beyond PROCESSED_KEEP (15 minutes).
+#define SCHED_DEMO_TASKS 100 ///< Tasks simulated by taskScheduler (2.8 KB).
+#define SCHED_FLOWCHART_SIZE 256 ///< Flowchart entries for taskScheduler (1 KB); round robin needs 241 for 100 tasks.
+#define ALLOC_ARENA_SIZE 1024 ///< Pool arena for the library allocations of the background job.
 
 
 // =========== GLOBAL VARIABLES ===========
-// uint32_t LEDR_timer; ///< Timer which represents how long it has been since LEDR has been read.
-uint32_t LED_timer; ///< Timer which represents how long it has been since LED has changed/been outputted to.
-// uint32_t AVG_timer; ///< Timer which represents how long it has been since the last average was taken.
-uint32_t BACKGROUND_timer; ///< Timer which represents how long it has been since the background tasks were called.
-DynamicArray processedData; ///< processData holds a growing dynamic array that stores a list of average brightnesses
-CircularBuffer cb; ///< cb is a Circular buffer, meant to be at size 5, holds LEDR brightness values
+MonotonicClock timer64(0, COUNTS_PER_US); ///< 64 bit view of timer group 0; the 32 bit low word alone wraps after ~71 minutes.
+SoftTimerWheel<N_SOFT_TIMERS> softTimers(TIMER_TICK_US); ///< Runs each periodic job when it is due, replacing the per-job timer globals.
+DynamicArray processedData; ///< processData holds the recent average brightnesses, with older ones summarized into processedHistory
+int processedStorage[PROCESSED_KEEP + PROCESSED_WINDOW]; ///< Fixed backing store for processedData, so the loop never touches the heap
+ArraySummary processedSummaries[PROCESSED_SUMMARIES]; ///< Fixed backing store for processedHistory
+ArrayHistory processedHistory; ///< Downsampled averages evicted from processedData
+Task schedTasks[SCHED_DEMO_TASKS]; ///< Workload of taskScheduler, static so setup() takes nothing from the heap
+uint32_t schedFlowchart[SCHED_FLOWCHART_SIZE]; ///< Timeline recorded by taskScheduler
+SensorBuffer cb; ///< cb is a ring buffer of SENSOR_BUFFER_SIZE, holds LEDR brightness values between averages
 CircularBuffer cb_t5; ///< cb_t5 is a circular buffer used to test Task 5. 
+alignas(16) uint8_t allocArena[ALLOC_ARENA_SIZE]; ///< Backing store of allocPool
+AllocPool allocPool; ///< Serves every library allocation once setup() is done, so loop() never touches the heap
+size_t backgroundCarved = 0; ///< allocPool.carved after the first background run; later runs must not carve more
+int backgroundRuns = 0; ///< Background jobs run so far
 
 // ==== HELPER and TEST TASK FUNCTIONS ====
 
@@ -78,16 +103,15 @@ void task2(){
   // Task 2: Fibonacci and Factorial test cases. Use as needed
   printString("Task 2: Fibonacci and Factorial\n");
   
-  ///// Handling Fibonacci
-  unsigned long long *fibSequence;
-  fibonacci(FIB_SIZE, &fibSequence);
+  ///// Handling Fibonacci: terms come from a table, nothing is allocated
   printString("Fibonacci: ");
 
   for (int i = 0; i < FIB_SIZE; i++) {
-    printInt(fibSequence[i]);
+    unsigned long long term;
+    fibonacciTerm(i, &term);
+    printInt(term);
     if (i < FIB_SIZE-1) printString(", ");
   }
-  free(fibSequence);
   printString("\n");
 
   printString("The size of the Fibonacci is: ");
@@ -96,17 +120,37 @@ void task2(){
 
   ///// Handling Factorial
   unsigned long long factorialResult;
-  factorial(FACT_VAL, &factorialResult);
 
   printString("Factorial of ");
   printInt(FACT_VAL);
   printString(": ");
-  printInt(factorialResult);
+  if (factorial(FACT_VAL, &factorialResult) == MATH_OK) {
+    printInt(factorialResult);
+  } else {
+    printString("overflow");
+  }
   printString("\n");
 
   printString("Mem use of Factorial is: ");
   printInt(sizeof(unsigned long long) * 2);
   printString("\n");
+
+  ///// Beyond 64 bits
+  static BigUInt big;  // 260 bytes, kept off the loop() stack
+
+  printString("Fibonacci ");
+  printInt(FIB_BIG_N);
+  printString(": ");
+  if (bigintFibonacci(FIB_BIG_N, &big)) printBigUInt(&big);
+  else printString("overflow");
+  printString("\n");
+
+  printString("Factorial of ");
+  printInt(FACT_BIG_N);
+  printString(": ");
+  if (bigintFactorial(FACT_BIG_N, &big)) printBigUInt(&big);
+  else printString("overflow");
+  printString("\n");
   printString("Task 2 Completed.\n");
   printString("\n");
 
@@ -120,6 +164,9 @@ void task2(){
 void task3(){
   // Task 4: Dynamic Array sample test cases. Use as needed
   printString("Task 3: Dynamic Array\n");
+  AllocStats before, after;
+  getAllocStats(ALLOC_TAG_ARRAY, &before);
+
   DynamicArray arr;
   initArray(&arr, 2);
   addElement(&arr, 21);
@@ -139,19 +186,34 @@ void task3(){
   printString("/");
   printInt((&arr)->capacity);
   printString("\n");
+  // Allocated bytes come from the tracker, not from capacity, so they show what the allocator really holds
+  getAllocStats(ALLOC_TAG_ARRAY, &after);
+  uint32_t allocated = after.liveBytes - before.liveBytes;
+  uint32_t used = sizeof(int) * (&arr)->size;
   printString("Memory Report:\n");
   printString("\t- Total allocated: ");
-  printInt(sizeof(int) * (&arr)->capacity);
-  printString(" Bytes\n");
+  printUInt(allocated);
+  printString(" Bytes in ");
+  printUInt(after.liveBlocks - before.liveBlocks);
+  printString(" block(s)\n");
   printString("\t- Used: ");
-  printInt(sizeof(int) * (&arr)->size);
+  printUInt(used);
   printString(" Bytes\n");
   printString("\t- FreeSpace for more elements: ");
-  printInt(sizeof(int) * ((&arr)->capacity - (&arr)->size));
+  printUInt(allocated - used);
+  printString(" Bytes\n");
+  printString("\t- Grown ");
+  printUInt(after.reallocs - before.reallocs);
+  printString(" times, copying ");
+  printUInt((uint32_t)(after.copiedBytes - before.copiedBytes));
   printString(" Bytes\n");
 
   freeArray(&arr);
-  printString("Freed\n");
+  getAllocStats(ALLOC_TAG_ARRAY, &after);
+  printString("Freed, array bytes still live: ");
+  printUInt(after.liveBytes - before.liveBytes);
+  printString("\n");
+  printAllocReport();
   printString("Task 3 Completed.\n");
   printString("\n");
 }
@@ -221,7 +283,40 @@ void task4() {
   const char* b = "1100";
   print_truth_table(a, b);
 
-  Serial.println("Task 4 completed.\n");
+  printString("Task 4 completed.\n\n");
+}
+
+/**
+ * Name: taskScheduler
+ * @brief Simulates SCHED_DEMO_TASKS tasks under each scheduling policy and prints a Gantt chart and the statistics of each.
+ * @details The same workload is used for every policy, so the averages can be compared directly.
+ */
+void taskScheduler() {
+  static const SchedulerPolicy policies[] = { SCHED_ROUND_ROBIN, SCHED_PRIORITY, SCHED_SHORTEST_JOB };
+  static const char *names[] = { "Round robin", "Priority", "Shortest job first" };
+  printString("Scheduler Simulation\n");
+
+  for (int p = 0; p < 3; p++) {
+    SchedulerStats stats;
+    initialize_tasks(schedTasks, SCHED_DEMO_TASKS);
+    setSchedulerPolicy(policies[p], SCHED_DEFAULT_QUANTUM_MS);
+    run_scheduler(schedTasks, SCHED_DEMO_TASKS, schedFlowchart, SCHED_FLOWCHART_SIZE);
+    getSchedulerStats(&stats);
+
+    printString(names[p]);
+    printString(": makespan ");
+    printUInt(stats.makespan);
+    printString(" ms, max waiting ");
+    printUInt(stats.max_waiting);
+    printString(" ms, ");
+    printUInt(stats.context_switches);
+    printString(" context switches, ");
+    printInt(stats.entries);
+    printString(" flowchart entries\n");
+    print_flowchart(schedFlowchart, SCHED_FLOWCHART_SIZE, SCHED_DEMO_TASKS, schedTasks);
+  }
+
+  printString("Scheduler Simulation completed.\n\n");
 }
 
 /**
@@ -314,11 +409,18 @@ void testPointerOperations() {
   print_static_array(array2, 4);
   
   printString("Array tripled: ");
-  array_modify(array, 4, mult_3);
+  transformArray(array, 4, [](int x) { return mult_3(x); });
   print_static_array(array, 4);
 
   printString("Array2 + 1: ");
-  array_modify(array2, 4, add_1);
+  transformArray(array2, 4, [](int x) { return add_1(x); });
+  print_static_array(array2, 4);
+
+  // Three transforms fused into one pass over the array
+  printString("Array2 doubled, - 10, + 1: ");
+  transformArray(array2, 4, makePipeline([](int x) { return double_value(x); },
+                                         [](int x) { return subtract_ten(x); },
+                                         [](int x) { return add_1(x); }));
   print_static_array(array2, 4);
 
   //str_to_int
@@ -335,8 +437,9 @@ void testPointerOperations() {
   const char* b = "1100";
 
   print_truth_table(a, b);
+  printOperationComparisonTable();
 
-  Serial.println("Task 4 completed.\n");
+  printString("Task 4 completed.\n\n");
 }
 
 /**
@@ -442,6 +545,70 @@ void testCircularBuffer() {
   printString("Circular Buffer test completed.\n");
 }
 
+/**
+ * @}
+ */
+
+/**
+ * @name Periodic Jobs
+ * Soft timer callbacks registered in setup() and run by softTimers.poll() in loop().
+ * @{
+ */
+
+/**
+ * Name: sampleJob
+ * @brief Every 500 ms: reads the LDR into the ring buffer.
+ */
+void sampleJob(void *arg) {
+  sampleSensor(&cb);
+}
+
+/**
+ * Name: averageJob
+ * @brief Every 2.5 s: averages the recent samples into processedData and prints it.
+ */
+void averageJob(void *arg) {
+  averageSensor(&cb, &processedData);
+}
+
+/**
+ * Name: ledJob
+ * @brief Every 1 s: uses the most recent average as the LED brightness.
+ */
+void ledJob(void *arg) {
+  if(processedData.size > 0) {
+    ledcWrite(LED, (&processedData)->data[(&processedData)->size - 1]);
+  }
+}
+
+/**
+ * Name: backgroundJob
+ * @brief Every 10 s: runs tasks 2 to 5 again.
+ * @details Their allocations come from allocPool. The first run carves every block they
+ *      need; a later run that carves more, or leaves blocks live, is reported as heap churn.
+ */
+void backgroundJob(void *arg) {
+  task2();
+  task3();
+  task4();
+  task5();
+
+  AllocStats totals;
+  getAllocTotals(&totals);
+  if(backgroundRuns++ == 0) {
+    backgroundCarved = allocPool.carved;
+  } else if(allocPool.carved != backgroundCarved || totals.liveBlocks != 0) {
+    printString("Heap churn: pool carved ");
+    printUInt(allocPool.carved);
+    printString(" Bytes (was ");
+    printUInt(backgroundCarved);
+    printString("), live blocks ");
+    printUInt(totals.liveBlocks);
+    printString("\n");
+    backgroundCarved = allocPool.carved;
+  }
+}
+
 /**
  * @}
  */
@@ -469,10 +636,12 @@ void start_timer() {
  * Name: setup
  * @brief sets up all pins, timers and arrays to be used. 
  * @details Serial Monitor is begun at 9600 baud
- *      Tasks 2-5 are run. During testing, testPointerOperations, testReverse, and testCircularBuffer are run as well.
+ *      Tasks 2-5 and the scheduler simulation are run. During testing, testPointerOperations, testReverse, and testCircularBuffer are run as well.
+ *      The library allocator is then switched from the heap to allocPool for loop().
  *      Pin LED is enabled as GPIO, marked as an output and instantiated to 0. 
- *      Timers are configured. All timers are initialized.
+ *      Timers are configured. The periodic jobs are registered with the soft timer wheel.
  *      LEDC is attached 10 100Hz and 11 precision.
+ *      Output waits for the UART during the setup tests, then switches to dropping on overflow so loop() never stalls.
  */
 void setup() {
   Serial.begin(9600);
@@ -485,30 +654,44 @@ void setup() {
   // testReverse();
   // testCircularBuffer();
   task5();
+  taskScheduler();
+
+  // The one-off tests above used the heap; from here on the library allocates from the pool
+  if(!initAllocPool(&allocPool, allocArena, sizeof(allocArena)) || !setAllocator(&allocPool.allocator)) {
+    printString("Allocator pool not installed, loop() stays on the heap.\n");
+  }
 
   PIN_FUNC_SELECT(GPIO_PIN_MUX_REG[LED], PIN_FUNC_GPIO); // DEFINING LED_PIN as a GPIO PIN
   *(volatile uint32_t *) GPIO_ENABLE_REG |= (1 << LED); // Enabling pin
   *(volatile uint32_t *) GPIO_OUT_REG &= ~(1 << LED); // Switching off in the beginning
 
   start_timer();
-  // AVG_timer = *(volatile uint32_t *) TIMG_T0LO_REG(0); // start val for Averaging LEDR readings timer set up
-  LED_timer = *(volatile uint32_t *) TIMG_T0LO_REG(0); // start val for LED output modulation timer set up
-  BACKGROUND_timer = *(volatile uint32_t *) TIMG_T0LO_REG(0); // start val for background tasks timer set up
-  // LEDR_timer = *(volatile uint32_t *) TIMG_T0LO_REG(0); // start val for appending to circular buffer timer set up
+  softTimers.begin(timer64.micros());
+  softTimers.every(SENSOR_SAMPLE_US, sampleJob, NULL);   // appending to circular buffer
+  softTimers.every(SENSOR_AVERAGE_US, averageJob, NULL); // averaging LEDR readings
+  softTimers.every(COUNT, ledJob, NULL);                 // LED output modulation
+  softTimers.every(10 * COUNT, backgroundJob, NULL);     // background tasks
 
   // Initialize arrays
-  initBuffer(&cb, 5);
-  initArray(&processedData, 10);
+  initArrayStatic(&processedData, processedStorage, PROCESSED_KEEP + PROCESSED_WINDOW);
+  setArrayRetention(&processedData, &processedHistory, processedSummaries, PROCESSED_SUMMARIES, PROCESSED_WINDOW);
 
   //initialize LED as LEDC
   ledcAttach(LED, 100, 11); 
+
+  // From here on prints are staged and sent as the UART has room, never waiting on it
+  printFlush();
+  setPrintFlushPolicy(PRINT_FLUSH_THRESHOLD | PRINT_FLUSH_NEWLINE | PRINT_FLUSH_TIMER, PRINT_STAGING_SIZE / 4, PRINT_MAX_AGE);
+  setPrintOverflowPolicy(PRINT_OVERFLOW_DROP);
 }
 
 /**
  * Name: loop
  * @brief loop to be run repeatedly. Equivalent to running everything in main whith a while(1).
- * @details Updates timers and reads analog input from LEDR pin.
- *      checks if timers of 500ms, 2.5s, 1s, and 10s are triggered. expected outcomes are detailed further
+ * @details Reads the 64 bit time once and runs whichever of the 500ms, 2.5s, 1s, and 10s jobs are due.
+ *      Jobs that are not due cost nothing; expected outcomes are detailed with each job
+ *      Drains up to TRACE_DRAIN_PER_PASS trace records per pass, so diagnostics are printed off the hot path,
+ *      then lets printPoll hand staged output to the UART without blocking.
  */
 void loop() {
   // Task 6
@@ -516,32 +699,12 @@ void loop() {
   // Commented Purpose: Demonstrates integration of string manipulation, dynamic memory, and circular buffers in a real-time sensing and control task.
   // Edge Case Handling: Handles buffer wrap-around, buffer full condition, and dynamic array resizing automatically.
   // Error Handling: Assumes sensor and LED GPIO are properly initialized elsewhere as direct register access is used.
-  *(volatile uint32_t *) TIMG_T0UPDATE_REG(0) = 1; // Latch timer value
-  uint32_t curr_time = *(volatile uint32_t *) TIMG_T0LO_REG(0); //read timer val
-
-  simulateSensorData(&cb, &processedData);
+  //    a-d. Run the sample (500 ms), average (2.5 s), LED (1 s) and background (10 s) jobs that are due.
+  softTimers.poll(timer64.micros());
 
-  //    c. Check if 1 Second has passed since last LED update.
-  //       - If yes:
-  //          • Use most recent average as a brightness level for the LED.
-  //          • Apply this brightness level to the LED using PWM register logic.
-  //          • Reset the 1000 ms timer.
-  if(curr_time - LED_timer > COUNT) {
-    ledcWrite(LED, (&processedData)->data[(&processedData)->size - 1]);
-    LED_timer = curr_time;
-  }
-
-  //    d. Check if 10 seconds have passed since the last background tasks:
-  //       - If yes:
-  //          • Do all tasks from 2 to 5 again.
-  //          • Reset the 10000 ms timer.
-  if(curr_time - BACKGROUND_timer > 10 * COUNT) {
-    BACKGROUND_timer = curr_time;
-    task2();
-    task3();
-    task4();
-    task5();
-  }
+  //    e. Format a few pending trace records from the buffer/array operations above.
+  traceDrain(TRACE_DRAIN_PER_PASS);
+  printPoll();
 
   // 3. Do not use any blocking function calls (no delays).
   // 4. Do not use pinMode() or digitalWrite(); use direct register access instead.
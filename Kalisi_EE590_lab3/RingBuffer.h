@@ -0,0 +1,285 @@
+// Filename: RingBuffer.h
+// Author: Sai Jayanth Kalisi
+// Date: 10/17/26
+// Description: Header-only ring buffers for any trivially copyable type.
+//   RingBuffer<T, N> has compile-time capacity and static storage.
+//   DynamicRingBuffer<T> has a heap allocated capacity that can grow and shrink.
+//   Both keep free-running head/tail counters wrapped by a power-of-two mask, and move
+//   elements in bulk with at most two memcpy calls. Neither is safe to share between
+//   an ISR and a task; use SpscCircularBuffer for that.
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <type_traits>
+#include "Alloc590.h"
+
+/**
+ * @brief A contiguous run of elements inside a ring buffer.
+ */
+template <typename T>
+struct RingSpan {
+  T *data;      ///< First element of the run
+  size_t size;  ///< Number of elements in the run
+};
+
+namespace ringbuffer_detail {
+
+/**
+ * Name: copyIn
+ * @brief Copies count elements into a ring at position head, wrapping once if needed.
+ */
+template <typename T>
+inline void copyIn(T *storage, size_t capacity, size_t head, const T *src, size_t count) {
+  size_t offset = head & (capacity - 1);
+  size_t first = (count < capacity - offset) ? count : capacity - offset;
+  memcpy(storage + offset, src, first * sizeof(T));
+  memcpy(storage, src + first, (count - first) * sizeof(T));
+}
+
+/**
+ * Name: copyOut
+ * @brief Copies count elements out of a ring starting at position tail, wrapping once if needed.
+ */
+template <typename T>
+inline void copyOut(const T *storage, size_t capacity, size_t tail, T *dst, size_t count) {
+  size_t offset = tail & (capacity - 1);
+  size_t first = (count < capacity - offset) ? count : capacity - offset;
+  memcpy(dst, storage + offset, first * sizeof(T));
+  memcpy(dst + first, storage, (count - first) * sizeof(T));
+}
+
+/**
+ * Name: spans
+ * @brief Splits the size elements starting at tail into the two contiguous runs they occupy.
+ */
+template <typename T>
+inline void spans(T *storage, size_t capacity, size_t tail, size_t size, RingSpan<T> *first, RingSpan<T> *second) {
+  size_t offset = tail & (capacity - 1);
+  size_t run = (size < capacity - offset) ? size : capacity - offset;
+  first->data = storage + offset;
+  first->size = run;
+  second->data = storage;
+  second->size = size - run;
+}
+
+} // namespace ringbuffer_detail
+
+/**
+ * @brief Fixed capacity FIFO ring buffer.
+ * @tparam T element type, must be trivially copyable.
+ * @tparam N capacity, must be a power of two.
+ */
+template <typename T, size_t N>
+class RingBuffer {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "RingBuffer capacity must be a power of two");
+  static_assert(std::is_trivially_copyable<T>::value, "RingBuffer elements are moved with memcpy");
+
+public:
+  static constexpr size_t capacity() { return N; }
+  size_t size() const { return head_ - tail_; }
+  bool empty() const { return head_ == tail_; }
+  bool full() const { return size() == N; }
+  void clear() { head_ = tail_ = 0; }
+
+  /**
+   * Name: push
+   * @brief Appends one element.
+   * @retval false if full.
+   */
+  bool push(const T &value) {
+    if (full()) return false;
+    storage_[head_ & MASK] = value;
+    head_++;
+    return true;
+  }
+
+  /**
+   * Name: pop
+   * @brief Removes the oldest element into value.
+   * @retval false if empty.
+   */
+  bool pop(T *value) {
+    if (empty()) return false;
+    *value = storage_[tail_ & MASK];
+    tail_++;
+    return true;
+  }
+
+  /**
+   * Name: push_n
+   * @brief Appends up to count elements from src in at most two copies.
+   * @return number of elements appended, less than count if the buffer filled up.
+   */
+  size_t push_n(const T *src, size_t count) {
+    size_t space = N - size();
+    if (count > space) count = space;
+    ringbuffer_detail::copyIn(storage_, N, head_, src, count);
+    head_ += count;
+    return count;
+  }
+
+  /**
+   * Name: pop_n
+   * @brief Removes up to count of the oldest elements into dst in at most two copies.
+   * @return number of elements removed.
+   */
+  size_t pop_n(T *dst, size_t count) {
+    if (count > size()) count = size();
+    ringbuffer_detail::copyOut(storage_, N, tail_, dst, count);
+    tail_ += count;
+    return count;
+  }
+
+  /**
+   * Name: peek
+   * @brief Zero-copy view of every element, oldest first, as two contiguous runs.
+   * @details second is empty unless the contents wrap. Call consume() once done with them.
+   * @return total number of elements in both runs.
+   */
+  size_t peek(RingSpan<const T> *first, RingSpan<const T> *second) const {
+    ringbuffer_detail::spans<const T>(storage_, N, tail_, size(), first, second);
+    return size();
+  }
+
+  /**
+   * Name: consume
+   * @brief Drops up to count of the oldest elements, e.g. after reading them through peek().
+   */
+  void consume(size_t count) {
+    tail_ += (count < size()) ? count : size();
+  }
+
+private:
+  static constexpr size_t MASK = N - 1;
+  T storage_[N];
+  size_t head_ = 0;  ///< Elements ever pushed
+  size_t tail_ = 0;  ///< Elements ever popped
+};
+
+/**
+ * @brief FIFO ring buffer whose capacity is chosen, grown and shrunk at run time.
+ * @details Capacities are rounded up to a power of two. Storage comes from labAlloc
+ *      (tag ALLOC_TAG_RING) and is released by the destructor or release().
+ * @tparam T element type, must be trivially copyable.
+ */
+template <typename T>
+class DynamicRingBuffer {
+  static_assert(std::is_trivially_copyable<T>::value, "DynamicRingBuffer elements are moved with memcpy");
+
+public:
+  DynamicRingBuffer() {}
+  ~DynamicRingBuffer() { release(); }
+  DynamicRingBuffer(const DynamicRingBuffer &) = delete;
+  DynamicRingBuffer &operator=(const DynamicRingBuffer &) = delete;
+
+  size_t capacity() const { return capacity_; }
+  size_t size() const { return head_ - tail_; }
+  bool empty() const { return head_ == tail_; }
+  bool full() const { return size() == capacity_; }
+  void clear() { head_ = tail_ = 0; }
+
+  /**
+   * Name: resize
+   * @brief Grows or shrinks the storage, keeping FIFO order.
+   * @details The contents are moved to the front of the new storage with at most two copies.
+   * @param new_capacity requested capacity, rounded up to a power of two.
+   * @retval false if the rounded capacity cannot hold the current contents, or the allocation failed.
+   *      The buffer is unchanged in both cases.
+   */
+  bool resize(size_t new_capacity) {
+    size_t rounded = 1;
+    while (rounded < new_capacity) rounded <<= 1;
+    if (rounded < size()) return false;
+    if (rounded == capacity_) return true;
+
+    T *fresh = (T *)labAlloc(ALLOC_TAG_RING, rounded * sizeof(T));
+    if (fresh == NULL) return false;
+
+    size_t count = size();
+    if (storage_ != NULL) {
+      ringbuffer_detail::copyOut(storage_, capacity_, tail_, fresh, count);
+      labFree(ALLOC_TAG_RING, storage_, capacity_ * sizeof(T));
+    }
+    storage_ = fresh;
+    capacity_ = rounded;
+    tail_ = 0;
+    head_ = count;
+    return true;
+  }
+
+  /**
+   * Name: shrink_to_fit
+   * @brief Shrinks capacity to the smallest power of two holding the current contents.
+   */
+  bool shrink_to_fit() {
+    return resize(size() > 0 ? size() : 1);
+  }
+
+  /**
+   * Name: release
+   * @brief Frees the storage and empties the buffer.
+   */
+  void release() {
+    labFree(ALLOC_TAG_RING, storage_, capacity_ * sizeof(T));
+    storage_ = NULL;
+    capacity_ = 0;
+    head_ = tail_ = 0;
+  }
+
+  bool push(const T &value) {
+    if (full()) return false;
+    storage_[head_ & (capacity_ - 1)] = value;
+    head_++;
+    return true;
+  }
+
+  bool pop(T *value) {
+    if (empty()) return false;
+    *value = storage_[tail_ & (capacity_ - 1)];
+    tail_++;
+    return true;
+  }
+
+  size_t push_n(const T *src, size_t count) {
+    size_t space = capacity_ - size();
+    if (count > space) count = space;
+    if (count == 0) return 0;
+    ringbuffer_detail::copyIn(storage_, capacity_, head_, src, count);
+    head_ += count;
+    return count;
+  }
+
+  size_t pop_n(T *dst, size_t count) {
+    if (count > size()) count = size();
+    if (count == 0) return 0;
+    ringbuffer_detail::copyOut(storage_, capacity_, tail_, dst, count);
+    tail_ += count;
+    return count;
+  }
+
+  size_t peek(RingSpan<const T> *first, RingSpan<const T> *second) const {
+    if (storage_ == NULL) {
+      first->data = second->data = NULL;
+      first->size = second->size = 0;
+      return 0;
+    }
+    ringbuffer_detail::spans<const T>(storage_, capacity_, tail_, size(), first, second);
+    return size();
+  }
+
+  void consume(size_t count) {
+    tail_ += (count < size()) ? count : size();
+  }
+
+private:
+  T *storage_ = NULL;
+  size_t capacity_ = 0;  ///< Always 0 or a power of two
+  size_t head_ = 0;      ///< Elements ever pushed
+  size_t tail_ = 0;      ///< Elements ever popped
+};
+
+#endif
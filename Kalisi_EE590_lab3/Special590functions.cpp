@@ -22,12 +22,135 @@
 #include <Arduino.h>
 #include <cmath>
 
-// =========== DEFINES ===========
+// =========== GLOBALS ===========
+static char stagingBuffer[PRINT_STAGING_SIZE];  // Output staged here until it is flushed to Serial
+static size_t stageHead = 0;                    // Bytes ever staged
+static size_t stageTail = 0;                    // Bytes ever handed to Serial
+static uint32_t stageSince = 0;                 // micros() when the oldest pending byte was staged
+static size_t droppedBytes = 0;                 // Bytes lost under PRINT_OVERFLOW_DROP
 
-#define BUFFER_SIZE 128          // Define buffer size for all strings
+static uint8_t flushFlags = PRINT_FLUSH_THRESHOLD | PRINT_FLUSH_NEWLINE;
+static size_t flushThreshold = PRINT_STAGING_SIZE / 2;
+static uint32_t flushMaxAge = 20000;
+static PrintOverflowPolicy overflowPolicy = PRINT_OVERFLOW_BLOCK;
 
-// =========== GLOBALS ===========
-char stringBuffer[BUFFER_SIZE];  // Declare a global buffer for strings
+// Two ASCII digits for every value 0-99, so integers are formatted two digits per step
+static const char digitPairs[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+
+// =========== HELPERS ===========
+
+/**
+ * Name: sendStaged
+ * @brief Hands staged bytes to Serial, one Serial.write per contiguous segment.
+ * @param block if false, only as many bytes as Serial.availableForWrite() reports are sent.
+ */
+static void sendStaged(bool block) {
+  while (stageHead != stageTail) {
+    size_t offset = stageTail & (PRINT_STAGING_SIZE - 1);
+    size_t len = stageHead - stageTail;
+    if (len > PRINT_STAGING_SIZE - offset) {
+      len = PRINT_STAGING_SIZE - offset;  // up to the end of the ring, the rest goes next pass
+    }
+
+    if (!block) {
+      int space = Serial.availableForWrite();
+      if (space <= 0) break;
+      if ((size_t)space < len) len = space;
+    }
+
+    size_t sent = Serial.write((const uint8_t *)&stagingBuffer[offset], len);
+    stageTail += sent;
+    if (sent < len) break;
+  }
+
+  if (stageHead != stageTail) {
+    stageSince = micros();  // whatever is left is treated as a new batch
+  }
+}
+
+/**
+ * Name: stageBytes
+ * @brief Copies bytes into the staging ring.
+ * @details When the ring is full it flushes according to the overflow policy; under
+ *      PRINT_OVERFLOW_DROP anything that still does not fit is dropped and counted.
+ * @param data bytes to stage.
+ * @param len number of bytes.
+ */
+static void stageBytes(const char *data, size_t len) {
+  if (stageHead == stageTail) {
+    stageSince = micros();
+  }
+
+  while (len > 0) {
+    size_t space = PRINT_STAGING_SIZE - (stageHead - stageTail);
+    if (space == 0) {
+      sendStaged(overflowPolicy == PRINT_OVERFLOW_BLOCK);
+      space = PRINT_STAGING_SIZE - (stageHead - stageTail);
+      if (space == 0) {
+        droppedBytes += len;
+        return;
+      }
+    }
+
+    size_t offset = stageHead & (PRINT_STAGING_SIZE - 1);
+    size_t chunk = len;
+    if (chunk > space) chunk = space;
+    if (chunk > PRINT_STAGING_SIZE - offset) chunk = PRINT_STAGING_SIZE - offset;
+
+    memcpy(&stagingBuffer[offset], data, chunk);
+    stageHead += chunk;
+    data += chunk;
+    len -= chunk;
+  }
+}
+
+/**
+ * Name: autoFlush
+ * @brief Applies the threshold and newline flush policies after a print.
+ * @param newline whether the print contained a '\n'.
+ */
+static void autoFlush(bool newline) {
+  bool overThreshold = (stageHead - stageTail) >= flushThreshold;
+  if (((flushFlags & PRINT_FLUSH_THRESHOLD) && overThreshold) ||
+      ((flushFlags & PRINT_FLUSH_NEWLINE) && newline)) {
+    sendStaged(overflowPolicy == PRINT_OVERFLOW_BLOCK);
+  }
+}
+
+/**
+ * Name: formatDecimal
+ * @brief Writes num in decimal ending just before end, two digits per step.
+ * @param num value to format.
+ * @param end one past the last character to write.
+ * @return pointer to the first character written.
+ */
+static char *formatDecimal(uint32_t num, char *end) {
+  char *p = end;
+  while (num >= 100) {
+    const char *pair = &digitPairs[(num % 100) * 2];
+    num /= 100;
+    *--p = pair[1];
+    *--p = pair[0];
+  }
+  if (num >= 10) {
+    *--p = digitPairs[num * 2 + 1];
+    *--p = digitPairs[num * 2];
+  } else {
+    *--p = '0' + num;
+  }
+  return p;
+}
 
 
 // =========== FUNCTIONS ===========
@@ -35,81 +158,154 @@ char stringBuffer[BUFFER_SIZE];  // Declare a global buffer for strings
 /**
  * Name: printChar
  * @brief Task 1 step 1: Print Char pointed to by c.
- * @details prints character to the serial pointed to by c.
+ * @details stages the character pointed to by c for output.
  * @param c pointer pointing to a character to be printed.
  */
 void printChar(const char *c) {
-  Serial.print(*c);
+  stageBytes(c, 1);
+  autoFlush(*c == '\n');
 }
 
 /**
  * Name: printString
  * @brief Task 1 step 2: Print str.
- * @details prints all characters until a new line is detected.
+ * @details stages the whole string in one copy. A newline no longer ends the string;
+ *      it only triggers a flush when PRINT_FLUSH_NEWLINE is set.
  * @param str pointer pointing to a list of chars to be printed.
  */
 void printString(const char *str) {
-  //task 1 step 2
-  // This is a fully completed function for you to study.
-
-  // Iterate through the memory locations of the input string
-  char *dest = stringBuffer;  // Pointer to the destination buffer
-  const char *src = str;      // Pointer to the source string
-
-  // Copy characters from src to dest until null terminator or buffer limit
-  while (*src != '\0' && (dest - stringBuffer) < BUFFER_SIZE - 1) {
-    *dest = *src;     // Copy character
-    printChar(dest);  // Print the copied character
-    if (*dest == '\n') {
-      break;  // Stop at newline character
-    }
-    src++;   // Move source pointer to next character
-    dest++;  // Move destination pointer to next position
-  }
-
-  // Null terminate the buffer
-  *dest = '\0';
-
-  // Reset the buffer (clear all data)
-  for (int i = 0; i < BUFFER_SIZE; i++) {
-    stringBuffer[i] = '\0';
-  }
+  size_t len = strlen(str);
+  stageBytes(str, len);
+  autoFlush(memchr(str, '\n', len) != NULL);
 }
 
 /**
  * Name: printFloat
  * @brief Task 1 step 3: Print str.
  * @details prints all characters in a float until teh 2nd decimal place.
+ *      Whole and fractional parts are formatted separately with the digit table, so no
+ *      sprintf is needed. Magnitudes of 2^32 and above print as "ovf".
  * @param f float to be printed.
  */
 void printFloat(float f) {
-  // task 1 step 3: Print the given float value 'f'
-  // 'f' can be upto 8 digits long
-  // 'f' should always be printed out to 2 decimal places
-  int n;
-  char buffer [8];
-  n = sprintf(buffer, "%0.2f", f);
-  printString(buffer);
+  if (std::isnan(f)) {
+    printString("nan");
+    return;
+  }
+
+  bool isNeg = std::signbit(f);
+  float mag = std::fabs(f);
+  if (mag >= 4294967296.0f) {
+    printString(isNeg ? "-ovf" : "ovf");
+    return;
+  }
+
+  uint32_t whole = (uint32_t)mag;
+  uint32_t frac = (uint32_t)((mag - whole) * 100.0f + 0.5f);
+  if (frac >= 100) {
+    whole++;
+    frac -= 100;
+  }
+
+  char buffer[16];
+  char *end = buffer + sizeof(buffer);
+  char *p = end - 2;
+  p[0] = digitPairs[frac * 2];
+  p[1] = digitPairs[frac * 2 + 1];
+  *--p = '.';
+  p = formatDecimal(whole, p);
+  if (isNeg) *--p = '-';
+
+  stageBytes(p, end - p);
+  autoFlush(false);
 }
 
 /**
  * Name: printInt
  * @brief Helper function I created to print ints faster.
- * @details Prints all ints digit by digit.
- * @param num number to print. Assumes that all nums are valid numbers.
+ * @details Formats the whole number into a local buffer without recursion, then stages it once.
+ * @param num number to print. All ints, including INT_MIN, are valid.
  */
 void printInt(int num) {
-    // Handle negative numbers
-    if (num < 0) {
-        printChar("-");
-        num = -num;
-    }
+  char buffer[12];
+  char *end = buffer + sizeof(buffer);
+  uint32_t mag = (num < 0) ? 0u - (uint32_t)num : (uint32_t)num;
+  char *p = formatDecimal(mag, end);
+  if (num < 0) *--p = '-';
 
-    // Convert integer to string using recursion
-    if (num / 10 != 0) {
-        printInt(num / 10);  // print leading digits
-    }
+  stageBytes(p, end - p);
+  autoFlush(false);
+}
+
+/**
+ * Name: printUInt
+ * @brief Prints an unsigned 32 bit number, such as a raw timer value.
+ * @param num number to print.
+ */
+void printUInt(uint32_t num) {
+  char buffer[10];
+  char *end = buffer + sizeof(buffer);
+  char *p = formatDecimal(num, end);
+
+  stageBytes(p, end - p);
+  autoFlush(false);
+}
+
+/**
+ * Name: printFlush
+ * @brief Sends everything staged, waiting for the UART if it has to.
+ */
+void printFlush() {
+  sendStaged(true);
+}
 
-    char digit = (num % 10) + '0';
-    printChar(&digit);         // print current digit
+/**
+ * Name: printPoll
+ * @brief Call once per loop pass. Applies the timer flush policy.
+ * @details Staged output older than max_age_us is sent; under PRINT_OVERFLOW_DROP only
+ *      what the UART can take right now is sent, so this never waits.
+ */
+void printPoll() {
+  if ((flushFlags & PRINT_FLUSH_TIMER) && stageHead != stageTail &&
+      micros() - stageSince >= flushMaxAge) {
+    sendStaged(overflowPolicy == PRINT_OVERFLOW_BLOCK);
+  }
+}
+
+/**
+ * Name: setPrintFlushPolicy
+ * @brief Chooses when staged output is sent automatically.
+ * @param flags PRINT_FLUSH_* flags combined with |.
+ * @param threshold staged byte count that triggers PRINT_FLUSH_THRESHOLD.
+ * @param max_age_us age that triggers PRINT_FLUSH_TIMER in printPoll().
+ */
+void setPrintFlushPolicy(uint8_t flags, size_t threshold, uint32_t max_age_us) {
+  flushFlags = flags;
+  flushThreshold = threshold;
+  flushMaxAge = max_age_us;
+}
+
+/**
+ * Name: setPrintOverflowPolicy
+ * @brief Chooses whether prints wait for the UART or drop output once staging is full.
+ * @param policy PRINT_OVERFLOW_BLOCK or PRINT_OVERFLOW_DROP.
+ */
+void setPrintOverflowPolicy(PrintOverflowPolicy policy) {
+  overflowPolicy = policy;
+}
+
+/**
+ * Name: printPending
+ * @brief Number of staged bytes not yet handed to Serial.
+ */
+size_t printPending() {
+  return stageHead - stageTail;
+}
+
+/**
+ * Name: printDroppedBytes
+ * @brief Total bytes dropped under PRINT_OVERFLOW_DROP.
+ */
+size_t printDroppedBytes() {
+  return droppedBytes;
 }
@@ -7,9 +7,36 @@
 #ifndef SPECIAL590FUNCTIONS_H
 #define SPECIAL590FUNCTIONS_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef PRINT_STAGING_SIZE
+#define PRINT_STAGING_SIZE 2048  // Bytes staged before output is flushed or dropped. Must be a power of two
+#endif
+
+// Flush policy flags, combined with |
+#define PRINT_FLUSH_MANUAL    0x00  // Only printFlush() sends staged output
+#define PRINT_FLUSH_THRESHOLD 0x01  // Flush once the staged bytes reach the threshold
+#define PRINT_FLUSH_NEWLINE   0x02  // Flush after any print containing '\n'
+#define PRINT_FLUSH_TIMER     0x04  // printPoll() flushes output older than max_age_us
+
+// What happens when the staging buffer is full
+typedef enum {
+  PRINT_OVERFLOW_BLOCK,  // Wait for the UART to take the bytes (nothing is lost)
+  PRINT_OVERFLOW_DROP    // Never wait; bytes that do not fit are dropped and counted
+} PrintOverflowPolicy;
+
 void printChar(const char *c);
 void printString(const char *str);
 void printFloat(float value);
 void printInt(int num);
+void printUInt(uint32_t num);
+
+void printFlush();
+void printPoll();
+void setPrintFlushPolicy(uint8_t flags, size_t threshold, uint32_t max_age_us);
+void setPrintOverflowPolicy(PrintOverflowPolicy policy);
+size_t printPending();
+size_t printDroppedBytes();
 
 #endif
@@ -0,0 +1,136 @@
+/**
+ * @file Trace590.cpp
+ *
+ * @section description Description
+ * Deferred tracing for the Lab 3 data structures. The hot path stores a 12 byte record
+ * in a RAM ring; traceDrain formats the records through Special590functions later,
+ * from the background part of loop().
+ *
+ * @section notes Notes
+ * - Comments are Doxygen compatible.
+ * - Records are expected from one context only, the same as the CircularBuffer and
+ *   DynamicArray functions that produce them. The drain may run in another.
+ *
+ * @section author Author
+ * - Created by Sai Jayanth Kalisi.
+ */
+
+// =========== Libraries ===========
+#include "Trace590.h"
+#include "Special590functions.h"
+#include "Arduino.h"
+
+#include <atomic>
+#include "soc/timer_group_reg.h"
+
+// =========== GLOBALS ===========
+
+/**
+ * @brief Text printed around the two arguments of each TraceEvent.
+ * A NULL infix means the event only uses its first argument.
+ */
+typedef struct {
+  const char *prefix;
+  const char *infix;
+} TraceFormat;
+
+static const TraceFormat traceFormats[TRACE_EV_COUNT] = {
+  {"Write: ", NULL},                                           // TRACE_EV_WRITE
+  {"Buffer is Full. Unable to write ", NULL},                  // TRACE_EV_WRITE_FULL
+  {"Read -> ", NULL},                                          // TRACE_EV_READ
+  {"Pop ", ". Tail at: "},                                     // TRACE_EV_POP
+  {"Pop ", NULL},                                              // TRACE_EV_POP_EMPTY
+  {"Push ", ". New Head at "},                                 // TRACE_EV_PUSH
+  {"Overwrote Tail. Was full. Initial at ", ". Tail is now at "},  // TRACE_EV_PUSH_OVERWRITE
+  {"Resized from ", " to "},                                   // TRACE_EV_RESIZE
+  {"Resize rejected. Kept ", " over "},                        // TRACE_EV_RESIZE_REJECTED
+  {"addElement: ", NULL},                                      // TRACE_EV_ADD_ELEMENT
+  {"addElement grew capacity to ", NULL},                      // TRACE_EV_ARRAY_GROW
+  {"Increasing Capacity failed at ", NULL},                    // TRACE_EV_ARRAY_GROW_FAILED
+  {"Array storage full. Dropped ", NULL},                      // TRACE_EV_ARRAY_FULL
+  {"Summarized ", " oldest elements, mean "},                  // TRACE_EV_ARRAY_EVICT
+};
+
+static const char *const traceLevelNames[] = {"", "E ", "W ", "I ", "D "};
+
+static TraceRecord traceRing[TRACE_RING_SIZE];  ///< Pending records
+static std::atomic<uint32_t> traceHead(0);      ///< Records ever written
+static std::atomic<uint32_t> traceTail(0);      ///< Records ever drained
+static std::atomic<uint32_t> traceDropped(0);   ///< Records lost to a full ring since the last drain
+
+// =========== FUNCTIONS ===========
+
+/**
+ * Name: traceRecord
+ * @brief Stores one trace record. Use the TRACE_* macros instead of calling this directly.
+ * @details Never blocks or prints: if the ring is full the record is dropped and counted,
+ *      and the drain reports the count.
+ * @param level TRACE_LEVEL_* of the event.
+ * @param event TraceEvent id.
+ * @param arg0 first argument.
+ * @param arg1 second argument.
+ */
+void IRAM_ATTR traceRecord(uint16_t level, uint16_t event, int32_t arg0, int32_t arg1) {
+  uint32_t head = traceHead.load(std::memory_order_relaxed);
+  if (head - traceTail.load(std::memory_order_acquire) >= TRACE_RING_SIZE) {
+    traceDropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  TraceRecord *rec = &traceRing[head & (TRACE_RING_SIZE - 1)];
+  rec->timestamp = *(volatile uint32_t *) TIMG_T0LO_REG(0);
+  rec->event = event;
+  rec->level = level;
+  rec->args[0] = arg0;
+  rec->args[1] = arg1;
+  traceHead.store(head + 1, std::memory_order_release);
+}
+
+/**
+ * Name: traceDrain
+ * @brief Formats and prints pending trace records.
+ * @details Prints at most max_records so a single loop pass stays short, each as
+ *      "[timestamp] L message". A dropped-record count is printed first if any were lost.
+ * @param max_records most records to print in this call.
+ * @return number of records printed.
+ */
+size_t traceDrain(size_t max_records) {
+  uint32_t dropped = traceDropped.exchange(0, std::memory_order_relaxed);
+  if (dropped > 0) {
+    printString("[trace] dropped ");
+    printInt(dropped);
+    printString(" records\n");
+  }
+
+  size_t printed = 0;
+  uint32_t tail = traceTail.load(std::memory_order_relaxed);
+  while (printed < max_records && tail != traceHead.load(std::memory_order_acquire)) {
+    const TraceRecord *rec = &traceRing[tail & (TRACE_RING_SIZE - 1)];
+    const TraceFormat *fmt = &traceFormats[rec->event < TRACE_EV_COUNT ? rec->event : 0];
+
+    printString("[");
+    printUInt(rec->timestamp);
+    printString("] ");
+    printString(traceLevelNames[rec->level <= TRACE_LEVEL_DEBUG ? rec->level : 0]);
+    printString(fmt->prefix);
+    printInt(rec->args[0]);
+    if (fmt->infix != NULL) {
+      printString(fmt->infix);
+      printInt(rec->args[1]);
+    }
+    printString("\n");
+
+    tail++;
+    traceTail.store(tail, std::memory_order_release);
+    printed++;
+  }
+  return printed;
+}
+
+/**
+ * Name: tracePending
+ * @brief Number of records waiting to be drained.
+ */
+size_t tracePending() {
+  return traceHead.load(std::memory_order_acquire) - traceTail.load(std::memory_order_acquire);
+}
@@ -0,0 +1,82 @@
+// Filename: Trace590.h
+// Author: Sai Jayanth Kalisi
+// Date: 10/17/26
+// Description: Deferred, compile-time-levelled tracing for the Lab 3 data structures.
+
+#ifndef TRACE590_H
+#define TRACE590_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Trace levels. Anything above TRACE_LEVEL compiles to nothing.
+#define TRACE_LEVEL_NONE  0
+#define TRACE_LEVEL_ERROR 1
+#define TRACE_LEVEL_WARN  2
+#define TRACE_LEVEL_INFO  3
+#define TRACE_LEVEL_DEBUG 4
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL TRACE_LEVEL_INFO
+#endif
+
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 64  // Records held before new ones are dropped. Must be a power of two
+#endif
+
+// Event ids. Each has a matching entry in the format table in Trace590.cpp.
+typedef enum {
+  TRACE_EV_WRITE,
+  TRACE_EV_WRITE_FULL,
+  TRACE_EV_READ,
+  TRACE_EV_POP,
+  TRACE_EV_POP_EMPTY,
+  TRACE_EV_PUSH,
+  TRACE_EV_PUSH_OVERWRITE,
+  TRACE_EV_RESIZE,
+  TRACE_EV_RESIZE_REJECTED,
+  TRACE_EV_ADD_ELEMENT,
+  TRACE_EV_ARRAY_GROW,
+  TRACE_EV_ARRAY_GROW_FAILED,
+  TRACE_EV_ARRAY_FULL,
+  TRACE_EV_ARRAY_EVICT,
+  TRACE_EV_COUNT
+} TraceEvent;
+
+// One binary trace record, formatted later by traceDrain.
+typedef struct {
+  uint32_t timestamp;  // TIMG_T0LO_REG(0) at the time of the event
+  uint16_t event;      // TraceEvent
+  uint16_t level;      // TRACE_LEVEL_* of the event
+  int32_t args[2];     // Event arguments, meaning given by the format table
+} TraceRecord;
+
+void traceRecord(uint16_t level, uint16_t event, int32_t arg0, int32_t arg1);
+size_t traceDrain(size_t max_records);
+size_t tracePending();
+
+#if TRACE_LEVEL >= TRACE_LEVEL_ERROR
+#define TRACE_ERROR(ev, a0, a1) traceRecord(TRACE_LEVEL_ERROR, (ev), (int32_t)(a0), (int32_t)(a1))
+#else
+#define TRACE_ERROR(ev, a0, a1) do { } while (0)
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_WARN
+#define TRACE_WARN(ev, a0, a1) traceRecord(TRACE_LEVEL_WARN, (ev), (int32_t)(a0), (int32_t)(a1))
+#else
+#define TRACE_WARN(ev, a0, a1) do { } while (0)
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_INFO
+#define TRACE_INFO(ev, a0, a1) traceRecord(TRACE_LEVEL_INFO, (ev), (int32_t)(a0), (int32_t)(a1))
+#else
+#define TRACE_INFO(ev, a0, a1) do { } while (0)
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_DEBUG
+#define TRACE_DEBUG(ev, a0, a1) traceRecord(TRACE_LEVEL_DEBUG, (ev), (int32_t)(a0), (int32_t)(a1))
+#else
+#define TRACE_DEBUG(ev, a0, a1) do { } while (0)
+#endif
+
+#endif
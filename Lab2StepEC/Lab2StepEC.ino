@@ -11,20 +11,53 @@
 #include "soc/gpio_reg.h"
 #include "soc/gpio_periph.h"
 #include "soc/timer_group_reg.h"
+#include <MonotonicClock.h>
+#include <SoftTimer.h>
 
 // ================ MACROS ================
 
 #define LED_PIN 1 //output LED
 #define LEDR_PIN 10 //photoresistor input
 #define TIME_FREQ 80000000 //timer frequency
+#define COUNTS_PER_US (TIME_FREQ / 1000000) //timer counts per microsecond
+#define BLINK_TICK_US 1000 //soft timer resolution, 1 ms
 
 // =========== GLOBAL VARIABLES ===========
-uint32_t timer_val;
+// The 32 bit low word of the 80 MHz timer wraps every ~53 s, so time is read as 64 bits
+MonotonicClock timer64(0, COUNTS_PER_US);
+SoftTimerWheel<1> timers(BLINK_TICK_US); //only the blink job
+int blinkTimer; //soft timer toggling the LED
 bool currentState = true; //not required if using xor
-int freqMod; //modifier is changed depending on photoresistor light exposure
+int freqMod = 0; //modifier is changed depending on photoresistor light exposure, 0 when off
 
 // ======= Function IMPLEMENTATIONS =======
 
+// Name: toggleLed
+// Description: soft timer job, runs once per half period
+// Expected Behavior: light output is swapped from off to on and viceversa
+void toggleLed(void *arg) {
+  if(currentState){
+    *(volatile uint32_t *) GPIO_OUT_REG |= (1 << LED_PIN); //on
+  }
+  else {
+    *(volatile uint32_t *) GPIO_OUT_REG &= ~(1 << LED_PIN); //off
+  }
+  currentState = !currentState; //swap state
+}
+
+// Name: setBlinkRate
+// Description: restarts the blink job when the frequency modifier changes, stops it for 0
+void setBlinkRate(int newFreqMod) {
+  if(newFreqMod == freqMod) return;
+  freqMod = newFreqMod;
+  if(freqMod == 0) {
+    timers.stop(blinkTimer);
+  } else {
+    uint32_t period = 1000000 / freqMod; //TIME_FREQ/freqMod counts, in microseconds
+    timers.start(blinkTimer, period, period);
+  }
+}
+
 // Name: start_timer
 // Description: Setting up timer
 // Expected Behavior: a 80 MHz timer
@@ -42,7 +75,8 @@ void setup() {
 
   //talk about how to configure pins for input
   start_timer();
-  timer_val = *(volatile uint32_t *) TIMG_T0LO_REG(0); //start val for timer set up
+  timers.begin(timer64.micros()); //start val for timer set up
+  blinkTimer = timers.create(toggleLed, NULL);
 
   Serial.begin(115200);
 }
@@ -53,38 +87,27 @@ void setup() {
     // and the LED frequency is modified based on the read value. based on thresholds 
     // met (200, 500, 900) of analog read values, the led period is (off, 0.5hz, 1 hz and 2 hz)
     // read value range requivalent is printed to serial
+    // the blink itself is the toggleLed soft timer job, run by timers.poll when it is due
 void loop() {
-  *(volatile uint32_t *) TIMG_T0UPDATE_REG(0) = 1; // Latch timer value
-  uint32_t timer_val2 = *(volatile uint32_t *) TIMG_T0LO_REG(0); //read timer val
   int currIntensity = analogRead(LEDR_PIN); //photo resistor input val
   
   // off condition
   if(currIntensity < 200) {
+    setBlinkRate(0);
     *(volatile uint32_t *) GPIO_OUT_REG &= ~(1 << LED_PIN);
     Serial.println("OFF");
   } else {
     if (currIntensity < 500) { //low frequency condition
-      freqMod = 1;
+      setBlinkRate(1);
       Serial.println("LOW");
     } else if (currIntensity < 900) { //mid frequency condition
-      freqMod = 2;
+      setBlinkRate(2);
       Serial.println("MID");
     } else { //high frequency condition
-      freqMod = 4;
+      setBlinkRate(4);
       Serial.println("HIGH");
     }
+  }
 
-    //based on condition ser, time is checked. If time check passes period requirements
-    //light output is swapped from off to on and viceversa
-    if(timer_val2 - timer_val > TIME_FREQ/freqMod) {
-      if(currentState){
-        *(volatile uint32_t *) GPIO_OUT_REG |= (1 << LED_PIN); //on
-      }
-      else {
-        *(volatile uint32_t *) GPIO_OUT_REG &= ~(1 << LED_PIN); //off
-      }
-      currentState = !currentState; //swap state
-      timer_val = timer_val2;
-    }
-  } 
+  timers.poll(timer64.micros()); //runs the blink job only when its period has passed
 }
@@ -0,0 +1,71 @@
+/**
+ * @file Bench.h
+ * @brief Minimal timing helpers shared by the host benchmarks.
+ *
+ * @section description Description
+ * benchNsPerOp runs a body several times and keeps the fastest run, which is the
+ * least disturbed by the rest of the machine. Results are printed as one row per
+ * case so runs can be diffed.
+ */
+#ifndef HOST_BENCH_H
+#define HOST_BENCH_H
+
+#include <chrono>
+#include <stddef.h>
+#include <stdio.h>
+
+#define BENCH_REPEATS 5 ///< Runs per case; the fastest is reported
+
+/**
+ * Name: benchNowSeconds
+ * @brief Monotonic wall clock in seconds.
+ */
+inline double benchNowSeconds() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Name: benchKeep
+ * @brief Stops the compiler from discarding a value that is only computed for timing.
+ */
+template <typename T>
+inline void benchKeep(T const &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * Name: benchNsPerOp
+ * @brief Times body(iterations) and returns nanoseconds per iteration.
+ * @param body callable taking the iteration count; it runs the whole loop itself so
+ *      the call overhead is not part of the measurement.
+ * @param iterations iterations per run.
+ */
+template <typename Body>
+double benchNsPerOp(Body body, size_t iterations) {
+  double best = 1e30;
+  for (int r = 0; r < BENCH_REPEATS; r++) {
+    double start = benchNowSeconds();
+    body(iterations);
+    double elapsed = benchNowSeconds() - start;
+    if (elapsed < best) best = elapsed;
+  }
+  return best * 1e9 / iterations;
+}
+
+/**
+ * Name: benchHeader
+ * @brief Prints the column header used by benchRow.
+ */
+inline void benchHeader() {
+  printf("%-40s %10s %12s\n", "benchmark", "param", "ns/op");
+}
+
+/**
+ * Name: benchRow
+ * @brief Prints one result row.
+ */
+inline void benchRow(const char *name, long param, double nsPerOp) {
+  printf("%-40s %10ld %12.2f\n", name, param, nsPerOp);
+}
+
+#endif
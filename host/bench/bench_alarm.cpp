@@ -0,0 +1,253 @@
+/**
+ * @file bench_alarm.cpp
+ * @brief Lab 5 Part 2 anomaly alarm: sample-to-alarm latency and dropped samples of the
+ *      blocking blink against BlinkAlarm.
+ *
+ * @section description Description
+ * Replays one scripted minute on a virtual clock with 1 ms steps. A light sample arrives
+ * every 500 ms; its SMA is anomalous from 10 s to 40 s and for one sample at 50 s. Samples
+ * go into an ALARM_QUEUE_LEN deep queue, dropped when it is full, and the alarm task can
+ * only run outside the scripted stalls, when a higher priority task holds its core; one
+ * stall covers the anomalous sample at 50 s and the normal one after it.
+ * - blocking: the alarm task as it was. Every anomalous sample blinks the LED 4 times with
+ *   vTaskDelay (1.6 s) before the next is taken.
+ * - drain to newest: BlinkAlarm, with the task emptying the queue and checking only the
+ *   newest sample, as the first non-blocking version did.
+ * - BlinkAlarm: the alarm task now. It checks every sample it receives, in order, and the
+ *   LED blinks from BlinkAlarm edges while the task keeps checking.
+ * For each it reports the samples checked, dropped on a full queue and lost (received but
+ * never checked), the average and worst time from a sample being published to it being
+ * checked, whether the single anomalous sample raised the alarm, and how long the LED kept
+ * blinking after the sustained anomaly ended.
+ *
+ * Then one trigger is checked to give exactly ALARM_BLINKS blinks of the right length, and
+ * poll is timed. Exits non-zero if BlinkAlarm loses or drops a sample, checks one later than
+ * the longest stall, misses the single anomaly, keeps blinking past its pattern, or leaves a
+ * gap in the blinking during the sustained anomaly.
+ */
+#include <BlinkAlarm.h>
+#include "Bench.h"
+
+#include <algorithm>
+#include <deque>
+
+#define SCRIPT_MS 60000         ///< Length of the scripted run
+#define SAMPLE_MS 500           ///< As SAMPLE_PERIOD_MS in the sketch
+#define ALARM_QUEUE_LEN 8       ///< As the sketch
+#define ALARM_BLINKS 4          ///< As the sketch
+#define ALARM_HALF_PERIOD_MS 200 ///< As the sketch
+#define ANOMALY_FROM_MS 10000   ///< Sustained anomaly start
+#define ANOMALY_TO_MS 40000     ///< Sustained anomaly end (exclusive)
+#define BLIP_MS 50000           ///< A single anomalous sample
+
+/**
+ * @brief A stretch in which a higher priority task keeps the alarm task off its core.
+ */
+struct Stall {
+  uint32_t fromMs;
+  uint32_t toMs;  ///< Exclusive
+};
+
+static const Stall stalls[] = {
+  { 5200, 5900 },           // before the anomaly: two samples wait
+  { BLIP_MS - 200, 50900 }, // the anomalous sample and the normal one after it wait together
+};
+
+/**
+ * @brief What one alarm design made of the script.
+ */
+struct AlarmRun {
+  uint32_t checked = 0;
+  uint32_t dropped = 0;
+  uint32_t lost = 0;           ///< Received and discarded without a check
+  bool blipAlarmed = false;    ///< The single anomalous sample was checked and triggered the alarm
+  uint64_t latencySumMs = 0;
+  uint32_t latencyMaxMs = 0;
+  uint32_t lastLedOffMs = 0;   ///< When the LED last turned off after the sustained anomaly
+  uint32_t longestGapMs = 0;   ///< Longest LED-off stretch during the sustained anomaly, after the first blink
+};
+
+static bool anomalousAt(uint32_t ms) {
+  return (ms >= ANOMALY_FROM_MS && ms < ANOMALY_TO_MS) || ms == BLIP_MS;
+}
+
+static bool stalledAt(uint32_t ms) {
+  for (const Stall &stall : stalls) {
+    if (ms >= stall.fromMs && ms < stall.toMs) return true;
+  }
+  return false;
+}
+
+static uint32_t longestStallMs() {
+  uint32_t longest = 0;
+  for (const Stall &stall : stalls) longest = std::max(longest, stall.toMs - stall.fromMs);
+  return longest;
+}
+
+/**
+ * Name: publish
+ * @brief The light task's xQueueSend with no wait: the sample is dropped if the queue is full.
+ */
+static void publish(AlarmRun &run, std::deque<uint32_t> &queue, uint32_t now) {
+  if (now % SAMPLE_MS != 0 || now == 0) return;
+  if (queue.size() < ALARM_QUEUE_LEN) {
+    queue.push_back(now);
+  } else {
+    run.dropped++;
+  }
+}
+
+/**
+ * Name: check
+ * @brief Records one checked sample, published at t, checked at now.
+ * @retval true if it is anomalous.
+ */
+static bool check(AlarmRun &run, uint32_t t, uint32_t now) {
+  uint32_t latency = now - t;
+  run.checked++;
+  run.latencySumMs += latency;
+  run.latencyMaxMs = std::max(run.latencyMaxMs, latency);
+  if (t == BLIP_MS) run.blipAlarmed = true;
+  return anomalousAt(t);
+}
+
+/**
+ * Name: noteLed
+ * @brief Tracks LED-off gaps during the sustained anomaly and when the LED went quiet after it.
+ */
+static void noteLed(AlarmRun &run, uint32_t now, bool on, bool &wasOn, uint32_t &offSince, bool &started) {
+  if (on && !wasOn) {
+    if (started && now > ANOMALY_FROM_MS && now < ANOMALY_TO_MS) {
+      run.longestGapMs = std::max(run.longestGapMs, now - offSince);
+    }
+    started = started || now >= ANOMALY_FROM_MS;
+  }
+  if (!on && wasOn) {
+    offSince = now;
+    if (now >= ANOMALY_TO_MS && now < BLIP_MS) run.lastLedOffMs = now;
+  }
+  wasOn = on;
+}
+
+/**
+ * Name: runBlocking
+ * @brief The old task: FIFO queue, and each anomalous sample blocks the task for the blink.
+ */
+static AlarmRun runBlocking() {
+  AlarmRun run;
+  std::deque<uint32_t> queue;  // publish times
+  uint32_t busyUntil = 0;
+  uint32_t blinkStart = 0;
+  bool blinking = false, wasOn = false, started = false;
+  uint32_t offSince = 0;
+  for (uint32_t now = 0; now < SCRIPT_MS; now++) {
+    publish(run, queue, now);
+    if (now >= busyUntil) blinking = false;
+    if (now >= busyUntil && !queue.empty() && !stalledAt(now)) {
+      uint32_t t = queue.front();
+      queue.pop_front();
+      if (check(run, t, now)) {
+        blinking = true;
+        blinkStart = now;
+        busyUntil = now + 2 * ALARM_BLINKS * ALARM_HALF_PERIOD_MS;
+      }
+    }
+    bool on = blinking && ((now - blinkStart) / ALARM_HALF_PERIOD_MS) % 2 == 0;
+    noteLed(run, now, on, wasOn, offSince, started);
+  }
+  return run;
+}
+
+/**
+ * Name: runBlinkAlarm
+ * @brief The non-blocking task: whenever it can run it receives until the queue is empty,
+ *      then polls BlinkAlarm. Checks take no virtual time.
+ * @param drainToNewest check only the newest of the samples waiting, the rest being lost.
+ */
+static AlarmRun runBlinkAlarm(bool drainToNewest) {
+  AlarmRun run;
+  BlinkAlarm blink(ALARM_BLINKS, ALARM_HALF_PERIOD_MS * 1000);
+  std::deque<uint32_t> queue;  // publish times
+  bool wasOn = false, started = false, led = false;
+  uint32_t offSince = 0;
+  for (uint32_t now = 0; now < SCRIPT_MS; now++) {
+    uint32_t nowUs = now * 1000;
+    publish(run, queue, now);
+    if (!stalledAt(now)) {
+      while (!queue.empty()) {
+        uint32_t t = queue.front();
+        queue.pop_front();
+        if (drainToNewest) {
+          run.lost += (uint32_t)queue.size();
+          t = queue.empty() ? t : queue.back();
+          queue.clear();
+        }
+        if (check(run, t, now)) blink.trigger(nowUs);
+      }
+      if (blink.poll(nowUs)) led = blink.level();
+    }
+    noteLed(run, now, led, wasOn, offSince, started);
+  }
+  return run;
+}
+
+static void printRun(const char *name, const AlarmRun &run) {
+  printf("%-16s %8u %8u %6u %10.1f %10u %6s %14.1f\n", name, run.checked, run.dropped, run.lost,
+         run.checked ? (double)run.latencySumMs / run.checked : 0.0, run.latencyMaxMs,
+         run.blipAlarmed ? "yes" : "NO",
+         run.lastLedOffMs > ANOMALY_TO_MS ? (run.lastLedOffMs - ANOMALY_TO_MS) / 1000.0 : 0.0);
+}
+
+/**
+ * Name: checkPattern
+ * @brief One trigger gives ALARM_BLINKS on periods of ALARM_HALF_PERIOD_MS, then stays off.
+ */
+static bool checkPattern() {
+  BlinkAlarm blink(ALARM_BLINKS, ALARM_HALF_PERIOD_MS * 1000);
+  blink.trigger(0);
+  uint32_t onMs = 0, turnOns = 0;
+  bool led = false;
+  for (uint32_t now = 0; now < 5000; now++) {
+    if (blink.poll(now * 1000)) {
+      led = blink.level();
+      if (led) turnOns++;
+    }
+    if (led) onMs++;
+  }
+  bool ok = turnOns == ALARM_BLINKS && onMs == ALARM_BLINKS * ALARM_HALF_PERIOD_MS && !blink.active();
+  printf("single trigger: %u blinks, %u ms on %s\n", turnOns, onMs, ok ? "ok" : "WRONG");
+  return ok;
+}
+
+int main() {
+  AlarmRun blocking = runBlocking();
+  AlarmRun drained = runBlinkAlarm(true);
+  AlarmRun blinkAlarm = runBlinkAlarm(false);
+
+  printf("%-16s %8s %8s %6s %10s %10s %6s %14s\n", "alarm", "checked", "dropped", "lost", "avg ms", "worst ms",
+         "blip", "blinks on (s)");
+  printRun("blocking", blocking);
+  printRun("drain to newest", drained);
+  printRun("BlinkAlarm", blinkAlarm);
+  uint32_t samples = SCRIPT_MS / SAMPLE_MS - 1;
+  bool ok = blinkAlarm.checked == samples && blinkAlarm.dropped == 0 && blinkAlarm.lost == 0 &&
+            blinkAlarm.latencyMaxMs <= longestStallMs() && blinkAlarm.blipAlarmed &&
+            blinkAlarm.lastLedOffMs <= ANOMALY_TO_MS + 2 * ALARM_BLINKS * ALARM_HALF_PERIOD_MS &&
+            blinkAlarm.longestGapMs <= ALARM_HALF_PERIOD_MS;
+  if (!ok) printf("BlinkAlarm lost, dropped or delayed a sample, missed the single anomaly, or blinked wrongly\n");
+  ok = checkPattern() && ok;
+
+  printf("\n");
+  benchHeader();
+  static BlinkAlarm blink(ALARM_BLINKS, ALARM_HALF_PERIOD_MS * 1000);
+  double ns = benchNsPerOp([](size_t n) {
+    uint32_t changes = 0;
+    for (size_t i = 0; i < n; i++) {
+      if (i % 4096 == 0) blink.trigger((uint32_t)i * 100);
+      changes += blink.poll((uint32_t)i * 100);
+    }
+    benchKeep(changes);
+  }, 10000000);
+  benchRow("BlinkAlarm poll", ALARM_BLINKS, ns);
+  return ok ? 0 : 1;
+}
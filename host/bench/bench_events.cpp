@@ -0,0 +1,242 @@
+/**
+ * @file bench_events.cpp
+ * @brief EventQueue: lost events and reaction latency against the old flag loop, plus a
+ *      multi-producer stress test.
+ *
+ * @section description Description
+ * The first table replays one scripted minute of button presses (each with contact bounce)
+ * and BLE writes, some in bursts, on a virtual clock with a 1 ms loop pass:
+ * - flags: the old Kalisi_EE590_Lab4_BLE loop. An ISR sets a bool, and loop() shows the
+ *   message, delay(2000)s and clears the bool, so anything arriving in between is lost.
+ * - queue: the ISRs push into an EventQueue, loop() pops everything each pass and
+ *   debounces presses from their timestamps, as the sketch does now.
+ * For each it reports presses and messages handled out of those scripted, and the worst
+ * time from an event to the loop reacting to it.
+ *
+ * Then push plus pop is timed on one thread, and four producer threads push into a
+ * 32 event queue while one consumer pops, retrying when full. Every event must arrive
+ * exactly once and in order per producer. Exits non-zero if a check fails.
+ */
+#include <EventQueue.h>
+#include "Arduino.h"
+#include "Bench.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#define SCRIPT_S 60            ///< Length of the scripted run
+#define PASS_US 1000           ///< One loop() pass
+#define OVERLAY_US 2000000     ///< The old delay(2000), now the overlay length
+#define DEBOUNCE_US 50000      ///< As the sketch
+#define PRODUCERS 4            ///< Threads pushing in the stress test
+#define STRESS_EVENTS 1000000  ///< Events per producer
+
+enum : uint16_t { EVENT_BUTTON, EVENT_MESSAGE };
+
+/**
+ * @brief One ISR or callback firing in the script.
+ */
+struct ScriptEdge {
+  uint32_t timeUs;
+  uint16_t type;
+};
+
+/**
+ * @brief What the script contains, and what a loop made of it.
+ */
+struct EventCount {
+  size_t presses = 0;
+  size_t messages = 0;
+  uint32_t worstLatencyUs = 0;
+  uint32_t overflows = 0;
+};
+
+/**
+ * Name: buildScript
+ * @brief Presses every 1.5 s, a burst of three 300 ms apart every 10 s, and BLE writes
+ *      every 3.7 s with a burst of five 50 ms apart every 15 s. Each press bounces three
+ *      times within 4 ms.
+ * @param real receives the presses and messages scripted.
+ */
+static std::vector<ScriptEdge> buildScript(EventCount &real) {
+  std::vector<ScriptEdge> edges;
+  auto press = [&](uint32_t t) {
+    for (uint32_t bounce : {0u, 300u, 1100u, 3900u}) edges.push_back({t + bounce, EVENT_BUTTON});
+    real.presses++;
+  };
+  auto message = [&](uint32_t t) {
+    edges.push_back({t, EVENT_MESSAGE});
+    real.messages++;
+  };
+  for (uint32_t t = 500000; t < SCRIPT_S * 1000000u; t += 1500000) press(t);
+  for (uint32_t t = 5300000; t < SCRIPT_S * 1000000u; t += 10000000) {
+    for (int k = 0; k < 3; k++) press(t + k * 300000);
+  }
+  for (uint32_t t = 900000; t < SCRIPT_S * 1000000u; t += 3700000) message(t);
+  for (uint32_t t = 7700000; t < SCRIPT_S * 1000000u; t += 15000000) {
+    for (int k = 0; k < 5; k++) message(t + k * 50000);
+  }
+  std::stable_sort(edges.begin(), edges.end(),
+                   [](const ScriptEdge &a, const ScriptEdge &b) { return a.timeUs < b.timeUs; });
+  return edges;
+}
+
+/**
+ * Name: runFlags
+ * @brief The old loop: a flag per source, handled with a blocking delay, cleared afterwards.
+ */
+static EventCount runFlags(const std::vector<ScriptEdge> &edges) {
+  EventCount got;
+  size_t next = 0;
+  bool flag[2] = {false, false};
+  uint32_t firstUs[2] = {0, 0};  // oldest edge behind a set flag, for the latency
+  uint32_t now = 0;
+  auto arrive = [&](uint32_t until) {
+    for (; next < edges.size() && edges[next].timeUs < until; next++) {
+      uint16_t type = edges[next].type;
+      if (!flag[type]) firstUs[type] = edges[next].timeUs;
+      flag[type] = true;
+    }
+  };
+  while (now < SCRIPT_S * 1000000u + OVERLAY_US) {
+    arrive(now);
+    for (uint16_t type : {EVENT_BUTTON, EVENT_MESSAGE}) {
+      if (!flag[type]) continue;
+      (type == EVENT_BUTTON ? got.presses : got.messages)++;
+      got.worstLatencyUs = std::max(got.worstLatencyUs, now - firstUs[type]);
+      now += OVERLAY_US;  // delay(2000)
+      arrive(now);
+      flag[type] = false;  // whatever came in meanwhile is gone
+    }
+    now += PASS_US;
+  }
+  return got;
+}
+
+/**
+ * Name: runQueue
+ * @brief The new loop: ISRs push, every pass pops everything and debounces from timestamps.
+ */
+static EventCount runQueue(const std::vector<ScriptEdge> &edges) {
+  static EventQueue<32> events;
+  EventCount got;
+  size_t next = 0;
+  uint32_t lastEdgeUs = 0;
+  bool edgeSeen = false;
+  for (uint32_t now = 0; now < SCRIPT_S * 1000000u + OVERLAY_US; now += PASS_US) {
+    for (; next < edges.size() && edges[next].timeUs < now; next++) {
+      events.push(edges[next].type, edges[next].timeUs);
+    }
+    Event e = {};
+    while (events.pop(e)) {
+      if (e.type == EVENT_BUTTON) {
+        bool bounce = edgeSeen && e.timeUs - lastEdgeUs < DEBOUNCE_US;
+        lastEdgeUs = e.timeUs;
+        edgeSeen = true;
+        if (bounce) continue;
+        got.presses++;
+      } else {
+        got.messages++;
+      }
+      got.worstLatencyUs = std::max(got.worstLatencyUs, now - e.timeUs);
+    }
+  }
+  got.overflows = events.overflows();
+  return got;
+}
+
+static void printCount(const char *name, const EventCount &got, const EventCount &real) {
+  printf("%-24s %6zu/%-6zu %6zu/%-6zu %12.1f %9u\n", name, got.presses, real.presses, got.messages,
+         real.messages, got.worstLatencyUs / 1000.0, got.overflows);
+}
+
+/**
+ * Name: benchPushPop
+ * @brief Host time for one push and one pop on a single thread.
+ */
+static void benchPushPop() {
+  static EventQueue<32> events;
+  double ns = benchNsPerOp([&](size_t n) {
+    Event e = {};
+    uint32_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+      events.push(EVENT_BUTTON, (uint32_t)i, (uint32_t)i);
+      events.pop(e);
+      sum += e.payload;
+    }
+    benchKeep(sum);
+  }, 10000000);
+  benchRow("EventQueue push + pop", 32, ns);
+}
+
+/**
+ * Name: stress
+ * @brief PRODUCERS threads push STRESS_EVENTS each, retrying when full, while one thread pops.
+ * @retval true if every event arrived once and in order per producer.
+ */
+static bool stress() {
+  static EventQueue<32> events;
+  size_t retries[PRODUCERS] = {};
+  std::vector<std::thread> producers;
+  double start = benchNowSeconds();
+  for (int p = 0; p < PRODUCERS; p++) {
+    producers.emplace_back([p, &retries] {
+      for (uint32_t i = 0; i < STRESS_EVENTS; i++) {
+        while (!events.push((uint16_t)p, i, i)) {
+          retries[p]++;
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  uint32_t expect[PRODUCERS] = {};
+  size_t received = 0;
+  size_t errors = 0;
+  while (received < (size_t)PRODUCERS * STRESS_EVENTS) {
+    Event e = {};
+    if (!events.pop(e)) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (e.type >= PRODUCERS || e.payload != expect[e.type] || e.timeUs != e.payload) {
+      errors++;
+    } else {
+      expect[e.type]++;
+    }
+    received++;
+  }
+  for (std::thread &t : producers) t.join();
+  double elapsed = benchNowSeconds() - start;
+
+  size_t full = 0;
+  for (int p = 0; p < PRODUCERS; p++) full += retries[p];
+  Event e;
+  bool ok = errors == 0 && !events.pop(e) && full == events.overflows();
+  printf("stress: %d producers x %d events in %.3f s, %zu full retries, %zu out of order or lost %s\n", PRODUCERS,
+         STRESS_EVENTS, elapsed, full, errors, ok ? "ok" : "WRONG");
+  return ok;
+}
+
+int main() {
+  EventCount real;
+  std::vector<ScriptEdge> edges = buildScript(real);
+  EventCount flags = runFlags(edges);
+  EventCount queue = runQueue(edges);
+
+  printf("%-24s %13s %13s %12s %9s\n", "scripted minute", "presses", "messages", "worst ms", "overflow");
+  printCount("flags + delay(2000)", flags, real);
+  printCount("EventQueue", queue, real);
+  bool ok = queue.presses == real.presses && queue.messages == real.messages && queue.overflows == 0 &&
+            queue.worstLatencyUs <= PASS_US;
+  if (!ok) printf("EventQueue lost events or reacted late\n");
+
+  printf("\n");
+  benchHeader();
+  benchPushPop();
+
+  printf("\n");
+  ok = stress() && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,1046 @@
+/**
+ * @file bench_lab3.cpp
+ * @brief Microbenchmarks for the Lab 3 library on the host HAL.
+ *
+ * @section description Description
+ * Covers the circular buffer, RingBuffer bulk operations and resizing, dynamic array, mem_copy, str_to_int, reverseString,
+ * array_modify against the fused and parallel transforms, BitSet parsing and operations,
+ * fibonacci/factorial, the Special590functions print path, and one simulated
+ * simulateSensorData run driven by the virtual clock and a scripted LDR.
+ *
+ * The allocation checks replay the library calls of the sketch's background job on the
+ * heap and on an AllocPool, and fail the benchmark (non-zero exit) if a run leaks, if the
+ * number of allocator calls per run changes, if the pool keeps carving after the first
+ * run, or if the simulateSensorData loop allocates at all. Their timings alternate heap and
+ * pool for ALLOC_ROUNDS rounds and report the best of each along with the rounds the pool
+ * won. A labAlloc + labFree pair is consistently faster on the pool; a whole job run is
+ * dominated by its copying and printing, and the two allocators differ by no more than
+ * the spread between invocations.
+ *
+ * The Fibonacci/factorial checks also fail the benchmark: F(300) and 50! must print as
+ * their known decimal values, every BigUInt F(n) up to F(2951) must be the sum of the two
+ * before it and every n! up to 300! must be n times the one before, the 64 bit tables must
+ * agree with the BigUInt results, and overflow must be reported from F(2952), 301!, F(94)
+ * and 21! on.
+ *
+ * So do the differential checks: str_to_int against strtoll on random valid and invalid
+ * strings, reverseString against std::reverse at every alignment, and mem_copy against
+ * memcpy at every source and destination offset, with guard bytes around the destination.
+ * bitsetAnd and bitsetCount are checked against the per-character AND and count on random
+ * strings of every width up to DIFF_MAX_LEN and a few wide ones, bit by bit and as printed.
+ * transformArrayParallel is run with CHECK_WORKERS pool threads, whatever the core count,
+ * and must give the serial transformArray result on lengths around every chunk boundary.
+ * A DynamicArray whose initArray failed, and one after freeArray, must take elements.
+ */
+#include "590Lab3.h"
+#include "Alloc590.h"
+#include "ArrayTransform.h"
+#include "Special590functions.h"
+#include "Trace590.h"
+#include "Arduino.h"
+#include "soc/timer_group_reg.h"
+#include "Bench.h"
+
+#include <algorithm>
+#include <climits>
+#include <iterator>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#define LEDR 10 ///< LDR pin read by simulateSensorData
+#define CHURN_RUNS 100 ///< Background job runs replayed per allocator
+#define CHURN_ARENA 1024 ///< Pool arena, as ALLOC_ARENA_SIZE in the sketch
+#define ALLOC_ROUNDS 9 ///< Interleaved heap/pool timing rounds; the best of each is reported
+#define BIG_FIB_MAX 2951 ///< Largest Fibonacci index that fits a BigUInt
+#define BIG_FACT_MAX 300 ///< Largest factorial that fits a BigUInt
+#define DIFF_STRINGS 200000 ///< Random strings given to str_to_int and strtoll
+#define DIFF_MAX_LEN 300 ///< Longest string reversed and block copied in the differential checks
+#define DIFF_OFFSETS 16 ///< Source and destination offsets tried by the mem_copy check
+#define BITSET_TRIALS 8 ///< Random string pairs per width in the BitSet check
+#define ARRAY_REFILL 9 ///< Elements added to an array left without data
+#define CHECK_WORKERS 3 ///< Pool threads forced for the parallel transform check
+
+static const char *const FIB_300 = "222232244629420445529739893461909967206666939096499764990979600";
+static const char *const FACT_50 = "30414093201713378043612608166064768844377641568960512000000000000";
+
+/**
+ * Name: benchCircularBuffer
+ * @brief writeBuffer then popBuffer of one element, buffer size 5.
+ */
+static void benchCircularBuffer() {
+  CircularBuffer cb;
+  initBuffer(&cb, BUFFER_SIZE);
+  double ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      writeBuffer(&cb, (int)i);
+      benchKeep(popBuffer(&cb));
+    }
+    while (tracePending() > 0) traceDrain(64);
+  }, 200000);
+  benchRow("CircularBuffer write+pop (+trace drain)", BUFFER_SIZE, ns);
+  freeBuffer(&cb);
+}
+
+/**
+ * Name: benchRingBulk
+ * @brief Moving 1024 ints through a ring of 64 one element at a time against push_n/pop_n.
+ */
+static void benchRingBulk() {
+  const size_t total = 1024;
+  const size_t chunk = 48;
+  int src[total];
+  int dst[total];
+  for (size_t i = 0; i < total; i++) src[i] = (int)i;
+
+  CircularBuffer cb;
+  initBuffer(&cb, 64);
+  double ns = benchNsPerOp([&](size_t n) {
+    for (size_t r = 0; r < n / total; r++) {
+      for (size_t done = 0; done < total; done += chunk) {
+        size_t count = (total - done < chunk) ? total - done : chunk;
+        for (size_t i = 0; i < count; i++) writeBuffer(&cb, src[done + i]);
+        for (size_t i = 0; i < count; i++) dst[done + i] = popBuffer(&cb);
+      }
+      benchKeep(dst[total - 1]);
+      while (tracePending() > 0) traceDrain(64);
+    }
+  }, 200 * total);
+  benchRow("CircularBuffer per element", chunk, ns);
+  freeBuffer(&cb);
+
+  RingBuffer<int, 64> ring;
+  ns = benchNsPerOp([&](size_t n) {
+    for (size_t r = 0; r < n / total; r++) {
+      for (size_t done = 0; done < total; done += chunk) {
+        size_t count = (total - done < chunk) ? total - done : chunk;
+        ring.push_n(src + done, count);
+        ring.pop_n(dst + done, count);
+      }
+      benchKeep(dst[total - 1]);
+    }
+  }, 200 * total);
+  benchRow("RingBuffer<int, 64> push_n/pop_n", chunk, ns);
+}
+
+/**
+ * Name: benchResize
+ * @brief Growing a wrapped, half full buffer from size to 2 * size and back.
+ */
+static void benchResize(size_t size) {
+  std::vector<int> fill(size / 2, 7);
+  double ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      CircularBuffer cb;
+      initBuffer(&cb, size);
+      cb.head = cb.tail = size - size / 4;  // contents wrap around the end
+      for (size_t k = 0; k < size / 2; k++) writeBuffer(&cb, fill[k]);
+      resizeBuffer(&cb, size * 2);
+      resizeBuffer(&cb, size);
+      benchKeep(cb.buffer[0]);
+      freeBuffer(&cb);
+      while (tracePending() > 0) traceDrain(64);
+    }
+  }, 2000);
+  benchRow("resizeBuffer grow+shrink (incl. fill)", (long)size, ns);
+
+  ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      DynamicRingBuffer<int> ring;
+      ring.resize(size);
+      for (size_t k = 0; k < size - size / 4; k++) ring.push(0);
+      ring.consume(size - size / 4);  // contents wrap around the end
+      ring.push_n(fill.data(), fill.size());
+      ring.resize(size * 2);
+      ring.resize(size);
+      benchKeep(ring.size());
+    }
+  }, 2000);
+  benchRow("DynamicRingBuffer grow+shrink (incl. fill)", (long)size, ns);
+}
+
+/**
+ * Name: benchDynamicArray
+ * @brief addElement from an empty array of capacity 2 up to count elements.
+ */
+static void benchDynamicArray(int count) {
+  double ns = benchNsPerOp([&](size_t n) {
+    for (size_t r = 0; r < n / count; r++) {
+      DynamicArray arr;
+      initArray(&arr, 2);
+      for (int i = 0; i < count; i++) addElement(&arr, i);
+      benchKeep(arr.data[count - 1]);
+      freeArray(&arr);
+      while (tracePending() > 0) traceDrain(64);
+    }
+  }, 100000);
+  benchRow("DynamicArray addElement", count, ns);
+}
+
+/**
+ * Name: benchBoundedArray
+ * @brief addElement on static storage with a retention policy, the way the sketch uses it.
+ */
+static void benchBoundedArray() {
+  int storage[32];
+  ArraySummary summaries[16];
+  ArrayHistory history;
+  DynamicArray bounded;
+  initArrayStatic(&bounded, storage, 32);
+  setArrayRetention(&bounded, &history, summaries, 16, 8);
+  double ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      addElement(&bounded, (int)i);
+      if ((i & 63) == 0) while (tracePending() > 0) traceDrain(64);
+    }
+    benchKeep(bounded.data[0]);
+  }, 100000);
+  benchRow("DynamicArray addElement (bounded, static)", 32, ns);
+}
+
+// =========== Byte-at-a-time references ===========
+// The Lab 3 versions before the word kernels, kept here as the baseline rows.
+
+/**
+ * Name: byteMemCopy
+ * @brief mem_copy one byte per iteration.
+ */
+static void __attribute__((noinline)) byteMemCopy(void *dest, const void *src, size_t n) {
+  char *d = (char *)dest;
+  const char *s = (const char *)src;
+  for (size_t i = 0; i < n; i++) {
+    d[i] = s[i];
+    __asm__ volatile("" ::: "memory");  // keep the compiler from turning it back into memcpy
+  }
+}
+
+/**
+ * Name: byteReverse
+ * @brief reverseString swapping one char per iteration.
+ */
+static void __attribute__((noinline)) byteReverse(char *str) {
+  char *beg = str;
+  char *end = str + strlen(str) - 1;
+  while (beg < end) {
+    char temp = *beg;
+    *beg++ = *end;
+    *end-- = temp;
+  }
+}
+
+/**
+ * Name: strlenStrToInt
+ * @brief str_to_int calling strlen every iteration, without range checks.
+ */
+static int __attribute__((noinline)) strlenStrToInt(const char *str) {
+  bool isNeg = str[0] == '-';
+  int currNum = 0;
+  for (int i = isNeg ? 1 : 0; i < (int)strlen(str); i++) {
+    if (str[i] < 48 || str[i] > 58) return -1;
+    currNum = currNum * 10 + (str[i] - 48);
+  }
+  return isNeg ? -currNum : currNum;
+}
+
+/**
+ * Name: benchMemCopy
+ * @brief mem_copy against the byte loop and libc memcpy for one size; dest aligned,
+ *      src aligned or offset by one byte.
+ */
+static void benchMemCopy(size_t size, size_t srcOffset) {
+  std::vector<char> srcBuf(size + 1, 'x');
+  std::vector<char> dst(size);
+  const char *src = srcBuf.data() + srcOffset;
+  size_t iters = 20000000 / (size + 16);
+  const char *suffix = srcOffset ? " (src+1)" : "";
+  char name[48];
+
+  double ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      mem_copy(dst.data(), src, size);
+      benchKeep(dst[size - 1]);
+    }
+  }, iters);
+  snprintf(name, sizeof(name), "mem_copy%s", suffix);
+  benchRow(name, size, ns);
+
+  ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      byteMemCopy(dst.data(), src, size);
+      benchKeep(dst[size - 1]);
+    }
+  }, iters);
+  snprintf(name, sizeof(name), "mem_copy byte loop%s", suffix);
+  benchRow(name, size, ns);
+
+  ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      memcpy(dst.data(), src, size);
+      benchKeep(dst[size - 1]);
+    }
+  }, iters);
+  snprintf(name, sizeof(name), "memcpy (libc)%s", suffix);
+  benchRow(name, size, ns);
+}
+
+/**
+ * Name: benchStrToInt
+ * @brief str_to_int against the strlen-per-digit loop and libc strtol on one input
+ *      string; param is its length.
+ */
+static void benchStrToInt(const char *str) {
+  double ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) benchKeep(str_to_int(str));
+  }, 1000000);
+  benchRow("str_to_int", (long)strlen(str), ns);
+
+  ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) benchKeep(strlenStrToInt(str));
+  }, 1000000);
+  benchRow("str_to_int strlen loop", (long)strlen(str), ns);
+
+  ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) benchKeep(strtol(str, NULL, 10));
+  }, 1000000);
+  benchRow("strtol (libc)", (long)strlen(str), ns);
+}
+
+/**
+ * Name: benchReverse
+ * @brief reverseString on a string of length len.
+ */
+static void benchReverse(size_t len) {
+  std::vector<char> str(len + 1, 'a');
+  str[len] = '\0';
+  for (size_t i = 0; i < len; i++) str[i] = 'a' + (i % 26);
+  double ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      reverseString(str.data());
+      benchKeep(str[0]);
+    }
+  }, 20000000 / (len + 16));
+  benchRow("reverseString", (long)len, ns);
+
+  ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      byteReverse(str.data());
+      benchKeep(str[0]);
+    }
+  }, 20000000 / (len + 16));
+  benchRow("reverseString byte swap", (long)len, ns);
+
+  ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      char *p = str.data();
+      std::reverse(p, p + strlen(p));
+      benchKeep(str[0]);
+    }
+  }, 20000000 / (len + 16));
+  benchRow("std::reverse + strlen", (long)len, ns);
+}
+
+static int __attribute__((noinline)) benchTriple(int x) { return 3 * x; }
+static int __attribute__((noinline)) benchAddOne(int x) { return x + 1; }
+static int __attribute__((noinline)) benchMinusTen(int x) { return x - 10; }
+
+/**
+ * Name: benchTransform
+ * @brief x * 3 + 1 - 10 over len ints: three array_modify passes through function
+ *      pointers, one fused transformArray pass, and the fused pass split by
+ *      transformArrayParallel.
+ */
+static void benchTransform(size_t len) {
+  std::vector<int> data(len, 1);
+  size_t iters = 50000000 / (len + 16);
+  auto fused = makePipeline([](int x) { return 3 * x; },
+                            [](int x) { return x + 1; },
+                            [](int x) { return x - 10; });
+
+  double ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      array_modify(data.data(), len, benchTriple);
+      array_modify(data.data(), len, benchAddOne);
+      array_modify(data.data(), len, benchMinusTen);
+      benchKeep(data[len - 1]);
+    }
+  }, iters);
+  benchRow("array_modify x3 passes", (long)len, ns);
+
+  ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      transformArray(data.data(), len, fused);
+      benchKeep(data[len - 1]);
+    }
+  }, iters);
+  benchRow("transformArray fused", (long)len, ns);
+
+  ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      transformArrayParallel(data.data(), len, fused);
+      benchKeep(data[len - 1]);
+    }
+  }, iters);
+  char name[48];
+  snprintf(name, sizeof(name), "transformArrayParallel (%d workers)", transformWorkers());
+  benchRow(name, (long)len, ns);
+}
+
+/**
+ * Name: benchBitset
+ * @brief Two binary strings of width bits: parse into BitSets, then AND and count the
+ *      result, against the same AND and count done one character at a time.
+ */
+static void benchBitset(size_t bits) {
+  std::string a(bits, '0'), b(bits, '0');
+  for (size_t i = 0; i < bits; i++) {
+    a[i] = "01"[(i * 7 + 3) % 5 < 2];
+    b[i] = "01"[(i * 11 + 1) % 3 == 0];
+  }
+  size_t iters = 20000000 / (bits + 16);
+
+  double ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      BitSet set;
+      bitsetFromString(&set, a.c_str(), 0);
+      benchKeep(set.words[0]);
+      freeBitSet(&set);
+    }
+  }, iters);
+  benchRow("bitsetFromString", (long)bits, ns);
+
+  BitSet setA, setB, result;
+  bitsetFromString(&setA, a.c_str(), 0);
+  bitsetFromString(&setB, b.c_str(), 0);
+  initBitSet(&result, bits);
+  ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      bitsetAnd(&result, &setA, &setB);
+      benchKeep(bitsetCount(&result));
+    }
+  }, iters * 8);
+  benchRow("bitsetAnd + bitsetCount", (long)bits, ns);
+  freeBitSet(&setA);
+  freeBitSet(&setB);
+  freeBitSet(&result);
+
+  ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      size_t ones = 0;
+      for (size_t k = 0; k < bits; k++) ones += (a[k] - '0') & (b[k] - '0');
+      benchKeep(ones);
+    }
+  }, iters);
+  benchRow("per-character AND + count", (long)bits, ns);
+}
+
+/**
+ * Name: benchFibFact
+ * @brief fibonacci of length N (including the free), factorial(n), table lookups and BigUInt terms.
+ */
+static void benchFibFact() {
+  static const int fibSizes[] = {10, 90};
+  for (int size : fibSizes) {
+    double ns = benchNsPerOp([&](size_t n) {
+      for (size_t i = 0; i < n; i++) {
+        unsigned long long *seq;
+        fibonacci(size, &seq);
+        benchKeep(seq[size - 1]);
+        freeFibonacci(seq, size);
+      }
+    }, 500000);
+    benchRow("fibonacci sequence", size, ns);
+  }
+
+  static const int factValues[] = {10, 20};
+  for (int value : factValues) {
+    double ns = benchNsPerOp([&](size_t n) {
+      for (size_t i = 0; i < n; i++) {
+        unsigned long long result;
+        factorial(value, &result);
+        benchKeep(result);
+      }
+    }, 1000000);
+    benchRow("factorial", value, ns);
+  }
+
+  for (int size : fibSizes) {
+    double ns = benchNsPerOp([&](size_t n) {
+      for (size_t i = 0; i < n; i++) {
+        unsigned long long term;
+        fibonacciTerm((int)(i % size), &term);
+        benchKeep(term);
+      }
+    }, 10000000);
+    benchRow("fibonacciTerm", size, ns);
+  }
+
+  static const int bigFibValues[] = {300, 2000};
+  for (int value : bigFibValues) {
+    double ns = benchNsPerOp([&](size_t n) {
+      for (size_t i = 0; i < n; i++) {
+        BigUInt big;
+        bigintFibonacci(value, &big);
+        benchKeep(big.limb[0]);
+      }
+    }, 20000);
+    benchRow("bigintFibonacci", value, ns);
+  }
+
+  static const int bigFactValues[] = {50, 300};
+  for (int value : bigFactValues) {
+    double ns = benchNsPerOp([&](size_t n) {
+      for (size_t i = 0; i < n; i++) {
+        BigUInt big;
+        bigintFactorial(value, &big);
+        benchKeep(big.limb[0]);
+      }
+    }, 20000);
+    benchRow("bigintFactorial", value, ns);
+  }
+}
+
+/**
+ * Name: bigDecimal
+ * @brief x as printBigUInt prints it.
+ */
+static std::string bigDecimal(const BigUInt *x) {
+  printFlush();
+  Serial.captured.clear();
+  Serial.capture = true;
+  printBigUInt(x);
+  printFlush();
+  Serial.capture = false;
+  return Serial.captured;
+}
+
+/**
+ * Name: bigEqual
+ * @brief a == b + c * m, limb by limb, with c * m formed in 64 bits per limb.
+ */
+static bool bigEqual(const BigUInt &a, const BigUInt &b, const BigUInt &c, uint32_t m) {
+  uint64_t carry = 0;
+  int limbs = std::max(std::max(a.used, b.used), c.used + 1);
+  for (int i = 0; i < limbs && i < BIGINT_LIMBS; i++) {
+    uint64_t sum = carry;
+    if (i < b.used) sum += b.limb[i];
+    if (i < c.used) sum += (uint64_t)c.limb[i] * m;
+    uint32_t ai = (i < a.used) ? a.limb[i] : 0;
+    if ((uint32_t)sum != ai) return false;
+    carry = sum >> 32;
+  }
+  return carry == 0;
+}
+
+/**
+ * Name: bigLow64
+ * @brief The low 64 bits of x, and whether x fits in them.
+ */
+static bool bigLow64(const BigUInt &x, unsigned long long *value) {
+  *value = (x.used > 0 ? x.limb[0] : 0) | ((unsigned long long)(x.used > 1 ? x.limb[1] : 0) << 32);
+  return x.used <= 2;
+}
+
+/**
+ * Name: checkFibFact
+ * @brief Known values, recurrences and overflow boundaries of the table and BigUInt paths.
+ * @retval true if all of them hold.
+ */
+static bool checkFibFact() {
+  bool ok = true;
+  BigUInt big, prev1, prev2;
+  BigUInt zero;
+  zero.used = 0;
+
+  bigintFibonacci(300, &big);
+  std::string f300 = bigDecimal(&big);
+  bigintFactorial(50, &big);
+  std::string f50 = bigDecimal(&big);
+  if (f300 != FIB_300 || f50 != FACT_50) {
+    printf("F(300) = %s\n50! = %s\n", f300.c_str(), f50.c_str());
+    ok = false;
+  }
+
+  // F(n) = F(n - 1) + F(n - 2), and the 64 bit table below F(94)
+  int bad = 0;
+  bigintFibonacci(0, &prev2);
+  bigintFibonacci(1, &prev1);
+  for (int n = 2; n <= BIG_FIB_MAX; n++) {
+    if (!bigintFibonacci(n, &big) || !bigEqual(big, prev1, prev2, 1)) bad++;
+    unsigned long long term, low;
+    bool fits = bigLow64(big, &low);
+    if (fibonacciTerm(n, &term) != fits || (fits && term != low)) bad++;
+    prev2 = prev1;
+    prev1 = big;
+  }
+  // n! = (n - 1)! * n, and the 64 bit table below 21!
+  bigintFactorial(0, &prev1);
+  for (int n = 1; n <= BIG_FACT_MAX; n++) {
+    if (!bigintFactorial(n, &big) || !bigEqual(big, zero, prev1, (uint32_t)n)) bad++;
+    unsigned long long result, low;
+    bool fits = bigLow64(big, &low);
+    if ((factorial(n, &result) == MATH_OK) != fits || (fits && result != low)) bad++;
+    prev1 = big;
+  }
+  unsigned long long unused;
+  bool boundaries = !bigintFibonacci(BIG_FIB_MAX + 1, &big) && !bigintFactorial(BIG_FACT_MAX + 1, &big) &&
+                    !fibonacciTerm(FIB_TABLE_SIZE, &unused) && factorial(FACT_TABLE_SIZE, &unused) == MATH_OVERFLOW;
+  printf("F(300), 50!: %s; F(2..%d), 1!..%d!: %d wrong; overflow boundaries %s\n", ok ? "ok" : "WRONG",
+         BIG_FIB_MAX, BIG_FACT_MAX, bad, boundaries ? "ok" : "WRONG");
+  return ok && bad == 0 && boundaries;
+}
+
+/**
+ * Name: refStrToInt
+ * @brief What str_to_int must return, from strtoll: an optional '-' then only digits, in
+ *      the int range, or -1.
+ */
+static int refStrToInt(const std::string &str) {
+  size_t start = (!str.empty() && str[0] == '-') ? 1 : 0;
+  if (start == str.size()) return -1;
+  for (size_t i = start; i < str.size(); i++) {
+    if (str[i] < '0' || str[i] > '9') return -1;
+  }
+  size_t first = str.find_first_not_of('0', start);  // strtoll saturates, so drop the leading zeros first
+  if (first == std::string::npos) return 0;
+  if (str.size() - first > 12) return -1;
+  long long value = strtoll(str.c_str(), NULL, 10);
+  return (value < INT_MIN || value > INT_MAX) ? -1 : (int)value;
+}
+
+/**
+ * Name: randomNumberString
+ * @brief A random string for str_to_int: mostly valid numbers, many near the int limits or
+ *      with leading zeros, some with a stray character.
+ */
+static std::string randomNumberString(uint32_t &seed) {
+  static const char stray[] = " +-/:a.\t";
+  std::string str;
+  uint32_t kind = rand_r(&seed) % 4;
+  if (kind == 0) {
+    long long edge = (rand_r(&seed) % 2) ? INT_MAX : INT_MIN;
+    str = std::to_string(edge + (long long)(rand_r(&seed) % 21) - 10);
+  } else {
+    if (rand_r(&seed) % 3 == 0) str.push_back('-');
+    if (rand_r(&seed) % 4 == 0) str.append(rand_r(&seed) % 12, '0');
+    size_t digits = rand_r(&seed) % 14;
+    for (size_t i = 0; i < digits; i++) str.push_back((char)('0' + rand_r(&seed) % 10));
+  }
+  if (rand_r(&seed) % 8 == 0 && !str.empty()) {
+    str[rand_r(&seed) % str.size()] = stray[rand_r(&seed) % (sizeof(stray) - 1)];
+  }
+  return str;
+}
+
+/**
+ * Name: checkAgainstLibc
+ * @brief str_to_int, reverseString and mem_copy against strtoll, std::reverse and memcpy.
+ * @retval true if every case matched.
+ */
+static bool checkAgainstLibc() {
+  uint32_t seed = 4745;
+  int badInt = 0;
+  for (int i = 0; i < DIFF_STRINGS; i++) {
+    std::string str = randomNumberString(seed);
+    int got = str_to_int(str.c_str());
+    int expected = refStrToInt(str);
+    if (got != expected && badInt++ == 0) printf("str_to_int(\"%s\") = %d, expected %d\n", str.c_str(), got, expected);
+  }
+
+  // every length at every alignment of the string start
+  int badReverse = 0;
+  std::vector<char> buf(DIFF_MAX_LEN + 16);
+  for (size_t len = 0; len <= DIFF_MAX_LEN; len++) {
+    for (size_t offset = 0; offset < 8; offset++) {
+      std::string expected;
+      for (size_t i = 0; i < len; i++) expected.push_back((char)(1 + rand_r(&seed) % 255));
+      char *str = buf.data() + offset;
+      memcpy(str, expected.c_str(), len + 1);
+      std::reverse(expected.begin(), expected.end());
+      reverseString(str);
+      if (memcmp(str, expected.c_str(), len + 1) != 0 && badReverse++ == 0) {
+        printf("reverseString differs from std::reverse at length %zu, offset %zu\n", len, offset);
+      }
+    }
+  }
+
+  // every size at every source and destination offset; the guard bytes must survive
+  int badCopy = 0;
+  std::vector<unsigned char> src(DIFF_MAX_LEN + DIFF_OFFSETS), dst(DIFF_MAX_LEN + 2 * DIFF_OFFSETS + 16);
+  std::vector<unsigned char> expected(dst.size());
+  for (size_t i = 0; i < src.size(); i++) src[i] = (unsigned char)rand_r(&seed);
+  for (size_t size = 0; size <= DIFF_MAX_LEN; size++) {
+    for (size_t s = 0; s < DIFF_OFFSETS; s++) {
+      for (size_t d = 0; d < DIFF_OFFSETS; d++) {
+        std::fill(dst.begin(), dst.end(), 0xA5);
+        std::fill(expected.begin(), expected.end(), 0xA5);
+        mem_copy(dst.data() + 8 + d, src.data() + s, size);
+        memcpy(expected.data() + 8 + d, src.data() + s, size);
+        if (dst != expected && badCopy++ == 0) {
+          printf("mem_copy differs from memcpy: %zu bytes, src offset %zu, dest offset %zu\n", size, s, d);
+        }
+      }
+    }
+  }
+
+  printf("str_to_int: %d random strings, %d differ from strtoll; reverseString: %d differ from std::reverse; "
+         "mem_copy: %d differ from memcpy\n", DIFF_STRINGS, badInt, badReverse, badCopy);
+  return badInt == 0 && badReverse == 0 && badCopy == 0;
+}
+
+/**
+ * Name: bitsetString
+ * @brief set as printBitSet prints it.
+ */
+static std::string bitsetString(const BitSet *set) {
+  printFlush();
+  Serial.captured.clear();
+  Serial.capture = true;
+  printBitSet(set);
+  printFlush();
+  Serial.capture = false;
+  return Serial.captured;
+}
+
+/**
+ * Name: checkBitset
+ * @brief bitsetFromString, bitsetAnd and bitsetCount against the per-character AND and
+ *      count of the benchmark, on random strings of random density.
+ * @details Each result is compared bit by bit with bitsetTest, printed with printBitSet and
+ *      counted, so a wrong word, a stray bit past the width or a wrong count all show up.
+ * @retval true if every pair matched.
+ */
+static bool checkBitset() {
+  static const size_t wide[] = { 511, 512, 513, 4099, 100003 };
+  std::vector<size_t> widths;
+  for (size_t bits = 1; bits <= DIFF_MAX_LEN; bits++) widths.push_back(bits);
+  widths.insert(widths.end(), std::begin(wide), std::end(wide));
+
+  uint32_t seed = 1100;
+  int pairs = 0, bad = 0;
+  for (size_t bits : widths) {
+    for (int trial = 0; trial < BITSET_TRIALS; trial++) {
+      int density = rand_r(&seed) % 101;  // percent of '1's, 0 and 100 included
+      std::string a(bits, '0'), b(bits, '0'), both(bits, '0');
+      size_t ones = 0;
+      for (size_t k = 0; k < bits; k++) {
+        a[k] = "01"[rand_r(&seed) % 100 < density];
+        b[k] = "01"[rand_r(&seed) % 100 < density];
+        both[k] = (char)('0' + ((a[k] - '0') & (b[k] - '0')));
+        ones += both[k] - '0';
+      }
+
+      BitSet setA, setB, result;
+      bool right = bitsetFromString(&setA, a.c_str(), 0) && bitsetFromString(&setB, b.c_str(), 0) &&
+                   initBitSet(&result, bits) && bitsetAnd(&result, &setA, &setB);
+      right = right && bitsetCount(&result) == ones && bitsetString(&result) == both;
+      for (size_t k = 0; right && k < bits; k++) right = bitsetTest(&result, k) == (both[bits - 1 - k] == '1');
+      if (!right && bad++ == 0) printf("bitsetAnd + bitsetCount differ from the per-character loop: %zu bits\n", bits);
+      pairs++;
+      freeBitSet(&setA);
+      freeBitSet(&setB);
+      freeBitSet(&result);
+    }
+  }
+
+  printf("bitsetAnd + bitsetCount: %d random pairs of %zu widths, %d differ from the per-character loop\n",
+         pairs, widths.size(), bad);
+  return bad == 0;
+}
+
+/**
+ * Name: checkArrayWithoutData
+ * @brief addElement on an array left without data: initArray failing on an arena too
+ *      small for it, and the same array again after freeArray.
+ * @retval true if both took ARRAY_REFILL elements in order.
+ */
+static bool checkArrayWithoutData() {
+  alignas(16) static uint8_t arena[32];
+  static AllocPool pool;
+  DynamicArray arr;
+  bool failed = initAllocPool(&pool, arena, sizeof(arena)) && setAllocator(&pool.allocator);
+  Serial.capture = true;  // keep the failure message out of the table
+  initArray(&arr, 64);
+  Serial.capture = false;
+  failed = failed && arr.data == NULL && arr.capacity == 0 && setAllocator(&heapAllocator);
+
+  bool ok = failed;
+  for (int pass = 0; pass < 2; pass++) {
+    for (int i = 0; i < ARRAY_REFILL; i++) addElement(&arr, i * 7);
+    ok = ok && arr.data != NULL && arr.size == ARRAY_REFILL;
+    for (int i = 0; ok && i < ARRAY_REFILL; i++) ok = arr.data[i] == i * 7;
+    freeArray(&arr);
+  }
+  setAllocator(&heapAllocator);
+  printf("DynamicArray without data: initArray %s, refilled after the failure and after freeArray %s\n",
+         failed ? "failed as set up" : "did NOT fail", ok ? "ok" : "WRONG");
+  return ok;
+}
+
+/**
+ * Name: checkParallelTransform
+ * @brief transformArrayParallel with CHECK_WORKERS threads against transformArray, on
+ *      lengths on both sides of TRANSFORM_PARALLEL_MIN and of the chunk splits.
+ * @details The pipeline is not idempotent, so an element run twice or skipped shows up.
+ * @retval true if every length matched.
+ */
+static bool checkParallelTransform() {
+  static const size_t lengths[] = {
+    1, TRANSFORM_PARALLEL_MIN - 1, TRANSFORM_PARALLEL_MIN, TRANSFORM_PARALLEL_MIN + 1,
+    TRANSFORM_PARALLEL_MIN + CHECK_WORKERS, 5003, 65536, 65537, (1 << 20) + 3,
+  };
+  auto fused = makePipeline([](int x) { return 3 * x; },
+                            [](int x) { return x ^ (x >> 7); },
+                            [](int x) { return x - 10; });
+  transformSetWorkers(CHECK_WORKERS);
+  int workers = transformWorkers();
+  uint32_t seed = 4096;
+  int bad = 0;
+  for (size_t len : lengths) {
+    std::vector<int> serial(len);
+    for (int &v : serial) v = (int)rand_r(&seed) - RAND_MAX / 2;
+    std::vector<int> parallel(serial);
+    int serialRet = transformArray(serial.data(), len, fused);
+    int parallelRet = transformArrayParallel(parallel.data(), len, fused);
+    if (serial != parallel || serialRet != parallelRet) {
+      if (bad++ == 0) printf("transformArrayParallel differs from transformArray at length %zu\n", len);
+    }
+  }
+  transformSetWorkers(-1);
+
+  printf("transformArrayParallel: %d workers, %zu lengths, %d differ from transformArray\n",
+         workers, sizeof(lengths) / sizeof(lengths[0]), bad);
+  return workers == CHECK_WORKERS && bad == 0;
+}
+
+/**
+ * Name: benchPrint
+ * @brief The print path down to Serial.write, with output discarded.
+ */
+static void benchPrint() {
+  Serial.capture = false;
+  double ns = benchNsPerOp([](size_t n) {
+    for (size_t i = 0; i < n; i++) printString("Array tripled: [9, 21, 33, 45]\n");
+  }, 1000000);
+  benchRow("printString 31 chars + newline", 31, ns);
+
+  ns = benchNsPerOp([](size_t n) {
+    for (size_t i = 0; i < n; i++) printInt((int)((uint32_t)i * 7919u));
+  }, 1000000);
+  benchRow("printInt", 0, ns);
+
+  ns = benchNsPerOp([](size_t n) {
+    for (size_t i = 0; i < n; i++) printFloat((float)i * 0.37f);
+  }, 1000000);
+  benchRow("printFloat", 0, ns);
+  printFlush();
+}
+
+/**
+ * Name: backgroundRun
+ * @brief The library calls of one backgroundJob in the sketch: the task3 array, the task4
+ *      truth table (BitSets) and the task5 circular buffer.
+ */
+static void backgroundRun() {
+  static const int values[] = {21, 26, 31, 19, 24, 29, 1, 65, 36, 41};
+  DynamicArray arr;
+  initArray(&arr, 2);
+  for (int v : values) addElement(&arr, v);
+  benchKeep(arr.data[arr.size - 1]);
+  freeArray(&arr);
+
+  print_truth_table("10000", "1100");
+
+  CircularBuffer cb;
+  initBuffer(&cb, BUFFER_SIZE);
+  writeBuffer(&cb, 10);
+  writeBuffer(&cb, 20);
+  writeBuffer(&cb, 30);
+  benchKeep(readBuffer(&cb));
+  pushBuffer(&cb, 40);
+  pushBuffer(&cb, 50);
+  while (!isEmpty(&cb)) benchKeep(popBuffer(&cb));
+  freeBuffer(&cb);
+
+  while (tracePending() > 0) traceDrain(64);
+  printFlush();
+}
+
+/**
+ * Name: churnRuns
+ * @brief Replays CHURN_RUNS background jobs on the current allocator and prints one row.
+ * @param name allocator name for the row.
+ * @param pool the pool in use, or NULL on the heap.
+ * @retval true if no run leaked or failed, every run made the same allocator calls, and
+ *      the pool carved nothing after the first run.
+ */
+static bool churnRuns(const char *name, const AllocPool *pool) {
+  AllocStats prev, now;
+  resetAllocStats();
+  getAllocTotals(&prev);
+
+  uint32_t firstCalls = 0;
+  size_t firstCarved = 0;
+  bool ok = true;
+  for (int r = 0; r < CHURN_RUNS; r++) {
+    backgroundRun();
+    getAllocTotals(&now);
+    uint32_t calls = (now.allocs - prev.allocs) + (now.reallocs - prev.reallocs) + (now.frees - prev.frees);
+    if (r == 0) {
+      firstCalls = calls;
+      firstCarved = (pool != NULL) ? pool->carved : 0;
+    }
+    if (calls != firstCalls || now.liveBlocks != 0 || now.liveBytes != 0 || now.failures != 0) ok = false;
+    if (pool != NULL && pool->carved != firstCarved) ok = false;
+    prev = now;
+  }
+
+  char carved[32] = "-";
+  if (pool != NULL) snprintf(carved, sizeof(carved), "%zu/%zu", firstCarved, pool->carved);
+  printf("%-8s %10u %12llu %8zu %8u %14s %s\n", name, firstCalls,
+         (unsigned long long)(now.copiedBytes / CHURN_RUNS), now.peakBytes, now.liveBlocks, carved,
+         ok ? "ok" : "CHURN");
+  return ok;
+}
+
+/**
+ * Name: benchAllocChurn
+ * @brief Background job runs on the heap and on a CHURN_ARENA pool, then the time of one
+ *      run and of one 64 byte labAlloc + labFree on each.
+ * @details The timings alternate between the two allocators for ALLOC_ROUNDS rounds, so
+ *      a slow stretch of the machine does not land on one of them only.
+ * @retval false if a run leaked, churned, or the pool could not be installed.
+ */
+static bool benchAllocChurn() {
+  alignas(16) static uint8_t arena[CHURN_ARENA];
+  static AllocPool pool;
+
+  printf("%-8s %10s %12s %8s %8s %14s\n", "alloc", "calls/run", "copied/run", "peak B", "live", "carved 1st/all");
+  bool ok = churnRuns("heap", NULL);
+  if (!initAllocPool(&pool, arena, sizeof(arena)) || !setAllocator(&pool.allocator)) {
+    printf("pool not installed: earlier benchmarks left tracked blocks live\n");
+    return false;
+  }
+  ok = churnRuns("pool", &pool) && ok;
+  printf("pool free %zu B, largest free block %zu B\n\n", allocFreeBytes(), allocLargestFree());
+
+  double bestRun[2] = {1e30, 1e30}, bestPair[2] = {1e30, 1e30};
+  int poolRunWins = 0, poolPairWins = 0;
+  for (int round = 0; round < ALLOC_ROUNDS; round++) {
+    double run[2], pair[2];
+    for (int onPool = 0; onPool < 2; onPool++) {
+      setAllocator(onPool ? &pool.allocator : &heapAllocator);
+      run[onPool] = benchNsPerOp([](size_t n) {
+        for (size_t i = 0; i < n; i++) backgroundRun();
+      }, 500);
+      pair[onPool] = benchNsPerOp([](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+          void *p = labAlloc(ALLOC_TAG_SKETCH, 64);
+          benchKeep(p);
+          labFree(ALLOC_TAG_SKETCH, p, 64);
+        }
+      }, 2000000);
+      if (run[onPool] < bestRun[onPool]) bestRun[onPool] = run[onPool];
+      if (pair[onPool] < bestPair[onPool]) bestPair[onPool] = pair[onPool];
+    }
+    poolRunWins += run[1] < run[0];
+    poolPairWins += pair[1] < pair[0];
+  }
+  setAllocator(&heapAllocator);
+
+  benchHeader();
+  benchRow("background job run (heap)", 0, bestRun[0]);
+  benchRow("background job run (pool)", 0, bestRun[1]);
+  benchRow("labAlloc + labFree (heap)", 64, bestPair[0]);
+  benchRow("labAlloc + labFree (pool)", 64, bestPair[1]);
+  printf("pool faster in %d of %d rounds for a job run, %d of %d for labAlloc + labFree\n", poolRunWins,
+         ALLOC_ROUNDS, poolPairWins, ALLOC_ROUNDS);
+  return ok;
+}
+
+/**
+ * Name: benchSensorLoop
+ * @brief simulateSensorData with a 1 MHz timer, a scripted LDR and 1 ms loop passes.
+ * @details Reports nanoseconds per loop pass over 60 simulated seconds.
+ * @retval false if the loop made any allocator call.
+ */
+static bool benchSensorLoop() {
+  static const int ldr[] = {100, 900, 1800, 2700, 3600, 2700, 1800, 900};
+  const int passes = 60000;
+
+  hostReset();
+  hostSetAnalogScript(LEDR, ldr, sizeof(ldr) / sizeof(ldr[0]), true);
+  *(volatile uint32_t *) TIMG_T0CONFIG_REG(0) = (1u << 31) | (1u << 30) | (80 << 13);
+
+  SensorBuffer cb;
+  DynamicArray processed;
+  int storage[32];
+  ArraySummary summaries[45];
+  ArrayHistory history;
+  initArrayStatic(&processed, storage, 32);
+  setArrayRetention(&processed, &history, summaries, 45, 8);
+
+  AllocStats before, after;
+  getAllocTotals(&before);
+  double start = benchNowSeconds();
+  for (int i = 0; i < passes; i++) {
+    hostAdvanceMicros(1000);
+    simulateSensorData(&cb, &processed);
+    traceDrain(4);
+    printPoll();
+  }
+  double ns = (benchNowSeconds() - start) * 1e9 / passes;
+  printFlush();
+  benchRow("simulateSensorData loop pass", processed.size, ns);
+  getAllocTotals(&after);
+
+  freeArray(&processed);
+  uint32_t calls = (after.allocs - before.allocs) + (after.reallocs - before.reallocs) + (after.frees - before.frees);
+  if (calls != 0) printf("simulateSensorData loop made %u allocator calls\n", calls);
+  return calls == 0;
+}
+
+int main() {
+  Serial.capture = false;
+  benchHeader();
+
+  benchCircularBuffer();
+  benchRingBulk();
+  benchResize(1024);
+  benchDynamicArray(16);
+  benchDynamicArray(1024);
+  benchBoundedArray();
+
+  static const size_t copySizes[] = {3, 16, 256, 4096, 65536};
+  for (size_t size : copySizes) benchMemCopy(size, 0);
+  for (size_t size : copySizes) benchMemCopy(size, 1);
+
+  benchStrToInt("4745");
+  benchStrToInt("-42323");
+  benchStrToInt("123456789");
+  benchStrToInt("-2147483648");
+
+  static const size_t reverseSizes[] = {8, 17, 64, 1024, 16384};
+  for (size_t len : reverseSizes) benchReverse(len);
+
+  static const size_t transformSizes[] = {16, 1024, 65536, 1048576};
+  for (size_t len : transformSizes) benchTransform(len);
+
+  static const size_t bitsetSizes[] = {16, 1024, 65536};
+  for (size_t bits : bitsetSizes) benchBitset(bits);
+
+  benchFibFact();
+  benchPrint();
+  bool ok = benchSensorLoop();
+
+  printf("\n");
+  ok = checkFibFact() && ok;
+  ok = checkAgainstLibc() && ok;
+  ok = checkBitset() && ok;
+  ok = checkParallelTransform() && ok;
+  ok = checkArrayWithoutData() && ok;
+
+  printf("\n");
+  ok = benchAllocChurn() && ok;
+  return ok ? 0 : 1;
+}
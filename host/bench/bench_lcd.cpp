@@ -0,0 +1,335 @@
+/**
+ * @file bench_lcd.cpp
+ * @brief LCD update cost: clear-and-repaint against the LcdFrame diff.
+ *
+ * @section description Description
+ * Each workload draws a sequence of screens the way one of the sketches does. The
+ * repaint rows send them like the sketches used to: lcd.clear() and every character.
+ * The frame rows draw the same screens into an LcdFrame and flush it. Both go through
+ * the LiquidCrystal_I2C stand-in, so I2C transactions, bytes and time on the virtual
+ * clock (bus time plus the library's delays) are counted as on the board. After every
+ * update the display must show the screen, or the benchmark fails.
+ *
+ * The last rows time flush() itself on the host with a display that discards the
+ * output, i.e. the CPU cost of the diff, and the caller's cost of posting the same
+ * screens to an LcdQueue instead. A two-thread run then posts counter screens from one
+ * thread while another drains them, and checks that every ticket completes and the
+ * display ends on the last screen. A last check fills a small queue part way through a
+ * screen and requires the whole screen to be dropped, not its first half shown.
+ */
+#include <Arduino.h>
+#include <LiquidCrystal_I2C.h>
+#include <LcdFrame.h>
+#include <LcdQueue.h>
+#include <Wire.h>
+#include "Bench.h"
+
+#include <atomic>
+#include <thread>
+
+#define LCD_UPDATES 1000     ///< Screens per workload
+#define QUEUE_UPDATES 200000 ///< Screens posted by the two-thread run
+
+typedef LcdFrame<16, 2> Frame;
+
+/**
+ * @brief One screen: two rows of text, at most 16 characters each.
+ */
+struct Screen {
+  char rows[2][17];
+};
+
+typedef void (*ScreenFn)(int i, Screen &s);
+
+/// Lab 4 BLE: the counter ticking up
+static void counterScreen(int i, Screen &s) {
+  snprintf(s.rows[0], sizeof(s.rows[0]), "Count: %d", i);
+  s.rows[1][0] = '\0';
+}
+
+/// Lab 5 Part 2: a noisy light reading and its 5 sample average
+static int lightLevel(int i) {
+  uint32_t noise = (uint32_t)i * 2654435761u;
+  return 2000 + (int)((noise >> 16) % 64) - 32 + (i % 200);
+}
+
+static void lightScreen(int i, Screen &s) {
+  int n = (i < 5) ? i + 1 : 5;
+  int sum = 0;
+  for (int k = 0; k < n; k++) sum += lightLevel(i - k);
+  snprintf(s.rows[0], sizeof(s.rows[0]), "LEDR READ: %d", lightLevel(i));
+  snprintf(s.rows[1], sizeof(s.rows[1]), "SMA: %d", (sum + n / 2) / n);
+}
+
+/// Lab 4 TCB taskB: counts 1 to 10 over and over
+static void tcbScreen(int i, Screen &s) {
+  snprintf(s.rows[0], sizeof(s.rows[0]), "Count: %d", 1 + i % 10);
+  s.rows[1][0] = '\0';
+}
+
+/**
+ * @brief Bus traffic of one run.
+ */
+struct LcdCost {
+  size_t transactions;
+  size_t bytes;
+  uint64_t us;
+  size_t mismatches;  ///< Updates after which the display did not show the screen
+};
+
+/**
+ * Name: runScreens
+ * @brief Shows LCD_UPDATES screens through a fresh display, by repaint or through a frame.
+ */
+static LcdCost runScreens(ScreenFn screen, bool useFrame) {
+  hostReset();
+  LiquidCrystal_I2C lcd(0x27, 16, 2);
+  lcd.init();
+  Frame frame;
+
+  size_t transactions = Wire.transactions;
+  size_t bytes = Wire.bytes;
+  uint64_t start = hostNowMicros();
+  size_t mismatches = 0;
+  for (int i = 0; i < LCD_UPDATES; i++) {
+    Screen s;
+    screen(i, s);
+    if (useFrame) {
+      frame.clear();
+      frame.print(s.rows[0]);
+      frame.setCursor(0, 1);
+      frame.print(s.rows[1]);
+      frame.flush(lcd);
+    } else {
+      lcd.clear();
+      lcd.setCursor(0, 0);
+      lcd.print(s.rows[0]);
+      lcd.setCursor(0, 1);
+      lcd.print(s.rows[1]);
+    }
+    for (int r = 0; r < 2; r++) {
+      std::string want(s.rows[r]);
+      want.resize(16, ' ');
+      if (lcd.text(r) != want) mismatches++;
+    }
+  }
+
+  LcdCost cost;
+  cost.transactions = Wire.transactions - transactions;
+  cost.bytes = Wire.bytes - bytes;
+  cost.us = hostNowMicros() - start;
+  cost.mismatches = mismatches;
+  return cost;
+}
+
+static void printCost(const char *name, const LcdCost &c) {
+  printf("%-40s %10.1f %10.1f %12.1f\n", name, (double)c.transactions / LCD_UPDATES,
+         (double)c.bytes / LCD_UPDATES, (double)c.us / LCD_UPDATES);
+}
+
+/**
+ * @brief Display that only counts what it is sent, for timing flush() alone.
+ */
+struct NullLcd {
+  size_t sent = 0;
+  void setCursor(uint8_t col, uint8_t row) { sent += col + row; }
+  size_t write(uint8_t c) {
+    sent += c;
+    return 1;
+  }
+};
+
+/**
+ * Name: benchFlush
+ * @brief Host time to draw one screen of a workload into a frame and flush it.
+ */
+static void benchFlush(const char *name, ScreenFn screen) {
+  Screen screens[LCD_UPDATES];
+  for (int i = 0; i < LCD_UPDATES; i++) screen(i, screens[i]);
+  NullLcd lcd;
+  Frame frame;
+  double ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      const Screen &s = screens[i % LCD_UPDATES];
+      frame.clear();
+      frame.print(s.rows[0]);
+      frame.setCursor(0, 1);
+      frame.print(s.rows[1]);
+      frame.flush(lcd);
+    }
+  }, 200000);
+  benchKeep(lcd.sent);
+  benchRow(name, LCD_UPDATES, ns);
+}
+
+/**
+ * Name: postScreen
+ * @brief Posts a screen to q as the sketches do, as one update.
+ * @retval ticket of the last command, or LCD_QUEUE_FULL if the screen was dropped.
+ */
+template <typename Queue>
+static uint32_t postScreen(Queue &q, const Screen &s) {
+  q.beginUpdate();
+  q.clear();
+  q.print(s.rows[0]);
+  q.setCursor(0, 1);
+  q.print(s.rows[1]);
+  return q.endUpdate();
+}
+
+/**
+ * Name: benchPost
+ * @brief Host time for the caller to post one screen; the queue is drained between batches, untimed.
+ */
+static void benchPost(const char *name, ScreenFn screen) {
+  static Screen screens[LCD_UPDATES];
+  for (int i = 0; i < LCD_UPDATES; i++) screen(i, screens[i]);
+  static LcdQueue<64, 16, 2> queue;
+  NullLcd lcd;
+  double best = 1e30;
+  for (int r = 0; r < BENCH_REPEATS; r++) {
+    double total = 0;
+    for (int i = 0; i < LCD_UPDATES; i++) {
+      double start = benchNowSeconds();
+      for (int k = 0; k < 8; k++) postScreen(queue, screens[i]);
+      total += benchNowSeconds() - start;
+      queue.drain(lcd);
+    }
+    if (total < best) best = total;
+  }
+  benchKeep(lcd.sent);
+  benchRow(name, LCD_UPDATES, best * 1e9 / (LCD_UPDATES * 8));
+}
+
+/**
+ * @brief Display model for the two-thread run: DDRAM and cursor, like the HD44780.
+ */
+struct RecordingLcd {
+  char ddram[0x80];
+  uint8_t address = 0;
+  RecordingLcd() { memset(ddram, ' ', sizeof(ddram)); }
+  void setCursor(uint8_t col, uint8_t row) { address = (row ? 0x40 : 0x00) + col; }
+  size_t write(uint8_t c) {
+    ddram[address++ & 0x7F] = (char)c;
+    return 1;
+  }
+  std::string text(int row) const { return std::string(&ddram[row ? 0x40 : 0x00], 16); }
+};
+
+/**
+ * Name: queueStress
+ * @brief One thread posts QUEUE_UPDATES counter screens, retrying when the queue is full,
+ *      while another drains. The producer waits for its last ticket.
+ * @retval true if the display shows the last screen and the counts add up.
+ */
+static bool queueStress() {
+  static LcdQueue<16, 16, 2> queue;
+  RecordingLcd lcd;
+  std::atomic<bool> producing{true};
+  uint32_t rejected = 0;
+  uint32_t last = 0;
+
+  std::thread consumer([&] {
+    while (producing.load() || queue.pending() > 0) {
+      if (queue.drain(lcd) == 0) std::this_thread::yield();
+    }
+  });
+  double start = benchNowSeconds();
+  for (int i = 0; i < QUEUE_UPDATES; i++) {
+    Screen s;
+    counterScreen(i, s);
+    // a whole screen or nothing: retry the screen until it fits
+    while ((last = postScreen(queue, s)) == LCD_QUEUE_FULL) {
+      rejected++;
+      std::this_thread::yield();
+    }
+  }
+  queue.wait(last, [] { std::this_thread::yield(); });
+  double elapsed = benchNowSeconds() - start;
+  producing.store(false);
+  consumer.join();
+
+  Screen s;
+  counterScreen(QUEUE_UPDATES - 1, s);
+  std::string want(s.rows[0]);
+  want.resize(16, ' ');
+  bool ok = lcd.text(0) == want && queue.dropped() == rejected && last != LCD_QUEUE_FULL;
+  printf("queue stress: %d screens in %.3f s, %u full waits, %u dropped, display \"%s\" %s\n",
+         QUEUE_UPDATES, elapsed, rejected, queue.dropped(), lcd.text(0).c_str(), ok ? "ok" : "WRONG");
+  return ok;
+}
+
+/**
+ * Name: checkUpdateDropped
+ * @brief A screen that only partly fits must be dropped whole.
+ * @details One cursor command leaves an 8 command queue room for one 4 command screen and
+ *      3 commands of the next. Without updates the second screen's clear and first row
+ *      would be queued and shown over the first screen's second row.
+ * @retval true if the display shows the first screen and the second counted as dropped.
+ */
+static bool checkUpdateDropped() {
+  static LcdQueue<8, 16, 2> queue;
+  RecordingLcd lcd;
+  Screen first, second;
+  counterScreen(1, first);
+  counterScreen(2, second);
+  queue.setCursor(0, 0);
+  bool accepted = postScreen(queue, first) != LCD_QUEUE_FULL;
+  bool rejected = postScreen(queue, second) == LCD_QUEUE_FULL;
+  size_t pending = queue.pending();
+  queue.drain(lcd);
+
+  std::string want[2] = { first.rows[0], first.rows[1] };
+  for (std::string &row : want) row.resize(16, ' ');
+  bool ok = accepted && rejected && pending == 5 && queue.dropped() == 1 && lcd.text(0) == want[0] &&
+            lcd.text(1) == want[1];
+  printf("partial screen: %zu commands queued, %u dropped, display \"%s\" \"%s\" %s\n", pending, queue.dropped(),
+         lcd.text(0).c_str(), lcd.text(1).c_str(), ok ? "ok" : "WRONG");
+  return ok;
+}
+
+int main() {
+  static const struct {
+    const char *name;
+    ScreenFn screen;
+  } workloads[] = {
+    {"counter", counterScreen},
+    {"light", lightScreen},
+    {"tcb count", tcbScreen},
+  };
+
+  bool ok = true;
+  printf("%-40s %10s %10s %12s\n", "lcd update", "xfers/upd", "bytes/upd", "virt us/upd");
+  for (const auto &w : workloads) {
+    char name[64];
+    LcdCost repaint = runScreens(w.screen, false);
+    snprintf(name, sizeof(name), "%s: clear and repaint", w.name);
+    printCost(name, repaint);
+    LcdCost frame = runScreens(w.screen, true);
+    snprintf(name, sizeof(name), "%s: LcdFrame flush", w.name);
+    printCost(name, frame);
+    if (repaint.mismatches || frame.mismatches) {
+      printf("%s: display wrong after %zu repaint and %zu frame updates\n", w.name, repaint.mismatches,
+             frame.mismatches);
+      ok = false;
+    }
+  }
+
+  printf("\n");
+  benchHeader();
+  for (const auto &w : workloads) {
+    char name[64];
+    snprintf(name, sizeof(name), "flush cpu: %s", w.name);
+    benchFlush(name, w.screen);
+  }
+  for (const auto &w : workloads) {
+    char name[64];
+    snprintf(name, sizeof(name), "queue post: %s", w.name);
+    benchPost(name, w.screen);
+  }
+
+  printf("\n");
+  ok = queueStress() && ok;
+  ok = checkUpdateDropped() && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,219 @@
+/**
+ * @file bench_rt.cpp
+ * @brief Lab 5 Part 1 RTScheduler: admission tests, dispatch order and the cost of rtPick.
+ *
+ * @section description Description
+ * - Admission: hand-picked task sets with the answer each policy must give, including a
+ *   set that is only over 100% by less than 1 ppm per term, which rounding down admitted.
+ *   SRTF refuses every set whose busy period outlasts its shortest deadline.
+ * - Dispatch: a harmonic set is run tick by tick under RM and EDF and must produce the
+ *   timeline worked out by hand; a set only EDF admits must run under EDF without a miss.
+ * - Random sets: every set a policy admits is run for two hyperperiods and must not miss a
+ *   deadline. Deadlines are random up to the period for SRTF and EDF, equal to it for RM.
+ * Exits non-zero on any wrong answer. Then rtRelease + rtPick is timed per tick.
+ */
+#include "RTScheduler.h"
+#include "Bench.h"
+
+#include <stdlib.h>
+#include <string>
+
+#define RANDOM_SETS 4000 ///< Random task sets tried per policy
+
+/**
+ * @brief One task of a hand-picked set.
+ */
+struct Spec {
+  uint32_t period;
+  uint32_t wcet;
+  uint32_t deadline;
+};
+
+/**
+ * Name: loadSet
+ * @brief Replaces the task set under policy. Tasks go in one by one, as in the sketch.
+ * @retval false if a task was refused.
+ */
+static bool loadSet(RtPolicy policy, const Spec *specs, int count) {
+  rtClear();
+  rtSetPolicy(RT_POLICY_SRTF);  // an empty set is admissible under every policy
+  if (!rtSetPolicy(policy)) return false;
+  for (int i = 0; i < count; i++) {
+    if (rtAddTask("t", specs[i].period, specs[i].wcet, specs[i].deadline, NULL) == RT_NONE) return false;
+  }
+  return true;
+}
+
+/**
+ * Name: runTicks
+ * @brief Runs the loaded set one tick at a time from tick 0, the way the sketch's scheduler
+ *      task does on each event.
+ * @param timeline if not NULL, gets one letter per tick: 'A' for task 0 and so on, '-' for idle.
+ * @retval deadline misses over all tasks.
+ */
+static uint32_t runTicks(uint32_t ticks, std::string *timeline) {
+  rtStart(0);
+  for (uint32_t now = 0; now < ticks; now++) {
+    rtRelease(now);
+    int id = rtPick(now);
+    if (timeline != NULL) timeline->push_back(id == RT_NONE ? '-' : (char)('A' + id));
+    if (id == RT_NONE) continue;
+    rtCharge(id, 1);
+    if (rtGet(id)->remaining == 0) rtComplete(id, now + 1);
+  }
+  rtRelease(ticks);  // jobs still running at the end count as misses
+  uint32_t misses = 0;
+  for (int i = 0; i < rtTaskCount(); i++) misses += rtGet(i)->misses;
+  return misses;
+}
+
+/**
+ * @brief A hand-picked set and whether SRTF, EDF and RM must admit it.
+ */
+struct AdmissionCase {
+  const char *name;
+  Spec specs[5];
+  int count;
+  bool srtf, edf, rm;
+};
+
+static const AdmissionCase admissionCases[] = {
+  { "RM bound, 2 tasks, 80%", {{10, 4, 10}, {15, 6, 15}}, 2, true, true, true },
+  { "over RM bound, 90%", {{10, 5, 10}, {15, 6, 15}}, 2, false, true, false },
+  { "harmonic, 100%", {{10, 5, 10}, {20, 10, 20}}, 2, false, true, true },
+  { "over 100%", {{10, 5, 10}, {20, 11, 20}}, 2, false, false, false },
+  { "deadline < period", {{10, 3, 5}, {20, 2, 20}}, 2, true, true, false },
+  { "density over 100%", {{10, 3, 5}, {10, 3, 5}}, 2, false, false, false },
+  { "just over 100%", {{3, 1, 3}, {3, 1, 3}, {3, 1, 3}, {1000000, 1, 1000000}}, 4, false, false, false },
+};
+
+/**
+ * Name: checkAdmission
+ * @retval true if every case got the expected answer under every policy.
+ */
+static bool checkAdmission() {
+  static const RtPolicy policies[] = { RT_POLICY_SRTF, RT_POLICY_EDF, RT_POLICY_RM };
+  bool ok = true;
+  for (const AdmissionCase &c : admissionCases) {
+    bool expected[] = { c.srtf, c.edf, c.rm };
+    printf("%-24s", c.name);
+    for (int p = 0; p < 3; p++) {
+      bool admitted = loadSet(policies[p], c.specs, c.count);
+      bool right = admitted == expected[p];
+      printf(" %s %s%s", rtPolicyName(policies[p]), admitted ? "admits" : "refuses", right ? "" : " (WRONG)");
+      ok = ok && right;
+    }
+    printf("\n");
+  }
+  return ok;
+}
+
+/**
+ * Name: checkTimeline
+ * @brief Runs specs under policy for expected.size() ticks and compares the timeline.
+ */
+static bool checkTimeline(const char *name, RtPolicy policy, const Spec *specs, int count, const std::string &expected) {
+  if (!loadSet(policy, specs, count)) {
+    printf("%-24s %s refused the set (WRONG)\n", name, rtPolicyName(policy));
+    return false;
+  }
+  std::string timeline;
+  uint32_t misses = runTicks((uint32_t)expected.size(), &timeline);
+  bool ok = timeline == expected && misses == 0;
+  printf("%-24s %-4s %s, %u misses%s\n", name, rtPolicyName(policy), timeline.c_str(), misses, ok ? "" : " (WRONG)");
+  if (timeline != expected) printf("%-24s expected %s\n", "", expected.c_str());
+  return ok;
+}
+
+/**
+ * Name: checkDispatch
+ * @retval true if the hand-worked timelines match.
+ */
+static bool checkDispatch() {
+  // Periods 4, 8, 16: A first under RM, and under EDF whenever its deadline is nearer.
+  // B and C tie on deadline at 8-16 and B, added first, runs.
+  static const Spec harmonicSet[] = { {4, 1, 4}, {8, 2, 8}, {16, 6, 16} };
+  const std::string harmonicTimeline = "ABBCACCCABBCAC--ABBCACCCABBCAC--";
+  bool ok = checkTimeline("harmonic 87.5%", RT_POLICY_RM, harmonicSet, 3, harmonicTimeline);
+  ok = checkTimeline("harmonic 87.5%", RT_POLICY_EDF, harmonicSet, 3, harmonicTimeline) && ok;
+
+  // 97%: over the RM bound. Under RM, A's second job at 5-6 would make B finish at 8, past
+  // its deadline of 7; EDF lets B finish at 6 first, since A's deadline of 10 is later.
+  static const Spec edfOnlySet[] = { {5, 2, 5}, {7, 4, 7} };
+  bool rmAdmits = loadSet(RT_POLICY_RM, edfOnlySet, 2);
+  printf("%-24s RM   %s%s\n", "EDF only 97%", rmAdmits ? "admits" : "refuses", rmAdmits ? " (WRONG)" : "");
+  ok = !rmAdmits && ok;
+  return checkTimeline("EDF only 97%", RT_POLICY_EDF, edfOnlySet, 2, "AABBBBAABBBBAABAABBBAABBBBAABBAABB-") && ok;
+}
+
+static uint32_t gcd(uint32_t a, uint32_t b) {
+  while (b != 0) {
+    uint32_t r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+/**
+ * Name: checkRandomSets
+ * @brief Every random set a policy admits must run two hyperperiods without a miss.
+ * @retval true if none missed.
+ */
+static bool checkRandomSets(RtPolicy policy) {
+  uint32_t seed = 590 + (uint32_t)policy;
+  int admitted = 0, missed = 0;
+  for (int s = 0; s < RANDOM_SETS; s++) {
+    Spec specs[5];
+    int count = 1 + rand_r(&seed) % 5;
+    uint32_t hyperperiod = 1;
+    for (int i = 0; i < count; i++) {
+      specs[i].period = 2 + rand_r(&seed) % 11;
+      specs[i].wcet = 1 + rand_r(&seed) % (specs[i].period / 2 + 1);
+      specs[i].deadline = specs[i].period;
+      if (policy != RT_POLICY_RM) specs[i].deadline = specs[i].wcet + rand_r(&seed) % (specs[i].period - specs[i].wcet + 1);
+      hyperperiod = hyperperiod / gcd(hyperperiod, specs[i].period) * specs[i].period;
+    }
+    if (!loadSet(policy, specs, count)) continue;
+    admitted++;
+    if (runTicks(2 * hyperperiod, NULL) != 0) {
+      if (missed++ == 0) printf("%s: set %d (%d tasks) was admitted and missed a deadline\n", rtPolicyName(policy), s, count);
+    }
+  }
+  printf("%-4s %d random sets, %d admitted, %d of those missed a deadline\n", rtPolicyName(policy), RANDOM_SETS, admitted, missed);
+  return missed == 0;
+}
+
+int main() {
+  bool ok = checkAdmission();
+  printf("\n");
+  ok = checkDispatch() && ok;
+  printf("\n");
+  ok = checkRandomSets(RT_POLICY_SRTF) && ok;
+  ok = checkRandomSets(RT_POLICY_EDF) && ok;
+  ok = checkRandomSets(RT_POLICY_RM) && ok;
+  printf("\n");
+
+  benchHeader();
+  for (int count = 2; count <= RT_MAX_TASKS; count *= 2) {
+    Spec specs[RT_MAX_TASKS];
+    for (int i = 0; i < count; i++) specs[i] = { (uint32_t)(count << (i % 4)), 1, (uint32_t)(count << (i % 4)) };
+    loadSet(RT_POLICY_EDF, specs, count);
+    rtStart(0);
+    double ns = benchNsPerOp([](size_t n) {
+      int picks = 0;
+      for (size_t now = 0; now < n; now++) {
+        rtRelease((uint32_t)now);
+        int id = rtPick((uint32_t)now);
+        if (id != RT_NONE) {
+          rtCharge(id, 1);
+          if (rtGet(id)->remaining == 0) rtComplete(id, (uint32_t)now + 1);
+          picks++;
+        }
+      }
+      benchKeep(picks);
+    }, 1000000);
+    benchRow("EDF rtRelease + rtPick, per tick", count, ns);
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+/**
+ * @file bench_sched.cpp
+ * @brief Cost per task of the Lab 3 run_scheduler engine as the task count grows.
+ *
+ * @section description Description
+ * initialize_tasks builds the same workload for every policy (about 93% load, 1 to
+ * 40 ms jobs). The stepped row runs round robin one simulated millisecond at a time,
+ * the way a per-slot simulation would, for comparison; its cost follows the time span
+ * rather than the number of events. print_flowchart is timed on the largest run.
+ *
+ * Before timing, every policy is checked against a 1 ms stepped reference on random
+ * workloads (task count, run times, arrival gaps, priorities and quantum all vary):
+ * each task's finish_time and the makespan must match, or the bench exits non-zero.
+ */
+#include "590Lab3.h"
+#include "Special590functions.h"
+#include "Bench.h"
+
+#include <stdlib.h>
+#include <vector>
+
+#define MAX_TASKS      64000 ///< Largest task count measured
+#define FLOWCHART_SIZE 8192  ///< Flowchart entries; the larger runs are truncated, as on the board
+#define CHECK_WORKLOADS 3000 ///< Random workloads per policy in the reference check
+#define CHECK_MAX_TASKS 120  ///< Largest random workload
+
+/**
+ * Name: steppedRoundRobin
+ * @brief Round robin advanced one millisecond per step.
+ * @details tasks must be in arrival order; equal arrivals are taken in array order.
+ * @retval finish time of the last task.
+ */
+static uint32_t steppedRoundRobin(Task *tasks, int count, uint32_t quantum, std::vector<int> &ring) {
+  for (int i = 0; i < count; i++) tasks[i].remaining = tasks[i].run_time;
+  int next = 0, head = 0, queued = 0, done = 0, current = -1;
+  uint32_t slice = 0, now = 0;
+  while (done < count) {
+    while (next < count && tasks[next].arrival_time <= now) {
+      ring[(head + queued++) % count] = next++;
+    }
+    if (current >= 0 && slice == quantum) {
+      ring[(head + queued++) % count] = current;
+      current = -1;
+    }
+    if (current < 0 && queued > 0) {
+      current = ring[head];
+      head = (head + 1) % count;
+      queued--;
+      slice = 0;
+    }
+    now++;
+    if (current >= 0) {
+      slice++;
+      if (--tasks[current].remaining == 0) {
+        tasks[current].finish_time = now;
+        current = -1;
+        done++;
+      }
+    }
+  }
+  return now;
+}
+
+/**
+ * Name: steppedByKey
+ * @brief Priority (preemptive) or shortest job (to completion), advanced one millisecond per step.
+ * @details Each step runs the arrived task with the smallest priority or run_time, ties to the
+ *      earlier task; without preemption the running task keeps the CPU until it finishes.
+ *      tasks must be in arrival order.
+ * @retval finish time of the last task.
+ */
+static uint32_t steppedByKey(Task *tasks, int count, bool preemptive) {
+  for (int i = 0; i < count; i++) tasks[i].remaining = tasks[i].run_time;
+  int arrived = 0, done = 0, current = -1;
+  uint32_t now = 0;
+  while (done < count) {
+    while (arrived < count && tasks[arrived].arrival_time <= now) arrived++;
+    if (preemptive || current < 0) {
+      current = -1;
+      for (int i = 0; i < arrived; i++) {
+        if (tasks[i].remaining == 0) continue;
+        uint32_t key = preemptive ? tasks[i].priority : tasks[i].run_time;
+        if (current < 0 || key < (preemptive ? tasks[current].priority : tasks[current].run_time)) current = i;
+      }
+    }
+    now++;
+    if (current >= 0 && --tasks[current].remaining == 0) {
+      tasks[current].finish_time = now;
+      current = -1;
+      done++;
+    }
+  }
+  return now;
+}
+
+/**
+ * Name: randomWorkload
+ * @brief Fills tasks with count random tasks in arrival order.
+ */
+static void randomWorkload(Task *tasks, int count, uint32_t &seed) {
+  uint32_t arrival = 0;
+  uint32_t maxRun = 1 + rand_r(&seed) % 50;
+  uint32_t maxGap = rand_r(&seed) % 80;
+  for (int i = 0; i < count; i++) {
+    if (i > 0) arrival += rand_r(&seed) % (maxGap + 1);
+    tasks[i].task_id = i + 1;
+    tasks[i].run_time = 1 + rand_r(&seed) % maxRun;
+    tasks[i].priority = rand_r(&seed) % 8;
+    tasks[i].arrival_time = arrival;
+  }
+}
+
+/**
+ * Name: checkAgainstStepped
+ * @brief Runs every policy on random workloads and compares run_scheduler with the stepped
+ *      references task by task.
+ * @retval true if every finish_time and makespan matched.
+ */
+static bool checkAgainstStepped() {
+  static const SchedulerPolicy policies[] = { SCHED_ROUND_ROBIN, SCHED_PRIORITY, SCHED_SHORTEST_JOB };
+  static const char *names[] = { "round robin", "priority", "shortest job" };
+  std::vector<Task> tasks(CHECK_MAX_TASKS), reference(CHECK_MAX_TASKS);
+  std::vector<int> ring(CHECK_MAX_TASKS);
+  bool ok = true;
+
+  for (int p = 0; p < 3; p++) {
+    uint32_t seed = 590 + p;
+    int mismatches = 0;
+    for (int w = 0; w < CHECK_WORKLOADS; w++) {
+      int count = 1 + rand_r(&seed) % CHECK_MAX_TASKS;
+      uint32_t quantum = 1 + rand_r(&seed) % 15;
+      randomWorkload(tasks.data(), count, seed);
+      reference = tasks;
+
+      setSchedulerPolicy(policies[p], quantum);
+      run_scheduler(tasks.data(), count, NULL, 0);
+      SchedulerStats stats;
+      getSchedulerStats(&stats);
+      uint32_t makespan = (policies[p] == SCHED_ROUND_ROBIN)
+                              ? steppedRoundRobin(reference.data(), count, quantum, ring)
+                              : steppedByKey(reference.data(), count, policies[p] == SCHED_PRIORITY);
+
+      bool same = stats.makespan == makespan;
+      for (int i = 0; i < count; i++) same = same && tasks[i].finish_time == reference[i].finish_time;
+      if (!same && mismatches++ == 0) {
+        printf("%s: workload %d (%d tasks, quantum %u) differs from the stepped reference\n",
+               names[p], w, count, quantum);
+      }
+    }
+    printf("%-12s %d random workloads, %d differ from the stepped reference\n", names[p], CHECK_WORKLOADS, mismatches);
+    ok = ok && mismatches == 0;
+  }
+  setSchedulerPolicy(SCHED_ROUND_ROBIN, SCHED_DEFAULT_QUANTUM_MS);
+  return ok;
+}
+
+/**
+ * Name: benchTaskCount
+ * @brief Times every policy for count tasks.
+ */
+static void benchTaskCount(int count, std::vector<Task> &tasks, std::vector<uint32_t> &flowchart) {
+  static const SchedulerPolicy policies[] = { SCHED_ROUND_ROBIN, SCHED_PRIORITY, SCHED_SHORTEST_JOB };
+  static const char *names[] = { "run_scheduler round robin, per task",
+                                 "run_scheduler priority, per task",
+                                 "run_scheduler shortest job, per task" };
+  initialize_tasks(tasks.data(), count);
+
+  for (int p = 0; p < 3; p++) {
+    setSchedulerPolicy(policies[p], SCHED_DEFAULT_QUANTUM_MS);
+    double ns = benchNsPerOp([&](size_t n) {
+      for (size_t i = 0; i < n; i++) run_scheduler(tasks.data(), count, flowchart.data(), FLOWCHART_SIZE);
+    }, 1) / count;
+    benchRow(names[p], count, ns);
+  }
+
+  std::vector<int> ring(count);
+  double ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) benchKeep(steppedRoundRobin(tasks.data(), count, SCHED_DEFAULT_QUANTUM_MS, ring));
+  }, 1) / count;
+  benchRow("1 ms stepped round robin, per task", count, ns);
+}
+
+int main() {
+  std::vector<Task> tasks(MAX_TASKS);
+  std::vector<uint32_t> flowchart(FLOWCHART_SIZE);
+
+  bool ok = checkAgainstStepped();
+  printf("\n");
+
+  benchHeader();
+  for (int count = 1000; count <= MAX_TASKS; count *= 4) {
+    benchTaskCount(count, tasks, flowchart);
+  }
+
+  double ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      print_flowchart(flowchart.data(), FLOWCHART_SIZE, MAX_TASKS, tasks.data());
+      printFlush();
+    }
+  }, 20);
+  benchRow("print_flowchart, 8192 entries", MAX_TASKS, ns);
+  return ok ? 0 : 1;
+}
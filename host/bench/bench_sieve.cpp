@@ -0,0 +1,172 @@
+/**
+ * @file bench_sieve.cpp
+ * @brief Throughput and RAM of PrimeSieve against the sketch's trial division.
+ *
+ * @section description Description
+ * Every row finds the primes below N and reports nanoseconds per number in the range.
+ * The trial division row uses isPrime as fixed in the Lab 5 Part 2 sketch (bound
+ * i * i <= n) and is only run up to 10^6. The split rows give each host thread its
+ * own PrimeSieve over a splitPoint share, as the sketch does with the two ESP32 cores.
+ * RAM is the memory one PrimeSieve holds for the range.
+ *
+ * Before timing, PrimeSieve is checked against isPrime: the primes listed by forEachPrime
+ * and the result of count() must match on CHECK_RANGES random ranges below CHECK_LIMIT
+ * and on every range with both ends in 0..CHECK_EDGE. pi(10^7) must be 664579, and every
+ * split row must find as many primes as the single sieve. Any difference makes the bench
+ * exit non-zero.
+ */
+#include <PrimeSieve.h>
+#include "Bench.h"
+
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+#define MAX_RANGE 100000000 ///< Largest N measured
+#define CHECK_RANGES 3000   ///< Random ranges compared with isPrime
+#define CHECK_LIMIT 2000000 ///< Random ranges lie below this
+#define CHECK_EDGE 8        ///< Ranges with both ends up to this are all compared
+#define PI_10_7 664579      ///< Primes below 10^7
+
+static bool splitOk = true; ///< Every split count matched the single sieve
+
+/**
+ * Name: isPrime
+ * @brief The sketch's trial division.
+ */
+static bool isPrime(int n) {
+  if (n <= 1) return false;
+  for (int i = 2; i * i <= n; i++) {
+    if (n % i == 0) return false;
+  }
+  return true;
+}
+
+/**
+ * Name: sieveCount
+ * @brief Primes in [low, high), listed one by one as the sketch does.
+ */
+static uint32_t sieveCount(uint32_t low, uint32_t high) {
+  PrimeSieve sieve(low, high);
+  uint32_t count = 0;
+  while (sieve.nextSegment()) {
+    sieve.forEachPrime([&](uint32_t p) { count++; benchKeep(p); });
+  }
+  return count;
+}
+
+/**
+ * Name: splitCount
+ * @brief sieveCount over threads parts of [0, range), one host thread each.
+ */
+static uint32_t splitCount(uint32_t range, int threads) {
+  std::vector<std::thread> workers;
+  std::vector<uint32_t> counts(threads);
+  for (int t = 0; t < threads; t++) {
+    uint32_t low = PrimeSieve::splitPoint(0, range, t, threads);
+    uint32_t high = PrimeSieve::splitPoint(0, range, t + 1, threads);
+    workers.emplace_back([&counts, t, low, high] { counts[t] = sieveCount(low, high); });
+  }
+  uint32_t total = 0;
+  for (int t = 0; t < threads; t++) {
+    workers[t].join();
+    total += counts[t];
+  }
+  return total;
+}
+
+/**
+ * Name: checkRange
+ * @brief Compares the primes PrimeSieve lists in [low, high), and its count(), with the table.
+ */
+static bool checkRange(uint32_t low, uint32_t high, const std::vector<bool> &prime) {
+  std::vector<uint32_t> listed;
+  PrimeSieve sieve(low, high);
+  while (sieve.nextSegment()) {
+    sieve.forEachPrime([&](uint32_t p) { listed.push_back(p); });
+  }
+  std::vector<uint32_t> expected;
+  for (uint32_t k = low; k < high; k++) {
+    if (prime[k]) expected.push_back(k);
+  }
+  PrimeSieve counter(low, high);
+  uint32_t counted = counter.count();
+  if (listed == expected && counted == expected.size()) return true;
+  printf("  [%u, %u): listed %zu primes, counted %u, isPrime finds %zu\n", low, high, listed.size(), counted,
+         expected.size());
+  return false;
+}
+
+/**
+ * Name: checkAgainstIsPrime
+ * @retval true if every range matched and pi(10^7) is right.
+ */
+static bool checkAgainstIsPrime() {
+  std::vector<bool> prime(CHECK_LIMIT);
+  for (uint32_t k = 0; k < CHECK_LIMIT; k++) prime[k] = isPrime((int)k);
+
+  int bad = 0;
+  for (uint32_t low = 0; low <= CHECK_EDGE; low++) {
+    for (uint32_t high = low; high <= CHECK_EDGE; high++) bad += !checkRange(low, high, prime);
+  }
+  uint32_t seed = 2025;
+  for (int r = 0; r < CHECK_RANGES; r++) {
+    uint32_t length = (r % 2 == 0) ? rand_r(&seed) % 200 : rand_r(&seed) % 200000;
+    uint32_t low = rand_r(&seed) % (CHECK_LIMIT - length);
+    bad += !checkRange(low, low + length, prime);
+  }
+  uint32_t pi = sieveCount(0, 10000000);
+  printf("%d random and %d edge ranges checked against isPrime, %d differ; pi(10^7) = %u%s\n", CHECK_RANGES,
+         (CHECK_EDGE + 1) * (CHECK_EDGE + 2) / 2, bad, pi, pi == PI_10_7 ? "" : " (WRONG)");
+  return bad == 0 && pi == PI_10_7;
+}
+
+/**
+ * Name: benchRange
+ * @brief Times every method for the primes below range.
+ */
+static void benchRange(uint32_t range) {
+  uint32_t primes = 0;
+  double ns;
+  if (range <= 1000000) {
+    ns = benchNsPerOp([&](size_t n) {
+      for (size_t i = 0; i < n; i++) {
+        primes = 0;
+        for (uint32_t k = 0; k < range; k++) primes += isPrime((int)k);
+        benchKeep(primes);
+      }
+    }, 1) / range;
+    benchRow("trial division, per number", range, ns);
+  }
+
+  ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) primes = sieveCount(0, range);
+  }, 1) / range;
+  benchRow("PrimeSieve, per number", range, ns);
+
+  for (int threads = 2; threads <= 4; threads *= 2) {
+    uint32_t split = 0;
+    ns = benchNsPerOp([&](size_t n) {
+      for (size_t i = 0; i < n; i++) split = splitCount(range, threads);
+    }, 1) / range;
+    benchRow(threads == 2 ? "PrimeSieve 2 threads, per number" : "PrimeSieve 4 threads, per number", range, ns);
+    if (split != primes) {
+      printf("  split count %u differs from %u\n", split, primes);
+      splitOk = false;
+    }
+  }
+
+  PrimeSieve sieve(0, range);
+  printf("  %u primes, %zu bytes RAM per sieve\n", primes, sieve.ramBytes());
+}
+
+int main() {
+  bool ok = checkAgainstIsPrime();
+  printf("\n");
+
+  benchHeader();
+  for (uint32_t range = 5000; range <= MAX_RANGE; range *= (range == 5000) ? 200 : 10) {
+    benchRange(range);
+  }
+  return ok && splitOk ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file bench_spsc.cpp
+ * @brief Stress test and throughput benchmark for the SPSC circular buffer.
+ *
+ * @section description Description
+ * - Single thread: CircularBuffer (writeBuffer/popBuffer) against SpscCircularBuffer.
+ * - Two threads: one producer and one consumer on SpscCircularBuffer, checking that
+ *   every value arrives exactly once and in order.
+ * Exits non-zero if an ordering check fails.
+ */
+#include "590Lab3.h"
+#include "Arduino.h"
+#include "Bench.h"
+
+#include <thread>
+
+#define OPS 2000000          ///< Elements moved per single-thread run
+#define STRESS_OPS 20000000  ///< Elements moved per two-thread run
+
+/**
+ * Name: benchCircularBuffer
+ * @brief Fills and drains a CircularBuffer of the given size through the existing functions.
+ * @return million elements per second.
+ */
+static double benchCircularBuffer(size_t size) {
+  CircularBuffer cb;
+  initBuffer(&cb, size);
+  long long sum = 0;
+
+  double start = benchNowSeconds();
+  for (size_t done = 0; done < OPS; done += size) {
+    for (size_t i = 0; i < size; i++) writeBuffer(&cb, (int)i);
+    for (size_t i = 0; i < size; i++) sum += popBuffer(&cb);
+  }
+  double elapsed = benchNowSeconds() - start;
+
+  freeBuffer(&cb);
+  if (sum < 0) printf("unexpected sum\n");
+  return OPS / elapsed / 1e6;
+}
+
+/**
+ * Name: benchSpscSingle
+ * @brief Fills and drains an SpscCircularBuffer of the given size on one thread.
+ * @return million elements per second.
+ */
+static double benchSpscSingle(size_t size) {
+  SpscCircularBuffer cb;
+  initSpscBuffer(&cb, size);
+  long long sum = 0;
+  int value;
+
+  double start = benchNowSeconds();
+  for (size_t done = 0; done < OPS; done += size) {
+    for (size_t i = 0; i < size; i++) writeSpscBuffer(&cb, (int)i);
+    for (size_t i = 0; i < size; i++) {
+      popSpscBuffer(&cb, &value);
+      sum += value;
+    }
+  }
+  double elapsed = benchNowSeconds() - start;
+
+  freeSpscBuffer(&cb);
+  if (sum < 0) printf("unexpected sum\n");
+  return OPS / elapsed / 1e6;
+}
+
+/**
+ * Name: stressSpsc
+ * @brief Producer thread writes 0..STRESS_OPS-1, consumer checks they arrive in order.
+ * @param size buffer capacity.
+ * @param mops million elements per second achieved.
+ * @retval true if every element arrived exactly once and in order.
+ */
+static bool stressSpsc(size_t size, double *mops) {
+  SpscCircularBuffer cb;
+  initSpscBuffer(&cb, size);
+  bool ok = true;
+
+  double start = benchNowSeconds();
+  std::thread producer([&cb]() {
+    for (int i = 0; i < STRESS_OPS; i++) {
+      while (!writeSpscBuffer(&cb, i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  int expected = 0;
+  int value;
+  while (expected < STRESS_OPS) {
+    if (!popSpscBuffer(&cb, &value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (value != expected) {
+      printf("  order violation: expected %d, got %d\n", expected, value);
+      ok = false;
+      break;
+    }
+    expected++;
+  }
+  producer.join();
+  *mops = STRESS_OPS / (benchNowSeconds() - start) / 1e6;
+
+  if (ok && !isSpscEmpty(&cb)) {
+    printf("  buffer not empty after drain\n");
+    ok = false;
+  }
+  freeSpscBuffer(&cb);
+  return ok;
+}
+
+int main() {
+  static const size_t sizes[] = {5, 64, 1024};
+  bool ok = true;
+
+  printf("%-28s %8s %12s\n", "benchmark", "size", "Melem/s");
+  for (size_t size : sizes) {
+    printf("%-28s %8zu %12.2f\n", "CircularBuffer 1 thread", size, benchCircularBuffer(size));
+    printf("%-28s %8zu %12.2f\n", "SpscCircularBuffer 1 thread", size, benchSpscSingle(size));
+  }
+  for (size_t size : sizes) {
+    double mops = 0;
+    bool passed = stressSpsc(size, &mops);
+    ok = ok && passed;
+    printf("%-28s %8zu %12.2f %s\n", "SpscCircularBuffer 2 thread", size, mops, passed ? "ok" : "FAILED");
+  }
+  printf("serial bytes discarded: %zu\n", Serial.bytesWritten);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+/**
+ * @file bench_stats.cpp
+ * @brief Per-sample cost of the WindowedStats components as the window grows.
+ *
+ * @section description Description
+ * Each component is fed a pseudo random 12 bit LDR-like signal. The per-sample cost
+ * should stay flat from W = 5 up to W = 4096; the naive rows recompute the window
+ * mean the way a plain loop over the window would, for comparison.
+ *
+ * First, every component is checked against a brute-force reference recomputed from
+ * the last W samples after each add, on random streams of several shapes: wide values,
+ * a narrow range full of ties, and long rising and falling runs, for W = 1, 5 and 64 so
+ * the window wraps many times. Percentiles are checked at ranks 0, 1, 50, 99 and 100
+ * with samples outside the histogram range, and the EWMA against the exact recurrence.
+ * Exits non-zero on any mismatch.
+ */
+#include <WindowedStats.h>
+#include "Bench.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+#define SAMPLES 1000000 ///< Samples fed per run
+#define CHECK_SAMPLES 20000 ///< Samples per stream in the reference checks
+#define CHECK_LO (-50)      ///< Percentile histogram range of the checks; streams go past it
+#define CHECK_HI 1000
+
+/**
+ * Name: makeSignal
+ * @brief Deterministic 12 bit test signal.
+ */
+static std::vector<int32_t> makeSignal() {
+  std::vector<int32_t> signal(SAMPLES);
+  uint32_t state = 12345;
+  for (size_t i = 0; i < SAMPLES; i++) {
+    state = state * 1664525u + 1013904223u;
+    signal[i] = 2048 + (int32_t)(i % 400) - 200 + (int32_t)((state >> 20) & 0xFF);
+  }
+  return signal;
+}
+
+/**
+ * Name: checkStream
+ * @brief Test stream of one shape: 0 wide random, 1 narrow with ties, 2 rising and
+ *      falling runs with repeats.
+ */
+static std::vector<int32_t> checkStream(int shape, uint32_t seed) {
+  std::vector<int32_t> stream(CHECK_SAMPLES);
+  int32_t level = 0, step = 1;
+  for (size_t i = 0; i < stream.size(); i++) {
+    uint32_t r = (uint32_t)rand_r(&seed);
+    if (shape == 0) {
+      stream[i] = (int32_t)(r % 1600) - 300;
+    } else if (shape == 1) {
+      stream[i] = (int32_t)(r % 4);
+    } else {
+      if (r % 97 == 0) step = -step;
+      if (r % 3 != 0) level += step;  // a third of the samples repeat the last one
+      stream[i] = level;
+    }
+  }
+  return stream;
+}
+
+/**
+ * Name: refStddev
+ * @brief floor(sqrt(spread / n^3)), spread being the sum of (n * x - sum)^2: the
+ *      population standard deviation rounded down.
+ */
+static uint32_t refStddev(__int128 spread, int64_t n) {
+  __int128 n3 = (__int128)n * n * n;
+  uint64_t root = (uint64_t)sqrtl((long double)spread / (long double)n3);
+  while (root > 0 && (__int128)root * root * n3 > spread) root--;
+  while ((__int128)(root + 1) * (root + 1) * n3 <= spread) root++;
+  return (uint32_t)root;
+}
+
+/**
+ * Name: checkWindow
+ * @brief Every component of a StreamStats<W, BINS> against the last W samples, after every add.
+ * @retval mismatches found.
+ */
+template <size_t W, size_t BINS>
+static long checkWindow(const std::vector<int32_t> &stream, uint32_t alphaQ16) {
+  static const uint32_t ranks[] = {0, 1, 50, 99, 100};
+  StreamStats<W, BINS> stats(CHECK_LO, CHECK_HI, alphaQ16);
+  WindowedMoments<W> moments;
+  WindowedMinMax<W> range;
+  Ewma ewma(alphaQ16);
+  WindowedPercentile<W, BINS> pct(CHECK_LO, CHECK_HI);
+  int32_t width = (int32_t)(((int64_t)CHECK_HI - CHECK_LO + 1 + BINS - 1) / BINS);
+  long double ref = 0, alpha = alphaQ16 / 65536.0L;
+  long double ewmaBound = 1.0L / alpha + 1;  // truncation per step, in Q16 units, summed geometrically
+  std::vector<int32_t> sorted;
+  long bad = 0;
+
+  for (size_t i = 0; i < stream.size(); i++) {
+    int32_t x = stream[i];
+    stats.add(x);
+    moments.add(x);
+    range.add(x);
+    ewma.add(x);
+    pct.add(x);
+    ref = (i == 0) ? x : ref + alpha * (x - ref);
+
+    size_t first = (i + 1 > W) ? i + 1 - W : 0;
+    int64_t n = (int64_t)(i + 1 - first), sum = 0;
+    for (size_t k = first; k <= i; k++) sum += stream[k];
+    __int128 spread = 0;
+    for (size_t k = first; k <= i; k++) {
+      __int128 d = (__int128)n * stream[k] - sum;
+      spread += d * d;
+    }
+    int32_t mean = (int32_t)llroundl((long double)sum / n);
+    uint32_t variance = (n < 2) ? 0 : (uint32_t)((spread / n + (__int128)n * n / 2) / ((__int128)n * n));
+    uint32_t stddev = (n < 2) ? 0 : refStddev(spread, n);
+    bad += moments.count() != (size_t)n || moments.sum() != sum || moments.mean() != mean ||
+           moments.meanQ8() != (int32_t)llroundl((long double)sum * 256 / n) ||
+           moments.variance() != variance || moments.stddev() != stddev;
+
+    sorted.assign(stream.begin() + first, stream.begin() + i + 1);
+    std::sort(sorted.begin(), sorted.end());
+    bad += range.min() != sorted.front() || range.max() != sorted.back();
+
+    bad += fabsl((long double)ewma.valueQ16() - ref * 65536) > ewmaBound;
+
+    for (uint32_t p : ranks) {
+      size_t rank = ((size_t)n * p + 99) / 100;
+      int32_t v = sorted[rank == 0 ? 0 : rank - 1];
+      int32_t bin = (v < CHECK_LO) ? 0 : (v - CHECK_LO) / width;
+      if (bin >= (int32_t)BINS) bin = BINS - 1;
+      bad += pct.percentile(p) != CHECK_LO + bin * width + width / 2;
+    }
+
+    bad += stats.moments.mean() != moments.mean() || stats.moments.variance() != moments.variance() ||
+           stats.range.min() != range.min() || stats.range.max() != range.max() ||
+           stats.ewma.valueQ16() != ewma.valueQ16() || stats.percentiles.median() != pct.median();
+  }
+  return bad;
+}
+
+/**
+ * Name: checkAgainstBruteForce
+ * @brief checkWindow for W = 1, 5 and 64 on every stream shape.
+ * @retval true if nothing differed.
+ */
+static bool checkAgainstBruteForce() {
+  static const char *const shapes[] = {"wide", "ties", "runs"};
+  bool ok = true;
+  for (int shape = 0; shape < 3; shape++) {
+    std::vector<int32_t> stream = checkStream(shape, 707 + shape);
+    long bad[3] = {
+      checkWindow<1, 8>(stream, 65536),
+      checkWindow<5, 16>(stream, 65536 / 16),
+      checkWindow<64, 64>(stream, 65536 / 8 + 3),
+    };
+    printf("%-5s stream, %d samples: W=1 %ld, W=5 %ld, W=64 %ld mismatches against the brute-force window\n",
+           shapes[shape], CHECK_SAMPLES, bad[0], bad[1], bad[2]);
+    ok = ok && bad[0] == 0 && bad[1] == 0 && bad[2] == 0;
+  }
+  return ok;
+}
+
+/**
+ * Name: benchWindow
+ * @brief Times every component for one window length.
+ */
+template <size_t W>
+static void benchWindow(const std::vector<int32_t> &signal) {
+  WindowedMoments<W> moments;
+  double ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) moments.add(signal[i]);
+    benchKeep(moments.mean());
+  }, SAMPLES);
+  benchRow("WindowedMoments add", W, ns);
+
+  WindowedMinMax<W> range;
+  ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) range.add(signal[i]);
+    benchKeep(range.max());
+  }, SAMPLES);
+  benchRow("WindowedMinMax add", W, ns);
+
+  WindowedPercentile<W, 64> pct(0, 4095);
+  ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) pct.add(signal[i]);
+    benchKeep(pct.median());
+  }, SAMPLES);
+  benchRow("WindowedPercentile<64 bins> add", W, ns);
+
+  StreamStats<W, 64> all(0, 4095);
+  ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      all.add(signal[i]);
+      benchKeep(all.moments.mean());
+    }
+  }, SAMPLES);
+  benchRow("StreamStats add + mean", W, ns);
+
+  std::vector<int32_t> window(W, 0);
+  ns = benchNsPerOp([&](size_t n) {
+    size_t pos = 0;
+    for (size_t i = 0; i < n; i++) {
+      window[pos] = signal[i];
+      pos = (pos + 1 == W) ? 0 : pos + 1;
+      int64_t sum = 0;
+      for (size_t k = 0; k < W; k++) sum += window[k];
+      benchKeep(sum / (int64_t)W);
+    }
+  }, SAMPLES / 10);
+  benchRow("naive window mean per sample", W, ns);
+}
+
+int main() {
+  bool ok = checkAgainstBruteForce();
+  printf("\n");
+
+  std::vector<int32_t> signal = makeSignal();
+  benchHeader();
+
+  Ewma ewma(65536 / 16);
+  double ns = benchNsPerOp([&](size_t n) {
+    for (size_t i = 0; i < n; i++) ewma.add(signal[i]);
+    benchKeep(ewma.value());
+  }, SAMPLES);
+  benchRow("Ewma add", 0, ns);
+
+  benchWindow<5>(signal);
+  benchWindow<64>(signal);
+  benchWindow<1024>(signal);
+  benchWindow<4096>(signal);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,305 @@
+/**
+ * @file bench_tcb.cpp
+ * @brief Per-tick cost of the Lab 4 TCB scheduler core as the task count grows.
+ *
+ * @section description Description
+ * Every task runs for TICKS_PER_TASK scheduler ticks and then completes; when all are
+ * done a new round is released, as in the sketch. The linear rows replay the sketch's
+ * original scheduler(): scan TaskList from baseTaskIndex for a ready task, then scan it
+ * again for allDone on every tick. The core rows use tcbDispatch/tcbComplete and the
+ * kept active count, and should stay flat from 4 to TCB_MAX_TASKS tasks.
+ *
+ * First the core is checked, with a non-zero exit on any failure:
+ * - dispatch order: random sets of tasks run several rounds, each dispatched task
+ *   completing at once. Every round must run the lowest priority value first and, within
+ *   a priority, registration order starting one task later each round. A running task
+ *   must be returned again by tcbDispatch until it completes.
+ * - stale handles: a full pool is unregistered in random order and registered again, so
+ *   every slot is reused. Each old handle must then be refused by tcbGet, tcbUnregister,
+ *   tcbSetReady and tcbSetPriority, and tcbSlot(tcbGet()) of it must be -1.
+ * - task profile: the TaskProfile the sketch's scheduler() feeds is given dispatches of
+ *   known length, on both sides of the histogram's bucket edges, of the deadline and of a
+ *   timer wrap. Its dump lines must match the ones worked out by hand.
+ */
+#include "TCBScheduler.h"
+#include "TaskProfile.h"
+#include "Bench.h"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#define TICKS_PER_TASK 3       ///< Ticks each task stays running per round
+#define BENCH_TICKS    2000000 ///< Scheduler ticks per run
+#define CHECK_SETS     500     ///< Random task sets in the dispatch order check
+
+static int ticksLeft[TCB_MAX_TASKS]; ///< Remaining ticks this round, per slot or index
+
+// =========== Original linear scheduler ===========
+
+static TCBStruct linearList[TCB_MAX_TASKS];
+static int linearCount = 0;
+static int linearBase = 0;
+static int linearRunning = -1;
+
+static void linearTask(void *p) {
+  int idx = (int)(intptr_t)p;
+  if (--ticksLeft[idx] == 0) {
+    linearList[idx].state = STATE_INACTIVE;
+    linearRunning = -1;
+  }
+}
+
+static void linearReset() {
+  for (int i = 0; i < linearCount; i++) {
+    linearList[i].state = STATE_READY;
+    ticksLeft[i] = TICKS_PER_TASK;
+  }
+  linearRunning = -1;
+}
+
+/**
+ * Name: linearScheduler
+ * @brief The sketch's original scheduler() without its Serial output.
+ */
+static void linearScheduler() {
+  if (linearRunning == -1) {
+    for (int i = 0; i < linearCount; i++) {
+      int idx = (linearBase + i) % linearCount;
+      if (linearList[idx].state == STATE_READY) {
+        linearList[idx].state = STATE_RUNNING;
+        linearRunning = idx;
+        linearList[idx].ftpr(linearList[idx].arg_ptr);
+        linearList[idx].priority = i + 1;
+        break;
+      }
+    }
+  } else {
+    linearList[linearRunning].ftpr(linearList[linearRunning].arg_ptr);
+  }
+
+  bool allDone = true;
+  for (int i = 0; i < linearCount; i++) {
+    if (linearList[i].state != STATE_INACTIVE) {
+      allDone = false;
+      break;
+    }
+  }
+  if (allDone) {
+    linearBase = (linearBase + 1) % linearCount;
+    linearReset();
+  }
+}
+
+// =========== Scheduler core ===========
+
+static TCBHandle coreHandles[TCB_MAX_TASKS];
+
+static void coreTask(void *p) {
+  int idx = (int)(intptr_t)p;
+  if (--ticksLeft[idx] == 0) {
+    tcbComplete(tcbCurrent());
+  }
+}
+
+static void coreScheduler(int count) {
+  TCBStruct *current = tcbDispatch();
+  if (current != NULL) current->ftpr(current->arg_ptr);
+  if (tcbActiveCount() == 0) {
+    for (int i = 0; i < count; i++) ticksLeft[i] = TICKS_PER_TASK;
+    tcbReleaseAll();
+  }
+}
+
+// =========== Checks ===========
+
+static void checkTask(void *p) { (void)p; }
+
+/**
+ * Name: checkDispatchOrder
+ * @brief Random task sets against the order worked out from their priorities and the turn.
+ * @retval true if every round ran in the expected order.
+ */
+static bool checkDispatchOrder() {
+  uint32_t seed = 404;
+  int badRounds = 0, rounds = 0;
+  bool heldOk = true;
+  for (int set = 0; set < CHECK_SETS; set++) {
+    tcbClear();
+    int count = 1 + rand_r(&seed) % TCB_MAX_TASKS;
+    int levels = 1 + rand_r(&seed) % 4;  // few levels, so most priorities are shared
+    std::vector<int> priority(count), slotTask(TCB_MAX_TASKS, -1);
+    for (int i = 0; i < count; i++) {
+      priority[i] = rand_r(&seed) % levels * 7;
+      slotTask[tcbSlot(tcbGet(tcbRegister(checkTask, NULL, priority[i])))] = i;
+    }
+
+    for (int round = 0; round < count + 2; round++) {
+      if (round > 0) tcbReleaseAll();
+      std::vector<int> expected(count), ran;
+      for (int j = 0; j < count; j++) expected[j] = (round + j) % count;
+      std::stable_sort(expected.begin(), expected.end(), [&](int a, int b) { return priority[a] < priority[b]; });
+
+      for (TCBStruct *t = tcbDispatch(); t != NULL; t = tcbDispatch()) {
+        heldOk = heldOk && tcbDispatch() == t && tcbCurrent() == t;  // not preempted while running
+        ran.push_back(slotTask[tcbSlot(t)]);
+        tcbComplete(t);
+      }
+      badRounds += ran != expected || tcbActiveCount() != 0;
+      rounds++;
+    }
+  }
+  printf("dispatch order: %d rounds of %d random task sets, %d out of order%s\n", rounds, CHECK_SETS, badRounds,
+         heldOk ? "" : ", a running task was replaced");
+  return badRounds == 0 && heldOk;
+}
+
+/**
+ * Name: checkStaleHandles
+ * @brief Every slot reused once; the handles from before must all be refused.
+ * @retval true if no old handle was accepted and every new one works.
+ */
+static bool checkStaleHandles() {
+  uint32_t seed = 77;
+  tcbClear();
+  std::vector<TCBHandle> old, fresh;
+  for (int i = 0; i < TCB_MAX_TASKS; i++) old.push_back(tcbRegister(checkTask, NULL, i % TCB_PRIORITY_LEVELS));
+  bool full = tcbRegister(checkTask, NULL, 0) == TCB_INVALID_HANDLE;
+
+  std::vector<TCBHandle> order(old);
+  for (size_t i = order.size(); i > 1; i--) std::swap(order[i - 1], order[rand_r(&seed) % i]);
+  bool ok = full;
+  for (TCBHandle h : order) ok = tcbUnregister(h) && ok;
+  for (int i = 0; i < TCB_MAX_TASKS; i++) fresh.push_back(tcbRegister(checkTask, NULL, 0));
+
+  int accepted = 0;
+  for (TCBHandle h : old) {
+    accepted += tcbGet(h) != NULL || tcbSlot(tcbGet(h)) != -1 || tcbUnregister(h) || tcbSetReady(h) ||
+                tcbSetPriority(h, 1) || std::find(fresh.begin(), fresh.end(), h) != fresh.end();
+  }
+  for (TCBHandle h : { (TCBHandle)TCB_INVALID_HANDLE, (TCBHandle)0, (TCBHandle)0x7FFFFFFF }) accepted += tcbGet(h) != NULL;
+  for (TCBHandle h : fresh) ok = ok && tcbGet(h) != NULL && tcbGet(h)->pid == h && tcbSlot(tcbGet(h)) >= 0;
+  ok = ok && tcbTaskCount() == TCB_MAX_TASKS;
+
+  printf("stale handles: %d slots reused, %d old or invalid handles accepted, new handles %s\n", TCB_MAX_TASKS,
+         accepted, ok ? "ok" : "WRONG");
+  return ok && accepted == 0;
+}
+
+/**
+ * @brief Collects profileDump output.
+ */
+struct DumpCapture {
+  std::string text;
+  void print(const char *str) { text += str; }
+};
+
+/**
+ * Name: checkTaskProfile
+ * @brief Known dispatch lengths against the statistics and dump lines worked out by hand.
+ * @retval true if every dump line and every length end() returned is as expected.
+ */
+static bool checkTaskProfile() {
+  // 100 and 101 sit either side of the deadline, 2^22 - 1 and 2^22 either side of the
+  // last bucket's edge. The timer wraps during the 20 us dispatch.
+  static const uint32_t lengths[] = { 0, 1, 2, 3, 4, 7, 8, 100, 101, 4194303, 4194304 };
+  TaskProfile profiles[3];
+  profiles[0].setup("taskA", 100, 4096);
+  bool ok = true;
+  uint32_t now = 5000;
+  for (uint32_t us : lengths) {
+    profiles[0].begin(now);
+    now += us;
+    ok = profiles[0].end(now) == us && ok;
+  }
+  profiles[0].begin(0xFFFFFFF6u);
+  ok = profiles[0].end(0x0000000Au) == 20 && ok;
+  for (uint32_t freeBytes : { 900, 300, 500 }) profiles[0].stackHighWater(freeBytes);
+
+  profiles[1].setup("taskB", PROFILE_UNSET, 2048);
+  profiles[1].record(5);
+  profiles[1].record(4000000000u);  // no deadline, so not an overrun
+  profiles[2].setup("idle");
+
+  // sum 8388853 over 12 dispatches; buckets 0 to 23
+  const std::string expected =
+      "# prof name n min avg max dl over stk h@first=counts (us, stk = least free/size bytes)\n"
+      "prof taskA n=12 min=0 avg=699071 max=4194304 dl=100 over=3 stk=300/4096 "
+      "h@0=1,1,2,2,1,1,0,2,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1\n"
+      "prof taskB n=2 min=5 avg=2000000002 max=4000000000 dl=- over=0 stk=-/2048 "
+      "h@3=1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1\n"
+      "prof idle n=0 min=0 avg=0 max=0 dl=- over=0 stk=-/-\n";
+  DumpCapture dump;
+  profileDump(dump, profiles, 3);
+  bool dumpOk = dump.text == expected;
+  if (!dumpOk) printf("profile dump:\n%sexpected:\n%s", dump.text.c_str(), expected.c_str());
+
+  // a name too long for the line buffer is cut, and the line still ends in a newline
+  TaskProfile longName;
+  const std::string name(200, 'x');
+  longName.setup(name.c_str());
+  longName.record(1);
+  DumpCapture cut;
+  profileDump(cut, &longName, 1);
+  size_t keyEnd = cut.text.find('\n') + 1;
+  bool cutOk = cut.text.size() - keyEnd == 159 && cut.text.back() == '\n' &&
+               cut.text.compare(keyEnd, 5, "prof ") == 0;
+
+  printf("task profile: %u dispatches, bucket edges, overruns and dump lines %s, long line %s\n",
+         (unsigned)profiles[0].count(), ok && dumpOk ? "ok" : "WRONG", cutOk ? "cut ok" : "WRONG");
+  return ok && dumpOk && cutOk;
+}
+
+/**
+ * Name: benchTaskCount
+ * @brief Times both schedulers with count tasks registered.
+ */
+static void benchTaskCount(int count) {
+  linearCount = count;
+  linearBase = 0;
+  for (int i = 0; i < count; i++) {
+    linearList[i] = TCBStruct();
+    linearList[i].ftpr = linearTask;
+    linearList[i].arg_ptr = (void *)(intptr_t)i;
+    linearList[i].pid = i + 1;
+  }
+  linearReset();
+  double ns = benchNsPerOp([](size_t n) {
+    for (size_t i = 0; i < n; i++) linearScheduler();
+  }, BENCH_TICKS);
+  benchRow("linear scan scheduler tick", count, ns);
+
+  tcbClear();
+  for (int i = 0; i < count; i++) {
+    coreHandles[i] = tcbRegister(coreTask, (void *)(intptr_t)i, i % 4);
+    ticksLeft[i] = TICKS_PER_TASK;
+  }
+  ns = benchNsPerOp([count](size_t n) {
+    for (size_t i = 0; i < n; i++) coreScheduler(count);
+  }, BENCH_TICKS);
+  benchRow("ready-queue scheduler tick", count, ns);
+
+  // churn: drop and re-add one task per iteration while the rest stay registered
+  ns = benchNsPerOp([count](size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      int victim = (int)(i % count);
+      tcbUnregister(coreHandles[victim]);
+      coreHandles[victim] = tcbRegister(coreTask, (void *)(intptr_t)victim, victim % 4);
+    }
+  }, BENCH_TICKS);
+  benchRow("unregister + register", count, ns);
+}
+
+int main() {
+  bool ok = checkDispatchOrder();
+  ok = checkStaleHandles() && ok;
+  ok = checkTaskProfile() && ok;
+  printf("\n");
+
+  benchHeader();
+  for (int count = 4; count <= TCB_MAX_TASKS; count *= 2) {
+    benchTaskCount(count);
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,303 @@
+/**
+ * @file bench_timers.cpp
+ * @brief Cost of one loop pass of periodic-job dispatch as the number of jobs grows.
+ *
+ * @section description Description
+ * N jobs with periods between 10 ms and 10 s are run from a loop that passes every
+ * 1 ms for 60 simulated seconds. The polled rows do what the sketches did: keep a
+ * 32 bit last-run time per job and compare every one of them on every pass. The wheel
+ * rows hand the time to SoftTimerWheel::poll, which only touches due jobs, so the
+ * per-pass cost should stay nearly flat as N grows.
+ *
+ * Before timing, the wheel is checked against a brute-force reference that keeps every
+ * deadline in a heap: random starts and stops between polls, callbacks that stop or
+ * restart their own timer, and irregular poll gaps that make periodic timers miss runs.
+ * The timers fired by each poll and the missed count must match; the bench exits
+ * non-zero if they do not. A 1 us tick runs the same check with deadlines beyond the
+ * wheel's span, which are parked and re-parked.
+ */
+#include <SoftTimer.h>
+#include "Bench.h"
+
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+#define PASS_US   1000  ///< Loop period
+#define PASSES    60000 ///< Loop passes per run (60 s)
+#define MAX_JOBS  4096  ///< Largest job count measured
+
+static uint64_t jobRuns = 0; ///< Callback executions, kept so the work is not optimised out
+
+static void job(void *arg) {
+  (void)arg;
+  jobRuns++;
+}
+
+/**
+ * Name: makePeriods
+ * @brief Deterministic job periods in microseconds, multiples of 1 ms from 10 ms to 10 s.
+ */
+static std::vector<uint32_t> makePeriods(size_t count) {
+  std::vector<uint32_t> periods(count);
+  uint32_t state = 2025;
+  for (size_t i = 0; i < count; i++) {
+    state = state * 1664525u + 1013904223u;
+    periods[i] = 10000 + (state >> 8) % 9990 * 1000;
+  }
+  return periods;
+}
+
+#define CHECK_TIMERS 64       ///< Timers in the reference check
+#define CHECK_POLLS  400000   ///< Polls per reference check
+
+/**
+ * Name: checkRandom
+ * @brief Deterministic 32 bit hash, so both wheels make the same choices.
+ */
+static uint32_t checkRandom(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+/**
+ * @brief Brute-force wheel: one deadline per timer, due timers taken from a heap in deadline order.
+ */
+struct RefWheel {
+  struct Due {
+    uint64_t deadline;
+    int id;
+    uint32_t generation;
+    bool operator>(const Due &o) const { return deadline > o.deadline; }
+  };
+  uint32_t tickUs;
+  uint64_t target = 0;   ///< Tick of the last poll
+  uint64_t current = 0;  ///< First tick not yet run
+  uint64_t missed = 0;
+  std::vector<uint64_t> deadline;
+  std::vector<uint32_t> period;
+  std::vector<uint32_t> generation;  ///< Bumped on every start/stop; older heap entries are stale
+  std::vector<bool> armed;
+  std::priority_queue<Due, std::vector<Due>, std::greater<Due>> heap;
+
+  RefWheel(uint32_t tick, size_t count)
+      : tickUs(tick), deadline(count), period(count), generation(count), armed(count) {}
+
+  /**
+   * Name: start
+   * @brief As SoftTimerWheel::start. firedTick is the tick of the running callback, or
+   *      UINT64_MAX outside poll().
+   */
+  void start(int id, uint32_t delayUs, uint32_t periodUs, uint64_t firedTick = UINT64_MAX) {
+    uint64_t due = target + (delayUs + tickUs - 1) / tickUs;
+    uint64_t first = (firedTick == UINT64_MAX) ? current : firedTick + 1;
+    deadline[id] = std::max(due, first);
+    uint32_t ticks = (periodUs + tickUs / 2) / tickUs;
+    period[id] = (periodUs == 0) ? 0 : (ticks ? ticks : 1);
+    armed[id] = true;
+    heap.push({deadline[id], id, ++generation[id]});
+  }
+
+  void stop(int id) {
+    armed[id] = false;
+    generation[id]++;
+  }
+
+  /**
+   * Name: poll
+   * @brief Fires due timers in deadline order; onFire(id, tick) may start or stop id.
+   */
+  template <typename OnFire>
+  void poll(uint64_t nowUs, OnFire onFire) {
+    target = nowUs / tickUs;
+    while (!heap.empty() && heap.top().deadline <= target) {
+      Due d = heap.top();
+      heap.pop();
+      if (!armed[d.id] || d.generation != generation[d.id]) continue;
+      if (period[d.id] != 0) {
+        uint64_t next = d.deadline + period[d.id];
+        if (next <= target) {
+          uint64_t late = (target - next) / period[d.id] + 1;
+          next += late * period[d.id];
+          missed += late;
+        }
+        deadline[d.id] = next;
+        heap.push({next, d.id, ++generation[d.id]});
+      } else {
+        armed[d.id] = false;
+      }
+      onFire(d.id, d.deadline);
+    }
+    current = std::max(current, target + 1);
+  }
+};
+
+/**
+ * @brief What the timer under test did, shared by the callbacks of one check.
+ */
+struct CheckState {
+  SoftTimerWheel<CHECK_TIMERS> *wheel;
+  std::vector<int> fired;        ///< Ids fired by the current poll
+  std::vector<uint32_t> fires;   ///< Firings so far per timer
+};
+
+/**
+ * Name: callbackAction
+ * @brief What a callback does on the n-th firing of timer id: 0 nothing, 1 stop,
+ *      2 restart with the delay and period returned through delayUs and periodUs.
+ */
+static int callbackAction(int id, uint32_t n, uint32_t tickUs, uint32_t &delayUs, uint32_t &periodUs) {
+  uint32_t r = checkRandom((uint32_t)id * 2654435761u + n);
+  switch (r & 15) {
+  case 0:
+    return 1;
+  case 1:
+  case 2:
+    delayUs = (r >> 4) % 4 == 0 ? 0 : (r >> 8) % (200 * tickUs);
+    periodUs = (r >> 6) % 3 == 0 ? 0 : tickUs + (r >> 12) % (100 * tickUs);
+    return 2;
+  default:
+    return 0;
+  }
+}
+
+static CheckState *checkState = NULL;
+
+static void checkCallback(void *arg) {
+  int id = (int)(intptr_t)arg;
+  CheckState &st = *checkState;
+  st.fired.push_back(id);
+  uint32_t delayUs = 0, periodUs = 0;
+  int action = callbackAction(id, st.fires[id]++, st.wheel->tickUs(), delayUs, periodUs);
+  if (action == 1) st.wheel->stop(id);
+  if (action == 2) st.wheel->start(id, delayUs, periodUs);
+}
+
+/**
+ * Name: checkAgainstReference
+ * @brief Runs the wheel and RefWheel through the same random script.
+ * @param tickUs wheel tick.
+ * @param maxDelayUs largest delay and period given to start() between polls.
+ * @param farDelayUs largest delay of the one start in eight that may go far out.
+ * @param maxGapUs largest of the long gaps between polls, one poll in longEvery.
+ * @retval true if every poll fired the same timers and the missed counts agree.
+ */
+static bool checkAgainstReference(uint32_t tickUs, uint32_t maxDelayUs, uint32_t farDelayUs, uint32_t maxGapUs,
+                                  uint32_t longEvery) {
+  SoftTimerWheel<CHECK_TIMERS> *wheel = new SoftTimerWheel<CHECK_TIMERS>(tickUs);
+  RefWheel ref(tickUs, CHECK_TIMERS);
+  CheckState st;
+  st.wheel = wheel;
+  st.fires.assign(CHECK_TIMERS, 0);
+  checkState = &st;
+  std::vector<uint32_t> refFires(CHECK_TIMERS, 0);
+
+  wheel->begin(0);
+  for (int i = 0; i < CHECK_TIMERS; i++) wheel->create(checkCallback, (void *)(intptr_t)i);
+
+  uint64_t now = 0, firings = 0;
+  uint32_t seed = tickUs;
+  bool ok = true;
+  for (uint32_t p = 0; p < CHECK_POLLS && ok; p++) {
+    // a few starts and stops between polls
+    uint32_t r = checkRandom(seed++);
+    for (uint32_t k = 0; k < (r & 3); k++) {
+      uint32_t q = checkRandom(seed++);
+      int id = (int)(q % CHECK_TIMERS);
+      if ((q >> 8) % 5 == 0) {
+        wheel->stop(id);
+        ref.stop(id);
+      } else {
+        uint32_t delayUs = checkRandom(seed++) % ((q >> 16) % 8 == 0 ? farDelayUs : maxDelayUs);
+        uint32_t periodUs = (q >> 12) % 4 == 0 ? 0 : checkRandom(seed++) % maxDelayUs;
+        wheel->start(id, delayUs, periodUs);
+        ref.start(id, delayUs, periodUs);
+      }
+    }
+
+    // mostly short gaps, now and then a long one
+    r = checkRandom(seed++);
+    now += (r % longEvery == 0) ? (r >> 8) % maxGapUs : r % (4 * tickUs + 1);
+
+    st.fired.clear();
+    wheel->poll(now);
+    std::vector<int> expected;
+    ref.poll(now, [&](int id, uint64_t tick) {
+      expected.push_back(id);
+      uint32_t delayUs = 0, periodUs = 0;
+      int action = callbackAction(id, refFires[id]++, tickUs, delayUs, periodUs);
+      if (action == 1) ref.stop(id);
+      if (action == 2) ref.start(id, delayUs, periodUs, tick);
+    });
+
+    // timers due on the same tick may fire in any order
+    std::sort(st.fired.begin(), st.fired.end());
+    std::sort(expected.begin(), expected.end());
+    if (st.fired != expected || wheel->missed() != (uint32_t)ref.missed) {
+      printf("tick %u us: poll %u at %llu us fired %zu timers, reference %zu; missed %u, reference %llu\n",
+             tickUs, p, (unsigned long long)now, st.fired.size(), expected.size(), wheel->missed(),
+             (unsigned long long)ref.missed);
+      ok = false;
+    }
+    firings += expected.size();
+  }
+  printf("tick %u us: %llu firings over %llu ticks, %llu missed, %s\n", tickUs, (unsigned long long)firings,
+         (unsigned long long)(now / tickUs), (unsigned long long)ref.missed, ok ? "matches the reference" : "MISMATCH");
+  checkState = NULL;
+  delete wheel;
+  return ok;
+}
+
+/**
+ * Name: benchJobCount
+ * @brief Times both dispatch styles for count jobs.
+ */
+static void benchJobCount(size_t count) {
+  std::vector<uint32_t> periods = makePeriods(count);
+
+  std::vector<uint32_t> last(count);
+  double ns = benchNsPerOp([&](size_t passes) {
+    for (size_t i = 0; i < count; i++) last[i] = 0;
+    uint32_t now = 0;
+    for (size_t p = 0; p < passes; p++) {
+      now += PASS_US;
+      for (size_t i = 0; i < count; i++) {
+        if (now - last[i] > periods[i]) {
+          job(NULL);
+          last[i] = now;
+        }
+      }
+    }
+  }, PASSES);
+  benchRow("polled 32 bit timers, per pass", (long)count, ns);
+
+  ns = benchNsPerOp([&](size_t passes) {
+    SoftTimerWheel<MAX_JOBS> *wheel = new SoftTimerWheel<MAX_JOBS>(1000);  // too big for the stack
+    wheel->begin(0);
+    for (size_t i = 0; i < count; i++) wheel->every(periods[i], job, NULL);
+    uint64_t now = 0;
+    for (size_t p = 0; p < passes; p++) {
+      now += PASS_US;
+      wheel->poll(now);
+    }
+    delete wheel;
+  }, PASSES);
+  benchRow("SoftTimerWheel poll, per pass", (long)count, ns);
+}
+
+int main() {
+  bool ok = checkAgainstReference(1000, 300000, 20000000, 2000000, 256);
+  ok = checkAgainstReference(1, 20000, 4000000000u, 40000000, 4096) && ok;
+  printf("\n");
+
+  benchHeader();
+  for (size_t count = 4; count <= MAX_JOBS; count *= 4) {
+    benchJobCount(count);
+  }
+  benchKeep(jobRuns);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file Arduino.h
+ * @brief Host stand-in for the parts of the Arduino core used by the lab libraries.
+ *
+ * @section description Description
+ * Lets the sketch-folder .cpp files build with the host compiler.
+ * - Serial output is counted, and captured to memory when Serial.capture is set.
+ * - analogRead returns values scripted per pin with hostSetAnalogScript.
+ * - micros/millis/delay run on a virtual clock that only moves through
+ *   hostAdvanceMicros (or delay), and drives the simulated timer group registers.
+ * - digitalWrite/ledcWrite keep the last level per pin.
+ * - With hostSetSerialBaud, Serial drains a TX FIFO at the line rate and a write
+ *   that does not fit blocks on the virtual clock, like the ESP32 UART driver.
+ * - Serial input is scripted with hostSerialReceive and arrives at its line rate.
+ * - Every pin, Serial, and (through Wire) I2C write is reported to the hook set
+ *   with hostSetOutputHook, stamped with the virtual time.
+ * - Every delay and delayMicroseconds is reported to the hook set with hostSetDelayHook
+ *   before the clock moves, so a simulator can tell where the sketch waits.
+ */
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#define IRAM_ATTR ///< No IRAM placement on the host
+
+#define HOST_ANALOG_PINS 64 ///< Pins that can be scripted
+#define HOST_DIGITAL_PINS 64 ///< Pins whose output level is tracked
+
+#define LOW    0x0
+#define HIGH   0x1
+#define INPUT  0x01
+#define OUTPUT 0x03
+
+/**
+ * @brief Kind of output reported to the output hook.
+ */
+typedef enum {
+  HOST_OUT_PIN = 0, ///< digitalWrite
+  HOST_OUT_PWM,     ///< ledcWrite
+  HOST_OUT_SERIAL,  ///< Serial write call
+  HOST_OUT_I2C,     ///< Wire transmission
+} HostOutput;
+
+typedef void (*HostOutputHook)(HostOutput kind, int channel, uint64_t timeUs); ///< See hostSetOutputHook
+typedef void (*HostDelayHook)(uint64_t us); ///< See hostSetDelayHook
+
+/**
+ * @brief Serial port that writes to memory.
+ */
+class HardwareSerial {
+public:
+  void begin(unsigned long baud);
+  size_t write(uint8_t c);
+  size_t write(const uint8_t *buf, size_t len);
+  size_t print(char c);
+  size_t print(const char *str);
+  size_t print(int num);
+  size_t println(const char *str = "");
+  size_t println(int num);
+  int availableForWrite();
+  int available();
+  int read();
+
+  bool capture = false; ///< When true, bytes are appended to captured
+  std::string captured; ///< Captured output
+  size_t bytesWritten = 0; ///< Total bytes written since begin()
+  size_t writeCalls = 0; ///< Number of write/print calls since begin()
+  int txSpace = INT_MAX; ///< Value reported by availableForWrite()
+  size_t rxPeak = 0; ///< Most input bytes seen waiting at once by available()
+};
+
+extern HardwareSerial Serial;
+
+int analogRead(uint8_t pin);
+unsigned long micros();
+unsigned long millis();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+bool ledcAttach(uint8_t pin, uint32_t freq, uint8_t resolution);
+bool ledcWrite(uint8_t pin, uint32_t duty);
+
+// =========== Host controls ===========
+void hostSetAnalogScript(uint8_t pin, const int *values, size_t count, bool repeat);
+void hostSetAnalogValue(uint8_t pin, int value);
+void hostAdvanceMicros(uint64_t us);
+void hostRewindMicros(uint64_t us);
+uint64_t hostNowMicros();
+void hostReset();
+void hostSetSerialBaud(uint32_t baud, size_t fifoBytes);
+void hostSerialReceive(const char *data, uint32_t baud);
+uint64_t hostSerialNextArrival();
+uint32_t hostPinDuty(uint8_t pin);
+void hostSetOutputHook(HostOutputHook hook);
+void hostReportOutput(HostOutput kind, int channel);
+void hostSetDelayHook(HostDelayHook hook);
+
+#endif
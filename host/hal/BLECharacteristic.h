@@ -0,0 +1,67 @@
+/**
+ * @file BLECharacteristic.h
+ * @brief Host stand-in for the arduino-esp32 BLECharacteristic, notifications only.
+ *
+ * @section description Description
+ * setValue keeps the value and notify hands it to the hook set with hostSetNotifyHook,
+ * which plays the client and the BLE stack: it sees every notification, stamped with the
+ * virtual time, and returns the status the stack would report. The status goes to the
+ * callbacks' onStatus as on the board, so code that reacts to it runs unchanged.
+ * Without a hook every notification succeeds.
+ */
+#ifndef HOST_BLECHARACTERISTIC_H
+#define HOST_BLECHARACTERISTIC_H
+
+#include "Arduino.h"
+
+#include <vector>
+
+class BLECharacteristic;
+
+/**
+ * @brief Status callback, as in arduino-esp32 (onWrite is not modelled).
+ */
+class BLECharacteristicCallbacks {
+public:
+  /// Same values and order as the arduino-esp32 enum
+  typedef enum {
+    SUCCESS_INDICATE,
+    SUCCESS_NOTIFY,
+    ERROR_INDICATE_DISABLED,
+    ERROR_NOTIFY_DISABLED,
+    ERROR_GATT,
+    ERROR_NO_CLIENT,
+    ERROR_INDICATE_TIMEOUT,
+    ERROR_INDICATE_FAILURE,
+  } Status;
+
+  virtual ~BLECharacteristicCallbacks() {}
+  virtual void onStatus(BLECharacteristic *characteristic, Status s, uint32_t code) {
+    (void)characteristic;
+    (void)s;
+    (void)code;
+  }
+};
+
+/**
+ * @brief One characteristic whose notifications go to a host hook.
+ */
+class BLECharacteristic {
+public:
+  void setCallbacks(BLECharacteristicCallbacks *callbacks);
+  void setValue(uint8_t *data, size_t size);
+  void notify(bool isNotification = true);
+
+  std::vector<uint8_t> value;  ///< Last value set
+  size_t notifications = 0;    ///< notify calls
+  size_t notifiedBytes = 0;    ///< Value bytes of all notify calls
+
+private:
+  BLECharacteristicCallbacks *callbacks = NULL;
+};
+
+typedef BLECharacteristicCallbacks::Status (*HostNotifyHook)(const uint8_t *data, size_t size, uint64_t timeUs); ///< See hostSetNotifyHook
+
+void hostSetNotifyHook(HostNotifyHook hook);
+
+#endif
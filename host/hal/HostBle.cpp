@@ -0,0 +1,37 @@
+/**
+ * @file HostBle.cpp
+ * @brief Implementation of the host BLECharacteristic stand-in.
+ */
+#include "BLECharacteristic.h"
+
+static HostNotifyHook notifyHook = NULL; ///< Client model, or NULL for one that takes everything
+
+/**
+ * Name: hostSetNotifyHook
+ * @brief Sets the client model that receives every notification and decides its status.
+ * @param hook callback, or NULL for every notification to succeed.
+ */
+void hostSetNotifyHook(HostNotifyHook hook) {
+  notifyHook = hook;
+}
+
+void BLECharacteristic::setCallbacks(BLECharacteristicCallbacks *callbacks) {
+  this->callbacks = callbacks;
+}
+
+void BLECharacteristic::setValue(uint8_t *data, size_t size) {
+  value.assign(data, data + size);
+}
+
+/**
+ * Name: notify
+ * @brief Passes the value to the client model and reports its status to onStatus.
+ */
+void BLECharacteristic::notify(bool isNotification) {
+  (void)isNotification;
+  notifications++;
+  notifiedBytes += value.size();
+  BLECharacteristicCallbacks::Status status = BLECharacteristicCallbacks::SUCCESS_NOTIFY;
+  if (notifyHook != NULL) status = notifyHook(value.data(), value.size(), hostNowMicros());
+  if (callbacks != NULL) callbacks->onStatus(this, status, 0);
+}
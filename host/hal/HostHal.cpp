@@ -0,0 +1,381 @@
+/**
+ * @file HostHal.cpp
+ * @brief Implementation of the host stand-in HAL.
+ */
+#include "Arduino.h"
+#include "soc/timer_group_reg.h"
+
+HardwareSerial Serial;
+volatile HostTimerGroup hostTimerGroups[2];
+
+/**
+ * @brief Values returned by analogRead for one pin.
+ */
+struct AnalogScript {
+  const int *values; ///< Scripted values, NULL to return value
+  size_t count;      ///< Number of scripted values
+  size_t next;       ///< Index of the next value to return
+  bool repeat;       ///< Start over after the last value instead of holding it
+  int value;         ///< Fixed value when there is no script
+};
+
+static AnalogScript analogScripts[HOST_ANALOG_PINS];
+static uint64_t virtualMicros = 0;         ///< Virtual clock
+static uint64_t timerApbTicks[2] = {0, 0}; ///< APB ticks not yet turned into timer counts
+static uint64_t timerCounts[2] = {0, 0};   ///< Full 64 bit timer values
+
+static uint8_t pinLevels[HOST_DIGITAL_PINS];  ///< Last digitalWrite value per pin
+static uint32_t pinDuties[HOST_DIGITAL_PINS]; ///< Last ledcWrite duty per pin
+static HostOutputHook outputHook = NULL;     ///< Receives every output, or NULL
+static HostDelayHook delayHook = NULL;       ///< Receives every delay, or NULL
+
+static double serialUsPerByte = 0;     ///< Line time of one 10 bit frame; 0 when Serial is not modelled
+static size_t serialFifoBytes = 0;     ///< TX FIFO size when modelled
+static double serialBusyUntilUs = 0;   ///< Virtual time the TX FIFO runs empty
+static std::string serialInput;        ///< Scripted input, read and unread
+static size_t serialInputRead = 0;     ///< Bytes of serialInput returned by read()
+static double serialInputStartUs = 0;  ///< Virtual time the first scripted byte started arriving
+static double serialInputUsPerByte = 0; ///< Line time of one input frame; 0 when it all arrives at once
+
+// =========== Serial ===========
+
+void HardwareSerial::begin(unsigned long baud) {
+  (void)baud;
+  captured.clear();
+  bytesWritten = 0;
+  writeCalls = 0;
+}
+
+/**
+ * @brief Queues len bytes on the modelled UART, blocking on the virtual clock until they fit.
+ */
+static void serialTransmit(size_t len) {
+  double now = (double)virtualMicros;
+  if (serialBusyUntilUs < now) serialBusyUntilUs = now;
+
+  // the write returns once everything but the last FIFO-full is on the wire
+  double readyAt = serialBusyUntilUs + (double)len * serialUsPerByte - (double)serialFifoBytes * serialUsPerByte;
+  if (readyAt > now) {
+    hostAdvanceMicros((uint64_t)ceil(readyAt - now));
+  }
+  serialBusyUntilUs += (double)len * serialUsPerByte;
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t len) {
+  if (serialUsPerByte > 0) {
+    serialTransmit(len);
+  }
+  hostReportOutput(HOST_OUT_SERIAL, 0);
+  if (capture) {
+    captured.append((const char *)buf, len);
+  }
+  bytesWritten += len;
+  writeCalls++;
+  return len;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t HardwareSerial::print(char c) {
+  return write((uint8_t)c);
+}
+
+size_t HardwareSerial::print(const char *str) {
+  return write((const uint8_t *)str, strlen(str));
+}
+
+size_t HardwareSerial::print(int num) {
+  char buf[12];
+  int n = snprintf(buf, sizeof(buf), "%d", num);
+  return write((const uint8_t *)buf, n);
+}
+
+size_t HardwareSerial::println(const char *str) {
+  size_t n = print(str);
+  return n + write((const uint8_t *)"\r\n", 2);
+}
+
+size_t HardwareSerial::println(int num) {
+  size_t n = print(num);
+  return n + println();
+}
+
+int HardwareSerial::availableForWrite() {
+  if (serialUsPerByte > 0) {
+    double queued = ceil((serialBusyUntilUs - (double)virtualMicros) / serialUsPerByte);
+    if (queued < 0) queued = 0;
+    return (int)serialFifoBytes - (int)queued;
+  }
+  return txSpace;
+}
+
+/**
+ * Name: serialArrived
+ * @brief Scripted input bytes that have fully arrived by now.
+ */
+static size_t serialArrived() {
+  if (serialInputUsPerByte <= 0) return serialInput.size();
+  double elapsed = (double)virtualMicros - serialInputStartUs;
+  if (elapsed < 0) return 0;
+  size_t frames = (size_t)((elapsed + 1e-6) / serialInputUsPerByte);  // + 1e-6: hostSerialNextArrival rounds up to it
+  return frames < serialInput.size() ? frames : serialInput.size();
+}
+
+int HardwareSerial::available() {
+  size_t waiting = serialArrived() - serialInputRead;
+  if (waiting > rxPeak) rxPeak = waiting;
+  return (int)waiting;
+}
+
+int HardwareSerial::read() {
+  if (serialArrived() == serialInputRead) return -1;
+  return (uint8_t)serialInput[serialInputRead++];
+}
+
+/**
+ * Name: hostSerialReceive
+ * @brief Scripts the bytes Serial.read() returns, arriving from now on at the line rate.
+ * @details Replaces any earlier script. The ESP32 RX buffer is not modelled as a limit;
+ *          Serial.rxPeak shows how far behind the reader fell.
+ * @param data bytes to receive.
+ * @param baud line rate, 10 bits per byte; 0 makes everything available at once.
+ */
+void hostSerialReceive(const char *data, uint32_t baud) {
+  serialInput = data;
+  serialInputRead = 0;
+  serialInputStartUs = (double)virtualMicros;
+  serialInputUsPerByte = (baud == 0) ? 0 : 10.0 * 1000000.0 / baud;
+  Serial.rxPeak = 0;
+}
+
+/**
+ * Name: hostSerialNextArrival
+ * @brief Virtual time at which the next scripted byte will have arrived, or UINT64_MAX if
+ *        the script is used up. Lets a simulation skip idle time.
+ */
+uint64_t hostSerialNextArrival() {
+  size_t arrived = serialArrived();
+  if (arrived > serialInputRead) return virtualMicros;
+  if (arrived == serialInput.size()) return UINT64_MAX;
+  return (uint64_t)ceil(serialInputStartUs + (double)(arrived + 1) * serialInputUsPerByte);
+}
+
+/**
+ * Name: hostSetSerialBaud
+ * @brief Models Serial as a UART with a TX FIFO instead of an instant sink.
+ * @details Bytes leave the FIFO at baud / 10 per second. A write that does not fit
+ *          advances the virtual clock until it does, the way the ESP32 driver blocks.
+ * @param baud line rate; 0 turns the model off.
+ * @param fifoBytes TX FIFO plus driver ring size.
+ */
+void hostSetSerialBaud(uint32_t baud, size_t fifoBytes) {
+  serialUsPerByte = (baud == 0) ? 0 : 10.0 * 1000000.0 / baud;
+  serialFifoBytes = fifoBytes;
+  serialBusyUntilUs = (double)virtualMicros;
+}
+
+// =========== Digital ===========
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin >= HOST_DIGITAL_PINS) return;
+  pinLevels[pin] = value ? HIGH : LOW;
+  hostReportOutput(HOST_OUT_PIN, pin);
+}
+
+int digitalRead(uint8_t pin) {
+  if (pin >= HOST_DIGITAL_PINS) return LOW;
+  return pinLevels[pin];
+}
+
+bool ledcAttach(uint8_t pin, uint32_t freq, uint8_t resolution) {
+  (void)freq;
+  (void)resolution;
+  return pin < HOST_DIGITAL_PINS;
+}
+
+bool ledcWrite(uint8_t pin, uint32_t duty) {
+  if (pin >= HOST_DIGITAL_PINS) return false;
+  pinDuties[pin] = duty;
+  hostReportOutput(HOST_OUT_PWM, pin);
+  return true;
+}
+
+/**
+ * Name: hostPinDuty
+ * @brief Last duty written to pin with ledcWrite.
+ */
+uint32_t hostPinDuty(uint8_t pin) {
+  return (pin < HOST_DIGITAL_PINS) ? pinDuties[pin] : 0;
+}
+
+// =========== Output hook ===========
+
+/**
+ * Name: hostSetOutputHook
+ * @brief Calls hook for every pin, PWM, Serial and I2C write, with the virtual time.
+ * @param hook callback, or NULL to stop reporting.
+ */
+void hostSetOutputHook(HostOutputHook hook) {
+  outputHook = hook;
+}
+
+/**
+ * Name: hostReportOutput
+ * @brief Passes one output to the hook, if any. Used by the HAL peripherals.
+ */
+void hostReportOutput(HostOutput kind, int channel) {
+  if (outputHook != NULL) outputHook(kind, channel, virtualMicros);
+}
+
+// =========== Analog ===========
+
+int analogRead(uint8_t pin) {
+  if (pin >= HOST_ANALOG_PINS) return 0;
+  AnalogScript *s = &analogScripts[pin];
+  if (s->values == NULL || s->count == 0) return s->value;
+
+  int value = s->values[s->next];
+  if (s->next + 1 < s->count) {
+    s->next++;
+  } else if (s->repeat) {
+    s->next = 0;
+  }
+  return value;
+}
+
+/**
+ * Name: hostSetAnalogScript
+ * @brief Makes analogRead(pin) return values[0], values[1], ... in order.
+ * @param pin pin to script.
+ * @param values values to return. Must outlive the script.
+ * @param count number of values.
+ * @param repeat start over after the last value; otherwise the last value is held.
+ */
+void hostSetAnalogScript(uint8_t pin, const int *values, size_t count, bool repeat) {
+  if (pin >= HOST_ANALOG_PINS) return;
+  analogScripts[pin].values = values;
+  analogScripts[pin].count = count;
+  analogScripts[pin].next = 0;
+  analogScripts[pin].repeat = repeat;
+}
+
+/**
+ * Name: hostSetAnalogValue
+ * @brief Makes analogRead(pin) always return value.
+ */
+void hostSetAnalogValue(uint8_t pin, int value) {
+  if (pin >= HOST_ANALOG_PINS) return;
+  analogScripts[pin].values = NULL;
+  analogScripts[pin].value = value;
+}
+
+// =========== Time ===========
+
+/**
+ * Name: hostAdvanceMicros
+ * @brief Moves the virtual clock forward and steps the enabled timer group counters.
+ * @param us microseconds to advance.
+ */
+void hostAdvanceMicros(uint64_t us) {
+  virtualMicros += us;
+
+  for (int i = 0; i < 2; i++) {
+    uint32_t config = hostTimerGroups[i].t0config;
+    if (!(config & (1u << 31))) continue;
+
+    uint32_t divider = (config >> 13) & 0xFFFF;
+    if (divider < 2) divider = (divider == 0) ? 65536 : 2;  // hardware treats 0 as 65536 and 1 as 2
+
+    timerApbTicks[i] += us * (HOST_APB_CLK_HZ / 1000000ULL);
+    uint64_t counts = timerApbTicks[i] / divider;
+    timerApbTicks[i] -= counts * divider;
+
+    if (config & (1u << 30)) {
+      timerCounts[i] += counts;
+    } else {
+      timerCounts[i] -= counts;
+    }
+    timerCounts[i] &= (1ULL << 54) - 1;  // 54 bit counter
+    hostTimerGroups[i].t0lo = (uint32_t)timerCounts[i];
+    hostTimerGroups[i].t0hi = (uint32_t)(timerCounts[i] >> 32);
+  }
+}
+
+/**
+ * Name: hostRewindMicros
+ * @brief Moves the virtual clock back without touching the timer group counters.
+ * @details For long simulations: on the host unsigned long is 64 bits, so sketch code
+ *          that keeps micros() in an int sign-extends once the clock passes 2^31 us,
+ *          where the 32 bit target simply wraps. The caller shifts its own stored
+ *          timestamps by the same amount.
+ * @param us microseconds to go back; at most hostNowMicros().
+ */
+void hostRewindMicros(uint64_t us) {
+  if (us > virtualMicros) us = virtualMicros;
+  virtualMicros -= us;
+  serialBusyUntilUs -= (double)us;
+}
+
+uint64_t hostNowMicros() {
+  return virtualMicros;
+}
+
+unsigned long micros() {
+  return (unsigned long)virtualMicros;
+}
+
+unsigned long millis() {
+  return (unsigned long)(virtualMicros / 1000);
+}
+
+void delay(uint32_t ms) {
+  if (delayHook != NULL) delayHook((uint64_t)ms * 1000);
+  hostAdvanceMicros((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us) {
+  if (delayHook != NULL) delayHook(us);
+  hostAdvanceMicros(us);
+}
+
+/**
+ * Name: hostSetDelayHook
+ * @brief Calls hook with the length of every delay and delayMicroseconds, before the clock moves.
+ * @param hook callback, or NULL to stop reporting.
+ */
+void hostSetDelayHook(HostDelayHook hook) {
+  delayHook = hook;
+}
+
+/**
+ * Name: hostReset
+ * @brief Restores the clock, timers, pins, analog scripts and Serial to power-on state.
+ */
+void hostReset() {
+  virtualMicros = 0;
+  for (int i = 0; i < 2; i++) {
+    timerApbTicks[i] = 0;
+    timerCounts[i] = 0;
+    hostTimerGroups[i].t0config = 0;
+    hostTimerGroups[i].t0lo = 0;
+    hostTimerGroups[i].t0hi = 0;
+    hostTimerGroups[i].t0update = 0;
+  }
+  for (int i = 0; i < HOST_ANALOG_PINS; i++) {
+    analogScripts[i] = AnalogScript();
+  }
+  memset(pinLevels, 0, sizeof(pinLevels));
+  memset(pinDuties, 0, sizeof(pinDuties));
+  outputHook = NULL;
+  delayHook = NULL;
+  hostSetSerialBaud(0, 0);
+  hostSerialReceive("", 0);
+  Serial.begin(0);
+}
@@ -0,0 +1,156 @@
+/**
+ * @file HostLcd.cpp
+ * @brief Implementation of the host LiquidCrystal_I2C stand-in.
+ */
+#include "LiquidCrystal_I2C.h"
+#include "Wire.h"
+
+#define LCD_CLEARDISPLAY   0x01
+#define LCD_RETURNHOME     0x02
+#define LCD_SETDDRAMADDR   0x80
+#define LCD_FUNCTIONSET    0x20
+#define LCD_DISPLAYCONTROL 0x08
+#define LCD_ENTRYMODESET   0x04
+
+#define LCD_EN 0x04 ///< Enable bit on the PCF8574
+#define LCD_RS 0x01 ///< Register select bit on the PCF8574
+
+static const uint8_t rowOffsets[4] = {0x00, 0x40, 0x14, 0x54};
+
+LiquidCrystal_I2C::LiquidCrystal_I2C(uint8_t addr, uint8_t cols, uint8_t rows)
+    : addr(addr), cols(cols), rows(rows) {
+  memset(ddram, ' ', sizeof(ddram));
+}
+
+/**
+ * Name: init
+ * @brief Runs the library's 4 bit initialisation sequence, including its delays.
+ */
+void LiquidCrystal_I2C::init() {
+  Wire.begin();
+  begin();
+}
+
+void LiquidCrystal_I2C::begin() {
+  delay(50);
+  expanderWrite(backlightBit);
+  delay(1000);
+
+  write4bits(0x03 << 4);
+  delayMicroseconds(4500);
+  write4bits(0x03 << 4);
+  delayMicroseconds(4500);
+  write4bits(0x03 << 4);
+  delayMicroseconds(150);
+  write4bits(0x02 << 4);
+
+  command(LCD_FUNCTIONSET | 0x08);
+  command(LCD_DISPLAYCONTROL | 0x04);
+  clear();
+  command(LCD_ENTRYMODESET | 0x02);
+  home();
+}
+
+void LiquidCrystal_I2C::clear() {
+  command(LCD_CLEARDISPLAY);
+  delayMicroseconds(2000);
+}
+
+void LiquidCrystal_I2C::home() {
+  command(LCD_RETURNHOME);
+  delayMicroseconds(2000);
+}
+
+void LiquidCrystal_I2C::setCursor(uint8_t col, uint8_t row) {
+  if (row >= rows) row = rows - 1;
+  command(LCD_SETDDRAMADDR | (col + rowOffsets[row]));
+}
+
+void LiquidCrystal_I2C::backlight() {
+  backlightBit = 0x08;
+  expanderWrite(0);
+}
+
+void LiquidCrystal_I2C::noBacklight() {
+  backlightBit = 0;
+  expanderWrite(0);
+}
+
+/**
+ * Name: command
+ * @brief Sends a command byte and applies it to the display model.
+ */
+void LiquidCrystal_I2C::command(uint8_t value) {
+  send(value, 0);
+  commands++;
+  if (value & LCD_SETDDRAMADDR) {
+    address = value & 0x7F;
+  } else if (value == LCD_CLEARDISPLAY) {
+    memset(ddram, ' ', sizeof(ddram));
+    address = 0;
+  } else if (value == LCD_RETURNHOME) {
+    address = 0;
+  }
+}
+
+/**
+ * Name: write
+ * @brief Sends a data byte and stores it at the current DDRAM address.
+ */
+size_t LiquidCrystal_I2C::write(uint8_t value) {
+  send(value, LCD_RS);
+  characters++;
+  ddram[address & (HOST_LCD_DDRAM - 1)] = (char)value;
+  address = (address + 1) & 0x7F;
+  return 1;
+}
+
+size_t LiquidCrystal_I2C::print(const char *str) {
+  size_t n = 0;
+  while (*str) n += write((uint8_t)*str++);
+  return n;
+}
+
+size_t LiquidCrystal_I2C::print(char c) {
+  return write((uint8_t)c);
+}
+
+size_t LiquidCrystal_I2C::print(int num) {
+  char buf[12];
+  snprintf(buf, sizeof(buf), "%d", num);
+  return print(buf);
+}
+
+size_t LiquidCrystal_I2C::print(unsigned long num) {
+  char buf[21];
+  snprintf(buf, sizeof(buf), "%lu", num);
+  return print(buf);
+}
+
+/**
+ * Name: text
+ * @brief What the display currently shows on row, cols characters wide.
+ */
+std::string LiquidCrystal_I2C::text(uint8_t row) const {
+  if (row >= rows) return std::string();
+  return std::string(&ddram[rowOffsets[row]], cols);
+}
+
+void LiquidCrystal_I2C::send(uint8_t value, uint8_t mode) {
+  write4bits((value & 0xF0) | mode);
+  write4bits(((value << 4) & 0xF0) | mode);
+}
+
+void LiquidCrystal_I2C::write4bits(uint8_t value) {
+  expanderWrite(value);
+  expanderWrite(value | LCD_EN);
+  delayMicroseconds(1);
+  expanderWrite(value & ~LCD_EN);
+  delayMicroseconds(50);
+}
+
+void LiquidCrystal_I2C::expanderWrite(uint8_t data) {
+  Wire.beginTransmission(addr);
+  Wire.write(data | backlightBit);
+  Wire.endTransmission();
+}
@@ -0,0 +1,81 @@
+/**
+ * @file HostWire.cpp
+ * @brief Implementation of the host I2C master.
+ */
+#include "Wire.h"
+
+TwoWire Wire;
+
+static HostI2cHook i2cHook = NULL; ///< Receives every data byte, or NULL
+
+/**
+ * Name: hostSetI2cHook
+ * @brief Calls hook for every data byte sent, with the virtual time its ACK bit ends.
+ * @param hook callback, or NULL to stop reporting.
+ */
+void hostSetI2cHook(HostI2cHook hook) {
+  i2cHook = hook;
+}
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency) {
+  (void)sda;
+  (void)scl;
+  if (frequency != 0) clockHz = frequency;
+  transactions = 0;
+  bytes = 0;
+  pending = 0;
+  return true;
+}
+
+bool TwoWire::setClock(uint32_t frequency) {
+  if (frequency == 0) return false;
+  clockHz = frequency;
+  return true;
+}
+
+void TwoWire::beginTransmission(uint8_t addr) {
+  address = addr;
+  pending = 0;
+  overflow = false;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (pending >= HOST_I2C_BUFFER) {
+    overflow = true;
+    return 0;
+  }
+  buffer[pending++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t len) {
+  size_t n = 0;
+  while (n < len && write(data[n]) == 1) n++;
+  return n;
+}
+
+/**
+ * Name: endTransmission
+ * @brief Sends the buffered bytes and advances the virtual clock by the bus time.
+ * @details Start, address and data bytes with their ACK bits, and stop:
+ *          2 + 9 * (1 + n) bit times, plus overheadUs before the start bit.
+ * @retval 0 on success, 1 if the bytes did not fit in the buffer (as the Arduino API).
+ */
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  (void)sendStop;
+  if (i2cHook != NULL) {
+    // data byte i ends after the start bit, the address byte and i + 1 data bytes
+    double start = (double)hostNowMicros() + overheadUs;
+    for (size_t i = 0; i < pending; i++) {
+      double bitsDone = 1 + 9 * (2 + (double)i);
+      i2cHook(address, buffer[i], (uint64_t)(start + bitsDone * 1000000.0 / clockHz));
+    }
+  }
+  uint64_t bits = 2 + 9 * (1 + (uint64_t)pending);
+  hostAdvanceMicros((bits * 1000000ULL + clockHz - 1) / clockHz + overheadUs);
+  transactions++;
+  bytes += pending;
+  hostReportOutput(HOST_OUT_I2C, address);
+  pending = 0;
+  return overflow ? 1 : 0;
+}
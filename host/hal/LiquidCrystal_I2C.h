@@ -0,0 +1,58 @@
+/**
+ * @file LiquidCrystal_I2C.h
+ * @brief Host stand-in for the LiquidCrystal_I2C library (HD44780 behind a PCF8574).
+ *
+ * @section description Description
+ * Drives the bus exactly like the library does: every byte is sent as two nibbles,
+ * and every nibble costs three single-byte Wire transactions (data, enable high,
+ * enable low) plus the library's enable-pulse delays. Bus time and transaction
+ * counts therefore come out of the Wire model the same as on hardware.
+ * The display contents are kept so a run can check what ended up on screen.
+ */
+#ifndef HOST_LIQUIDCRYSTAL_I2C_H
+#define HOST_LIQUIDCRYSTAL_I2C_H
+
+#include "Arduino.h"
+
+#define HOST_LCD_DDRAM 0x80 ///< HD44780 DDRAM address space
+
+/**
+ * @brief Character LCD on the host I2C bus.
+ */
+class LiquidCrystal_I2C {
+public:
+  LiquidCrystal_I2C(uint8_t addr, uint8_t cols, uint8_t rows);
+
+  void init();
+  void begin();
+  void clear();
+  void home();
+  void setCursor(uint8_t col, uint8_t row);
+  void backlight();
+  void noBacklight();
+  void command(uint8_t value);
+  size_t write(uint8_t value);
+  size_t print(const char *str);
+  size_t print(char c);
+  size_t print(int num);
+  size_t print(unsigned long num);
+
+  std::string text(uint8_t row) const;
+
+  size_t commands = 0;  ///< Command bytes sent since construction
+  size_t characters = 0; ///< Data bytes sent since construction
+
+private:
+  void send(uint8_t value, uint8_t mode);
+  void write4bits(uint8_t value);
+  void expanderWrite(uint8_t data);
+
+  uint8_t addr;
+  uint8_t cols;
+  uint8_t rows;
+  uint8_t backlightBit = 0x08;
+  uint8_t address = 0;  ///< Current DDRAM address
+  char ddram[HOST_LCD_DDRAM];
+};
+
+#endif
@@ -0,0 +1,49 @@
+/**
+ * @file Wire.h
+ * @brief Host stand-in for the Arduino I2C master.
+ *
+ * @section description Description
+ * Bytes written between beginTransmission and endTransmission are buffered and sent
+ * as one transaction, like the ESP32 driver. A transaction costs its bit time at the
+ * configured clock plus a fixed driver overhead, charged to the virtual clock.
+ * Transactions and bytes are counted so drivers can be compared by bus traffic.
+ * A device model can follow the traffic byte by byte through hostSetI2cHook.
+ */
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include "Arduino.h"
+
+#define HOST_I2C_BUFFER 128 ///< Bytes one transaction can hold, as on the ESP32
+
+typedef void (*HostI2cHook)(uint8_t address, uint8_t data, uint64_t timeUs); ///< See hostSetI2cHook
+
+/**
+ * @brief I2C master that charges bus time to the virtual clock.
+ */
+class TwoWire {
+public:
+  bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+  bool setClock(uint32_t frequency);
+  void beginTransmission(uint8_t address);
+  size_t write(uint8_t data);
+  size_t write(const uint8_t *data, size_t len);
+  uint8_t endTransmission(bool sendStop = true);
+
+  uint32_t clockHz = 100000;    ///< Bus clock
+  uint32_t overheadUs = 10;     ///< Driver cost per transaction; an estimate for the ESP32 IDF driver
+  size_t transactions = 0;      ///< Transactions since begin()
+  size_t bytes = 0;             ///< Data bytes, excluding address bytes, since begin()
+
+private:
+  uint8_t address = 0;
+  uint8_t buffer[HOST_I2C_BUFFER];
+  size_t pending = 0;
+  bool overflow = false;
+};
+
+extern TwoWire Wire;
+
+void hostSetI2cHook(HostI2cHook hook);
+
+#endif
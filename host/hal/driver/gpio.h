@@ -0,0 +1,8 @@
+/**
+ * @file gpio.h
+ * @brief Empty host stand-in so sketches that include the ESP-IDF header compile.
+ */
+#ifndef HOST_DRIVER_GPIO_H
+#define HOST_DRIVER_GPIO_H
+
+#endif
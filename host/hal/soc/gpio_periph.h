@@ -0,0 +1,8 @@
+/**
+ * @file gpio_periph.h
+ * @brief Empty host stand-in so sketches that include the ESP-IDF header compile.
+ */
+#ifndef HOST_SOC_GPIO_PERIPH_H
+#define HOST_SOC_GPIO_PERIPH_H
+
+#endif
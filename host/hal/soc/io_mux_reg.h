@@ -0,0 +1,8 @@
+/**
+ * @file io_mux_reg.h
+ * @brief Empty host stand-in so sketches that include the ESP-IDF header compile.
+ */
+#ifndef HOST_SOC_IO_MUX_REG_H
+#define HOST_SOC_IO_MUX_REG_H
+
+#endif
@@ -0,0 +1,36 @@
+/**
+ * @file timer_group_reg.h
+ * @brief Host stand-in for the ESP32 timer group register addresses.
+ *
+ * @section description Description
+ * The register macros resolve to words in an in-memory block so direct register
+ * accesses in the libraries compile and run unchanged. hostAdvanceMicros moves each
+ * enabled timer by the number of 80 MHz APB ticks divided by its configured divider,
+ * counting up or down per the increment bit, and refreshes T0LO/T0HI so they always
+ * read as freshly latched.
+ */
+#ifndef HOST_SOC_TIMER_GROUP_REG_H
+#define HOST_SOC_TIMER_GROUP_REG_H
+
+#include <stdint.h>
+
+#define HOST_APB_CLK_HZ 80000000ULL ///< Clock feeding the timer dividers
+
+/**
+ * @brief Timer 0 registers of one timer group.
+ */
+struct HostTimerGroup {
+  uint32_t t0config; ///< TIMG_T0CONFIG_REG: bit 31 enable, bit 30 increment, bits 13-28 divider
+  uint32_t t0lo;     ///< TIMG_T0LO_REG
+  uint32_t t0hi;     ///< TIMG_T0HI_REG
+  uint32_t t0update; ///< TIMG_T0UPDATE_REG
+};
+
+extern volatile HostTimerGroup hostTimerGroups[2];
+
+#define TIMG_T0CONFIG_REG(i) ((uintptr_t)&hostTimerGroups[i].t0config)
+#define TIMG_T0LO_REG(i)     ((uintptr_t)&hostTimerGroups[i].t0lo)
+#define TIMG_T0HI_REG(i)     ((uintptr_t)&hostTimerGroups[i].t0hi)
+#define TIMG_T0UPDATE_REG(i) ((uintptr_t)&hostTimerGroups[i].t0update)
+
+#endif
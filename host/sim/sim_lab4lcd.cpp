@@ -0,0 +1,279 @@
+/**
+ * @file sim_lab4lcd.cpp
+ * @brief Host simulation of the Lab 4 LCD serial-to-display stream.
+ *
+ * @section description Description
+ * Builds Kalisi_EE590_Lab4LCD.ino unchanged against the host HAL, runs setup(), then
+ * feeds a text through Serial at the line rate and calls loop() as the board would,
+ * skipping the virtual clock ahead while no input is waiting.
+ *
+ * Every expander byte on the bus is decoded by an HD44780 model, which keeps the display
+ * contents and counts timing faults:
+ * - an instruction latched while the previous one is still executing (37 us, 1.52 ms
+ *   for clear and home),
+ * - enable rising in the same byte that changes RS (no RS setup time).
+ *
+ * The same stream is then sent through the LiquidCrystal_I2C stand-in, which drives the
+ * bus like the original driver: three single-byte transactions per nibble with CPU
+ * delays, at the default 100 kHz. Per character it reports the CPU time spent in
+ * loop(), I2C transactions and bytes, and the most input bytes seen waiting.
+ * Exits with 1 if the display does not show the expected text or a timing fault occurred.
+ *
+ * @section usage Usage
+ *   sim_lab4lcd [-b baud] [-n repeats] [-e exec_us]
+ *   -e sets the modelled instruction time, e.g. 50 for a slow oscillator.
+ */
+#include <Arduino.h>
+#include "../../Kalisi_EE590_Lab4LCD/Kalisi_EE590_Lab4LCD.ino"
+
+#include <LiquidCrystal_I2C.h>
+#include <unistd.h>
+
+#define SIM_LCD_COLS 16
+#define SIM_LCD_ROWS 2
+#define SIM_EXEC_US 37         ///< HD44780 instruction time at the typical 270 kHz oscillator (default of -e)
+#define SIM_SLOW_EXEC_US 1520  ///< Clear display and return home
+
+static uint64_t simExecUs = SIM_EXEC_US;  ///< Instruction time modelled, -e
+
+static const char *const simText =
+    "Hello from the host simulator\n"
+    "EE590 Lab 4 LCD: serial to display, batched over I2C.\n"
+    "The quick brown fox jumps over the lazy dog 0123456789\n";
+
+/**
+ * @brief HD44780 in 4 bit mode behind a PCF8574 (D7-D4 on P7-P4, EN on P2, RS on P0).
+ */
+struct SimHd44780 {
+  bool eightBit = true;     ///< Before the 0x2 function set nibble
+  bool haveHigh = false;    ///< High nibble latched, low nibble pending
+  uint8_t high = 0;
+  uint8_t pins = 0;         ///< Last expander output
+  uint8_t address = 0;      ///< DDRAM address
+  uint64_t busyUntil = 0;   ///< Virtual time the current instruction completes
+  size_t execFaults = 0;
+  size_t setupFaults = 0;
+  char ddram[0x80];
+
+  SimHd44780() { memset(ddram, ' ', sizeof(ddram)); }
+
+  void onByte(uint8_t data, uint64_t timeUs) {
+    bool enableRise = !(pins & ENABLE) && (data & ENABLE);
+    bool enableFall = (pins & ENABLE) && !(data & ENABLE);
+    if (enableRise && ((pins ^ data) & RS)) setupFaults++;
+    if (enableFall) latch(pins, timeUs);
+    pins = data;
+  }
+
+  void latch(uint8_t latched, uint64_t timeUs) {
+    uint8_t nibble = latched >> 4;
+    if (eightBit) {
+      // initialisation: each nibble is a whole 8 bit function set
+      if (nibble == 0x2) eightBit = false;
+      busyUntil = timeUs + simExecUs;
+      return;
+    }
+    if (!haveHigh) {
+      if (timeUs < busyUntil) execFaults++;
+      high = nibble;
+      haveHigh = true;
+      return;
+    }
+    haveHigh = false;
+    execute((uint8_t)((high << 4) | nibble), latched & RS, timeUs);
+  }
+
+  void execute(uint8_t value, bool data, uint64_t timeUs) {
+    uint64_t exec = simExecUs;
+    if (data) {
+      ddram[address & 0x7F] = (char)value;
+      address = (address + 1) & 0x7F;
+    } else if (value & 0x80) {
+      address = value & 0x7F;
+    } else if (value == 0x01) {
+      memset(ddram, ' ', sizeof(ddram));
+      address = 0;
+      exec = SIM_SLOW_EXEC_US;
+    } else if (value <= 0x03) {
+      address = 0;
+      exec = SIM_SLOW_EXEC_US;
+    }
+    busyUntil = timeUs + exec;
+  }
+
+  std::string row(int r) const { return std::string(&ddram[r ? 0x40 : 0x00], SIM_LCD_COLS); }
+};
+
+static SimHd44780 *simLcd = NULL;
+
+static void simOnI2c(uint8_t address, uint8_t data, uint64_t timeUs) {
+  if (address == I2C_ADDR && simLcd != NULL) simLcd->onByte(data, timeUs);
+}
+
+/**
+ * @brief Outcome of one stream.
+ */
+struct SimResult {
+  size_t chars;
+  uint64_t busyUs;     ///< Virtual time spent inside loop()
+  uint64_t spanUs;     ///< First input byte until the last one is on the display
+  size_t transactions;
+  size_t bytes;
+  size_t rxPeak;
+};
+
+/**
+ * Name: simExpected
+ * @brief What the sketch's loop() should leave on the display for text.
+ */
+static void simExpected(const std::string &text, std::string rows[SIM_LCD_ROWS]) {
+  rows[0] = rows[1] = std::string(SIM_LCD_COLS, ' ');
+  int col = 0, row = 0;
+  for (char c : text) {
+    if (c == '\n') {
+      col = 0;
+      row = (row + 1) % SIM_LCD_ROWS;
+    } else if (c != '\r' && c != '\t') {
+      rows[row][col++] = c;
+      if (col >= SIM_LCD_COLS) {
+        col = 0;
+        row = (row + 1) % SIM_LCD_ROWS;
+      }
+    }
+  }
+}
+
+/**
+ * Name: simStream
+ * @brief Feeds text at baud and runs step() whenever input is waiting, until it is all read.
+ */
+template <typename Step>
+static SimResult simStream(const std::string &text, uint32_t baud, Step step) {
+  size_t transactions = Wire.transactions;
+  size_t bytes = Wire.bytes;
+  uint64_t start = hostNowMicros();
+  uint64_t busy = 0;
+
+  hostSerialReceive(text.c_str(), baud);
+  for (;;) {
+    uint64_t next = hostSerialNextArrival();
+    if (next == UINT64_MAX) break;
+    if (next > hostNowMicros()) hostAdvanceMicros(next - hostNowMicros());
+    uint64_t before = hostNowMicros();
+    step();
+    busy += hostNowMicros() - before;
+  }
+
+  SimResult r;
+  r.chars = text.size();
+  r.busyUs = busy;
+  r.spanUs = hostNowMicros() - start;
+  r.transactions = Wire.transactions - transactions;
+  r.bytes = Wire.bytes - bytes;
+  r.rxPeak = Serial.rxPeak;
+  return r;
+}
+
+/**
+ * Name: simLibraryLoop
+ * @brief The sketch's loop() written against LiquidCrystal_I2C, i.e. the original driver's traffic.
+ */
+static void simLibraryLoop(LiquidCrystal_I2C &lcd) {
+  static int col = 0, row = 0;
+  while (Serial.available() > 0) {
+    char c = Serial.read();
+    if (c == '\n') {
+      col = 0;
+      row = (row + 1) % SIM_LCD_ROWS;
+      lcd.setCursor(col, row);
+    } else if (c != '\r' && c != '\t') {
+      lcd.write((uint8_t)c);
+      if (++col >= SIM_LCD_COLS) {
+        col = 0;
+        row = (row + 1) % SIM_LCD_ROWS;
+        lcd.setCursor(col, row);
+      }
+    }
+  }
+}
+
+static void simReportRow(const char *name, const SimResult &r) {
+  printf("%-34s %9.1f %9.2f %9.1f %9zu %10.1f\n", name, (double)r.busyUs / r.chars,
+         (double)r.transactions / r.chars, (double)r.bytes / r.chars, r.rxPeak,
+         (double)r.spanUs / 1000.0);
+}
+
+/**
+ * Name: simCheck
+ * @brief Compares the decoded display with the expected rows and reports timing faults.
+ * @retval true if both are clean.
+ */
+static bool simCheck(const char *name, const SimHd44780 &lcd, const std::string expected[SIM_LCD_ROWS]) {
+  bool ok = true;
+  for (int r = 0; r < SIM_LCD_ROWS; r++) {
+    if (lcd.row(r) != expected[r]) {
+      printf("%s: row %d shows \"%s\", expected \"%s\"\n", name, r, lcd.row(r).c_str(), expected[r].c_str());
+      ok = false;
+    }
+  }
+  if (lcd.execFaults || lcd.setupFaults) {
+    printf("%s: %zu instructions latched while busy, %zu enable edges without RS setup\n", name,
+           lcd.execFaults, lcd.setupFaults);
+    ok = false;
+  }
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  uint32_t baud = 115200;
+  int repeats = 20;
+  int opt;
+  while ((opt = getopt(argc, argv, "b:n:e:")) != -1) {
+    switch (opt) {
+      case 'b': baud = (uint32_t)strtoul(optarg, NULL, 10); break;
+      case 'n': repeats = atoi(optarg); break;
+      case 'e': simExecUs = strtoull(optarg, NULL, 10); break;
+      default:
+        fprintf(stderr, "usage: %s [-b baud] [-n repeats] [-e exec_us]\n", argv[0]);
+        return 2;
+    }
+  }
+
+  std::string text;
+  for (int i = 0; i < repeats; i++) text += simText;
+  std::string expected[SIM_LCD_ROWS];
+  simExpected(text, expected);
+  bool ok = true;
+
+  printf("%zu characters at %u baud (%.1f us per character on the line)\n", text.size(), baud,
+         baud ? 10e6 / baud : 0.0);
+  printf("%-34s %9s %9s %9s %9s %10s\n", "driver", "cpu us/ch", "xfers/ch", "bytes/ch", "rx peak", "span ms");
+
+  // the sketch's batched driver
+  hostReset();
+  SimHd44780 batched;
+  simLcd = &batched;
+  hostSetI2cHook(simOnI2c);
+  setup();
+  char name[48];
+  snprintf(name, sizeof(name), "batched (%u kHz)", (unsigned)(I2C_HZ / 1000));
+  SimResult r = simStream(text, baud, [] { loop(); });
+  simReportRow(name, r);
+  ok = simCheck(name, batched, expected) && ok;
+
+  // library-style driver, one transaction per expander byte
+  hostReset();
+  Wire.setClock(100000);
+  SimHd44780 perByte;
+  simLcd = &perByte;
+  LiquidCrystal_I2C lcd(I2C_ADDR, SIM_LCD_COLS, SIM_LCD_ROWS);
+  lcd.init();
+  lcd.setCursor(0, 0);
+  r = simStream(text, baud, [&lcd] { simLibraryLoop(lcd); });
+  simReportRow("per-byte transactions (100 kHz)", r);
+  ok = simCheck("per-byte", perByte, expected) && ok;
+
+  hostSetI2cHook(NULL);
+  simLcd = NULL;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,366 @@
+/**
+ * @file sim_lab4tcb.cpp
+ * @brief Discrete-event simulation of the Lab 4 TCB scheduler on the host.
+ *
+ * @section description Description
+ * Builds Kalisi_EE590_Lab4TCB.ino against the host HAL and calls its loop() on the
+ * virtual clock. The only change to the sketch is LOOP_IDLE_US, which is defined before the
+ * include so the loop period can be swept. Time only moves where the hardware would spend it:
+ * - the delayMicroseconds that ends each loop() pass (counted as idle, through the HAL delay
+ *   hook), which the sketch shortens by the time its LCD drain took,
+ * - delayMicroseconds inside a task (busy waiting),
+ * - LCD writes, charged per I2C transaction by the Wire model,
+ * - Serial output, blocking when the modelled 128 byte UART FIFO is full,
+ * - a fixed cost per loop() pass.
+ *
+ * Every task is released when resetTasks() starts a rotation. Per task it reports:
+ * - response time: release until the first call of the task body,
+ * - completion time: release until the task marks itself STATE_INACTIVE,
+ * - jitter: spread (max - min) of the completion time over all rotations,
+ * - output period: time between consecutive calls that produced output (LED edge,
+ *   PWM write, LCD or Serial), with its standard deviation and spread, which is
+ *   how far the visible behaviour strays from the intended interval.
+ * It also reports the fraction of virtual time spent idle in the loop period, and prints
+ * the sketch's own task profiles (TaskProfile.h) as its serial dump would, timed on the
+ * emulated timer group 0.
+ *
+ * The sketch keeps some micros() values in int fields. On the 32 bit target the
+ * differences wrap correctly; on the host unsigned long is 64 bits and they would
+ * sign-extend past 2^31 us. So at each rotation boundary the clock is moved back to
+ * SIM_CLOCK_BASE, shifting the one timestamp resetTasks() does not clear with it.
+ * Every other timestamp is 0 after resetTasks(), which stays "long ago" at that base,
+ * just as it is on the board.
+ *
+ * @section usage Usage
+ *   sim_lab4tcb [-p period_us] [-r rotations] [-m task_mask] [-o overhead_us] [-b baud]
+ * Without -p, sweeps several loop periods so they can be compared.
+ * -m is a bit mask of the tasks to keep (bit 0 = taskA); dropped tasks finish at once.
+ */
+#include <Arduino.h>
+
+static uint32_t simLoopIdleUs = 15000; ///< Loop period of the current run
+#define LOOP_IDLE_US simLoopIdleUs
+#include "../../Kalisi_EE590_Lab4TCB/Kalisi_EE590_Lab4TCB.ino"
+
+#include <math.h>
+#include <new>
+#include <unistd.h>
+
+#include "Bench.h"
+
+#define SIM_UART_FIFO 128 ///< ESP32 UART TX FIFO, with the Arduino default of no extra TX ring
+#define SIM_CLOCK_BASE (1ULL << 30) ///< Clock value after a rebase; well above every task interval
+#define SIM_LCD_TASK 1 ///< taskB, whose queued LCD writes loop() sends; their output is counted for it
+
+static const char *const simTaskNames[N_LAB_TASKS] = {"Blink LED", "LCD Count", "LED Intensity", "Alphabet Print"};
+
+/**
+ * @brief Parameters of one simulation run.
+ */
+struct SimConfig {
+  uint32_t loopPeriodUs; ///< LOOP_IDLE_US, the idle time of each loop() pass
+  uint32_t rotations;    ///< Rotations (all tasks completed once) to simulate
+  uint32_t taskMask;     ///< Tasks to keep, bit i = TaskHandles[i]
+  uint32_t overheadUs;   ///< Cost of one loop() pass outside the task bodies
+  uint32_t baud;         ///< Serial line rate, 0 for an instant Serial
+};
+
+/**
+ * @brief Min/mean/max/spread accumulator over microsecond samples.
+ */
+struct SimMetric {
+  uint64_t count;
+  double sum;
+  double sumSquares;
+  uint64_t min;
+  uint64_t max;
+
+  void add(uint64_t v) {
+    if (count == 0 || v < min) min = v;
+    if (count == 0 || v > max) max = v;
+    count++;
+    sum += (double)v;
+    sumSquares += (double)v * (double)v;
+  }
+  double mean() const { return count ? sum / count : 0; }
+  double stddev() const {
+    if (count < 2) return 0;
+    double m = mean();
+    double var = sumSquares / count - m * m;
+    return var > 0 ? sqrt(var) : 0;
+  }
+  uint64_t spread() const { return count ? max - min : 0; }
+};
+
+/**
+ * @brief What the simulator tracks for one task.
+ */
+struct SimTask {
+  void (*body)(void *p);  ///< Original TaskList entry
+  uint64_t releaseUs;     ///< When the current rotation released the task
+  bool dispatched;        ///< Body called since release
+  bool completed;         ///< Became STATE_INACTIVE since release
+  bool outputSeen;        ///< Output produced since release
+  uint64_t lastOutputUs;  ///< Start of the last call that produced output
+  uint64_t busyUs;        ///< Time inside the body
+  uint64_t calls;         ///< Body calls
+  SimMetric response;
+  SimMetric completion;
+  SimMetric outputPeriod;
+};
+
+static SimTask simTasks[N_LAB_TASKS];
+static int simInsideTask = -1;        ///< Task whose body is running, or -1
+static bool simCallOutput = false;    ///< Current body call produced output
+static uint64_t simRewoundUs = 0;     ///< Virtual time removed by simRebase
+static uint64_t simPassStartUs = 0;   ///< When the current loop() pass started
+static bool simDrainOutput = false;   ///< loop() wrote to the LCD outside the task bodies this pass
+static uint64_t simDrainStartUs = 0;  ///< When that write started
+static uint32_t simRound = 0;         ///< tcbRounds() when the current rotation started
+static uint32_t simRotations = 0;     ///< Rotations completed in this run
+static uint64_t simIdleUs = 0;        ///< Time loop() spent in its idle delay in this run
+static uint64_t simPassDelayUs = 0;   ///< Last delay of the current pass outside the task bodies
+
+/**
+ * Name: simOnOutput
+ * @brief HAL output hook: notes that the running task body produced output, or that
+ *      loop() sent LCD requests from its drain.
+ */
+static void simOnOutput(HostOutput kind, int channel, uint64_t timeUs) {
+  (void)channel;
+  if (simInsideTask >= 0) {
+    simCallOutput = true;
+  } else if (kind == HOST_OUT_I2C && !simDrainOutput) {
+    simDrainOutput = true;
+    simDrainStartUs = timeUs;
+  }
+}
+
+/**
+ * Name: simRecordOutput
+ * @brief Adds an output period to task i for output that started at startUs.
+ */
+static void simRecordOutput(int i, uint64_t startUs) {
+  SimTask &t = simTasks[i];
+  if (t.outputSeen) t.outputPeriod.add(startUs - t.lastOutputUs);
+  t.outputSeen = true;
+  t.lastOutputUs = startUs;
+}
+
+/**
+ * Name: simRunTask
+ * @brief Calls the real task body for TaskHandles[i] and records what happened.
+ */
+static void simRunTask(int i, void *p) {
+  SimTask &t = simTasks[i];
+  uint64_t start = hostNowMicros();
+  if (!t.dispatched) {
+    t.dispatched = true;
+    t.response.add(start - t.releaseUs);
+  }
+
+  simInsideTask = i;
+  simCallOutput = false;
+  t.body(p);
+  simInsideTask = -1;
+
+  uint64_t end = hostNowMicros();
+  t.busyUs += end - start;
+  t.calls++;
+
+  if (simCallOutput) simRecordOutput(i, start);
+  if (!t.completed && tcbGet(TaskHandles[i])->state == STATE_INACTIVE) {
+    t.completed = true;
+    t.completion.add(end - t.releaseUs);
+  }
+}
+
+/**
+ * Name: simSkipTask
+ * @brief Stand-in body for a task left out of the mix: completes on its first call.
+ */
+static void simSkipTask(void *p) {
+  (void)p;
+  tcbComplete(tcbCurrent());
+}
+
+template <int I>
+static void simTrampoline(void *p) {
+  simRunTask(I, p);
+}
+
+static void (*const simTrampolines[N_LAB_TASKS])(void *) = {
+  simTrampoline<0>, simTrampoline<1>, simTrampoline<2>, simTrampoline<3>,
+};
+
+/**
+ * Name: simRelease
+ * @brief Starts a rotation for every task at virtual time atUs.
+ */
+static void simRelease(uint64_t atUs) {
+  for (int i = 0; i < N_LAB_TASKS; i++) {
+    simTasks[i].releaseUs = atUs;
+    simTasks[i].dispatched = false;
+    simTasks[i].completed = false;
+    simTasks[i].outputSeen = false;
+  }
+}
+
+/**
+ * Name: simRebase
+ * @brief Moves the clock back to SIM_CLOCK_BASE between rotations, see the file description.
+ */
+static void simRebase() {
+  uint64_t now = hostNowMicros();
+  if (now <= SIM_CLOCK_BASE) return;
+  uint64_t shift = now - SIM_CLOCK_BASE;
+  ledcControl.previousMicros -= (int)shift;
+  hostRewindMicros(shift);
+  simRewoundUs += shift;
+}
+
+/**
+ * Name: simElapsedMicros
+ * @brief Virtual time since the run started, including rewound time.
+ */
+static uint64_t simElapsedMicros() {
+  return hostNowMicros() + simRewoundUs;
+}
+
+/**
+ * Name: simOnDelay
+ * @brief HAL delay hook: notes a delay made outside the task bodies. The LCD library delays
+ *      while the queue drains, so only the last one of a loop() pass is its idle delay.
+ */
+static void simOnDelay(uint64_t us) {
+  if (simInsideTask < 0) simPassDelayUs = us;
+}
+
+/**
+ * Name: simEndPass
+ * @brief Accounts for a loop() pass once it returned: the LCD writes drained in it are the
+ *      LCD task's output, its last delay is idle, and a completed rotation releases the next
+ *      where that delay began.
+ */
+static void simEndPass() {
+  // the LCD writes the pass queued belong to it; if the task body already produced output
+  // in this pass, the two are one output
+  const SimTask &lcdTask = simTasks[SIM_LCD_TASK];
+  if (simDrainOutput && !(lcdTask.outputSeen && lcdTask.lastOutputUs >= simPassStartUs)) {
+    simRecordOutput(SIM_LCD_TASK, simDrainStartUs);
+  }
+  simDrainOutput = false;
+
+  if (tcbRounds() != simRound) {
+    simRound = tcbRounds();
+    simRotations++;
+    simRebase();
+    simRelease(hostNowMicros() - simPassDelayUs);
+  }
+  simIdleUs += simPassDelayUs;
+  simPassDelayUs = 0;
+}
+
+/**
+ * Name: simRun
+ * @brief Runs setup() and then the sketch's loop() until cfg.rotations rotations completed.
+ * @retval virtual microseconds spent idle in the loop period.
+ */
+static uint64_t simRun(const SimConfig &cfg) {
+  hostReset();
+  hostSetSerialBaud(cfg.baud, SIM_UART_FIFO);
+
+  // the sketch's globals keep their values between runs; restore the power-on ones
+  lcdControl = {1, 0, 500, false};
+  led1 = {LED1, true, LOW, 0, 0, 62500, 0, false};
+  ledcControl = {LED2, 100, 11, 0, 0, 1000000, false};
+  printTask = {0, 1000000, 0, "ABCDEFGHIJKLMNOPQRSTUVWXYZ", false};
+  new (&lcdQueue) decltype(lcdQueue)();  // empty queue, blank frame: lcd.init() clears the display again
+
+  simRewoundUs = 0;
+  simLoopIdleUs = cfg.loopPeriodUs;
+  setup();
+  memset(simTasks, 0, sizeof(simTasks));
+  for (int i = 0; i < N_LAB_TASKS; i++) {
+    TCBStruct *tcb = tcbGet(TaskHandles[i]);
+    simTasks[i].body = (cfg.taskMask & (1u << i)) ? tcb->ftpr : simSkipTask;
+    tcb->ftpr = simTrampolines[i];
+  }
+  simDrainOutput = false;
+  simRound = tcbRounds();
+  simRotations = 0;
+  simIdleUs = 0;
+  simPassDelayUs = 0;
+  hostSetOutputHook(simOnOutput);
+  hostSetDelayHook(simOnDelay);
+  simRelease(hostNowMicros());
+
+  while (simRotations < cfg.rotations) {
+    hostAdvanceMicros(cfg.overheadUs);
+    simPassStartUs = hostNowMicros();
+    loop();
+    simEndPass();
+  }
+  hostSetOutputHook(NULL);
+  hostSetDelayHook(NULL);
+  return simIdleUs;
+}
+
+/**
+ * @brief Sends profileDump output to stdout instead of the simulated UART.
+ */
+struct SimStdout {
+  void print(const char *str) { fputs(str, stdout); }
+};
+
+/**
+ * Name: simReport
+ * @brief Prints the per-task table for one run.
+ */
+static void simReport(const SimConfig &cfg, uint64_t idleUs, double wallSeconds) {
+  uint64_t total = simElapsedMicros();
+  printf("\nloop period %u us, %u rotations, %.1f s simulated in %.2f s, idle %.1f%%\n",
+         cfg.loopPeriodUs, cfg.rotations, total / 1e6, wallSeconds, 100.0 * idleUs / total);
+  printf("%-15s %9s %9s | %9s %9s %9s %9s | %9s %9s %9s\n", "task (ms)", "resp avg", "resp max",
+         "compl min", "compl avg", "compl max", "jitter", "out avg", "out sd", "out sprd");
+  for (int i = 0; i < N_LAB_TASKS; i++) {
+    if (!(cfg.taskMask & (1u << i))) continue;
+    const SimTask &t = simTasks[i];
+    printf("%-15s %9.2f %9.2f | %9.2f %9.2f %9.2f %9.2f | %9.2f %9.2f %9.2f\n", simTaskNames[i],
+           t.response.mean() / 1e3, t.response.max / 1e3,
+           t.completion.min / 1e3, t.completion.mean() / 1e3, t.completion.max / 1e3,
+           t.completion.spread() / 1e3,
+           t.outputPeriod.mean() / 1e3, t.outputPeriod.stddev() / 1e3, t.outputPeriod.spread() / 1e3);
+  }
+  SimStdout out;
+  profileDump(out, profiles, N_PROFILES);
+}
+
+int main(int argc, char **argv) {
+  SimConfig cfg = {15000, 1000, (1u << N_LAB_TASKS) - 1, 2, 115200};
+  bool sweep = true;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "p:r:m:o:b:")) != -1) {
+    switch (opt) {
+      case 'p': cfg.loopPeriodUs = strtoul(optarg, NULL, 0); sweep = false; break;
+      case 'r': cfg.rotations = strtoul(optarg, NULL, 0); break;
+      case 'm': cfg.taskMask = strtoul(optarg, NULL, 0); break;
+      case 'o': cfg.overheadUs = strtoul(optarg, NULL, 0); break;
+      case 'b': cfg.baud = strtoul(optarg, NULL, 0); break;
+      default:
+        fprintf(stderr, "usage: %s [-p period_us] [-r rotations] [-m task_mask] [-o overhead_us] [-b baud]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  static const uint32_t periods[] = {1000, 5000, 15000, 30000};
+  size_t runs = sweep ? sizeof(periods) / sizeof(periods[0]) : 1;
+  for (size_t r = 0; r < runs; r++) {
+    if (sweep) cfg.loopPeriodUs = periods[r];
+    double start = benchNowSeconds();
+    uint64_t idleUs = simRun(cfg);
+    simReport(cfg, idleUs, benchNowSeconds() - start);
+  }
+  return 0;
+}
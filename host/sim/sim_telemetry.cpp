@@ -0,0 +1,244 @@
+/**
+ * @file sim_telemetry.cpp
+ * @brief Host simulation of the BLE light telemetry: batching, framing and backpressure.
+ *
+ * @section description Description
+ * A light level is sampled every SIM_SAMPLE_MS with its moving average (WindowedMoments),
+ * added to a TelemetryPublisher and polled every SIM_LOOP_MS, as in
+ * Kalisi_EE590_Lab4_BLE.ino. Notifications go through the BLECharacteristic stand-in to a
+ * client model that decodes every frame.
+ *
+ * Each scenario sets the MTU, the notify interval, the backlog policy and the client:
+ * - ideal: every notification is taken.
+ * - outages: the stack reports congestion for SIM_OUTAGE_S of every SIM_OUTAGE_EVERY_S, as
+ *   the ESP_GATTS_CONGEST_EVT handler would, and notifications sent meanwhile fail.
+ * - unsignalled outages: the same outages without the congestion report, so every
+ *   notification in them fails and the publisher keeps the samples for a retry.
+ *
+ * Per scenario it reports notifications per second, payload bytes per sample, samples
+ * delivered, dropped and merged, failed notifications, and the publisher's host CPU time per sample. Every frame is
+ * checked: it decodes, sequence numbers follow on, timestamps increase, each record's
+ * level is the (mean of the) samples it stands for, and delivered + dropped + still
+ * queued adds up to the samples taken. Summarizing must coarsen the backlog evenly: no
+ * record may stand for more than twice the samples of the record after it, and the most
+ * samples behind one record is reported. Exits with 1 if a check fails.
+ *
+ * @section usage Usage
+ *   sim_telemetry [-s seconds]
+ */
+#include <Arduino.h>
+#include <BLECharacteristic.h>
+#include <Telemetry.h>
+#include <WindowedStats.h>
+#include <unistd.h>
+
+#include "Bench.h"
+
+#include <vector>
+
+#define SIM_SAMPLE_MS 50          ///< Light sampling period (20 Hz)
+#define SIM_LOOP_MS 10            ///< loop() period, poll() once per pass
+#define SIM_BACKLOG 256           ///< Samples the publisher keeps, 12.8 s at 20 Hz
+#define SIM_OUTAGE_S 30           ///< Length of a congestion outage
+#define SIM_OUTAGE_EVERY_S 60     ///< One outage starts every this many seconds
+#define SIM_CLOCK_START 1000000   ///< Virtual micros() of the first sample
+
+typedef TelemetryPublisher<SIM_BACKLOG> Publisher;
+
+/**
+ * @brief One scenario.
+ */
+struct SimScenario {
+  const char *name;
+  uint16_t mtu;
+  uint32_t intervalMs;
+  TelemetryPolicy policy;
+  bool outages;
+  bool signalled;  ///< The stack reports the outages as congestion; otherwise notifications just fail
+};
+
+/**
+ * @brief What the client model saw, and what it found wrong.
+ */
+struct SimClient {
+  const std::vector<uint16_t> *levels;  ///< Level of every sample taken, by index
+  bool outages;
+  uint32_t nextSequence;
+  uint32_t lastUs;
+  bool any;
+  uint64_t delivered;      ///< Samples behind the records received
+  uint64_t dropped;        ///< Sum of the headers' dropped counts
+  uint64_t notifications;  ///< Notifications that reached the client
+  uint16_t lastSamples;    ///< Samples behind the previous record
+  uint16_t maxSamples;     ///< Most samples behind one record
+  uint64_t uneven;         ///< Records holding over twice the samples of the next one
+  uint64_t errors;
+};
+
+static SimClient simClient;
+static Publisher *simPublisher = NULL;
+
+/**
+ * Name: simCongested
+ * @brief True while the client model is in an outage.
+ */
+static bool simCongested(uint64_t timeUs) {
+  if (!simClient.outages) return false;
+  uint64_t s = (timeUs - SIM_CLOCK_START) / 1000000;
+  return s % SIM_OUTAGE_EVERY_S >= (uint64_t)(SIM_OUTAGE_EVERY_S - SIM_OUTAGE_S);
+}
+
+/**
+ * Name: simCheckRecord
+ * @brief Compares a record with the samples it stands for.
+ */
+static void simCheckRecord(const TelemetryRecord &r) {
+  SimClient &c = simClient;
+  if (c.any && (int32_t)(r.timestampUs - c.lastUs) <= 0) c.errors++;
+  c.any = true;
+  c.lastUs = r.timestampUs;
+
+  uint64_t offset = r.timestampUs - SIM_CLOCK_START;
+  size_t first = offset / (SIM_SAMPLE_MS * 1000);
+  if (offset % (SIM_SAMPLE_MS * 1000) != 0 || r.samples == 0 || first + r.samples > c.levels->size()) {
+    c.errors++;
+    return;
+  }
+  uint64_t sum = 0;
+  for (size_t i = first; i < first + r.samples; i++) sum += (*c.levels)[i];
+  if (r.level != (sum + r.samples / 2) / r.samples) c.errors++;
+  c.delivered += r.samples;
+  if (c.lastSamples > 2 * r.samples) c.uneven++;
+  c.lastSamples = r.samples;
+  if (r.samples > c.maxSamples) c.maxSamples = r.samples;
+}
+
+/**
+ * Name: simOnNotify
+ * @brief Client model: decodes and checks a frame unless the link is congested.
+ */
+static BLECharacteristicCallbacks::Status simOnNotify(const uint8_t *data, size_t size, uint64_t timeUs) {
+  if (simCongested(timeUs)) return BLECharacteristicCallbacks::ERROR_GATT;
+
+  TelemetryHeader header = {};
+  int records = telemetryDecode(data, size, &header, simCheckRecord);
+  if (records <= 0 || header.sequence != (uint16_t)simClient.nextSequence) simClient.errors++;
+  simClient.nextSequence = header.sequence + 1;
+  simClient.dropped += header.dropped;
+  simClient.notifications++;
+  return BLECharacteristicCallbacks::SUCCESS_NOTIFY;
+}
+
+/**
+ * @brief Forwards the characteristic's status to the publisher, as the sketch's callbacks do.
+ */
+class SimCallbacks : public BLECharacteristicCallbacks {
+  void onStatus(BLECharacteristic *characteristic, Status s, uint32_t code) override {
+    (void)characteristic;
+    (void)code;
+    simPublisher->notifyResult(s == SUCCESS_NOTIFY);
+  }
+};
+
+/**
+ * Name: simLevel
+ * @brief Light level of sample i: a slow swing with some noise, 0 to 4095.
+ */
+static uint16_t simLevel(size_t i) {
+  uint32_t noise = (uint32_t)i * 2654435761u;
+  double swing = 1800.0 * sin((double)i / 400.0);
+  return (uint16_t)(2000 + (int)swing + (int)((noise >> 16) % 101) - 50);
+}
+
+/**
+ * Name: simRun
+ * @brief Runs one scenario for seconds of virtual time and prints its row.
+ * @retval true if every check passed.
+ */
+static bool simRun(const SimScenario &sc, uint32_t seconds) {
+  hostReset();
+  hostAdvanceMicros(SIM_CLOCK_START);
+
+  size_t samples = (size_t)seconds * 1000 / SIM_SAMPLE_MS;
+  std::vector<uint16_t> levels(samples);
+  for (size_t i = 0; i < samples; i++) levels[i] = simLevel(i);
+
+  memset(&simClient, 0, sizeof(simClient));
+  simClient.levels = &levels;
+  simClient.outages = sc.outages;
+
+  Publisher publisher(sc.policy, sc.intervalMs);
+  publisher.setMtu(sc.mtu);
+  simPublisher = &publisher;
+  BLECharacteristic characteristic;
+  SimCallbacks callbacks;
+  characteristic.setCallbacks(&callbacks);
+  hostSetNotifyHook(simOnNotify);
+
+  WindowedMoments<5> window;
+  size_t taken = 0;
+  double cpu = 0;
+  for (uint64_t ms = 0; taken < samples; ms += SIM_LOOP_MS) {
+    uint64_t now = hostNowMicros();
+    double start = benchNowSeconds();
+    if (ms % SIM_SAMPLE_MS == 0) {
+      window.add(levels[taken]);
+      publisher.add((uint32_t)now, levels[taken], (uint16_t)window.mean());
+      taken++;
+    }
+    if (sc.signalled) publisher.setCongested(simCongested(now));  // the GATTS congestion event
+    publisher.poll(characteristic, (uint32_t)now);
+    cpu += benchNowSeconds() - start;
+    hostAdvanceMicros(SIM_LOOP_MS * 1000);
+  }
+  hostSetNotifyHook(NULL);
+  simPublisher = NULL;
+
+  // the rest is still queued; a summarized record can stand for several samples
+  uint64_t queued = samples - simClient.delivered - publisher.dropped();
+  // drops after the last frame are not in any header yet
+  bool ok = simClient.errors == 0 && simClient.uneven == 0 && simClient.dropped <= publisher.dropped() &&
+            simClient.delivered + publisher.dropped() <= samples && queued >= publisher.pending() &&
+            (publisher.pending() > 0 || queued == 0);
+  if (!sc.outages || sc.policy == TELEMETRY_SUMMARIZE) ok = ok && publisher.dropped() == 0;
+
+  printf("%-38s %6u %8.2f %9.1f %9llu %8u %8u %7u %7u %8.0f %s\n", sc.name, (unsigned)publisher.recordsPerFrame(),
+         (double)characteristic.notifications / seconds, (double)characteristic.notifiedBytes / samples,
+         (unsigned long long)simClient.delivered, publisher.dropped(), publisher.summarized(), simClient.maxSamples,
+         publisher.failures(), cpu * 1e9 / samples, ok ? "ok" : "FAIL");
+  if (!ok) {
+    printf("  %llu errors, header drops %llu, publisher drops %u, pending %zu\n",
+           (unsigned long long)simClient.errors, (unsigned long long)simClient.dropped, publisher.dropped(),
+           publisher.pending());
+  }
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  uint32_t seconds = 600;
+  int opt;
+  while ((opt = getopt(argc, argv, "s:")) != -1) {
+    switch (opt) {
+      case 's': seconds = (uint32_t)strtoul(optarg, NULL, 10); break;
+      default:
+        fprintf(stderr, "usage: %s [-s seconds]\n", argv[0]);
+        return 2;
+    }
+  }
+
+  static const SimScenario scenarios[] = {
+    {"per sample, MTU 23, ideal", 23, 0, TELEMETRY_DROP_OLDEST, false, false},
+    {"batched 1 s, MTU 247, ideal", 247, 1000, TELEMETRY_DROP_OLDEST, false, false},
+    {"per sample, MTU 23, outages", 23, 0, TELEMETRY_DROP_OLDEST, true, true},
+    {"batched 1 s, outages, drop oldest", 247, 1000, TELEMETRY_DROP_OLDEST, true, true},
+    {"batched 1 s, outages, summarize", 247, 1000, TELEMETRY_SUMMARIZE, true, true},
+    {"batched 1 s, unsignalled, summarize", 247, 1000, TELEMETRY_SUMMARIZE, true, false},
+  };
+
+  printf("%u s at %d Hz, backlog %d samples\n", seconds, 1000 / SIM_SAMPLE_MS, SIM_BACKLOG);
+  printf("%-38s %6s %8s %9s %9s %8s %8s %7s %7s %8s\n", "scenario", "rec/fr", "notify/s", "bytes/smp", "delivered",
+         "dropped", "merged", "smp/rec", "failed", "ns/smp");
+  bool ok = true;
+  for (const SimScenario &sc : scenarios) ok = simRun(sc, seconds) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file BlinkAlarm.h
+ * @brief Non-blocking LED blink pattern for an alarm, driven by timestamps instead of delays.
+ *
+ * @section description Description
+ * A BlinkAlarm replaces "for 4 blinks: on, delay, off, delay" in an alarm task. trigger(now)
+ * starts a pattern of BLINKS on/off cycles, poll(now) moves the LED through the edges that
+ * are due, and untilNextEdge(now) tells the task how long it may block, e.g. as the timeout
+ * of its queue receive. The task therefore keeps checking new samples while the LED blinks,
+ * instead of leaving them queued for the length of the pattern.
+ *
+ * Triggering again while the pattern runs restarts its count without breaking the current
+ * on/off cycle, so a sustained anomaly blinks steadily and stops BLINKS cycles after the
+ * last anomalous sample.
+ *
+ * @section notes Notes
+ * - Times are 32 bit microseconds with wrap-safe differences.
+ * - One task owns an alarm; nothing here is shared.
+ *
+ * @section author Author
+ * Created by Sai Jayanth Kalisi, 2025
+ */
+#ifndef BLINK_ALARM_H
+#define BLINK_ALARM_H
+
+#include <stdint.h>
+
+/**
+ * @brief On/off LED pattern started by trigger() and advanced by poll().
+ */
+class BlinkAlarm {
+public:
+  /**
+   * @param blinks on/off cycles per trigger.
+   * @param halfPeriodUs time the LED stays on, and then off, in each cycle.
+   */
+  BlinkAlarm(uint8_t blinks, uint32_t halfPeriodUs) : blinks_(blinks), halfPeriodUs_(halfPeriodUs) {}
+
+  /**
+   * Name: trigger
+   * @brief Starts the pattern with the LED on, or restarts the count of a running pattern.
+   */
+  void trigger(uint32_t nowUs) {
+    if (edgesLeft_ == 0) {
+      on_ = true;
+      nextEdgeUs_ = nowUs + halfPeriodUs_;
+      edgesLeft_ = 2 * blinks_ - 1;  // the turn-on just made counts as the first edge
+      triggers_++;
+      return;
+    }
+    edgesLeft_ = on_ ? 2 * blinks_ - 1 : 2 * blinks_;  // finish this cycle, then BLINKS more
+    triggers_++;
+  }
+
+  /**
+   * Name: poll
+   * @brief Applies every edge due by nowUs.
+   * @retval true if the LED level differs from the one the last poll reported, including a
+   *      turn-on made by trigger(); write level() to the pin.
+   */
+  bool poll(uint32_t nowUs) {
+    while (edgesLeft_ > 0 && (int32_t)(nowUs - nextEdgeUs_) >= 0) {
+      on_ = !on_;
+      edgesLeft_--;
+      nextEdgeUs_ += halfPeriodUs_;
+    }
+    bool changed = on_ != reported_;
+    reported_ = on_;
+    return changed;
+  }
+
+  /**
+   * Name: untilNextEdge
+   * @brief Microseconds until poll() has an edge to apply: 0 if one is due, UINT32_MAX if idle.
+   */
+  uint32_t untilNextEdge(uint32_t nowUs) const {
+    if (edgesLeft_ == 0) return UINT32_MAX;
+    int32_t left = (int32_t)(nextEdgeUs_ - nowUs);
+    return (left > 0) ? (uint32_t)left : 0;
+  }
+
+  bool level() const { return on_; }             ///< LED on
+  bool active() const { return edgesLeft_ > 0; } ///< Pattern still running
+  uint32_t triggers() const { return triggers_; }
+
+private:
+  uint8_t blinks_;
+  uint32_t halfPeriodUs_;
+  bool on_ = false;
+  bool reported_ = false;     ///< Level returned to the caller by the last poll
+  uint32_t edgesLeft_ = 0;    ///< Edges still to apply; the last turns the LED off
+  uint32_t nextEdgeUs_ = 0;
+  uint32_t triggers_ = 0;
+};
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file EventQueue.h
+ * @brief Lock-free queue of timestamped events, pushed from ISRs and callbacks, drained by the loop.
+ *
+ * @section description Description
+ * EventQueue<N> replaces "volatile bool somethingHappened" flags. Every interrupt or
+ * callback pushes an Event carrying its type, the micros() it happened at and a 32 bit
+ * payload, and the main loop pops them in order. Two presses between two passes of the
+ * loop are two events instead of one flag set twice, and the timestamps let the loop
+ * debounce or measure latency after the fact.
+ *
+ * Any number of producers may push at once, from ISRs on either core and from tasks such
+ * as the BLE callbacks. Each slot carries a sequence number (a bounded MPMC ring in the
+ * style of D. Vyukov): a producer claims a slot with one compare-and-swap on the tail and
+ * publishes it by storing the slot's sequence. Nothing waits on a lock, so an ISR that
+ * interrupts a producer in the middle of its push still completes its own.
+ *
+ * @section notes Notes
+ * - One consumer. pop() is not safe to call from two tasks at once.
+ * - A full queue rejects the event: push returns false and overflows() counts it, so a
+ *   loss is always visible. Size N for the longest burst the consumer can fall behind by.
+ * - An event claimed but not yet published (its producer was interrupted) holds back the
+ *   events after it until the producer finishes; pop() returns false meanwhile.
+ * - push() is small enough for IRAM_ATTR ISRs: no allocation, no blocking.
+ *
+ * @section author Author
+ * Created by Sai Jayanth Kalisi, 2025
+ */
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief One queued event.
+ */
+struct Event {
+  uint32_t timeUs;  ///< micros() when it happened
+  uint32_t payload; ///< Meaning depends on type
+  uint16_t type;    ///< Caller defined
+};
+
+/**
+ * @brief Bounded multi-producer, single-consumer event queue.
+ * @tparam N events the queue holds; a power of two.
+ */
+template <size_t N>
+class EventQueue {
+  static_assert(N > 1 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+  EventQueue() {
+    for (uint32_t i = 0; i < N; i++) slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  /**
+   * Name: push
+   * @brief Queues an event. Safe from any number of ISRs and tasks at once.
+   * @retval true if queued, false if the queue was full (counted by overflows()).
+   */
+  bool push(uint16_t type, uint32_t timeUs, uint32_t payload = 0) {
+    uint32_t pos = tail_.load(std::memory_order_relaxed);
+    Slot *slot;
+    for (;;) {
+      slot = &slots_[pos & (N - 1)];
+      int32_t diff = (int32_t)(slot->sequence.load(std::memory_order_acquire) - pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        overflows_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    slot->event.timeUs = timeUs;
+    slot->event.payload = payload;
+    slot->event.type = type;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Name: pop
+   * @brief Takes the oldest event. Consumer only.
+   * @retval true if out was filled, false if there is nothing (published) to take.
+   */
+  bool pop(Event &out) {
+    uint32_t pos = head_;
+    Slot &slot = slots_[pos & (N - 1)];
+    if ((int32_t)(slot.sequence.load(std::memory_order_acquire) - (pos + 1)) < 0) return false;
+    out = slot.event;
+    slot.sequence.store(pos + N, std::memory_order_release);  // free for the producer N pushes later
+    head_ = pos + 1;
+    return true;
+  }
+
+  /**
+   * Name: size
+   * @brief Events claimed and not yet popped. Consumer only; approximate while producers push.
+   */
+  size_t size() const { return tail_.load(std::memory_order_relaxed) - head_; }
+
+  /**
+   * Name: overflows
+   * @brief Events rejected because the queue was full.
+   */
+  uint32_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
+
+private:
+  struct Slot {
+    std::atomic<uint32_t> sequence;  ///< pos + 1 once the event for pos is published, pos + N once popped
+    Event event;
+  };
+
+  Slot slots_[N];
+  alignas(64) std::atomic<uint32_t> tail_{0};      ///< Events ever claimed; shared by the producers
+  std::atomic<uint32_t> overflows_{0};
+  alignas(64) uint32_t head_ = 0;                  ///< Events ever popped; consumer only
+};
+
+#endif
@@ -0,0 +1,206 @@
+/**
+ * @file LcdFrame.h
+ * @brief Shadow framebuffer for a character LCD that only sends the cells that changed.
+ *
+ * @section description Description
+ * LcdFrame<COLS, ROWS> keeps two copies of the screen in RAM: the frame being drawn
+ * and what the display was last sent. Writers draw with the usual clear(), setCursor()
+ * and print() calls, which only touch the frame. flush(lcd) then compares the two and
+ * writes the differing cells to the display, so redrawing a whole screen every update
+ * costs nothing on the bus for the cells that stayed the same.
+ *
+ * The display's address counter advances after every character, so a run of changed
+ * cells needs one setCursor before it and none inside it. flush skips even that
+ * setCursor when the cursor is already there from the previous run, and writes a single
+ * unchanged cell between two changed ones instead of moving past it (the same bus cost
+ * as the setCursor it saves). A counter going from 41 to 42 is one setCursor and one character;
+ * lcd.clear() plus a full repaint is a 1.5 ms clear, two setCursors and up to 32
+ * characters, and the screen is blank in between.
+ *
+ * @section notes Notes
+ * - The frame starts blank with the cursor unknown, which matches a display just after
+ *   lcd.init() or lcd.clear(). If anything else writes to the display, call invalidate()
+ *   so the next flush repaints every cell.
+ * - Text past the end of a row is dropped; it does not wrap onto the next row.
+ * - flush works with anything that has setCursor(col, row) and write(uint8_t), e.g.
+ *   LiquidCrystal_I2C.
+ * - One writer: the frame is not thread safe.
+ *
+ * @section author Author
+ * Created by Sai Jayanth Kalisi, 2025
+ */
+#ifndef LCD_FRAME_H
+#define LCD_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LCD_FRAME_CURSOR_UNKNOWN 0xFF ///< DDRAM address stored when the display cursor is not known
+
+/**
+ * @brief RAM copy of a COLS x ROWS character display, flushed as a diff.
+ * @tparam COLS characters per row, at most 40.
+ * @tparam ROWS rows, at most 4.
+ */
+template <uint8_t COLS, uint8_t ROWS>
+class LcdFrame {
+  static_assert(COLS > 0 && COLS <= 40 && ROWS > 0 && ROWS <= 4, "HD44780 geometry");
+
+public:
+  LcdFrame() {
+    memset(frame_, ' ', sizeof(frame_));
+    memset(shown_, ' ', sizeof(shown_));
+  }
+
+  /**
+   * Name: clear
+   * @brief Blanks the frame and moves the drawing position to 0, 0. Nothing is sent.
+   */
+  void clear() {
+    memset(frame_, ' ', sizeof(frame_));
+    col_ = row_ = 0;
+  }
+
+  /**
+   * Name: setCursor
+   * @brief Moves the drawing position. Out of range rows are clamped to the last one.
+   */
+  void setCursor(uint8_t col, uint8_t row) {
+    col_ = col;
+    row_ = (row < ROWS) ? row : ROWS - 1;
+  }
+
+  /**
+   * Name: write
+   * @brief Draws one character at the drawing position and moves it right.
+   * @retval 1 if the character is on the frame, 0 if it fell past the end of the row.
+   */
+  size_t write(uint8_t c) {
+    if (col_ >= COLS) return 0;
+    frame_[row_][col_++] = (char)c;
+    return 1;
+  }
+
+  size_t print(const char *str) {
+    size_t n = 0;
+    while (*str) n += write((uint8_t)*str++);
+    return n;
+  }
+
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int num) { return print((long)num); }
+  size_t print(unsigned int num) { return print((unsigned long)num); }
+  size_t print(long num) {
+    if (num >= 0) return print((unsigned long)num);
+    return write('-') + print(0UL - (unsigned long)num);
+  }
+  size_t print(unsigned long num) {
+    char digits[20];
+    int n = 0;
+    do {
+      digits[n++] = (char)('0' + num % 10);
+      num /= 10;
+    } while (num != 0);
+    size_t written = 0;
+    while (n > 0) written += write((uint8_t)digits[--n]);
+    return written;
+  }
+
+  /**
+   * Name: clearToEnd
+   * @brief Blanks the rest of the current row from the drawing position.
+   * @details For redrawing one field in place, e.g. a number that got shorter.
+   */
+  void clearToEnd() {
+    while (col_ < COLS) frame_[row_][col_++] = ' ';
+  }
+
+  /**
+   * Name: dirty
+   * @brief True if the next flush has anything to send.
+   */
+  bool dirty() const { return stale_ || memcmp(frame_, shown_, sizeof(frame_)) != 0; }
+
+  /**
+   * Name: invalidate
+   * @brief Forgets what the display shows, so the next flush rewrites every cell.
+   */
+  void invalidate() {
+    stale_ = true;
+    cursor_ = LCD_FRAME_CURSOR_UNKNOWN;
+  }
+
+  /**
+   * Name: flush
+   * @brief Sends the cells that differ from the display, with as few cursor moves as possible.
+   * @details Each row is scanned for runs of changed cells. A run is extended over a single
+   *      unchanged cell when another changed cell follows it. Each run costs one setCursor,
+   *      left out when the cursor already sits at its first cell, plus its characters.
+   * @retval characters plus cursor moves sent; 0 when the display was already up to date.
+   */
+  template <typename Lcd>
+  size_t flush(Lcd &lcd) {
+    size_t sent = 0;
+    for (uint8_t r = 0; r < ROWS; r++) {
+      const char *want = frame_[r];
+      char *have = shown_[r];
+      uint8_t c = 0;
+      while (c < COLS) {
+        if (!stale_ && want[c] == have[c]) {
+          c++;
+          continue;
+        }
+        uint8_t end = c + 1;
+        while (end < COLS) {
+          if (stale_ || want[end] != have[end]) {
+            end++;
+          } else if (end + 1 < COLS && want[end + 1] != have[end + 1]) {
+            end += 2;
+          } else {
+            break;
+          }
+        }
+
+        uint8_t address = rowAddress(r) + c;
+        if (cursor_ != address) {
+          lcd.setCursor(c, r);
+          sent++;
+        }
+        for (; c < end; c++) {
+          lcd.write((uint8_t)want[c]);
+          have[c] = want[c];
+          sent++;
+        }
+        cursor_ = rowAddress(r) + end;
+      }
+    }
+    stale_ = false;
+    return sent;
+  }
+
+  /**
+   * Name: row
+   * @brief The frame's row r, COLS characters, not NUL terminated.
+   */
+  const char *row(uint8_t r) const { return frame_[r < ROWS ? r : ROWS - 1]; }
+
+private:
+  /**
+   * Name: rowAddress
+   * @brief HD44780 DDRAM address of the first cell of row r.
+   */
+  static uint8_t rowAddress(uint8_t r) {
+    static const uint8_t offsets[4] = {0x00, 0x40, 0x14, 0x54};  // as LiquidCrystal_I2C::setCursor
+    return offsets[r];
+  }
+
+  char frame_[ROWS][COLS];          ///< What the writers drew
+  char shown_[ROWS][COLS];          ///< What the display was last sent
+  uint8_t col_ = 0;                 ///< Drawing position
+  uint8_t row_ = 0;
+  uint8_t cursor_ = LCD_FRAME_CURSOR_UNKNOWN; ///< DDRAM address the display's cursor is at
+  bool stale_ = false;              ///< shown_ is not to be trusted; rewrite every cell
+};
+
+#endif
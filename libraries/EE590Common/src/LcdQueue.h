@@ -0,0 +1,268 @@
+/**
+ * @file LcdQueue.h
+ * @brief Non-blocking LCD requests, queued by one task and sent to the display by another.
+ *
+ * @section description Description
+ * LcdQueue<N, COLS, ROWS> takes clear, setCursor and print requests into a bounded queue of
+ * N commands. Posting copies the request and returns at once; no I2C is done by the
+ * caller. A lower priority task, or the idle part of a loop, calls drain(lcd), which
+ * applies every queued command to an LcdFrame and flushes it, so only the cells that
+ * changed go over the bus and a burst of requests costs one flush.
+ *
+ * Every post returns a ticket. done(ticket) becomes true once that command, and every
+ * command before it, is on the display. wait(ticket, idle) calls idle() until then, for
+ * a caller that has to know, e.g. before reporting that its output is complete.
+ *
+ * Requests posted between beginUpdate() and endUpdate() are published together or not at
+ * all, so a screen made of several requests (clear, then print, then print) never
+ * reaches the display half drawn when the queue fills up part way through.
+ *
+ * An optional wake callback is run after each post, e.g. to notify the drain task so it
+ * can block instead of polling.
+ *
+ * @section notes Notes
+ * - One posting task and one draining task (single producer, single consumer). The
+ *   counters are atomics, so the two may run on different cores.
+ * - A full queue rejects the request: post returns LCD_QUEUE_FULL and dropped() counts it.
+ *   Nothing blocks. Text longer than LCD_QUEUE_TEXT takes several commands, all or none.
+ *   A rejected update is dropped whole and counts once.
+ * - The display should be cleared (lcd.init() or lcd.clear()) before the first drain; the
+ *   frame starts blank.
+ *
+ * @section author Author
+ * Created by Sai Jayanth Kalisi, 2025
+ */
+#ifndef LCD_QUEUE_H
+#define LCD_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "LcdFrame.h"
+
+#define LCD_QUEUE_TEXT 16 ///< Characters carried by one print command
+#define LCD_QUEUE_FULL 0  ///< Returned instead of a ticket when the request did not fit
+
+typedef void (*LcdQueueWake)(void *arg); ///< Run after every accepted post
+
+/**
+ * @brief Bounded single-producer, single-consumer queue of LCD requests.
+ * @tparam N commands the queue holds; a power of two.
+ * @tparam COLS display columns.
+ * @tparam ROWS display rows.
+ */
+template <size_t N, uint8_t COLS, uint8_t ROWS>
+class LcdQueue {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+  /**
+   * Name: setWake
+   * @brief Sets the callback run after every accepted post, or NULL for none.
+   */
+  void setWake(LcdQueueWake wake, void *arg) {
+    wakeArg_ = arg;
+    wake_ = wake;
+  }
+
+  /**
+   * Name: beginUpdate
+   * @brief Holds back the following requests until endUpdate(), which posts all or none.
+   * @details Inside an update each request returns the ticket it will have, or
+   *      LCD_QUEUE_FULL once one did not fit. Updates do not nest.
+   */
+  void beginUpdate() {
+    updating_ = true;
+    updateFull_ = false;
+  }
+
+  /**
+   * Name: endUpdate
+   * @brief Publishes every request since beginUpdate(), or none of them if one did not fit.
+   * @retval ticket of the last command, or LCD_QUEUE_FULL if the update was dropped or empty.
+   */
+  uint32_t endUpdate() {
+    updating_ = false;
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (updateFull_) {
+      staged_ = tail;
+      dropped_++;
+      return LCD_QUEUE_FULL;
+    }
+    if (staged_ == tail) return LCD_QUEUE_FULL;
+    return publish();
+  }
+
+  /**
+   * @name Requests
+   * Each returns the ticket of its last command, or LCD_QUEUE_FULL.
+   * @{
+   */
+  uint32_t clear() { return post(OP_CLEAR, 0, 0, NULL, 0); }
+  uint32_t setCursor(uint8_t col, uint8_t row) { return post(OP_CURSOR, col, row, NULL, 0); }
+  uint32_t clearToEnd() { return post(OP_CLEAR_TO_END, 0, 0, NULL, 0); }
+  uint32_t print(const char *str) { return post(OP_TEXT, 0, 0, str, strlen(str)); }
+  uint32_t print(int num) { return print((long)num); }
+  uint32_t print(long num) {
+    if (num >= 0) return print((unsigned long)num);
+    char text[21];
+    text[0] = '-';
+    size_t len = 1 + formatUnsigned(0UL - (unsigned long)num, text + 1);
+    return post(OP_TEXT, 0, 0, text, len);
+  }
+  uint32_t print(unsigned long num) {
+    char text[20];
+    return post(OP_TEXT, 0, 0, text, formatUnsigned(num, text));
+  }
+  /** @} */
+
+  /**
+   * Name: drain
+   * @brief Applies every queued command and flushes the changed cells to lcd.
+   * @details Called by the consumer only. Commands posted while it runs are left for the
+   *      next call.
+   * @retval commands applied.
+   */
+  template <typename Lcd>
+  size_t drain(Lcd &lcd) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    uint32_t tail = tail_.load(std::memory_order_acquire);
+    if (head == tail) return 0;
+
+    for (uint32_t i = head; i != tail; i++) {
+      const Command &cmd = slots_[i & (N - 1)];
+      switch (cmd.op) {
+        case OP_CLEAR: frame_.clear(); break;
+        case OP_CURSOR: frame_.setCursor(cmd.col, cmd.row); break;
+        case OP_CLEAR_TO_END: frame_.clearToEnd(); break;
+        case OP_TEXT:
+          for (uint8_t k = 0; k < cmd.len; k++) frame_.write((uint8_t)cmd.text[k]);
+          break;
+      }
+    }
+    head_.store(tail, std::memory_order_release);  // slots are free again
+    frame_.flush(lcd);
+    completed_.store(tail, std::memory_order_release);
+    return tail - head;
+  }
+
+  /**
+   * Name: done
+   * @brief True once the command with this ticket is on the display.
+   */
+  bool done(uint32_t ticket) const {
+    return (int32_t)(completed_.load(std::memory_order_acquire) - ticket) >= 0;
+  }
+
+  /**
+   * Name: wait
+   * @brief Calls idle() until done(ticket), e.g. with a one tick vTaskDelay.
+   */
+  template <typename Idle>
+  void wait(uint32_t ticket, Idle idle) const {
+    while (!done(ticket)) idle();
+  }
+
+  /**
+   * Name: pending
+   * @brief Commands queued and not yet drained.
+   */
+  size_t pending() const {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Name: dropped
+   * @brief Requests rejected because the queue was full.
+   */
+  uint32_t dropped() const { return dropped_; }
+
+private:
+  enum : uint8_t { OP_CLEAR, OP_CURSOR, OP_CLEAR_TO_END, OP_TEXT };
+
+  struct Command {
+    uint8_t op;
+    uint8_t col;
+    uint8_t row;
+    uint8_t len;
+    char text[LCD_QUEUE_TEXT];
+  };
+
+  /**
+   * Name: formatUnsigned
+   * @brief Writes num in decimal to text, without a terminator.
+   * @retval characters written.
+   */
+  static size_t formatUnsigned(unsigned long num, char *text) {
+    char digits[20];
+    size_t n = 0;
+    do {
+      digits[n++] = (char)('0' + num % 10);
+      num /= 10;
+    } while (num != 0);
+    for (size_t i = 0; i < n; i++) text[i] = digits[n - 1 - i];
+    return n;
+  }
+
+  /**
+   * Name: post
+   * @brief Queues one request as one command, or several for long text.
+   * @details The commands are written past staged_ and published at once, or by endUpdate()
+   *      inside an update.
+   */
+  uint32_t post(uint8_t op, uint8_t col, uint8_t row, const char *text, size_t len) {
+    if (updating_ && updateFull_) return LCD_QUEUE_FULL;
+    uint32_t tail = staged_;
+    uint32_t head = head_.load(std::memory_order_acquire);
+    size_t commands = (op == OP_TEXT && len > LCD_QUEUE_TEXT) ? (len + LCD_QUEUE_TEXT - 1) / LCD_QUEUE_TEXT : 1;
+    if (N - (tail - head) < commands) {
+      if (updating_) {
+        updateFull_ = true;
+      } else {
+        dropped_++;
+      }
+      return LCD_QUEUE_FULL;
+    }
+
+    do {
+      Command &cmd = slots_[tail & (N - 1)];
+      cmd.op = op;
+      cmd.col = col;
+      cmd.row = row;
+      cmd.len = (uint8_t)((len < LCD_QUEUE_TEXT) ? len : LCD_QUEUE_TEXT);
+      if (cmd.len) memcpy(cmd.text, text, cmd.len);
+      text += cmd.len;
+      len -= cmd.len;
+      tail++;
+    } while (len > 0);
+    staged_ = tail;
+    return updating_ ? tail : publish();
+  }
+
+  /**
+   * Name: publish
+   * @brief Hands the staged commands to the consumer and runs the wake callback.
+   * @retval ticket of the last command.
+   */
+  uint32_t publish() {
+    tail_.store(staged_, std::memory_order_release);
+    if (wake_ != NULL) wake_(wakeArg_);
+    return staged_;
+  }
+
+  Command slots_[N];
+  alignas(64) std::atomic<uint32_t> tail_{0};       ///< Commands ever posted; written by the producer
+  alignas(64) std::atomic<uint32_t> head_{0};       ///< Commands ever drained; written by the consumer
+  std::atomic<uint32_t> completed_{0};              ///< Ticket of the last command on the display
+  LcdFrame<COLS, ROWS> frame_;                      ///< Consumer's view of the display
+  uint32_t staged_ = 0;                             ///< Producer's tail, ahead of tail_ inside an update
+  bool updating_ = false;                           ///< Between beginUpdate() and endUpdate()
+  bool updateFull_ = false;                         ///< A request of the current update did not fit
+  uint32_t dropped_ = 0;
+  LcdQueueWake wake_ = NULL;
+  void *wakeArg_ = NULL;
+};
+
+#endif
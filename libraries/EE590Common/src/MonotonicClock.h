@@ -0,0 +1,85 @@
+/**
+ * @file MonotonicClock.h
+ * @brief 64 bit monotonic time from an ESP32 timer group counter.
+ *
+ * @section description Description
+ * The sketches used to latch the timer and read only TIMG_T0LO_REG, then subtract
+ * 32 bit values. That low word wraps every 2^32 counts: about 71 minutes at 1 MHz and
+ * about 53 s at 80 MHz. MonotonicClock latches the counter and reads both halves, so
+ * differences of its values never wrap in practice (the counter is 54 bits wide: more
+ * than 500 years at 1 MHz, 7 years at 80 MHz).
+ *
+ * @section notes Notes
+ * - The update register latches LO and HI together, but another caller (an ISR, the
+ *   other core) may latch again between our two reads. ticks() reads HI on both sides
+ *   of LO and retries if it moved, so a mixed pair is never returned.
+ * - Only timer 0 of a group is used, as everywhere else in the labs.
+ *
+ * @section author Author
+ * Created by Sai Jayanth Kalisi, 2025
+ */
+#ifndef MONOTONIC_CLOCK_H
+#define MONOTONIC_CLOCK_H
+
+#include <stdint.h>
+#include "soc/timer_group_reg.h"
+
+#define CLOCK_TIMER_EN        (1u << 31) ///< Timer enable bit of T0CONFIG
+#define CLOCK_TIMER_INCREMENT (1u << 30) ///< Count up instead of down
+#define CLOCK_DIVIDER_SHIFT   13         ///< Divider field of T0CONFIG
+
+/**
+ * @brief Wrap-free reader for timer 0 of one timer group.
+ */
+class MonotonicClock {
+public:
+  /**
+   * Name: MonotonicClock
+   * @param group timer group (0 or 1).
+   * @param countsPerMicro counter frequency in MHz, e.g. 1 with an 80 divider on the 80 MHz APB clock.
+   */
+  MonotonicClock(int group, uint32_t countsPerMicro) : group_(group), countsPerMicro_(countsPerMicro) {}
+
+  /**
+   * Name: start
+   * @brief Configures the timer to count up from its current value with the given APB divider.
+   * @details Sketches that configure the timer themselves skip this and only read.
+   */
+  void start(uint32_t divider) {
+    *(volatile uint32_t *) TIMG_T0CONFIG_REG(group_) =
+        CLOCK_TIMER_EN | CLOCK_TIMER_INCREMENT | (divider << CLOCK_DIVIDER_SHIFT);
+  }
+
+  /**
+   * Name: ticks
+   * @brief Latches the counter and returns all of it.
+   */
+  uint64_t ticks() const {
+    volatile uint32_t *update = (volatile uint32_t *) TIMG_T0UPDATE_REG(group_);
+    volatile uint32_t *lo = (volatile uint32_t *) TIMG_T0LO_REG(group_);
+    volatile uint32_t *hi = (volatile uint32_t *) TIMG_T0HI_REG(group_);
+
+    uint32_t h1, l, h2;
+    do {
+      *update = 1;
+      h1 = *hi;
+      l = *lo;
+      h2 = *hi;
+    } while (h1 != h2);
+    return ((uint64_t)h1 << 32) | l;
+  }
+
+  /**
+   * Name: micros
+   * @brief ticks() converted to microseconds.
+   */
+  uint64_t micros() const {
+    return (countsPerMicro_ == 1) ? ticks() : ticks() / countsPerMicro_;
+  }
+
+private:
+  int group_;
+  uint32_t countsPerMicro_;
+};
+
+#endif
@@ -0,0 +1,228 @@
+/**
+ * @file PrimeSieve.h
+ * @brief Segmented, odd-only, bit-packed Sieve of Eratosthenes over [low, high).
+ *
+ * @section description Description
+ * The range is sieved one segment at a time. A segment is SIEVE_SEGMENT_BYTES of
+ * bits, one bit per odd number, so it covers 16 * SIEVE_SEGMENT_BYTES integers and
+ * stays in cache while every base prime crosses off its multiples. Between segments
+ * the caller can yield, print or hand the primes on; nothing is kept from one segment
+ * to the next except the base primes (the odd primes up to sqrt(high)).
+ *
+ * Memory is the segment plus 2 bytes per base prime: about 4.9 KB for any range up
+ * to 10^7, about 17 KB up to 2^32. Work per segment is the segment size plus the
+ * crossings-off, so the whole range costs O(n log log n) with no per-number division.
+ *
+ * Ranges can be split with splitPoint and each part given its own PrimeSieve, e.g.
+ * one per ESP32 core or per host thread. Parts share nothing.
+ *
+ * @section notes Notes
+ * - One PrimeSieve per task: it holds its segment and is not thread safe.
+ * - The base primes are allocated with malloc in the constructor; ok() is false if
+ *   that failed.
+ *
+ * @section author Author
+ * Created by Sai Jayanth Kalisi, 2025
+ */
+#ifndef PRIME_SIEVE_H
+#define PRIME_SIEVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef SIEVE_SEGMENT_BYTES
+#define SIEVE_SEGMENT_BYTES 4096 ///< Segment size; must be a multiple of 4
+#endif
+#define SIEVE_SEGMENT_WORDS (SIEVE_SEGMENT_BYTES / 4)
+#define SIEVE_SEGMENT_BITS  (SIEVE_SEGMENT_BYTES * 8)  ///< Odd numbers per segment
+#define SIEVE_SEGMENT_SPAN  (2ULL * SIEVE_SEGMENT_BITS) ///< Integers per segment
+
+/**
+ * @brief Produces the primes of [low, high) one segment at a time.
+ */
+class PrimeSieve {
+public:
+  /**
+   * Name: PrimeSieve
+   * @param low first number of the range.
+   * @param high one past the last number; at most 2^32 - 1.
+   */
+  PrimeSieve(uint32_t low, uint32_t high) : high_(high) {
+    next_ = (low < 3) ? 3 : (low | 1);
+    pendingTwo_ = low <= 2 && high > 2;
+    segLow_ = segHigh_ = next_;
+
+    // odd primes up to sqrt(high), found with a plain sieve of one byte per odd number
+    uint32_t limit = 1;
+    while ((uint64_t)(limit + 1) * (limit + 1) < high_) limit++;
+    uint32_t odds = (limit + 1) / 2;  // 1, 3, 5 ... limit
+    uint8_t *composite = (uint8_t *)calloc(odds + 1, 1);
+    basePrimes_ = (uint16_t *)malloc((odds + 1) * sizeof(uint16_t));
+    if (composite == NULL || basePrimes_ == NULL) {
+      free(composite);
+      free(basePrimes_);
+      basePrimes_ = NULL;
+      return;
+    }
+    for (uint32_t i = 1; i < odds; i++) {
+      if (composite[i]) continue;
+      uint32_t p = 2 * i + 1;
+      basePrimes_[baseCount_++] = (uint16_t)p;
+      for (uint32_t j = (p * p) / 2; j < odds; j += p) composite[j] = 1;
+    }
+    free(composite);
+    basePrimes_ = (uint16_t *)realloc(basePrimes_, (baseCount_ + 1) * sizeof(uint16_t));
+  }
+
+  ~PrimeSieve() { free(basePrimes_); }
+
+  PrimeSieve(const PrimeSieve &) = delete;
+  PrimeSieve &operator=(const PrimeSieve &) = delete;
+
+  /**
+   * Name: ok
+   * @brief False if the base primes could not be allocated; nothing is produced then.
+   */
+  bool ok() const { return basePrimes_ != NULL; }
+
+  /**
+   * Name: nextSegment
+   * @brief Sieves the next segment of the range.
+   * @retval false when the range is exhausted.
+   */
+  bool nextSegment() {
+    if (!ok()) return false;
+    bool first = !started_;
+    started_ = true;
+    if (next_ >= high_) {
+      // no odd numbers left; a range holding only 2 still gets one (empty) segment
+      bits_ = 0;
+      segLow_ = segHigh_ = high_;
+      return first && pendingTwo_;
+    }
+
+    segLow_ = next_;
+    segHigh_ = segLow_ + SIEVE_SEGMENT_SPAN;
+    if (segHigh_ > high_) segHigh_ = high_;
+    bits_ = (uint32_t)((segHigh_ - segLow_ + 1) / 2);
+    next_ = segLow_ + SIEVE_SEGMENT_SPAN;
+
+    uint32_t words = (bits_ + 31) / 32;
+    memset(words_, 0xFF, words * 4);
+    if (bits_ % 32) words_[words - 1] = (1u << (bits_ % 32)) - 1;
+
+    for (uint32_t k = 0; k < baseCount_; k++) {
+      uint64_t p = basePrimes_[k];
+      uint64_t start = p * p;
+      if (start >= segHigh_) break;
+      if (start < segLow_) {
+        start = (segLow_ + p - 1) / p * p;
+        if ((start & 1) == 0) start += p;  // odd multiples only
+      }
+      for (uint64_t j = (start - segLow_) / 2; j < bits_; j += p) {
+        words_[j >> 5] &= ~(1u << (j & 31));
+      }
+    }
+    if (segLow_ == 1) words_[0] &= ~1u;  // 1 is not prime
+    return true;
+  }
+
+  /**
+   * Name: forEachPrime
+   * @brief Calls fn(p) for every prime of the current segment, in increasing order.
+   * @details 2 is reported with the first segment if it is in the range.
+   */
+  template <typename Fn>
+  void forEachPrime(Fn fn) {
+    if (pendingTwo_ && started_) {
+      fn((uint32_t)2);
+      pendingTwo_ = false;
+    }
+    uint32_t words = (bits_ + 31) / 32;
+    for (uint32_t w = 0; w < words; w++) {
+      uint32_t bits = words_[w];
+      while (bits != 0) {
+        uint32_t b = __builtin_ctz(bits);
+        fn((uint32_t)(segLow_ + 2 * (32 * w + b)));
+        bits &= bits - 1;
+      }
+    }
+  }
+
+  /**
+   * Name: countSegment
+   * @brief Number of primes in the current segment, without listing them (2 not included).
+   */
+  uint32_t countSegment() const {
+    uint32_t count = 0;
+    uint32_t words = (bits_ + 31) / 32;
+    for (uint32_t w = 0; w < words; w++) count += __builtin_popcount(words_[w]);
+    return count;
+  }
+
+  /**
+   * Name: count
+   * @brief Sieves the rest of the range and returns how many primes it holds.
+   */
+  uint32_t count() {
+    uint32_t total = 0;
+    while (nextSegment()) {
+      if (pendingTwo_) {
+        total++;
+        pendingTwo_ = false;
+      }
+      total += countSegment();
+    }
+    return total;
+  }
+
+  /**
+   * Name: segmentLow
+   * @brief First number of the current segment.
+   */
+  uint64_t segmentLow() const { return segLow_; }
+
+  /**
+   * Name: segmentHigh
+   * @brief One past the last number of the current segment.
+   */
+  uint64_t segmentHigh() const { return segHigh_; }
+
+  /**
+   * Name: ramBytes
+   * @brief Memory held: the object with its segment plus the base primes.
+   */
+  size_t ramBytes() const { return sizeof(*this) + baseCount_ * sizeof(uint16_t); }
+
+  /**
+   * Name: splitPoint
+   * @brief Boundary between part - 1 and part when [low, high) is split into parts
+   *      pieces of nearly equal length, rounded to a multiple of 64.
+   * @details splitPoint(low, high, 0, n) is low and splitPoint(low, high, n, n) is high.
+   */
+  static uint32_t splitPoint(uint32_t low, uint32_t high, uint32_t part, uint32_t parts) {
+    if (part == 0 || high <= low) return low;
+    if (part >= parts) return high;
+    uint64_t point = low + (uint64_t)(high - low) * part / parts;
+    point = (point + 32) & ~(uint64_t)63;
+    if (point < low) point = low;
+    if (point > high) point = high;
+    return (uint32_t)point;
+  }
+
+private:
+  uint64_t high_;
+  uint64_t next_;               ///< First odd number of the next segment
+  uint64_t segLow_;             ///< Odd number of bit 0 of the current segment
+  uint64_t segHigh_;
+  uint32_t bits_ = 0;           ///< Odd numbers in the current segment
+  bool pendingTwo_;             ///< 2 is in the range and not reported yet
+  bool started_ = false;        ///< nextSegment has been called
+  uint16_t *basePrimes_ = NULL; ///< Odd primes up to sqrt(high)
+  uint32_t baseCount_ = 0;
+  uint32_t words_[SIEVE_SEGMENT_WORDS];
+};
+
+#endif
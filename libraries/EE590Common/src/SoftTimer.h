@@ -0,0 +1,352 @@
+/**
+ * @file SoftTimer.h
+ * @brief Hierarchical timer wheel for periodic and one-shot jobs in a polled loop.
+ *
+ * @section description Description
+ * Each job registers a callback with create() and is armed with start(). The loop
+ * passes the current time to poll(), which runs the callbacks that are due and
+ * touches nothing else. Time is counted in ticks of tickUs microseconds.
+ *
+ * Timers are kept in SOFT_TIMER_LEVELS wheels of 64 slots each. Level 0 holds
+ * timers due within the next 64 ticks, one slot per tick; level L holds timers due
+ * within 64^(L+1) ticks, one slot per 64^L ticks, and its slots are moved down a
+ * level as the wheel turns past them. With 4 levels the wheel spans 2^24 ticks
+ * (4.6 hours at 1 ms); later deadlines are parked in the top level and re-parked
+ * until they come into range.
+ *
+ * Start, stop and firing are O(1). poll() costs O(timers fired) plus one step per
+ * 64 ticks elapsed (empty level 0 slots are skipped using a bitmap), independent of
+ * how many timers are armed.
+ *
+ * @section notes Notes
+ * - Callbacks may start and stop any timer, including their own.
+ * - A periodic timer keeps its phase. If the loop falls behind by whole periods, the
+ *   missed firings are skipped, not run back to back, and counted in missed().
+ * - Times are 64 bit (see MonotonicClock.h), so the wheel never sees a wrap.
+ * - Not interrupt safe: create, start, stop and poll must all run in the same task.
+ *
+ * @section author Author
+ * Created by Sai Jayanth Kalisi, 2025
+ */
+#ifndef SOFT_TIMER_H
+#define SOFT_TIMER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SOFT_TIMER_LEVELS    4  ///< Wheels; the span is 64^SOFT_TIMER_LEVELS ticks
+#define SOFT_TIMER_SLOT_BITS 6  ///< 64 slots per wheel, one bit each in a uint64_t
+#define SOFT_TIMER_SLOTS     (1 << SOFT_TIMER_SLOT_BITS)
+#define SOFT_TIMER_NONE      (-1) ///< Invalid timer id / empty link
+
+typedef void (*SoftTimerCallback)(void *arg); ///< Job run when a timer is due
+
+/**
+ * @brief Timer wheel with room for MAX_TIMERS timers.
+ * @tparam MAX_TIMERS timers that can be created, at most 32767.
+ */
+template <size_t MAX_TIMERS>
+class SoftTimerWheel {
+  static_assert(MAX_TIMERS > 0 && MAX_TIMERS < 32768, "timer ids are 16 bit");
+
+public:
+  /**
+   * Name: SoftTimerWheel
+   * @param tickUs length of one tick in microseconds; periods are rounded to whole ticks.
+   */
+  explicit SoftTimerWheel(uint32_t tickUs) : tickUs_(tickUs ? tickUs : 1) {
+    for (int l = 0; l < SOFT_TIMER_LEVELS; l++) {
+      occupied_[l] = 0;
+      for (int s = 0; s < SOFT_TIMER_SLOTS; s++) heads_[l][s] = SOFT_TIMER_NONE;
+    }
+  }
+
+  /**
+   * Name: begin
+   * @brief Sets the wheel's time. Call once with the clock's time before starting timers.
+   */
+  void begin(uint64_t nowUs) {
+    current_ = nowUs / tickUs_;
+    target_ = current_;
+  }
+
+  /**
+   * Name: create
+   * @brief Registers a job. The timer starts disarmed.
+   * @retval timer id, or SOFT_TIMER_NONE if MAX_TIMERS timers exist.
+   */
+  int create(SoftTimerCallback callback, void *arg) {
+    if (callback == NULL || count_ == MAX_TIMERS) return SOFT_TIMER_NONE;
+    Timer &t = timers_[count_];
+    t.callback = callback;
+    t.arg = arg;
+    t.state = STATE_IDLE;
+    t.armed = false;
+    t.rearmed = false;
+    return (int)count_++;
+  }
+
+  /**
+   * Name: every
+   * @brief create() and start() a periodic job whose first run is one period from now.
+   */
+  int every(uint32_t periodUs, SoftTimerCallback callback, void *arg) {
+    int id = create(callback, arg);
+    if (id != SOFT_TIMER_NONE) start(id, periodUs, periodUs);
+    return id;
+  }
+
+  /**
+   * Name: start
+   * @brief Arms (or re-arms) a timer.
+   * @param id timer from create().
+   * @param delayUs time until the first run, measured from the time last given to poll() (or
+   *      begin()) and rounded up to whole ticks; 0 runs it on the next poll.
+   * @param periodUs time between runs after that, or 0 for a one-shot timer.
+   */
+  bool start(int id, uint32_t delayUs, uint32_t periodUs) {
+    if (!valid(id)) return false;
+    Timer &t = timers_[id];
+    if (t.state == STATE_LINKED) unlink(id);
+
+    uint32_t periodTicks = (periodUs + tickUs_ / 2) / tickUs_;
+    t.deadline = target_ + (delayUs + tickUs_ - 1) / tickUs_;  // from the last time given to poll(); link() clamps to current_
+    t.period = (periodUs == 0) ? 0 : (periodTicks ? periodTicks : 1);
+    t.armed = true;
+    if (t.state == STATE_DUE) {
+      t.rearmed = true;  // poll() is walking the due list; it links the timer when it gets there
+    } else {
+      link(id);
+    }
+    return true;
+  }
+
+  /**
+   * Name: stop
+   * @brief Disarms a timer. It does not run again until started.
+   */
+  bool stop(int id) {
+    if (!valid(id)) return false;
+    Timer &t = timers_[id];
+    if (t.state == STATE_LINKED) {
+      unlink(id);
+      t.state = STATE_IDLE;
+    }
+    t.armed = false;
+    t.rearmed = false;
+    return true;
+  }
+
+  /**
+   * Name: isArmed
+   * @brief Whether the timer will run again.
+   */
+  bool isArmed(int id) const {
+    return valid(id) && timers_[id].armed;
+  }
+
+  /**
+   * Name: poll
+   * @brief Runs every timer due at or before nowUs, in deadline order.
+   * @retval number of callbacks run.
+   */
+  size_t poll(uint64_t nowUs) {
+    target_ = nowUs / tickUs_;
+    size_t fired = 0;
+
+    while (current_ <= target_) {
+      uint64_t tick = current_;
+      if ((tick & (SOFT_TIMER_SLOTS - 1)) == 0) cascade(tick);
+
+      int slot = (int)(tick & (SOFT_TIMER_SLOTS - 1));
+      int16_t due = heads_[0][slot];
+      heads_[0][slot] = SOFT_TIMER_NONE;
+      occupied_[0] &= ~(1ULL << slot);
+      current_ = tick + 1;
+      for (int16_t id = due; id != SOFT_TIMER_NONE; id = timers_[id].next) {
+        timers_[id].state = STATE_DUE;
+      }
+      fired += runDue(due);
+
+      skipEmpty();
+    }
+    return fired;
+  }
+
+  /**
+   * Name: missed
+   * @brief Periodic firings skipped because poll() was called too late to run them on time.
+   */
+  uint32_t missed() const {
+    return missed_;
+  }
+
+  /**
+   * Name: tickUs
+   * @brief Tick length in microseconds.
+   */
+  uint32_t tickUs() const {
+    return tickUs_;
+  }
+
+private:
+  enum : uint8_t {
+    STATE_IDLE = 0,  ///< In no list
+    STATE_LINKED,    ///< In a wheel slot
+    STATE_DUE,       ///< In the list poll() is running
+  };
+
+  struct Timer {
+    uint64_t deadline;          ///< Tick the timer is due at
+    uint32_t period;            ///< Ticks between runs, 0 for one-shot
+    SoftTimerCallback callback;
+    void *arg;
+    int16_t next;               ///< Next timer in the same slot
+    int16_t prev;               ///< Previous timer in the same slot
+    uint8_t level;              ///< Wheel the timer is linked into
+    uint8_t slot;               ///< Slot the timer is linked into
+    uint8_t state;
+    bool armed;                 ///< Will run again
+    bool rearmed;               ///< Restarted while due; link instead of running
+  };
+
+  bool valid(int id) const {
+    return id >= 0 && (size_t)id < count_;
+  }
+
+  /**
+   * Name: link
+   * @brief Puts a timer in the lowest wheel whose span covers its deadline.
+   */
+  void link(int16_t id) {
+    Timer &t = timers_[id];
+    if (t.deadline < current_) t.deadline = current_;
+
+    int level = SOFT_TIMER_LEVELS - 1;
+    int slot;
+    for (int l = 0; l < SOFT_TIMER_LEVELS; l++) {
+      int shift = l * SOFT_TIMER_SLOT_BITS;
+      if ((t.deadline >> shift) - (current_ >> shift) < SOFT_TIMER_SLOTS) {
+        level = l;
+        break;
+      }
+    }
+    int shift = level * SOFT_TIMER_SLOT_BITS;
+    if ((t.deadline >> shift) - (current_ >> shift) < SOFT_TIMER_SLOTS) {
+      slot = (int)((t.deadline >> shift) & (SOFT_TIMER_SLOTS - 1));
+    } else {
+      slot = (int)(((current_ >> shift) + SOFT_TIMER_SLOTS - 1) & (SOFT_TIMER_SLOTS - 1));  // beyond the span: park
+    }
+
+    t.level = (uint8_t)level;
+    t.slot = (uint8_t)slot;
+    t.prev = SOFT_TIMER_NONE;
+    t.next = heads_[level][slot];
+    if (t.next != SOFT_TIMER_NONE) timers_[t.next].prev = id;
+    heads_[level][slot] = id;
+    occupied_[level] |= 1ULL << slot;
+    t.state = STATE_LINKED;
+  }
+
+  void unlink(int16_t id) {
+    Timer &t = timers_[id];
+    if (t.prev == SOFT_TIMER_NONE) {
+      heads_[t.level][t.slot] = t.next;
+      if (t.next == SOFT_TIMER_NONE) occupied_[t.level] &= ~(1ULL << t.slot);
+    } else {
+      timers_[t.prev].next = t.next;
+    }
+    if (t.next != SOFT_TIMER_NONE) timers_[t.next].prev = t.prev;
+    t.next = t.prev = SOFT_TIMER_NONE;
+    t.state = STATE_IDLE;
+  }
+
+  /**
+   * Name: cascade
+   * @brief Moves the slots the wheel has just reached down a level, highest level first.
+   */
+  void cascade(uint64_t tick) {
+    int top = 1;
+    while (top + 1 < SOFT_TIMER_LEVELS &&
+           (tick & ((1ULL << ((top + 1) * SOFT_TIMER_SLOT_BITS)) - 1)) == 0) {
+      top++;
+    }
+    for (int l = top; l >= 1; l--) {
+      int slot = (int)((tick >> (l * SOFT_TIMER_SLOT_BITS)) & (SOFT_TIMER_SLOTS - 1));
+      int16_t id = heads_[l][slot];
+      heads_[l][slot] = SOFT_TIMER_NONE;
+      occupied_[l] &= ~(1ULL << slot);
+      while (id != SOFT_TIMER_NONE) {
+        int16_t next = timers_[id].next;
+        link(id);
+        id = next;
+      }
+    }
+  }
+
+  /**
+   * Name: runDue
+   * @brief Runs a detached list of due timers, re-linking periodic ones first.
+   */
+  size_t runDue(int16_t id) {
+    size_t fired = 0;
+    while (id != SOFT_TIMER_NONE) {
+      Timer &t = timers_[id];
+      int16_t next = t.next;
+      t.state = STATE_IDLE;
+
+      if (!t.armed) {
+        // stopped by an earlier callback in this list
+      } else if (t.rearmed) {
+        t.rearmed = false;
+        link(id);
+      } else {
+        if (t.period != 0) {
+          t.deadline += t.period;
+          if (t.deadline <= target_) {
+            uint64_t late = (target_ - t.deadline) / t.period + 1;
+            t.deadline += late * t.period;
+            missed_ += (uint32_t)late;
+          }
+          link(id);
+        } else {
+          t.armed = false;
+        }
+        t.callback(t.arg);
+        fired++;
+      }
+      id = next;
+    }
+    return fired;
+  }
+
+  /**
+   * Name: skipEmpty
+   * @brief Moves current_ past empty level 0 slots, stopping at the next wheel boundary.
+   */
+  void skipEmpty() {
+    if (current_ > target_) return;
+    if ((occupied_[0] | occupied_[1] | occupied_[2] | occupied_[3]) == 0) {
+      current_ = target_ + 1;  // nothing armed at all
+      return;
+    }
+    int slot = (int)(current_ & (SOFT_TIMER_SLOTS - 1));
+    if (slot == 0) return;  // boundary: cascade first
+    uint64_t ahead = occupied_[0] >> slot;
+    uint64_t next = (ahead != 0) ? current_ + __builtin_ctzll(ahead) : (current_ | (SOFT_TIMER_SLOTS - 1)) + 1;
+    current_ = (next <= target_) ? next : target_ + 1;
+  }
+
+  static_assert(SOFT_TIMER_LEVELS == 4, "skipEmpty tests four occupancy words");
+
+  Timer timers_[MAX_TIMERS];
+  size_t count_ = 0;
+  int16_t heads_[SOFT_TIMER_LEVELS][SOFT_TIMER_SLOTS];
+  uint64_t occupied_[SOFT_TIMER_LEVELS];  ///< Bit s set when slot s of the level holds a timer
+  uint64_t current_ = 0;                  ///< Next tick to process
+  uint64_t target_ = 0;                   ///< Tick poll() was last called for ("now")
+  uint32_t tickUs_;
+  uint32_t missed_ = 0;
+};
+
+#endif
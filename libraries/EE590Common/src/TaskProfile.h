@@ -0,0 +1,225 @@
+/**
+ * @file TaskProfile.h
+ * @brief Per-task execution time, WCET, deadline overrun and stack high-water statistics.
+ *
+ * @section description Description
+ * A TaskProfile is kept for each task. The dispatcher (or the task itself) calls
+ * begin(now) when a dispatch starts and end(now) when it finishes, with timestamps from
+ * the hardware timer. Each dispatch updates:
+ * - count, min, mean and max (the observed WCET) of the execution time;
+ * - a log2 histogram: bucket 0 holds 0 us, bucket k holds [2^(k-1), 2^k) us, and the last
+ *   bucket holds everything longer;
+ * - the number of dispatches longer than the task's deadline, if it has one.
+ * For FreeRTOS tasks, stackHighWater() records the least free stack seen, e.g. from
+ * uxTaskGetStackHighWaterMark, against the size the task was created with.
+ *
+ * profileDump() prints one line per task in a compact key=value format, so a serial
+ * command can dump measurements at any time and stack sizes and loop periods can be
+ * chosen from them:
+ *
+ *     # prof name n min avg max dl over stk h@first=counts
+ *     prof taskA n=812 min=3 avg=5 max=41 dl=2000 over=0 stk=-/- h@2=10,640,150,9,3
+ *
+ * "h@2=10,640,..." lists the buckets from the first non-empty one (2: 2-3 us) to the
+ * last non-empty one. "-" marks a field that was not set.
+ *
+ * @section notes Notes
+ * - Times are 32 bit microseconds with wrap-safe differences; one dispatch may last up
+ *   to about 71 minutes.
+ * - Each profile has one writer, the task or dispatcher it belongs to. profileDump may run
+ *   on another task; a line printed while that task is being updated can mix old and new
+ *   values, which is acceptable for a report.
+ * - begin/end measure time from dispatch to completion. Under a preemptive kernel that
+ *   includes time spent blocked or preempted, i.e. it is the response time of the dispatch.
+ *
+ * @section author Author
+ * Created by Sai Jayanth Kalisi, 2025
+ */
+#ifndef TASK_PROFILE_H
+#define TASK_PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define PROFILE_BUCKETS 24               ///< Histogram buckets; the last holds 2^22 us (4.2 s) and up
+#define PROFILE_UNSET   UINT32_MAX       ///< Deadline, stack size or stack mark not given
+
+/**
+ * @brief Statistics of one task's dispatches.
+ */
+class TaskProfile {
+public:
+  /**
+   * Name: setup
+   * @brief Names the task and sets its limits, and clears the statistics.
+   * @param name for the dump; kept by pointer.
+   * @param deadlineUs longest acceptable dispatch, or PROFILE_UNSET.
+   * @param stackBytes stack the task was created with, or PROFILE_UNSET.
+   */
+  void setup(const char *name, uint32_t deadlineUs = PROFILE_UNSET, uint32_t stackBytes = PROFILE_UNSET) {
+    name_ = name;
+    deadlineUs_ = deadlineUs;
+    stackBytes_ = stackBytes;
+    reset();
+  }
+
+  /**
+   * Name: reset
+   * @brief Clears the statistics and the stack mark, keeping the name and limits.
+   */
+  void reset() {
+    count_ = 0;
+    sumUs_ = 0;
+    minUs_ = UINT32_MAX;
+    maxUs_ = 0;
+    overruns_ = 0;
+    stackFree_ = PROFILE_UNSET;
+    for (size_t i = 0; i < PROFILE_BUCKETS; i++) buckets_[i] = 0;
+  }
+
+  /**
+   * Name: begin
+   * @brief Marks the start of a dispatch.
+   */
+  void begin(uint32_t nowUs) { startUs_ = nowUs; }
+
+  /**
+   * Name: end
+   * @brief Marks the end of the dispatch begun last and records its length.
+   * @retval the dispatch's length in microseconds.
+   */
+  uint32_t end(uint32_t nowUs) {
+    uint32_t us = nowUs - startUs_;
+    record(us);
+    return us;
+  }
+
+  /**
+   * Name: record
+   * @brief Records one dispatch of the given length.
+   */
+  void record(uint32_t us) {
+    count_++;
+    sumUs_ += us;
+    if (us < minUs_) minUs_ = us;
+    if (us > maxUs_) maxUs_ = us;
+    if (deadlineUs_ != PROFILE_UNSET && us > deadlineUs_) overruns_++;
+    buckets_[bucketOf(us)]++;
+  }
+
+  /**
+   * Name: stackHighWater
+   * @brief Records the free stack the task has left; the least value seen is kept.
+   */
+  void stackHighWater(uint32_t freeBytes) {
+    if (stackFree_ == PROFILE_UNSET || freeBytes < stackFree_) stackFree_ = freeBytes;
+  }
+
+  /**
+   * Name: bucketOf
+   * @brief Histogram bucket of a dispatch length: 0 for 0 us, else 1 + floor(log2(us)), capped.
+   */
+  static size_t bucketOf(uint32_t us) {
+    if (us == 0) return 0;
+    size_t k = 32 - __builtin_clz(us);
+    return (k < PROFILE_BUCKETS) ? k : PROFILE_BUCKETS - 1;
+  }
+
+  const char *name() const { return name_; }
+  uint32_t count() const { return count_; }
+  uint32_t minUs() const { return count_ ? minUs_ : 0; }
+  uint32_t maxUs() const { return maxUs_; }  ///< Observed WCET
+  uint32_t avgUs() const { return count_ ? (uint32_t)(sumUs_ / count_) : 0; }
+  uint32_t overruns() const { return overruns_; }
+  uint32_t deadlineUs() const { return deadlineUs_; }
+  uint32_t stackBytes() const { return stackBytes_; }
+  uint32_t stackFree() const { return stackFree_; }  ///< Least free stack seen, or PROFILE_UNSET
+  uint32_t bucket(size_t k) const { return buckets_[k]; }
+
+  /**
+   * Name: format
+   * @brief Writes the profile's dump line, without a newline, into line.
+   * @retval characters written, as snprintf.
+   */
+  int format(char *line, size_t size) const {
+    char dl[12], stk[24];
+    formatValue(dl, sizeof(dl), deadlineUs_);
+    if (stackBytes_ == PROFILE_UNSET && stackFree_ == PROFILE_UNSET) {
+      snprintf(stk, sizeof(stk), "-/-");
+    } else {
+      char left[12], total[12];
+      formatValue(left, sizeof(left), stackFree_);
+      formatValue(total, sizeof(total), stackBytes_);
+      snprintf(stk, sizeof(stk), "%s/%s", left, total);
+    }
+    int n = snprintf(line, size, "prof %s n=%lu min=%lu avg=%lu max=%lu dl=%s over=%lu stk=%s", name_,
+                     (unsigned long)count_, (unsigned long)minUs(), (unsigned long)avgUs(),
+                     (unsigned long)maxUs_, dl, (unsigned long)overruns_, stk);
+
+    size_t first = 0, last = 0;
+    bool any = false;
+    for (size_t k = 0; k < PROFILE_BUCKETS; k++) {
+      if (buckets_[k] == 0) continue;
+      if (!any) first = k;
+      last = k;
+      any = true;
+    }
+    if (!any) return n;
+    for (size_t k = first; k <= last && n >= 0 && (size_t)n < size; k++) {
+      if (k == first) {
+        n += snprintf(line + n, size - n, " h@%u=%lu", (unsigned)k, (unsigned long)buckets_[k]);
+      } else {
+        n += snprintf(line + n, size - n, ",%lu", (unsigned long)buckets_[k]);
+      }
+    }
+    return n;
+  }
+
+private:
+  /**
+   * Name: formatValue
+   * @brief A number, or "-" for PROFILE_UNSET.
+   */
+  static void formatValue(char *out, size_t size, uint32_t value) {
+    if (value == PROFILE_UNSET) {
+      snprintf(out, size, "-");
+    } else {
+      snprintf(out, size, "%lu", (unsigned long)value);
+    }
+  }
+
+  const char *name_ = "";
+  uint32_t deadlineUs_ = PROFILE_UNSET;
+  uint32_t stackBytes_ = PROFILE_UNSET;
+  uint32_t startUs_ = 0;
+  uint32_t count_ = 0;
+  uint64_t sumUs_ = 0;
+  uint32_t minUs_ = UINT32_MAX;
+  uint32_t maxUs_ = 0;
+  uint32_t overruns_ = 0;
+  uint32_t stackFree_ = PROFILE_UNSET;
+  uint32_t buckets_[PROFILE_BUCKETS] = {};
+};
+
+/**
+ * Name: profileDump
+ * @brief Prints a key line and one line per profile to out, e.g. Serial.
+ * @details out needs print(const char *). Each line is formatted in a small buffer first, so
+ *      it goes out as one write.
+ */
+template <typename Out>
+void profileDump(Out &out, const TaskProfile *profiles, size_t n) {
+  char line[160];
+  out.print("# prof name n min avg max dl over stk h@first=counts (us, stk = least free/size bytes)\n");
+  for (size_t i = 0; i < n; i++) {
+    int len = profiles[i].format(line, sizeof(line) - 1);
+    if (len < 0) continue;
+    size_t end = ((size_t)len < sizeof(line) - 2) ? (size_t)len : sizeof(line) - 2;
+    line[end] = '\n';
+    line[end + 1] = '\0';
+    out.print(line);
+  }
+}
+
+#endif
@@ -0,0 +1,342 @@
+/**
+ * @file Telemetry.h
+ * @brief Batches timestamped light samples into MTU sized frames sent as BLE notifications.
+ *
+ * @section description Description
+ * TelemetryPublisher<BACKLOG> keeps up to BACKLOG samples (light level and its moving
+ * average, stamped with micros()). poll() sends at most one notification per interval,
+ * packing as many of the oldest samples as fit in one ATT payload (MTU - 3 bytes), so
+ * a 20 Hz stream costs one radio event a second instead of twenty.
+ *
+ * Frame layout, little endian:
+ * | bytes | field                                                          |
+ * |-------|----------------------------------------------------------------|
+ * | 1     | TELEMETRY_VERSION                                              |
+ * | 1     | records in the frame                                           |
+ * | 2     | sequence number, +1 per frame sent                             |
+ * | 4     | micros() of the first record                                   |
+ * | 2     | samples dropped since the previous frame (saturates at 65535)  |
+ * | 8 * n | records: ms after the first record, level, average, samples    |
+ *
+ * A record normally holds one sample. When the backlog is full, the policy decides:
+ * - TELEMETRY_DROP_OLDEST discards the oldest sample and counts it in the next header.
+ * - TELEMETRY_SUMMARIZE merges adjacent pairs of records across the whole backlog, each
+ *   into one that holds their mean and the number of samples behind it. No sample is
+ *   lost and the resolution halves evenly over the backlog, rather than the oldest
+ *   records alone piling up samples; half the backlog is then free for new samples.
+ *
+ * Backpressure: a notification that fails (see notifyResult) leaves its samples in the
+ * backlog for the next interval, and nothing is sent while setCongested(true). Either way
+ * the backlog fills and the policy applies.
+ *
+ * poll() works with anything that has setValue(uint8_t *, size_t) and notify(), so the
+ * framing runs unchanged against the host stand-in for BLECharacteristic.
+ *
+ * @section notes Notes
+ * - add, poll and notifyResult run in the same task (the loop); setMtu and setCongested
+ *   may be called from the BLE stack's task. Both only store an atomic that poll() reads,
+ *   so a new MTU takes effect from the next frame built.
+ * - Times are 32 bit micros(); differences wrap correctly.
+ *
+ * @section author Author
+ * Created by Sai Jayanth Kalisi, 2025
+ */
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TELEMETRY_VERSION     1
+#define TELEMETRY_HEADER      10  ///< Bytes before the first record
+#define TELEMETRY_RECORD      8   ///< Bytes per record
+#define TELEMETRY_ATT_HEADER  3   ///< ATT notification overhead taken out of the MTU
+#define TELEMETRY_DEFAULT_MTU 23  ///< BLE minimum, until the client negotiates more
+#define TELEMETRY_MAX_PAYLOAD 244 ///< Largest frame built: an MTU of 247
+
+/**
+ * @brief What to do with a new sample when the backlog is full.
+ */
+typedef enum {
+  TELEMETRY_DROP_OLDEST = 0,
+  TELEMETRY_SUMMARIZE,
+} TelemetryPolicy;
+
+/**
+ * @brief One decoded record.
+ */
+typedef struct {
+  uint32_t timestampUs; ///< micros() of the (first) sample
+  uint16_t level;       ///< Light level, or the mean of the merged samples
+  uint16_t average;     ///< Moving average, or the mean of the merged samples
+  uint16_t samples;     ///< Samples behind the record, 1 unless summarized
+} TelemetryRecord;
+
+/**
+ * @brief Decoded frame header.
+ */
+typedef struct {
+  uint8_t records;
+  uint16_t sequence;
+  uint32_t firstUs;
+  uint16_t dropped;
+} TelemetryHeader;
+
+namespace telemetry_detail {
+
+inline void put16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+inline void put32(uint8_t *p, uint32_t v) {
+  put16(p, (uint16_t)v);
+  put16(p + 2, (uint16_t)(v >> 16));
+}
+
+inline uint16_t get16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+inline uint32_t get32(const uint8_t *p) { return get16(p) | ((uint32_t)get16(p + 2) << 16); }
+
+} // namespace telemetry_detail
+
+/**
+ * Name: telemetryDecode
+ * @brief Parses one frame and calls fn(record) for each record, oldest first.
+ * @param header filled in if not NULL.
+ * @retval records decoded, or -1 if the frame is malformed.
+ */
+template <typename Fn>
+int telemetryDecode(const uint8_t *data, size_t len, TelemetryHeader *header, Fn fn) {
+  using namespace telemetry_detail;
+  if (len < TELEMETRY_HEADER || data[0] != TELEMETRY_VERSION) return -1;
+  TelemetryHeader h;
+  h.records = data[1];
+  h.sequence = get16(data + 2);
+  h.firstUs = get32(data + 4);
+  h.dropped = get16(data + 8);
+  if (len != TELEMETRY_HEADER + (size_t)h.records * TELEMETRY_RECORD) return -1;
+  if (header != NULL) *header = h;
+
+  const uint8_t *p = data + TELEMETRY_HEADER;
+  for (int i = 0; i < h.records; i++, p += TELEMETRY_RECORD) {
+    TelemetryRecord r;
+    r.timestampUs = h.firstUs + (uint32_t)get16(p) * 1000u;
+    r.level = get16(p + 2);
+    r.average = get16(p + 4);
+    r.samples = get16(p + 6);
+    fn(r);
+  }
+  return h.records;
+}
+
+/**
+ * @brief Backlog of samples, sent as framed notifications at a fixed rate.
+ * @tparam BACKLOG samples kept while waiting to be sent; a power of two.
+ */
+template <size_t BACKLOG>
+class TelemetryPublisher {
+  static_assert(BACKLOG > 1 && (BACKLOG & (BACKLOG - 1)) == 0, "BACKLOG must be a power of two");
+
+public:
+  /**
+   * Name: TelemetryPublisher
+   * @param policy what a full backlog does with a new sample.
+   * @param intervalMs least time between two notifications; 0 sends on every poll.
+   */
+  TelemetryPublisher(TelemetryPolicy policy, uint32_t intervalMs)
+      : policy_(policy), intervalUs_(intervalMs * 1000u) {}
+
+  /**
+   * Name: setMtu
+   * @brief Sets the ATT MTU the client negotiated; frames are sized to MTU - 3.
+   */
+  void setMtu(uint16_t mtu) { mtu_.store(mtu, std::memory_order_relaxed); }
+
+  /**
+   * Name: add
+   * @brief Queues one sample. Amortized O(1); applies the policy if the backlog is full.
+   */
+  void add(uint32_t timestampUs, uint16_t level, uint16_t average) {
+    if (count_ == BACKLOG) makeRoom();
+    Slot &s = slots_[(head_ + count_) & (BACKLOG - 1)];
+    s.timestampUs = timestampUs;
+    s.levelSum = level;
+    s.averageSum = average;
+    s.samples = 1;
+    count_++;
+  }
+
+  /**
+   * Name: poll
+   * @brief Sends one frame of the oldest samples if the interval has passed.
+   * @retval true if a notification was sent and accepted.
+   */
+  template <typename Characteristic>
+  bool poll(Characteristic &ch, uint32_t nowUs) {
+    if (count_ == 0 || congested_.load(std::memory_order_relaxed)) return false;
+    if (sentOnce_ && nowUs - lastSendUs_ < intervalUs_) return false;
+    sentOnce_ = true;
+    lastSendUs_ = nowUs;
+
+    size_t records = buildFrame();
+    result_ = RESULT_PENDING;
+    ch.setValue(frame_, TELEMETRY_HEADER + records * TELEMETRY_RECORD);
+    ch.notify();
+    if (result_ == RESULT_FAILED) {
+      failures_++;
+      return false;  // the samples stay for the next interval
+    }
+
+    head_ = (head_ + records) & (BACKLOG - 1);
+    count_ -= records;
+    sequence_++;
+    frames_++;
+    droppedSinceFrame_ = 0;
+    return true;
+  }
+
+  /**
+   * Name: notifyResult
+   * @brief Reports how the notification poll() just sent went, from the characteristic's
+   *      status callback. Not calling it counts as success.
+   */
+  void notifyResult(bool ok) {
+    if (result_ == RESULT_PENDING) result_ = ok ? RESULT_OK : RESULT_FAILED;
+  }
+
+  /**
+   * Name: setCongested
+   * @brief Holds notifications while the BLE stack reports its buffers full.
+   */
+  void setCongested(bool congested) { congested_.store(congested, std::memory_order_relaxed); }
+
+  /**
+   * @name Counters
+   * @{
+   */
+  size_t pending() const { return count_; }           ///< Records waiting to be sent
+  uint32_t frames() const { return frames_; }         ///< Notifications accepted
+  uint32_t failures() const { return failures_; }     ///< Notifications that failed and were kept
+  uint32_t dropped() const { return dropped_; }       ///< Samples discarded by TELEMETRY_DROP_OLDEST
+  uint32_t summarized() const { return summarized_; } ///< Pairs merged by TELEMETRY_SUMMARIZE
+  size_t recordsPerFrame() const { return recordsFor(mtu_.load(std::memory_order_relaxed)); }
+  /** @} */
+
+private:
+  enum : uint8_t { RESULT_PENDING, RESULT_OK, RESULT_FAILED };
+
+  /**
+   * @brief A backlog entry; sums so merged records keep an exact mean.
+   */
+  struct Slot {
+    uint32_t timestampUs;
+    uint32_t levelSum;
+    uint32_t averageSum;
+    uint16_t samples;
+  };
+
+  Slot &slotAt(size_t i) { return slots_[(head_ + i) & (BACKLOG - 1)]; }
+
+  /**
+   * Name: recordsFor
+   * @brief Records that fit one notification at an MTU; at least 1.
+   */
+  static size_t recordsFor(uint16_t mtu) {
+    size_t payload = (mtu > TELEMETRY_ATT_HEADER) ? mtu - TELEMETRY_ATT_HEADER : 0;
+    if (payload > TELEMETRY_MAX_PAYLOAD) payload = TELEMETRY_MAX_PAYLOAD;
+    size_t records = (payload > TELEMETRY_HEADER) ? (payload - TELEMETRY_HEADER) / TELEMETRY_RECORD : 0;
+    return (records > 0) ? records : 1;
+  }
+
+  /**
+   * Name: makeRoom
+   * @brief Frees slots by summarizing the backlog, or the oldest slot by dropping it.
+   * @details Falls back to dropping when no pair could be merged without overflowing
+   *      the sample count.
+   */
+  void makeRoom() {
+    if (policy_ == TELEMETRY_SUMMARIZE) {
+      summarize();
+      if (count_ < BACKLOG) return;
+    }
+    Slot &oldest = slots_[head_];
+    dropped_ += oldest.samples;
+    droppedSinceFrame_ += oldest.samples;
+    head_ = (head_ + 1) & (BACKLOG - 1);
+    count_--;
+  }
+
+  /**
+   * Name: summarize
+   * @brief Merges records 0 and 1, 2 and 3, and so on, in place from the oldest.
+   * @details A pair whose samples would not fit a uint16_t is kept as two records.
+   *      Runs once per BACKLOG / 2 samples added while the link is down.
+   */
+  void summarize() {
+    size_t kept = 0;
+    for (size_t i = 0; i < count_; kept++) {
+      Slot merged = slotAt(i++);
+      if (i < count_ && (uint32_t)merged.samples + slotAt(i).samples <= UINT16_MAX) {
+        const Slot &next = slotAt(i++);
+        merged.levelSum += next.levelSum;
+        merged.averageSum += next.averageSum;
+        merged.samples += next.samples;
+        summarized_++;
+      }
+      slotAt(kept) = merged;
+    }
+    count_ = kept;
+  }
+
+  /**
+   * Name: buildFrame
+   * @brief Writes the oldest records that fit into frame_, without removing them.
+   * @retval records written.
+   */
+  size_t buildFrame() {
+    using namespace telemetry_detail;
+    uint32_t firstUs = slots_[head_].timestampUs;
+    size_t maxRecords = recordsPerFrame();  // read once: setMtu may run meanwhile
+    size_t records = 0;
+    uint8_t *p = frame_ + TELEMETRY_HEADER;
+    while (records < count_ && records < maxRecords) {
+      const Slot &s = slots_[(head_ + records) & (BACKLOG - 1)];
+      uint32_t offsetMs = (s.timestampUs - firstUs) / 1000u;
+      if (offsetMs > UINT16_MAX) break;  // the next frame starts from it
+      put16(p, (uint16_t)offsetMs);
+      put16(p + 2, (uint16_t)((s.levelSum + s.samples / 2) / s.samples));
+      put16(p + 4, (uint16_t)((s.averageSum + s.samples / 2) / s.samples));
+      put16(p + 6, s.samples);
+      p += TELEMETRY_RECORD;
+      records++;
+    }
+
+    frame_[0] = TELEMETRY_VERSION;
+    frame_[1] = (uint8_t)records;
+    put16(frame_ + 2, sequence_);
+    put32(frame_ + 4, firstUs);
+    put16(frame_ + 8, (uint16_t)(droppedSinceFrame_ < UINT16_MAX ? droppedSinceFrame_ : UINT16_MAX));
+    return records;
+  }
+
+  Slot slots_[BACKLOG];
+  size_t head_ = 0;
+  size_t count_ = 0;
+  TelemetryPolicy policy_;
+  uint32_t intervalUs_;
+  std::atomic<uint16_t> mtu_{TELEMETRY_DEFAULT_MTU};
+  uint32_t lastSendUs_ = 0;
+  bool sentOnce_ = false;
+  uint16_t sequence_ = 0;
+  uint8_t result_ = RESULT_OK;
+  std::atomic<bool> congested_{false};
+  uint8_t frame_[TELEMETRY_MAX_PAYLOAD];
+  uint32_t frames_ = 0;
+  uint32_t failures_ = 0;
+  uint32_t dropped_ = 0;
+  uint32_t droppedSinceFrame_ = 0;
+  uint32_t summarized_ = 0;
+};
+
+#endif
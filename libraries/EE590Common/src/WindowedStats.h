@@ -0,0 +1,366 @@
+/**
+ * @file WindowedStats.h
+ * @brief O(1) per-sample streaming statistics over sliding windows of integer samples.
+ *
+ * @section description Description
+ * - WindowedMoments<W>: mean, variance and standard deviation of the last W samples.
+ * - WindowedMinMax<W>: min and max of the last W samples (monotonic deques).
+ * - Ewma: exponentially weighted moving average with a Q16 smoothing factor.
+ * - WindowedPercentile<W, BINS>: percentiles of the last W samples from a binned histogram.
+ * - StreamStats<W, BINS>: all of the above fed by one add().
+ *
+ * Every add() does a constant amount of work regardless of W, and no component
+ * allocates. Arithmetic is integer or fixed point throughout.
+ *
+ * @section notes Notes
+ * - WindowedMoments keeps exact integer sums instead of Welford's floating point
+ *   running mean; with integer samples this gives the same sliding update without
+ *   drift. Sums are 64 bit, so |sample| < 2^20 with W < 2^10 cannot overflow.
+ *
+ * @section author Author
+ * Created by Sai Jayanth Kalisi, 2025
+ */
+#ifndef WINDOWED_STATS_H
+#define WINDOWED_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace windowed_stats_detail {
+
+/**
+ * Name: divRound
+ * @brief num / den rounded to nearest, halves away from zero. den must be positive.
+ */
+inline int64_t divRound(int64_t num, int64_t den) {
+  return (num >= 0) ? (num + den / 2) / den : -((-num + den / 2) / den);
+}
+
+/**
+ * Name: isqrt
+ * @brief Integer square root, rounded down.
+ */
+inline uint32_t isqrt(uint64_t x) {
+  uint64_t root = 0;
+  uint64_t bit = 1ULL << 62;
+  while (bit > x) bit >>= 2;
+  while (bit != 0) {
+    if (x >= root + bit) {
+      x -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32_t)root;
+}
+
+} // namespace windowed_stats_detail
+
+/**
+ * @brief Mean and variance of the last W samples.
+ * @tparam W window length in samples.
+ */
+template <size_t W>
+class WindowedMoments {
+  static_assert(W > 0, "window must hold at least one sample");
+
+public:
+  /**
+   * Name: add
+   * @brief Adds a sample, retiring the oldest one once the window is full.
+   */
+  void add(int32_t x) {
+    if (count_ == W) {
+      int32_t old = window_[pos_];
+      sum_ -= old;
+      sumSq_ -= (int64_t)old * old;
+    } else {
+      count_++;
+    }
+    window_[pos_] = x;
+    sum_ += x;
+    sumSq_ += (int64_t)x * x;
+    pos_ = (pos_ + 1 == W) ? 0 : pos_ + 1;
+  }
+
+  void reset() { count_ = pos_ = 0; sum_ = sumSq_ = 0; }
+  size_t count() const { return count_; }
+  bool full() const { return count_ == W; }
+  int64_t sum() const { return sum_; }
+
+  /** @brief Mean of the samples in the window, rounded. 0 when empty. */
+  int32_t mean() const {
+    return count_ ? (int32_t)windowed_stats_detail::divRound(sum_, count_) : 0;
+  }
+
+  /** @brief Mean in Q8 fixed point (256 = 1.0). */
+  int32_t meanQ8() const {
+    return count_ ? (int32_t)windowed_stats_detail::divRound(sum_ * 256, count_) : 0;
+  }
+
+  /** @brief Population variance of the window, rounded. */
+  uint32_t variance() const {
+    if (count_ < 2) return 0;
+    int64_t n = count_;
+    int64_t spread = n * sumSq_ - sum_ * sum_;  // n^2 * variance, never negative
+    return (uint32_t)((spread + n * n / 2) / (n * n));
+  }
+
+  /** @brief Population standard deviation of the window, rounded down. */
+  uint32_t stddev() const {
+    if (count_ < 2) return 0;
+    int64_t n = count_;
+    return windowed_stats_detail::isqrt((uint64_t)(n * sumSq_ - sum_ * sum_)) / (uint32_t)n;
+  }
+
+private:
+  int32_t window_[W];
+  size_t count_ = 0;
+  size_t pos_ = 0;     ///< Slot the next sample goes into
+  int64_t sum_ = 0;
+  int64_t sumSq_ = 0;
+};
+
+/**
+ * @brief Min and max of the last W samples.
+ * @details Each extreme is tracked by a deque of candidates that is monotonic in value;
+ *      every sample is pushed and popped at most once, so add() is amortized O(1).
+ * @tparam W window length in samples.
+ */
+template <size_t W>
+class WindowedMinMax {
+  static_assert(W > 0, "window must hold at least one sample");
+
+public:
+  /**
+   * Name: add
+   * @brief Adds a sample and expires the one that left the window.
+   */
+  void add(int32_t x) {
+    seq_++;
+    minQ_.expire(seq_);
+    maxQ_.expire(seq_);
+    while (!minQ_.empty() && minQ_.backValue() >= x) minQ_.popBack();
+    while (!maxQ_.empty() && maxQ_.backValue() <= x) maxQ_.popBack();
+    minQ_.pushBack(seq_, x);
+    maxQ_.pushBack(seq_, x);
+  }
+
+  void reset() { seq_ = 0; minQ_.clear(); maxQ_.clear(); }
+  bool empty() const { return minQ_.empty(); }
+
+  /** @brief Smallest sample in the window. 0 when empty. */
+  int32_t min() const { return minQ_.empty() ? 0 : minQ_.frontValue(); }
+
+  /** @brief Largest sample in the window. 0 when empty. */
+  int32_t max() const { return maxQ_.empty() ? 0 : maxQ_.frontValue(); }
+
+private:
+  /**
+   * @brief Fixed capacity deque of (sequence number, value) candidates.
+   */
+  class Deque {
+  public:
+    bool empty() const { return len_ == 0; }
+    void clear() { head_ = len_ = 0; }
+    int32_t frontValue() const { return value_[head_]; }
+    int32_t backValue() const { return value_[wrap(head_ + len_ - 1)]; }
+    void popBack() { len_--; }
+    void pushBack(uint32_t seq, int32_t value) {
+      size_t slot = wrap(head_ + len_);
+      seq_[slot] = seq;
+      value_[slot] = value;
+      len_++;
+    }
+    void expire(uint32_t now) {
+      // Sequence numbers advance by one per add, so at most one candidate leaves per call
+      if (len_ > 0 && now - seq_[head_] >= W) {
+        head_ = wrap(head_ + 1);
+        len_--;
+      }
+    }
+
+  private:
+    static size_t wrap(size_t i) { return (i >= W) ? i - W : i; }
+    uint32_t seq_[W];
+    int32_t value_[W];
+    size_t head_ = 0;
+    size_t len_ = 0;
+  };
+
+  uint32_t seq_ = 0;  ///< Sequence number of the newest sample
+  Deque minQ_;
+  Deque maxQ_;
+};
+
+/**
+ * @brief Exponentially weighted moving average in Q16 fixed point.
+ * @details value += alpha * (x - value), with alpha = alphaQ16 / 65536. The first
+ *      sample initializes the average so it does not ramp up from 0.
+ */
+class Ewma {
+public:
+  explicit Ewma(uint32_t alphaQ16 = 65536 / 8) : alphaQ16_(alphaQ16) {}
+
+  void setAlpha(uint32_t alphaQ16) { alphaQ16_ = alphaQ16; }
+  void reset() { primed_ = false; valueQ16_ = 0; }
+
+  /**
+   * Name: add
+   * @brief Folds in one sample.
+   */
+  void add(int32_t x) {
+    int64_t xQ16 = (int64_t)x * 65536;
+    if (!primed_) {
+      valueQ16_ = xQ16;
+      primed_ = true;
+      return;
+    }
+    valueQ16_ += ((xQ16 - valueQ16_) * (int64_t)alphaQ16_) / 65536;
+  }
+
+  /** @brief Current average, rounded. */
+  int32_t value() const { return (int32_t)windowed_stats_detail::divRound(valueQ16_, 65536); }
+
+  /** @brief Current average in Q16 fixed point. */
+  int64_t valueQ16() const { return valueQ16_; }
+
+private:
+  uint32_t alphaQ16_;
+  int64_t valueQ16_ = 0;
+  bool primed_ = false;
+};
+
+/**
+ * @brief Percentiles of the last W samples, estimated from a BINS bin histogram.
+ * @details add() moves one count into and one out of the histogram. A query walks the
+ *      bins, so its cost depends on BINS but not on W. Estimates are accurate to one bin
+ *      width, (hi - lo + 1) / BINS rounded up; samples outside [lo, hi] are clamped.
+ * @tparam W window length in samples.
+ * @tparam BINS number of histogram bins.
+ */
+template <size_t W, size_t BINS = 32>
+class WindowedPercentile {
+  static_assert(W > 0 && BINS > 0, "window and histogram must be non-empty");
+  static_assert(BINS <= 65535, "bin indices are stored as uint16_t");
+
+public:
+  /**
+   * @param lo smallest expected sample.
+   * @param hi largest expected sample.
+   */
+  WindowedPercentile(int32_t lo, int32_t hi) { setRange(lo, hi); }
+
+  /**
+   * Name: setRange
+   * @brief Sets the histogram range and empties it.
+   */
+  void setRange(int32_t lo, int32_t hi) {
+    lo_ = lo;
+    int64_t span = (int64_t)hi - lo + 1;
+    width_ = (int32_t)((span + BINS - 1) / BINS);
+    if (width_ < 1) width_ = 1;
+    reset();
+  }
+
+  void reset() {
+    count_ = pos_ = 0;
+    for (size_t i = 0; i < BINS; i++) hist_[i] = 0;
+  }
+
+  size_t count() const { return count_; }
+
+  /**
+   * Name: add
+   * @brief Adds a sample, retiring the oldest one once the window is full.
+   */
+  void add(int32_t x) {
+    int64_t offset = (int64_t)x - lo_;
+    size_t bin = (offset < 0) ? 0 : (size_t)(offset / width_);
+    if (bin >= BINS) bin = BINS - 1;
+
+    if (count_ == W) {
+      hist_[window_[pos_]]--;
+    } else {
+      count_++;
+    }
+    window_[pos_] = (uint16_t)bin;
+    hist_[bin]++;
+    pos_ = (pos_ + 1 == W) ? 0 : pos_ + 1;
+  }
+
+  /**
+   * Name: percentile
+   * @brief Estimated p-th percentile (nearest rank) of the window.
+   * @param p percentile from 0 to 100.
+   * @return centre of the bin holding that rank, 0 when empty.
+   */
+  int32_t percentile(uint32_t p) const {
+    if (count_ == 0) return 0;
+    if (p > 100) p = 100;
+    size_t rank = (count_ * p + 99) / 100;  // 1-based nearest rank
+    if (rank == 0) rank = 1;
+
+    size_t seen = 0;
+    for (size_t i = 0; i < BINS; i++) {
+      seen += hist_[i];
+      if (seen >= rank) return lo_ + (int32_t)i * width_ + width_ / 2;
+    }
+    return lo_ + (int32_t)(BINS - 1) * width_ + width_ / 2;
+  }
+
+  /** @brief Estimated median of the window. */
+  int32_t median() const { return percentile(50); }
+
+private:
+  uint16_t window_[W];    ///< Bin of each sample in the window
+  uint16_t hist_[BINS];   ///< Samples per bin
+  size_t count_ = 0;
+  size_t pos_ = 0;
+  int32_t lo_ = 0;
+  int32_t width_ = 1;
+};
+
+/**
+ * @brief Every statistic above over one window, fed by a single add().
+ * @tparam W window length in samples.
+ * @tparam BINS histogram bins for percentiles.
+ */
+template <size_t W, size_t BINS = 32>
+class StreamStats {
+public:
+  /**
+   * @param lo smallest expected sample, for percentiles.
+   * @param hi largest expected sample, for percentiles.
+   * @param alphaQ16 EWMA smoothing factor in Q16.
+   */
+  StreamStats(int32_t lo, int32_t hi, uint32_t alphaQ16 = 65536 / 8)
+    : ewma(alphaQ16), percentiles(lo, hi) {}
+
+  /**
+   * Name: add
+   * @brief Feeds one sample to every statistic.
+   */
+  void add(int32_t x) {
+    moments.add(x);
+    range.add(x);
+    ewma.add(x);
+    percentiles.add(x);
+  }
+
+  void reset() {
+    moments.reset();
+    range.reset();
+    ewma.reset();
+    percentiles.reset();
+  }
+
+  WindowedMoments<W> moments;
+  WindowedMinMax<W> range;
+  Ewma ewma;
+  WindowedPercentile<W, BINS> percentiles;
+};
+
+#endif